@@ -24,6 +24,16 @@
 
 static ssize_t OW_init_both(const char *params, enum restart_init repeat) ;
 static ssize_t OW_init_args_both(int argc, char **argv, enum restart_init repeat);
+static ssize_t OW_get_many_both(struct OW_get_item *items, int count);
+static void *OW_get_many_thread(void *v);
+
+/* a pending OW_get_many_async */
+struct OW_get_many_job {
+	struct OW_get_item *items;
+	int count;
+	void (*done) (struct OW_get_item *, int, void *);
+	void *v;
+};
 
 static ssize_t ReturnAndErrno(ssize_t ret)
 {
@@ -174,6 +184,102 @@ ssize_t OW_lread(const char *path, char *buffer, const size_t size, const off_t
 	return ReturnAndErrno(ret);
 }
 
+ssize_t OW_get_many(struct OW_get_item *items, int count)
+{
+	ssize_t ret = -EACCES;
+
+	/* Check the parameters */
+	if (items == NULL || count < 0) {
+		return ReturnAndErrno(-EINVAL);
+	}
+
+	if (API_access_start() == 0) {
+		ret = OW_get_many_both(items, count);
+		API_access_end();
+	}
+	return ReturnAndErrno(ret);
+}
+
+ssize_t OW_get_many_async(struct OW_get_item *items, int count, void (*done) (struct OW_get_item *, int, void *), void *v)
+{
+	struct OW_get_many_job *job;
+	pthread_t thread;
+
+	/* Check the parameters */
+	if (items == NULL || count < 0 || done == NULL) {
+		return ReturnAndErrno(-EINVAL);
+	}
+	if (StateInfo.owlib_state != lib_state_started) {
+		return ReturnAndErrno(-EACCES);
+	}
+
+	job = owmalloc(sizeof(struct OW_get_many_job));
+	if (job == NULL) {
+		return ReturnAndErrno(-ENOMEM);
+	}
+	job->items = items;
+	job->count = count;
+	job->done = done;
+	job->v = v;
+	if (pthread_create(&thread, DEFAULT_THREAD_ATTR, OW_get_many_thread, job) != 0) {
+		owfree(job);
+		return ReturnAndErrno(-EAGAIN);
+	}
+	return ReturnAndErrno(0);
+}
+
+static void *OW_get_many_thread(void *v)
+{
+	struct OW_get_many_job *job = v;
+	int item_index;
+
+	DETACH_THREAD;
+
+	if (API_access_start() == 0) {
+		OW_get_many_both(job->items, job->count);
+		API_access_end();
+	} else {
+		// finished meanwhile
+		for (item_index = 0; item_index < job->count; ++item_index) {
+			job->items[item_index].result = -EACCES;
+		}
+	}
+	job->done(job->items, job->count, job->v);
+	owfree(job);
+	return VOID_RETURN;
+}
+
+/* Both kinds, with access held. Results in each item */
+static ssize_t OW_get_many_both(struct OW_get_item *items, int count)
+{
+	struct many_read *reads;
+	int item_index;
+
+	if (count == 0) {
+		return 0;
+	}
+	reads = owcalloc(count, sizeof(struct many_read));
+	if (reads == NULL) {
+		for (item_index = 0; item_index < count; ++item_index) {
+			items[item_index].result = -ENOMEM;
+		}
+		return -ENOMEM;
+	}
+	for (item_index = 0; item_index < count; ++item_index) {
+		// the values land in the caller's buffers -- none is -EINVAL, not one of ours
+		reads[item_index].path = items[item_index].buffer == NULL ? NULL : items[item_index].path;
+		reads[item_index].buffer = items[item_index].buffer;
+		reads[item_index].size = items[item_index].size;
+		reads[item_index].offset = items[item_index].offset;
+	}
+	FS_read_many(reads, count);
+	for (item_index = 0; item_index < count; ++item_index) {
+		items[item_index].result = reads[item_index].read_return;
+	}
+	owfree(reads);
+	return 0;
+}
+
 ssize_t OW_lwrite(const char *path, const char *buffer, const size_t size, const off_t offset)
 {
 	ssize_t ret = -EACCES;		/* current buffer string length */
@@ -127,6 +127,39 @@ extern "C" {
 */
 	ssize_t OW_lread(const char *path, char *buf, const size_t size, const off_t offset);
 
+/*  OW_get_many -- read a list of values at once
+  items is an array of count requests, each filled in by the caller:
+    path    OWFS style name of a property, "10.468ACE13579B/temperature"
+    buffer  where the value is read to, size bytes long
+    offset  from start of value
+  and on return
+    result  length read into buffer, or -errno for that item (-EISDIR for a directory)
+
+  Each path is parsed once and values are read straight into the buffers.
+  Reads on different buses run at the same time, and several temperatures
+  on one bus share a single conversion. Much quicker than OW_lread in a loop.
+
+  return value  = 0 ok (see each result)
+                < 0 error
+*/
+	struct OW_get_item {
+		const char *path;
+		char *buffer;
+		size_t size;
+		off_t offset;
+		ssize_t result;
+	};
+	ssize_t OW_get_many(struct OW_get_item *items, int count);
+
+/*  OW_get_many_async -- same, but returns at once
+  done(items, count, v) is called from another thread when every result is in.
+  items (and the paths and buffers) must be left alone until then.
+
+  return value  = 0 started, done will be called
+                < 0 error, done will not be called
+*/
+	ssize_t OW_get_many_async(struct OW_get_item *items, int count, void (*done) (struct OW_get_item * items, int count, void *v), void *v);
+
 /*  OW_lwrite -- write data with offset
   path is OWFS style name,
     "05.468ACE13579B/PIO.A for a specific device property
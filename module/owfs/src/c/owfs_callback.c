@@ -16,6 +16,8 @@
 #include "owfs.h"
 #include "ow_pid.h"
 
+#ifndef OWFS_FUSE3				/* FUSE 3 uses owfs_lowlevel.c */
+
 /* There was a major change in the function prototypes at FUSE 2.2, we'll make a flag */
 #undef FUSE22PLUS
 #undef FUSE1X
@@ -52,6 +54,9 @@ static int CB_write(const char *path, const char *buffer, size_t size, off_t off
 #define CB_read FS_read
 #define CB_write FS_write
 #endif
+#ifdef OWFS_POLL
+static int FS_poll(const char *path, struct fuse_file_info *flags, struct fuse_pollhandle *ph, unsigned *reventsp);
+#endif							/* OWFS_POLL */
 #if FUSE_VERSION > 25
 static void *FS_init(struct fuse_conn_info *);
 #elif FUSE_VERSION > 22
@@ -87,6 +92,9 @@ struct fuse_operations owfs_oper = {
 #if FUSE_VERSION > 22
   init:FS_init,
 #endif							/* FUSE_VERSION > 22 */
+#ifdef OWFS_POLL
+  poll:FS_poll,
+#endif							/* OWFS_POLL */
 };
 
 /* ---------------------------------------------- */
@@ -117,25 +125,53 @@ static int FS_chown(const char *path, uid_t uid, gid_t gid)
 	return 0;
 }
 
-/* In theory, should handle file opening, but OWFS doesn't care. Device opened/closed with every read/write */
+#ifdef FUSE22PLUS
+/* Parse once, the query is kept in the file handle until release */
 static int FS_open(const char *path, FUSEFLAG flags)
 {
+	struct owfs_handle *oh;
+	ZERO_OR_ERROR open_return;
+
 #if FUSE_VERSION < 23
 	if (!pid_created)
 		PIDstart();
 #endif							/* FUSE_VERSION < 23 */
 	LEVEL_CALL("OPEN path=%s", SAFESTRING(path));
+	if (path == NO_PATH) {
+		path = "/";
+	}
+	open_return = Handle_open(path, &oh);
+	if (open_return == 0) {
+		flags->fh = Handle_fh(oh);
+	}
+	return open_return;
+}
+
+static int FS_release(const char *path, FUSEFLAG flags)
+{
+	LEVEL_CALL("RELEASE path=%s", SAFESTRING(path));
+	Handle_release(Handle(flags->fh));
+	flags->fh = 0;
+	return 0;
+}
+#else							/* FUSE22PLUS */
+/* No file handle before FUSE 2.2. Device opened/closed with every read/write */
+static int FS_open(const char *path, FUSEFLAG flags)
+{
+	if (!pid_created)
+		PIDstart();
+	LEVEL_CALL("OPEN path=%s", SAFESTRING(path));
 	(void) flags;
 	return 0;
 }
 
-/* In theory, should handle file closing, but OWFS doesn't care. Device opened/closed with every read/write */
 static int FS_release(const char *path, FUSEFLAG flags)
 {
 	LEVEL_CALL("RELEASE path=%s", SAFESTRING(path));
 	(void) flags;
 	return 0;
 }
+#endif							/* FUSE22PLUS */
 
 /* dummy truncation (empty) function */
 static int FS_truncate(const char *path, const off_t size)
@@ -194,43 +230,27 @@ static int FS_getdir(const char *path, fuse_dirh_t h, fuse_dirfil_t filler)
 #ifdef FUSE22PLUS
 static int CB_read(const char *path, char *buffer, size_t size, off_t offset, struct fuse_file_info *flags)
 {
-	(void) flags;
-	int return_size ;
-	OWQ_allocate_struct_and_pointer( owq ) ;
-
-	if (path == NO_PATH) {
-		path = "/";
-	}
-
-	if ( BAD( OWQ_create(path, owq) ) ) {	/* Can we parse the input string */
-		return -ENOENT;
-	}
-
-	if ( IsDir( PN(owq) ) ) { /* A directory of some kind */
-		return_size = -EISDIR ;
-	} else if ( offset >= (off_t) FullFileLength( PN(owq) ) ) {
-		// fuse requests a useless read at end of file -- just return ok.
-		return_size = 0 ;
-	} else {
-		if ( size > MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE ) {
-			LEVEL_DEBUG( "Requested read length %ld will be trimmed to owfs max %ld",(long int) size, (long int) MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE ) ;
-			size = MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE ;
-		}
-		OWQ_assign_read_buffer( buffer, size, offset, owq) ;
-		return_size = FS_read_postparse(owq) ;
-	}
-	OWQ_destroy(owq);
-
-	return return_size ;
+	(void) path;
+	return Handle_read(Handle(flags->fh), buffer, size, offset);
 }
 
 static int CB_write(const char *path, const char *buffer, size_t size, off_t offset, struct fuse_file_info *flags)
 {
-	(void) flags;
-	return FS_write(path, buffer, size, offset);
+	(void) path;
+	return Handle_write(Handle(flags->fh), buffer, size, offset);
 }
 #endif							/* FUSE22PLUS */
 
+#ifdef OWFS_POLL
+/* Wait for the value to change, see owfs_handle.c */
+static int FS_poll(const char *path, struct fuse_file_info *flags, struct fuse_pollhandle *ph, unsigned *reventsp)
+{
+	LEVEL_CALL("POLL path=%s", SAFESTRING(path));
+	*reventsp = Handle_poll(Handle(flags->fh), ph);
+	return 0;
+}
+#endif							/* OWFS_POLL */
+
 /* Change in statfs definition for newer FUSE versions */
 #ifdef FUSE1X
 int FS_statfs(struct fuse_statfs *fst)
@@ -255,3 +275,5 @@ static void *FS_init(void)
 	return VOID_RETURN;
 }
 #endif							/* FUSE_VERSION > 22 */
+
+#endif							/* OWFS_FUSE3 */
@@ -0,0 +1,229 @@
+/*
+    OW -- One-Wire filesystem
+    version 0.4 7/2/2003
+
+    Function naming scheme:
+    OW -- Generic call to interface
+    LI -- LINK commands
+    FS -- filesystem commands
+    UT -- utility functions
+    COM - serial port functions
+    DS2480 -- DS9097U serial connector
+
+    Written 2003 Paul H Alfille
+*/
+
+/* Open files keep their parsed query
+ *
+ * The path is parsed at open and the query used again for every read and
+ * write until release, instead of parsing (and checking presence) each
+ * time. It is parsed again once aliases, device locations or the bus list
+ * change, or when a parsed path memo entry would have expired.
+ *
+ * poll() reports an open file readable until it has been read, and again
+ * each time the value changes (FS_watch). A program can wait in poll or
+ * epoll for the next change instead of reading over and over.
+ *
+ * Shared by the FUSE 2 callbacks and the FUSE 3 low-level frontend.
+ */
+
+#include "owfs.h"
+#ifdef OWFS_POLL
+#include <poll.h>
+#endif							/* OWFS_POLL */
+
+struct owfs_handle {
+	char *path;
+	struct one_wire_query *owq;	// NO_ONE_WIRE_QUERY until parsed
+	UINT generation;			// Cache_ParsedName_Generation at parse
+	time_t expires;
+	pthread_mutex_t mutex;		// one read or write at a time
+#ifdef OWFS_POLL
+	struct watch_subscriber *watch;	// once polled
+	int polled;
+	int unread;					// changed since the last read
+	struct fuse_pollhandle *ph;	// poll waiting for a change
+	pthread_mutex_t poll_mutex;	// taken inside mutex and the watch lock
+#endif							/* OWFS_POLL */
+};
+
+#define HANDLELOCK( oh )     _MUTEX_LOCK(   (oh)->mutex )
+#define HANDLEUNLOCK( oh )   _MUTEX_UNLOCK( (oh)->mutex )
+#define POLLLOCK( oh )       _MUTEX_LOCK(   (oh)->poll_mutex )
+#define POLLUNLOCK( oh )     _MUTEX_UNLOCK( (oh)->poll_mutex )
+
+static GOOD_OR_BAD Handle_parse(struct owfs_handle *oh);
+#ifdef OWFS_POLL
+static void Handle_changed(void *v);
+#endif							/* OWFS_POLL */
+
+/* Parse path for a new open file. Returns 0 and the handle, or -errno */
+ZERO_OR_ERROR Handle_open(const char *path, struct owfs_handle **handle)
+{
+	struct owfs_handle *oh = owcalloc(1, sizeof(struct owfs_handle));
+
+	if (oh == NULL) {
+		return -ENOMEM;
+	}
+	oh->path = owstrdup(path);
+	if (oh->path == NULL) {
+		owfree(oh);
+		return -ENOMEM;
+	}
+	oh->owq = NO_ONE_WIRE_QUERY;
+	_MUTEX_INIT(oh->mutex);
+#ifdef OWFS_POLL
+	oh->unread = 1;
+	_MUTEX_INIT(oh->poll_mutex);
+#endif							/* OWFS_POLL */
+	if (BAD(Handle_parse(oh))) {
+		Handle_release(oh);
+		return -ENOENT;
+	}
+	*handle = oh;
+	return 0;
+}
+
+void Handle_release(struct owfs_handle *oh)
+{
+	if (oh == NULL) {
+		return;
+	}
+#ifdef OWFS_POLL
+	// no more change callbacks after this
+	FS_unwatch(oh->watch);
+	if (oh->ph != NULL) {
+		fuse_pollhandle_destroy(oh->ph);
+	}
+	_MUTEX_DESTROY(oh->poll_mutex);
+#endif							/* OWFS_POLL */
+	if (oh->owq != NO_ONE_WIRE_QUERY) {
+		OWQ_destroy(oh->owq);
+	}
+	_MUTEX_DESTROY(oh->mutex);
+	owfree(oh->path);
+	owfree(oh);
+}
+
+/* Same checks as a read by path, without the parse */
+SIZE_OR_ERROR Handle_read(struct owfs_handle *oh, char *buffer, size_t size, off_t offset)
+{
+	SIZE_OR_ERROR return_size;
+
+	HANDLELOCK(oh);
+	if (BAD(Handle_parse(oh))) {
+		return_size = -ENOENT;
+	} else if (IsDir(PN(oh->owq))) {	/* A directory of some kind */
+		return_size = -EISDIR;
+	} else if (offset >= (off_t) FullFileLength(PN(oh->owq))) {
+		// fuse requests a useless read at end of file -- just return ok.
+		return_size = 0;
+	} else {
+		if (size > MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE) {
+			LEVEL_DEBUG("Requested read length %ld will be trimmed to owfs max %ld", (long int) size, (long int) MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE);
+			size = MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE;
+		}
+		OWQ_assign_read_buffer(buffer, size, offset, oh->owq);
+		return_size = FS_read_postparse(oh->owq);
+	}
+#ifdef OWFS_POLL
+	if (return_size >= 0) {
+		POLLLOCK(oh);
+		oh->unread = 0;
+		POLLUNLOCK(oh);
+	}
+#endif							/* OWFS_POLL */
+	HANDLEUNLOCK(oh);
+	return return_size;
+}
+
+/* return size if ok, else negative */
+SIZE_OR_ERROR Handle_write(struct owfs_handle *oh, const char *buffer, size_t size, off_t offset)
+{
+	SIZE_OR_ERROR write_return;
+
+	LEVEL_CALL("path=%s size=%d offset=%d", oh->path, (int) size, (int) offset);
+	HANDLELOCK(oh);
+	if (BAD(Handle_parse(oh))) {
+		write_return = -ENOENT;
+	} else {
+		OWQ_assign_write_buffer(buffer, size, offset, oh->owq);
+		write_return = FS_write_postparse(oh->owq);
+	}
+	HANDLEUNLOCK(oh);
+	return write_return;
+}
+
+#ifdef OWFS_POLL
+/* Readable if changed since the last read, always writable (like any file).
+ * ph (if any) is notified at the next change */
+unsigned int Handle_poll(struct owfs_handle *oh, struct fuse_pollhandle *ph)
+{
+	unsigned int revents = POLLOUT | POLLWRNORM;
+
+	HANDLELOCK(oh);
+	if (!oh->polled) {
+		// sampling starts with the first poll, not every open
+		oh->polled = 1;
+		oh->watch = FS_watch(oh->path, Handle_changed, oh);
+	}
+	HANDLEUNLOCK(oh);
+
+	POLLLOCK(oh);
+	if (oh->watch == NULL) {
+		// not watchable, never blocks
+		oh->unread = 1;
+	}
+	if (oh->unread) {
+		revents |= POLLIN | POLLRDNORM;
+	}
+	if (ph != NULL) {
+		if (oh->ph != NULL) {
+			fuse_pollhandle_destroy(oh->ph);
+		}
+		oh->ph = ph;
+	}
+	POLLUNLOCK(oh);
+	return revents;
+}
+
+/* From the watch sampler */
+static void Handle_changed(void *v)
+{
+	struct owfs_handle *oh = v;
+
+	POLLLOCK(oh);
+	oh->unread = 1;
+	if (oh->ph != NULL) {
+#ifdef OWFS_FUSE3
+		fuse_lowlevel_notify_poll(oh->ph);
+#else							/* OWFS_FUSE3 */
+		fuse_notify_poll(oh->ph);
+#endif							/* OWFS_FUSE3 */
+		fuse_pollhandle_destroy(oh->ph);
+		oh->ph = NULL;
+	}
+	POLLUNLOCK(oh);
+}
+#endif							/* OWFS_POLL */
+
+/* Parse again if the topology changed or the parse is stale */
+static GOOD_OR_BAD Handle_parse(struct owfs_handle *oh)
+{
+	UINT generation = Cache_ParsedName_Generation();
+
+	if (oh->owq != NO_ONE_WIRE_QUERY) {
+		if (oh->generation == generation && NOW_TIME <= oh->expires) {
+			return gbGOOD;
+		}
+		LEVEL_DEBUG("Parse open file %s again", oh->path);
+		OWQ_destroy(oh->owq);
+	}
+	oh->owq = OWQ_create_from_path(oh->path);
+	if (oh->owq == NO_ONE_WIRE_QUERY) {
+		return gbBAD;
+	}
+	oh->generation = generation;
+	oh->expires = NOW_TIME + Cache_ParsedName_Lifespan();
+	return gbGOOD;
+}
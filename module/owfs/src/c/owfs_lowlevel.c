@@ -0,0 +1,589 @@
+/*
+    OW -- One-Wire filesystem
+    version 0.4 7/2/2003
+
+    Function naming scheme:
+    OW -- Generic call to interface
+    LI -- LINK commands
+    FS -- filesystem commands
+    UT -- utility functions
+    COM - serial port functions
+    DS2480 -- DS9097U serial connector
+
+    Written 2003 Paul H Alfille
+*/
+
+/* FUSE 3 low-level frontend
+ *
+ * The kernel refers to files by inode number. Each inode is a node holding
+ * the 1-wire path, found again by path so one path keeps one inode. Nodes
+ * are counted by kernel lookups and freed when the kernel forgets them.
+ *
+ * Every entry and attribute reply carries a timeout from the owlib cache
+ * settings (Cache_Lifespan) so repeated stat and ls calls are answered by
+ * the kernel without a trip here. readdirplus gives the attributes along
+ * with the listing.
+ *
+ * Open files keep their parsed query in the file handle (owfs_handle.c),
+ * which also answers poll.
+ *
+ * Requests are served by the FUSE multi-threaded session loop.
+ */
+
+#include "owfs.h"
+#include "ow_pid.h"
+
+#ifdef OWFS_FUSE3
+
+struct owfs_node {
+	char *path;
+	uint64_t nlookup;			// kernel references
+};
+
+struct owfs_dirent {
+	char *name;
+	struct stat st;
+	time_t lifespan;
+};
+
+struct owfs_dir {
+	struct owfs_dirent *entries;
+	int count;
+	int allocated;
+};
+
+static struct owfs_node root_node = { "/", 1, };
+static void *node_tree = NULL;	// struct owfs_node * by path
+
+static pthread_mutex_t node_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define NODELOCK     _MUTEX_LOCK(   node_mutex )
+#define NODEUNLOCK   _MUTEX_UNLOCK( node_mutex )
+
+static int node_compare(const void *a, const void *b);
+static struct owfs_node *Node(fuse_ino_t ino);
+static fuse_ino_t Node_ino(struct owfs_node *node);
+static struct owfs_node *Node_lookup(const char *path);
+static void Node_forget(fuse_ino_t ino, uint64_t nlookup);
+static char *Node_child(const struct owfs_node *parent, const char *name);
+static ZERO_OR_ERROR Node_entry(const char *path, struct fuse_entry_param *e);
+static void Dir_callback(void *v, const struct parsedname *pn_entry);
+static void Dir_add(struct owfs_dir *od, const char *name, const struct stat *st, time_t lifespan);
+static void Dir_free(struct owfs_dir *od);
+
+static void LL_init(void *userdata, struct fuse_conn_info *conn);
+static void LL_lookup(fuse_req_t req, fuse_ino_t parent, const char *name);
+static void LL_forget(fuse_req_t req, fuse_ino_t ino, uint64_t nlookup);
+static void LL_forget_multi(fuse_req_t req, size_t count, struct fuse_forget_data *forgets);
+static void LL_getattr(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *file_info);
+static void LL_setattr(fuse_req_t req, fuse_ino_t ino, struct stat *attr, int to_set, struct fuse_file_info *file_info);
+static void LL_open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *file_info);
+static void LL_read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, struct fuse_file_info *file_info);
+static void LL_write(fuse_req_t req, fuse_ino_t ino, const char *buffer, size_t size, off_t offset, struct fuse_file_info *file_info);
+static void LL_release(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *file_info);
+static void LL_poll(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *file_info, struct fuse_pollhandle *ph);
+static void LL_opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *file_info);
+static void LL_readdir_common(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, struct fuse_file_info *file_info, int plus);
+static void LL_readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, struct fuse_file_info *file_info);
+static void LL_readdirplus(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, struct fuse_file_info *file_info);
+static void LL_releasedir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *file_info);
+
+static const struct fuse_lowlevel_ops owfs_lowlevel_oper = {
+	.init = LL_init,
+	.lookup = LL_lookup,
+	.forget = LL_forget,
+	.forget_multi = LL_forget_multi,
+	.getattr = LL_getattr,
+	.setattr = LL_setattr,
+	.open = LL_open,
+	.read = LL_read,
+	.write = LL_write,
+	.release = LL_release,
+	.poll = LL_poll,
+	.opendir = LL_opendir,
+	.readdir = LL_readdir,
+	.readdirplus = LL_readdirplus,
+	.releasedir = LL_releasedir,
+};
+
+/* Mount and serve until unmounted. Command line as built for fuse_main */
+int Fuse_lowlevel_main(struct Fuse_option *fo)
+{
+	struct fuse_args args = FUSE_ARGS_INIT(fo->argc, fo->argv);
+	struct fuse_cmdline_opts opts;
+	struct fuse_session *se;
+	int ret = 1;
+
+	if (fuse_parse_cmdline(&args, &opts) != 0) {
+		LEVEL_DEFAULT("Cannot parse the FUSE options");
+		return 1;
+	}
+	if (opts.mountpoint == NULL) {
+		LEVEL_DEFAULT("No FUSE mount point");
+		fuse_opt_free_args(&args);
+		return 1;
+	}
+
+	se = fuse_session_new(&args, &owfs_lowlevel_oper, sizeof(owfs_lowlevel_oper), NULL);
+	if (se == NULL) {
+		LEVEL_DEFAULT("Cannot start a FUSE session");
+	} else {
+		if (fuse_set_signal_handlers(se) != 0) {
+			LEVEL_DEFAULT("Cannot set FUSE signal handlers");
+		} else {
+			if (fuse_session_mount(se, opts.mountpoint) != 0) {
+				LEVEL_DEFAULT("Cannot mount on %s", opts.mountpoint);
+			} else {
+				fuse_daemonize(opts.foreground);
+				if (opts.singlethread) {
+					ret = fuse_session_loop(se);
+				} else {
+					ret = fuse_session_loop_mt(se, opts.clone_fd);
+				}
+				fuse_session_unmount(se);
+			}
+			fuse_remove_signal_handlers(se);
+		}
+		fuse_session_destroy(se);
+	}
+
+	free(opts.mountpoint);		// allocated by fuse with malloc, not owmalloc
+	fuse_opt_free_args(&args);
+	return ret;
+}
+
+/* ---------------------------------------------- */
+/* Inodes                                         */
+/* ---------------------------------------------- */
+static int node_compare(const void *a, const void *b)
+{
+	return strcmp(((const struct owfs_node *) a)->path, ((const struct owfs_node *) b)->path);
+}
+
+/* inode number is the node address, except the root */
+static struct owfs_node *Node(fuse_ino_t ino)
+{
+	if (ino == FUSE_ROOT_ID) {
+		return &root_node;
+	}
+	return (struct owfs_node *) (uintptr_t) ino;
+}
+
+static fuse_ino_t Node_ino(struct owfs_node *node)
+{
+	if (node == &root_node) {
+		return FUSE_ROOT_ID;
+	}
+	return (fuse_ino_t) (uintptr_t) node;
+}
+
+/* Find or make the node for path and count a kernel reference */
+static struct owfs_node *Node_lookup(const char *path)
+{
+	struct owfs_node key;
+	struct owfs_node *node = NULL;
+	void *found;
+
+	if (strcmp(path, "/") == 0) {
+		return &root_node;
+	}
+
+	key.path = (char *) (uintptr_t) path;
+	NODELOCK;
+	found = tfind(&key, &node_tree, node_compare);
+	if (found != NULL) {
+		node = *(struct owfs_node **) found;
+	} else {
+		node = owmalloc(sizeof(struct owfs_node));
+		if (node != NULL) {
+			node->path = owstrdup(path);
+			node->nlookup = 0;
+			if (node->path == NULL || tsearch(node, &node_tree, node_compare) == NULL) {
+				SAFEFREE(node->path);
+				owfree(node);
+				node = NULL;
+			}
+		}
+	}
+	if (node != NULL) {
+		++node->nlookup;
+	}
+	NODEUNLOCK;
+	return node;
+}
+
+/* Kernel dropped references, free the node once none are left */
+static void Node_forget(fuse_ino_t ino, uint64_t nlookup)
+{
+	struct owfs_node *node = Node(ino);
+
+	if (node == &root_node) {
+		return;
+	}
+	NODELOCK;
+	if (node->nlookup > nlookup) {
+		node->nlookup -= nlookup;
+	} else {
+		tdelete(node, &node_tree, node_compare);
+		owfree(node->path);
+		owfree(node);
+	}
+	NODEUNLOCK;
+}
+
+/* Path of a directory entry */
+static char *Node_child(const struct owfs_node *parent, const char *name)
+{
+	size_t parent_length = strlen(parent->path);
+	char *path = owmalloc(parent_length + strlen(name) + 2);
+
+	if (path != NULL) {
+		if (parent_length > 0 && parent->path[parent_length - 1] == '/') {
+			// root
+			--parent_length;
+		}
+		memcpy(path, parent->path, parent_length);
+		path[parent_length] = '/';
+		strcpy(&path[parent_length + 1], name);
+	}
+	return path;
+}
+
+/* Attributes and timeouts for path, node counted */
+static ZERO_OR_ERROR Node_entry(const char *path, struct fuse_entry_param *e)
+{
+	struct parsedname pn;
+	struct owfs_node *node;
+	ZERO_OR_ERROR ret;
+
+	memset(e, 0, sizeof(struct fuse_entry_param));
+	if (FS_ParsedName(path, &pn) != 0) {
+		return -ENOENT;
+	}
+	ret = FS_fstat_postparse(&e->attr, &pn);
+	if (ret == 0) {
+		e->attr_timeout = e->entry_timeout = Cache_Lifespan(&pn);
+	}
+	FS_ParsedName_destroy(&pn);
+	if (ret != 0) {
+		return ret;
+	}
+
+	node = Node_lookup(path);
+	if (node == NULL) {
+		return -ENOMEM;
+	}
+	e->ino = e->attr.st_ino = Node_ino(node);
+	return 0;
+}
+
+/* ---------------------------------------------- */
+/* Filesystem callback functions                  */
+/* ---------------------------------------------- */
+static void LL_init(void *userdata, struct fuse_conn_info *conn)
+{
+	(void) userdata;
+	(void) conn;
+	PIDstart();
+	Announce_Systemd();
+}
+
+static void LL_lookup(fuse_req_t req, fuse_ino_t parent, const char *name)
+{
+	struct fuse_entry_param e;
+	char *path = Node_child(Node(parent), name);
+	ZERO_OR_ERROR ret;
+
+	if (path == NULL) {
+		fuse_reply_err(req, ENOMEM);
+		return;
+	}
+	LEVEL_CALL("LOOKUP path=%s", path);
+	ret = Node_entry(path, &e);
+	owfree(path);
+	if (ret != 0) {
+		fuse_reply_err(req, -ret);
+	} else {
+		fuse_reply_entry(req, &e);
+	}
+}
+
+static void LL_forget(fuse_req_t req, fuse_ino_t ino, uint64_t nlookup)
+{
+	Node_forget(ino, nlookup);
+	fuse_reply_none(req);
+}
+
+static void LL_forget_multi(fuse_req_t req, size_t count, struct fuse_forget_data *forgets)
+{
+	size_t i;
+
+	for (i = 0; i < count; ++i) {
+		Node_forget(forgets[i].ino, forgets[i].nlookup);
+	}
+	fuse_reply_none(req);
+}
+
+static void LL_getattr(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *file_info)
+{
+	struct owfs_node *node = Node(ino);
+	struct parsedname pn;
+	struct stat st;
+	ZERO_OR_ERROR ret;
+	time_t lifespan = 0;
+
+	(void) file_info;
+	LEVEL_CALL("GETATTR path=%s", node->path);
+	if (FS_ParsedName(node->path, &pn) != 0) {
+		fuse_reply_err(req, ENOENT);
+		return;
+	}
+	ret = FS_fstat_postparse(&st, &pn);
+	if (ret == 0) {
+		lifespan = Cache_Lifespan(&pn);
+	}
+	FS_ParsedName_destroy(&pn);
+
+	if (ret != 0) {
+		fuse_reply_err(req, -ret);
+	} else {
+		st.st_ino = ino;
+		fuse_reply_attr(req, &st, lifespan);
+	}
+}
+
+/* Needed for "SETATTR" (truncate, chmod, chown, utime) -- nothing to change */
+static void LL_setattr(fuse_req_t req, fuse_ino_t ino, struct stat *attr, int to_set, struct fuse_file_info *file_info)
+{
+	LEVEL_CALL("SETATTR path=%s", Node(ino)->path);
+	(void) attr;
+	(void) to_set;
+	LL_getattr(req, ino, file_info);
+}
+
+/* Parse once, the query is kept in the file handle until release */
+static void LL_open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *file_info)
+{
+	struct owfs_handle *oh;
+	ZERO_OR_ERROR open_return;
+
+	LEVEL_CALL("OPEN path=%s", Node(ino)->path);
+	open_return = Handle_open(Node(ino)->path, &oh);
+	if (open_return < 0) {
+		fuse_reply_err(req, -open_return);
+		return;
+	}
+	file_info->fh = Handle_fh(oh);
+	// values are not a fixed length, don't let the page cache guess
+	file_info->direct_io = 1;
+	if (fuse_reply_open(req, file_info) != 0) {
+		// interrupted, no release will come
+		Handle_release(oh);
+	}
+}
+
+static void LL_read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, struct fuse_file_info *file_info)
+{
+	char *buffer;
+	SIZE_OR_ERROR return_size;
+
+	(void) ino;
+	if (size > MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE) {
+		// trimmed by Handle_read as well
+		size = MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE;
+	}
+	buffer = owmalloc(size);
+	if (buffer == NULL) {
+		fuse_reply_err(req, ENOMEM);
+		return;
+	}
+	return_size = Handle_read(Handle(file_info->fh), buffer, size, offset);
+	if (return_size < 0) {
+		fuse_reply_err(req, -return_size);
+	} else {
+		fuse_reply_buf(req, buffer, return_size);
+	}
+	owfree(buffer);
+}
+
+static void LL_write(fuse_req_t req, fuse_ino_t ino, const char *buffer, size_t size, off_t offset, struct fuse_file_info *file_info)
+{
+	SIZE_OR_ERROR write_return = Handle_write(Handle(file_info->fh), buffer, size, offset);
+
+	(void) ino;
+	if (write_return < 0) {
+		fuse_reply_err(req, -write_return);
+	} else {
+		fuse_reply_write(req, write_return);
+	}
+}
+
+static void LL_release(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *file_info)
+{
+	LEVEL_CALL("RELEASE path=%s", Node(ino)->path);
+	Handle_release(Handle(file_info->fh));
+	fuse_reply_err(req, 0);
+}
+
+/* Wait for the value to change, see owfs_handle.c */
+static void LL_poll(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *file_info, struct fuse_pollhandle *ph)
+{
+	LEVEL_CALL("POLL path=%s", Node(ino)->path);
+	fuse_reply_poll(req, Handle_poll(Handle(file_info->fh), ph));
+}
+
+/* Listing taken once at open, handed out in pieces */
+static void LL_opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *file_info)
+{
+	struct owfs_node *node = Node(ino);
+	struct owfs_dir *od;
+	struct parsedname pn;
+	struct stat st;
+
+	LEVEL_CALL("OPENDIR path=%s", node->path);
+	if (FS_ParsedName(node->path, &pn) != 0) {
+		fuse_reply_err(req, ENOENT);
+		return;
+	}
+	if (pn.selected_filetype != NO_FILETYPE && !IsDir(&pn)) {
+		FS_ParsedName_destroy(&pn);
+		fuse_reply_err(req, ENOTDIR);
+		return;
+	}
+	od = owcalloc(1, sizeof(struct owfs_dir));
+	if (od == NULL) {
+		FS_ParsedName_destroy(&pn);
+		fuse_reply_err(req, ENOMEM);
+		return;
+	}
+
+	// "." and ".." need only the type
+	memset(&st, 0, sizeof(struct stat));
+	st.st_mode = S_IFDIR;
+	Dir_add(od, ".", &st, 0);
+	Dir_add(od, "..", &st, 0);
+	FS_dir(Dir_callback, od, &pn);
+	FS_ParsedName_destroy(&pn);
+
+	file_info->fh = (uint64_t) (uintptr_t) od;
+	if (fuse_reply_open(req, file_info) != 0) {
+		Dir_free(od);
+	}
+}
+
+static void Dir_callback(void *v, const struct parsedname *pn_entry)
+{
+	struct owfs_dir *od = v;
+	struct stat st;
+
+	if (FS_fstat_postparse(&st, pn_entry) == 0) {
+		Dir_add(od, FS_DirName(pn_entry), &st, Cache_Lifespan(pn_entry));
+	}
+}
+
+static void Dir_add(struct owfs_dir *od, const char *name, const struct stat *st, time_t lifespan)
+{
+	struct owfs_dirent *ode;
+
+	if (od->count == od->allocated) {
+		int allocated = (od->allocated == 0) ? 32 : 2 * od->allocated;
+		struct owfs_dirent *entries = owrealloc(od->entries, allocated * sizeof(struct owfs_dirent));
+		if (entries == NULL) {
+			return;
+		}
+		od->entries = entries;
+		od->allocated = allocated;
+	}
+	ode = &od->entries[od->count];
+	ode->name = owstrdup(name);
+	if (ode->name == NULL) {
+		return;
+	}
+	memcpy(&ode->st, st, sizeof(struct stat));
+	ode->lifespan = lifespan;
+	++od->count;
+}
+
+static void Dir_free(struct owfs_dir *od)
+{
+	int i;
+
+	for (i = 0; i < od->count; ++i) {
+		owfree(od->entries[i].name);
+	}
+	SAFEFREE(od->entries);
+	owfree(od);
+}
+
+/* Entries from offset on, as many as fit. With plus each counts as a lookup */
+static void LL_readdir_common(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, struct fuse_file_info *file_info, int plus)
+{
+	struct owfs_dir *od = (struct owfs_dir *) (uintptr_t) file_info->fh;
+	struct owfs_node *node = Node(ino);
+	char *buffer = owmalloc(size);
+	size_t used = 0;
+	int i;
+
+	if (buffer == NULL) {
+		fuse_reply_err(req, ENOMEM);
+		return;
+	}
+
+	for (i = offset; i < od->count; ++i) {
+		struct owfs_dirent *ode = &od->entries[i];
+		size_t entry_size;
+
+		if (!plus) {
+			entry_size = fuse_add_direntry(req, &buffer[used], size - used, ode->name, &ode->st, i + 1);
+		} else if (i < 2) {
+			// "." and ".." -- no lookup counted
+			struct fuse_entry_param e;
+			memset(&e, 0, sizeof(struct fuse_entry_param));
+			e.attr.st_mode = ode->st.st_mode;
+			entry_size = fuse_add_direntry_plus(req, &buffer[used], size - used, ode->name, &e, i + 1);
+		} else {
+			struct fuse_entry_param e;
+			char *path = Node_child(node, ode->name);
+			struct owfs_node *child = (path == NULL) ? NULL : Node_lookup(path);
+
+			SAFEFREE(path);
+			if (child == NULL) {
+				break;
+			}
+			memset(&e, 0, sizeof(struct fuse_entry_param));
+			memcpy(&e.attr, &ode->st, sizeof(struct stat));
+			e.ino = e.attr.st_ino = Node_ino(child);
+			e.attr_timeout = e.entry_timeout = ode->lifespan;
+			entry_size = fuse_add_direntry_plus(req, &buffer[used], size - used, ode->name, &e, i + 1);
+			if (entry_size > size - used) {
+				// didn't fit, not handed to the kernel after all
+				Node_forget(e.ino, 1);
+			}
+		}
+		if (entry_size > size - used) {
+			break;
+		}
+		used += entry_size;
+	}
+
+	fuse_reply_buf(req, buffer, used);
+	owfree(buffer);
+}
+
+static void LL_readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, struct fuse_file_info *file_info)
+{
+	LL_readdir_common(req, ino, size, offset, file_info, 0);
+}
+
+static void LL_readdirplus(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, struct fuse_file_info *file_info)
+{
+	LL_readdir_common(req, ino, size, offset, file_info, 1);
+}
+
+static void LL_releasedir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *file_info)
+{
+	(void) ino;
+	Dir_free((struct owfs_dir *) (uintptr_t) file_info->fh);
+	fuse_reply_err(req, 0);
+}
+
+#endif							/* OWFS_FUSE3 */
@@ -22,7 +22,12 @@
 
 //#define FUSE_USE_VERSION 26
 // FUSE_USE_VERSION is set from configure script
+#ifdef OWFS_FUSE3
+/* FUSE 3 -- low-level API, see owfs_lowlevel.c */
+#include <fuse3/fuse_lowlevel.h>
+#else							/* OWFS_FUSE3 */
 #include <fuse.h>
+#endif							/* OWFS_FUSE3 */
 #ifndef FUSE_VERSION
 #ifndef FUSE_MAJOR_VERSION
 #define FUSE_VERSION 11
@@ -33,7 +38,6 @@
 #endif							/* FUSE_MAJOR_VERSION */
 #endif							/* FUSE_VERSION */
 
-extern struct fuse_operations owfs_oper;
 
 struct Fuse_option {
 	int allocated_slots;
@@ -41,6 +45,26 @@ struct Fuse_option {
 	int argc;
 };
 
+#ifdef OWFS_FUSE3
+int Fuse_lowlevel_main(struct Fuse_option *fo);
+#else							/* OWFS_FUSE3 */
+extern struct fuse_operations owfs_oper;
+#endif							/* OWFS_FUSE3 */
+
+/* Open file, see owfs_handle.c */
+struct owfs_handle;
+ZERO_OR_ERROR Handle_open(const char *path, struct owfs_handle **handle);
+SIZE_OR_ERROR Handle_read(struct owfs_handle *oh, char *buffer, size_t size, off_t offset);
+SIZE_OR_ERROR Handle_write(struct owfs_handle *oh, const char *buffer, size_t size, off_t offset);
+void Handle_release(struct owfs_handle *oh);
+#if defined(OWFS_FUSE3) || FUSE_VERSION > 27
+/* poll() on open files, from FUSE 2.8 */
+#define OWFS_POLL
+unsigned int Handle_poll(struct owfs_handle *oh, struct fuse_pollhandle *ph);
+#endif							/* FUSE_VERSION > 27 */
+#define Handle_fh(oh)  ((uint64_t) (uintptr_t) (oh))
+#define Handle(fh)     ((struct owfs_handle *) (uintptr_t) (fh))
+
 int Fuse_setup(struct Fuse_option *fo);
 void Fuse_cleanup(struct Fuse_option *fo);
 int Fuse_parse(char *opts, struct Fuse_option *fo);
@@ -23,8 +23,11 @@ char *alloca();
 # endif
 #endif
 
-static void fdprintf(FILE_DESCRIPTOR_OR_ERROR file_descriptor, const char *fmt, ...);
-static void List_show(struct file_parse_s *fps, const struct parsedname *pn);
+/* listing is sent in pieces about this size */
+#define LIST_FLUSH 4096
+
+static void listprintf(struct file_parse_s *fps, const char *fmt, ...);
+static void List_show(struct file_parse_s *fps, const struct parsedname *pn, const ASCII * name);
 static void WildLexParse(struct file_parse_s *fps, ASCII * match);
 static char *skip_ls_options(char *filespec);
 
@@ -43,7 +46,8 @@ struct tm *localtime_r(const time_t * timep, struct tm *timeptr)
 }
 #endif							/* HAVE_LOCALTIME_R */
 
-static void List_show(struct file_parse_s *fps, const struct parsedname *pn)
+/* name is the part of the path shown */
+static void List_show(struct file_parse_s *fps, const struct parsedname *pn, const ASCII * name)
 {
 	struct stat stbuf;
 	time_t now;
@@ -61,12 +65,16 @@ static void List_show(struct file_parse_s *fps, const struct parsedname *pn)
 		"rwxrwxrwx",
 	};
 	LEVEL_DEBUG("List_show %s", pn->path);
+	if (!MemblobPure(fps->list)) {
+		// data connection already failed
+		return;
+	}
 	switch (fps->fle) {
 		case file_list_list:
 			FS_fstat_postparse(&stbuf, pn);
-			fdprintf(fps->out, "%s%s", stbuf.st_mode & S_IFDIR ? "d" : "-", perms[stbuf.st_mode & 0x07]);
+			listprintf(fps, "%s%s", stbuf.st_mode & S_IFDIR ? "d" : "-", perms[stbuf.st_mode & 0x07]);
 			/* fps->output link & ownership information */
-			fdprintf(fps->out, " %3d %-8d %-8d %8lu ", stbuf.st_nlink, stbuf.st_uid, stbuf.st_gid, (unsigned long) stbuf.st_size);
+			listprintf(fps, " %3d %-8d %-8d %8lu ", stbuf.st_nlink, stbuf.st_uid, stbuf.st_gid, (unsigned long) stbuf.st_size);
 			/* fps->output date */
 			time(&now);
 			localtime_r(&stbuf.st_mtime, &tm_now);
@@ -77,12 +85,39 @@ static void List_show(struct file_parse_s *fps, const struct parsedname *pn)
 			} else {
 				strftime(date_buf, sizeof(date_buf), "%b %e %H:%M", &tm_now);
 			}
-			fdprintf(fps->out, "%s ", date_buf);
+			listprintf(fps, "%s ", date_buf);
 			/* Fall Through */
 		case file_list_nlst:
 			/* fps->output filename */
-			fdprintf(fps->out, "%s\r\n", &pn->path[fps->start]);
+			listprintf(fps, "%s\r\n", name);
+	}
+	if (MemblobLength(fps->list) >= LIST_FLUSH) {
+		FileListFlush(fps);
+	}
+}
+
+/* send what is listed so far. A failed write stops the listing */
+void FileListFlush(struct file_parse_s *fps)
+{
+	struct memblob *mb = fps->list;
+	size_t amt_written = 0;
+	size_t buflen = MemblobLength(mb);
+
+	if (!MemblobPure(mb)) {
+		fps->ret = -EIO;
+		return;
+	}
+	while (amt_written < buflen) {
+		ssize_t write_ret = write(fps->out, MemblobData(mb) + amt_written, buflen - amt_written);
+		if (write_ret <= 0) {
+			ERROR_DATA("FTP listing not sent");
+			mb->troubled = 1;
+			fps->ret = -EIO;
+			return;
+		}
+		amt_written += write_ret;
 	}
+	MemblobTrim(buflen, mb);
 }
 
 void FileLexParse(struct file_parse_s *fps)
@@ -196,7 +231,7 @@ void FileLexParse(struct file_parse_s *fps)
 					fps->rest = NULL;
 					WildLexParse(fps, "*");
 				} else {
-					List_show(fps, &pn);
+					List_show(fps, &pn, &pn.path[fps->start]);
 				}
 				FS_ParsedName_destroy(&pn);
 			} else {
@@ -212,7 +247,7 @@ void FileLexParse(struct file_parse_s *fps)
 				return;
 			}
 			if (FS_ParsedNamePlus(fps->buffer, fps->rest, &pn) == 0) {
-				List_show(fps, &pn);
+				List_show(fps, &pn, &pn.path[fps->start]);
 				FS_ParsedName_destroy(&pn);
 			}
 			return;
@@ -240,6 +275,13 @@ static void WildLexParseCallback(void *v, const struct parsedname *const pn_entr
 		return;
 	}
 
+	/* Matched and nothing more to the path -- the directory pass already
+	   parsed this entry, so list it as is */
+	if (wlp->fps->rest == NULL || wlp->fps->rest[0] == '\0') {
+		List_show(wlp->fps, pn_entry, &wlp->fps->buffer[wlp->fps->start]);
+		return;
+	}
+
 	/* Matched! So set up for recursive call on nect elements in path name */
 	memcpy(&fps, wlp->fps, sizeof(fps));
 	fps.pse = parse_status_next;
@@ -290,16 +332,13 @@ static void WildLexParse(struct file_parse_s *fps, ASCII * match)
 
 }
 
-/* write with care for max length and incomplete outout */
-static void fdprintf(FILE_DESCRIPTOR_OR_ERROR file_descriptor, const char *fmt, ...)
+/* add to the listing with care for max length */
+static void listprintf(struct file_parse_s *fps, const char *fmt, ...)
 {
 	char buf[PATH_MAX + 1];
 	ssize_t buflen;
 	va_list ap;
-	int amt_written;
-	int write_ret;
 
-	daemon_assert(FILE_DESCRIPTOR_VALID(file_descriptor));
 	daemon_assert(fmt != NULL);
 
 	va_start(ap, fmt);
@@ -311,15 +350,7 @@ static void fdprintf(FILE_DESCRIPTOR_OR_ERROR file_descriptor, const char *fmt,
 	if ((size_t) buflen >= sizeof(buf)) {
 		buflen = sizeof(buf) - 1;
 	}
-
-	amt_written = 0;
-	while (amt_written < buflen) {
-		write_ret = write(file_descriptor, buf + amt_written, buflen - amt_written);
-		if (write_ret <= 0) {
-			return;
-		}
-		amt_written += write_ret;
-	}
+	MemblobAdd((BYTE *) buf, buflen, fps->list);
 }
 
 /* 
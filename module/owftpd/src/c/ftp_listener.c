@@ -5,17 +5,27 @@
 
 /*
  
-This is the code that waits for client connections and creates the
-threads that handle them.  When ftp_listener_init() is called, it binds
-to the appropriate socket and sets up the other values for the
-structure.  Then, when ftp_listener_start() is called, a thread is
-started dedicatd to accepting connections.
-
-This thread waits for input on two file descriptors.  If input arrives
-on the socket, then it accepts the connection and creates a thread to
-handle it.  If input arrives on the shutdown_request pipe, then the
-thread terminates.  This is how ftp_listener_stop() signals the listener
-to end.
+This is the code that waits for client connections and runs their
+commands.  When ftp_listener_init() is called, it binds to the
+appropriate socket and sets up the other values for the structure.
+Then, when ftp_listener_start() is called, one thread is started to
+watch every socket, and a fixed pool of workers to run commands.
+
+The watching thread waits for input on the listening socket, the
+shutdown_request pipe, and the control connection of every session
+that isn't running a command.  A new connection is accepted and greeted
+there, and so are commands that need neither the bus nor a data
+connection (USER, PASS, PWD, TYPE, NOOP, QUIT, PASV, PORT ...), so a
+busy pool never holds up a login or a QUIT.  Any other command line is
+handed to a worker.  Only the workers read or write the 1-wire bus, so
+a listing or a bulk RETR of device memory ties up one worker, not a
+thread per connection.  A session with nothing to do for the inactivity
+timeout is closed.
+
+If input arrives on the shutdown_request pipe, the listening socket is
+closed, idle sessions are closed, and the thread ends once commands
+still running are done.  This is how ftp_listener_stop() signals the
+listener to end.
 
 */
 
@@ -35,17 +45,41 @@ struct connection_info_s {
 	struct ftp_listener_s *ftp_listener;
 	struct telnet_session_s telnet_session;
 	struct ftp_session_s ftp_session;
-	struct watched_s watched;
 
-	struct connection_info *next;
+	/* command line for a worker */
+	char line[BUF_LEN];
+
+	int counted;				// in num_connections
+	int working;				// listener only -- a worker has the job
+	int done;					// job finished, under the listener mutex
+	time_t last_active;
+
+	struct connection_info_s *next;	// listener's list
+	struct connection_info_s *next_job;	// worker queue
 };
 
+static pthread_mutex_t job_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_cond = PTHREAD_COND_INITIALIZER;
+
+#define JOBLOCK        _MUTEX_LOCK(   job_mutex )
+#define JOBUNLOCK      _MUTEX_UNLOCK( job_mutex )
+#define JOBWAIT        my_pthread_cond_wait(   &job_cond, &job_mutex )
+#define JOBSIGNAL      my_pthread_cond_signal( &job_cond )
+
+static struct connection_info_s *job_head = NULL;
+static struct connection_info_s *job_tail = NULL;
+
 /* prototypes */
 static int invariant(const struct ftp_listener_s *f);
 static void *connection_acceptor(void *v);
 static char *addr2string(const sockaddr_storage_t * s);
-static void *connection_handler(void *v);
-static void connection_handler_cleanup(void *v);
+static GOOD_OR_BAD connection_accept(struct ftp_listener_s *f, struct connection_info_s **list);
+static int connection_read(struct connection_info_s *info);
+static int connection_open(struct connection_info_s *info);
+static void connection_dispatch(struct connection_info_s *info);
+static void *connection_worker(void *v);
+static void connection_wake(struct ftp_listener_s *f);
+static void connection_close(struct connection_info_s *info);
 
 /* initialize an FTP listener */
 /* ftp uses 0 as an error return */
@@ -100,6 +134,16 @@ int ftp_listener_init(struct ftp_listener_s *f)
 		ERROR_CONNECT("Error creating pipe for internal use");
 		return 0;
 	}
+
+	/* and one for workers done with a job, never blocking them */
+	if (pipe(f->wake_fd) != 0) {
+		ERROR_CONNECT("Error creating pipe for internal use");
+		return 0;
+	}
+	if (fcntl(f->wake_fd[fd_pipe_read], F_SETFL, O_NONBLOCK) != 0 || fcntl(f->wake_fd[fd_pipe_write], F_SETFL, O_NONBLOCK) != 0) {
+		ERROR_CONNECT("Error setting pipe to non-blocking");
+		return 0;
+	}
 //	fcntl (f->shutdown_request_fd[fd_pipe_read], F_SETFD, FD_CLOEXEC); // for safe forking
 //	fcntl (f->shutdown_request_fd[fd_pipe_write], F_SETFD, FD_CLOEXEC); // for safe forking
 
@@ -126,9 +170,24 @@ int ftp_listener_start(struct ftp_listener_s *f)
 	pthread_t thread_id;
 	int ret_val;
 	int error_code;
+	int worker;
 
 	daemon_assert(invariant(f));
 
+	for (worker = 0; worker < Globals.ftp_workers; ++worker) {
+		error_code = pthread_create(&thread_id, DEFAULT_THREAD_ATTR, connection_worker, f);
+		if (error_code != 0) {
+			if (worker == 0) {
+				errno = error_code;
+				ERROR_CONNECT("Unable to create worker threads");
+				return 0;
+			}
+			LEVEL_CONNECT("Only %d FTP worker threads started", worker);
+			break;
+		}
+	}
+	LEVEL_DEBUG("FTP listener with %d workers", worker);
+
 	error_code = pthread_create(&thread_id, DEFAULT_THREAD_ATTR, connection_acceptor, f);
 
 	if (error_code == 0) {
@@ -179,111 +238,301 @@ static int invariant(const struct ftp_listener_s *f)
 }
 #endif							/* NDEBUG */
 
-/* handle incoming connections */
+/* watch the listening socket and every idle session */
 static void *connection_acceptor(void *v)
 {
 	struct ftp_listener_s *f = (struct ftp_listener_s *) v;
+	struct connection_info_s *list = NULL;
+	int listening = 1;
 	int num_error;
 
+	daemon_assert(invariant(f));
+
+	num_error = 0;
+	while (listening || list != NULL) {
+		fd_set readfds;
+		FILE_DESCRIPTOR_OR_ERROR maxfd = f->wake_fd[fd_pipe_read];
+		struct timeval tv = { 1, 0, };	// for inactivity timeouts
+		struct connection_info_s **link;
+		struct connection_info_s *info;
+		time_t now;
+
+		/* wait for something to happen */
+		FD_ZERO(&readfds);
+		FD_SET(f->wake_fd[fd_pipe_read], &readfds);
+		if (listening) {
+			FD_SET(f->file_descriptor, &readfds);
+			FD_SET(f->shutdown_request_fd[fd_pipe_read], &readfds);
+			if (f->file_descriptor > maxfd) {
+				maxfd = f->file_descriptor;
+			}
+			if (f->shutdown_request_fd[fd_pipe_read] > maxfd) {
+				maxfd = f->shutdown_request_fd[fd_pipe_read];
+			}
+		}
+		for (info = list; info != NULL; info = info->next) {
+			if (!info->working) {
+				FD_SET(info->telnet_session.in_fd, &readfds);
+				if (info->telnet_session.in_fd > maxfd) {
+					maxfd = info->telnet_session.in_fd;
+				}
+			}
+		}
+		if (select(maxfd + 1, &readfds, NULL, NULL, &tv) < 0) {
+			if (errno != EINTR) {
+				ERROR_CONNECT("FTP listener select");
+			}
+			continue;
+		}
+
+		if (FD_ISSET(f->wake_fd[fd_pipe_read], &readfds)) {
+			char drain[64];
+			while (read(f->wake_fd[fd_pipe_read], drain, sizeof(drain)) > 0) {
+			}
+		}
+
+		if (listening) {
+			if (FD_ISSET(f->shutdown_request_fd[fd_pipe_read], &readfds)) {
+				/* data arrived on our pipe, we've been asked to exit */
+				Test_and_Close( & f->file_descriptor);
+				listening = 0;
+				LEVEL_CONNECT("Listener no longer accepting connections");
+			} else if (FD_ISSET(f->file_descriptor, &readfds)) {
+				/* accept our pending connection (if any) */
+				if (GOOD(connection_accept(f, &list))) {
+					num_error = 0;
+				} else if (++num_error >= MAX_ACCEPT_ERROR) {
+					LEVEL_CONNECT("Too many consecutive errors, FTP server exiting");
+					Test_and_Close( & f->file_descriptor);
+					listening = 0;
+				}
+			}
+		}
+
+		now = NOW_TIME;
+		link = &list;
+		while (*link != NULL) {
+			int keep = 1;
+
+			info = *link;
+			if (info->working) {
+				int done;
+
+				_MUTEX_LOCK(f->mutex);
+				done = info->done;
+				_MUTEX_UNLOCK(f->mutex);
+				if (done) {
+					info->working = 0;
+					info->done = 0;
+					info->last_active = now;
+					if (!connection_open(info)) {
+						keep = 0;
+					} else if (listening) {
+						// the client may have sent more already
+						keep = connection_read(info);
+					} else {
+						keep = 0;
+					}
+				}
+			} else if (!listening) {
+				keep = 0;
+			} else if (FD_ISSET(info->telnet_session.in_fd, &readfds)) {
+				info->last_active = now;
+				keep = connection_read(info);
+			} else if (now - info->last_active > f->inactivity_timeout) {
+				LEVEL_CONNECT("%s inactive for %d seconds", info->ftp_session.client_addr_str, f->inactivity_timeout);
+				keep = 0;
+			}
+
+			if (keep) {
+				link = &info->next;
+			} else {
+				*link = info->next;
+				connection_close(info);
+			}
+		}
+	}
+
+	_MUTEX_LOCK(f->mutex);
+	f->listener_running = 0;
+	pthread_cond_signal(&f->shutdown_cond);
+	_MUTEX_UNLOCK(f->mutex);
+	return VOID_RETURN;
+}
+
+/* take a new connection, greet it (or turn it away) */
+static GOOD_OR_BAD connection_accept(struct ftp_listener_s *f, struct connection_info_s **list)
+{
 	FILE_DESCRIPTOR_OR_ERROR file_descriptor;
 	int tcp_nodelay;
 	sockaddr_storage_t client_addr;
 	sockaddr_storage_t server_addr;
 	unsigned addr_len;
-
 	struct connection_info_s *info;
-	pthread_t thread_id;
-	int error_code;
 
-	fd_set readfds;
+	addr_len = sizeof(sockaddr_storage_t);
+	file_descriptor = accept(f->file_descriptor, (struct sockaddr *) &client_addr, &addr_len);
+	if (FILE_DESCRIPTOR_NOT_VALID(file_descriptor)) {
+		if ((errno == ECONNABORTED) || (errno == ECONNRESET) || (errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+			ERROR_CONNECT("Interruption accepting FTP connection");
+			return gbGOOD;
+		}
+		ERROR_CONNECT("Error accepting FTP connection");
+		return gbBAD;
+	}
 
-	daemon_assert(invariant(f));
+	if (file_descriptor >= FD_SETSIZE) {
+		LEVEL_CONNECT("Too many open files, FTP server dropping connection");
+		Test_and_Close( & file_descriptor);
+		return gbGOOD;
+	}
 
-	if (!watchdog_init(&f->watchdog, f->inactivity_timeout)) {
-		LEVEL_CONNECT("Error initializing watchdog thread");
-		return VOID_RETURN;
+	tcp_nodelay = 1;
+	if (setsockopt(file_descriptor, IPPROTO_TCP, TCP_NODELAY, (void *) &tcp_nodelay, sizeof(int)) != 0) {
+		ERROR_CONNECT("Error in setsockopt(), FTP server dropping connection");
+		Test_and_Close( & file_descriptor);
+		return gbGOOD;
 	}
 
-	num_error = 0;
-	for (;;) {
+	addr_len = sizeof(sockaddr_storage_t);
+	if (getsockname(file_descriptor, (struct sockaddr *) &server_addr, &addr_len) == -1) {
+		ERROR_CONNECT("Error in getsockname(), FTP server dropping connection");
+		Test_and_Close( & file_descriptor);
+		return gbGOOD;
+	}
 
-		/* wait for something to happen */
-		FD_ZERO(&readfds);
-		FD_SET(f->file_descriptor, &readfds);
-		FD_SET(f->shutdown_request_fd[fd_pipe_read], &readfds);
-		select(FD_SETSIZE, &readfds, NULL, NULL, NULL);
-
-		/* if data arrived on our pipe, we've been asked to exit */
-		if (FD_ISSET(f->shutdown_request_fd[fd_pipe_read], &readfds)) {
-			Test_and_Close( & f->file_descriptor);
-			LEVEL_CONNECT("Listener no longer accepting connections");
-			pthread_exit(NULL);
-			return VOID_RETURN;
-		}
+	info = (struct connection_info_s *) owcalloc(1, sizeof(struct connection_info_s));
+	if (info == NULL) {
+		LEVEL_CONNECT("Out of memory, FTP server dropping connection");
+		Test_and_Close( & file_descriptor);
+		return gbGOOD;
+	}
+	info->ftp_listener = f;
 
-		/* otherwise accept our pending connection (if any) */
-		addr_len = sizeof(sockaddr_storage_t);
-		file_descriptor = accept(f->file_descriptor, (struct sockaddr *) &client_addr, &addr_len);
-		if (FILE_DESCRIPTOR_VALID(file_descriptor)) {
-			tcp_nodelay = 1;
-			if (setsockopt(file_descriptor, IPPROTO_TCP, TCP_NODELAY, (void *) &tcp_nodelay, sizeof(int)) != 0) {
-				ERROR_CONNECT("Error in setsockopt(), FTP server dropping connection");
-				Test_and_Close( & file_descriptor);
-				continue;
-			}
+	telnet_session_init(&info->telnet_session, file_descriptor, file_descriptor);
 
-			addr_len = sizeof(sockaddr_storage_t);
-			if (getsockname(file_descriptor, (struct sockaddr *) &server_addr, &addr_len) == -1) {
-				ERROR_CONNECT("Error in getsockname(), FTP server dropping connection");
-				Test_and_Close( & file_descriptor);
-				continue;
-			}
+	if (!ftp_session_init(&info->ftp_session, &client_addr, &server_addr, &info->telnet_session, f->dir)) {
+		LEVEL_CONNECT("Error initializing FTP session, FTP server dropping connection");
+		telnet_session_destroy(&info->telnet_session);
+		owfree(info);
+		return gbGOOD;
+	}
 
-			info = (struct connection_info_s *) owmalloc(sizeof(struct connection_info_s));
-			if (info == NULL) {
-				LEVEL_CONNECT("Out of memory, FTP server dropping connection");
-				Test_and_Close( & file_descriptor);
-				continue;
-			}
-			info->ftp_listener = f;
+	/* process global data */
+	_MUTEX_LOCK(f->mutex);
+	if (f->num_connections < f->max_connections) {
+		++f->num_connections;
+		info->counted = 1;
+		ERROR_DEBUG("%s port %d connection", addr2string(&info->ftp_session.client_addr), ntohs(SINPORT(&info->ftp_session.client_addr)));
+	} else {
+		/* log the rejection */
+		LEVEL_CONNECT
+			("%s port %d exceeds max users (%d), dropping connection",
+			 addr2string(&info->ftp_session.client_addr), ntohs(SINPORT(&info->ftp_session.client_addr)), f->max_connections);
+	}
+	_MUTEX_UNLOCK(f->mutex);
 
-			telnet_session_init(&info->telnet_session, file_descriptor, file_descriptor);
+	if (!info->counted) {
+		/* too many users */
+		char drop_reason[80];
+		sprintf(drop_reason, "Too many users logged in, dropping connection (%d logins maximum)", f->max_connections);
+		ftp_session_drop(&info->ftp_session, drop_reason);
+		connection_close(info);
+		return gbGOOD;
+	}
+
+	ftp_session_hello(&info->ftp_session);
+	if (!connection_open(info)) {
+		connection_close(info);
+		return gbGOOD;
+	}
+	info->last_active = NOW_TIME;
+	info->next = *list;
+	*list = info;
+	return gbGOOD;
+}
 
-			if (!ftp_session_init(&info->ftp_session, &client_addr, &server_addr, &info->telnet_session, f->dir)) {
-				LEVEL_CONNECT("Eerror initializing FTP session, FTP server exiting");
-				close(file_descriptor);
-				telnet_session_destroy(&info->telnet_session);
-				owfree(info);
-				continue;
+/* answer the command lines that don't need the bus, hand the first one that does to a worker.
+ * Returns 0 if the connection is closed */
+static int connection_read(struct connection_info_s *info)
+{
+	for (;;) {
+		switch (telnet_session_readln(&info->telnet_session, info->line, sizeof(info->line))) {
+		case 1:
+			if (!ftp_session_quick(&info->ftp_session, info->line)) {
+				connection_dispatch(info);
+				return 1;
+			}
+			ftp_session_command(&info->ftp_session, info->line);
+			if (!connection_open(info)) {
+				// QUIT, or the client went away
+				return 0;
 			}
+			break;
+		case 0:
+			// rest of the line still to come
+			return 1;
+		default:
+			return 0;
+		}
+	}
+}
+
+/* still logged in and taking replies */
+static int connection_open(struct connection_info_s *info)
+{
+	return info->ftp_session.session_active && info->telnet_session.out_errno == 0 && info->telnet_session.out_eof == 0;
+}
+
+static void connection_dispatch(struct connection_info_s *info)
+{
+	info->working = 1;
+	info->next_job = NULL;
+	JOBLOCK;
+	if (job_tail == NULL) {
+		job_head = info;
+	} else {
+		job_tail->next_job = info;
+	}
+	job_tail = info;
+	JOBSIGNAL;
+	JOBUNLOCK;
+}
 
+/* the only threads reading the 1-wire bus for FTP clients */
+static void *connection_worker(void *v)
+{
+	struct ftp_listener_s *f = (struct ftp_listener_s *) v;
 
-			error_code = pthread_create(&thread_id, DEFAULT_THREAD_ATTR, connection_handler, info);
+	DETACH_THREAD;
 
-			if (error_code != 0) {
-				errno = error_code;
-				ERROR_CONNECT("Error creating new thread");
-				close(file_descriptor);
-				telnet_session_destroy(&info->telnet_session);
-				owfree(info);
-			}
+	for (;;) {
+		struct connection_info_s *info;
 
-			num_error = 0;
-		} else {
-			if ((errno == ECONNABORTED) || (errno == ECONNRESET)) {
-				ERROR_CONNECT("Interruption accepting FTP connection");
-			} else {
-				ERROR_CONNECT("Error accepting FTP connection");
-				++num_error;
-			}
-			if (num_error >= MAX_ACCEPT_ERROR) {
-				LEVEL_CONNECT("Too many consecutive errors, FTP server exiting");
-				return VOID_RETURN;
-			}
+		JOBLOCK;
+		while (job_head == NULL) {
+			JOBWAIT;
 		}
+		info = job_head;
+		job_head = info->next_job;
+		if (job_head == NULL) {
+			job_tail = NULL;
+		}
+		JOBUNLOCK;
+
+		ftp_session_command(&info->ftp_session, info->line);
+
+		_MUTEX_LOCK(f->mutex);
+		info->done = 1;
+		_MUTEX_UNLOCK(f->mutex);
+		connection_wake(f);
 	}
 	return VOID_RETURN;
+}
 
+static void connection_wake(struct ftp_listener_s *f)
+{
+	ignore_result = write(f->wake_fd[fd_pipe_write], "W", 1);	// full pipe is already awake
 }
 
 /* convert an address to a printable string */
@@ -314,75 +563,19 @@ static char *addr2string(const sockaddr_storage_t * s)
 }
 
 
-static void *connection_handler(void *v)
-{
-	struct connection_info_s *info = (struct connection_info_s *) v;
-	struct ftp_listener_s *f;
-	int num_connections;
-	char drop_reason[80];
-
-	/* for ease of use only */
-	f = info->ftp_listener;
-
-	/* don't save state for pthread_join() */
-	DETACH_THREAD;
-
-	/* set up our watchdog */
-	pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, NULL);
-	watchdog_add_watched(&f->watchdog, &info->watched);
-
-	/* set up our cleanup handler */
-	pthread_cleanup_push(connection_handler_cleanup, info);
-
-	/* process global data */
-	_MUTEX_LOCK(f->mutex);
-	num_connections = ++f->num_connections;
-	ERROR_DEBUG("%s port %d connection", addr2string(&info->ftp_session.client_addr), ntohs(SINPORT(&info->ftp_session.client_addr)));
-	_MUTEX_UNLOCK(f->mutex);
-
-	/* handle the session */
-	if (num_connections <= f->max_connections) {
-
-		ftp_session_run(&info->ftp_session, &info->watched);
-
-	} else {
-
-		/* too many users */
-		sprintf(drop_reason, "Too many users logged in, dropping connection (%d logins maximum)", f->max_connections);
-		ftp_session_drop(&info->ftp_session, drop_reason);
-
-		/* log the rejection */
-		_MUTEX_LOCK(f->mutex);
-		LEVEL_CONNECT
-			("%s port %d exceeds max users (%d), dropping connection",
-			 addr2string(&info->ftp_session.client_addr), ntohs(SINPORT(&info->ftp_session.client_addr)), num_connections);
-		_MUTEX_UNLOCK(f->mutex);
-
-	}
-
-	/* exunt (pop calls cleanup function) */
-	pthread_cleanup_pop(1);
-
-	/* return for form :) */
-	return VOID_RETURN;
-}
-
 /* clean up a connection */
-static void connection_handler_cleanup(void *v)
+static void connection_close(struct connection_info_s *info)
 {
-	struct connection_info_s *info = (struct connection_info_s *) v;
 	struct ftp_listener_s *f;
 
 	f = info->ftp_listener;
 
-	watchdog_remove_watched(&info->watched);
-
 	_MUTEX_LOCK(f->mutex);
 
-	f->num_connections--;
-	pthread_cond_signal(&f->shutdown_cond);
-
-	LEVEL_CONNECT("%s port %d disconnected", addr2string(&info->ftp_session.client_addr), ntohs(SINPORT(&info->ftp_session.client_addr)));
+	if (info->counted) {
+		f->num_connections--;
+		LEVEL_CONNECT("%s port %d disconnected", addr2string(&info->ftp_session.client_addr), ntohs(SINPORT(&info->ftp_session.client_addr)));
+	}
 
 	_MUTEX_UNLOCK(f->mutex);
 
@@ -405,9 +598,9 @@ void ftp_listener_stop(struct ftp_listener_s *f)
 #else
 	write(f->shutdown_request_fd[fd_pipe_write], "", 1);
 #endif
-	/* wait for client connections to complete */
+	/* wait for commands running to complete */
 	_MUTEX_LOCK(f->mutex);
-	while (f->num_connections > 0) {
+	while (f->listener_running) {
 		pthread_cond_wait(&f->shutdown_cond, &f->mutex);
 	}
 	_MUTEX_UNLOCK(f->mutex);
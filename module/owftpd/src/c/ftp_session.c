@@ -7,6 +7,7 @@
 #include <sys/utsname.h>
 #include <arpa/inet.h>
 #include <stdarg.h>
+#include <poll.h>
 
 /* space requirements */
 #define ADDRPORT_STRLEN 58
@@ -16,6 +17,7 @@ static int invariant(const struct ftp_session_s *f);
 static void reply(struct ftp_session_s *f, int code, const char *fmt, ...);
 static void change_dir(struct ftp_session_s *f, const char *new_dir);
 static FILE_DESCRIPTOR_OR_ERROR open_connection(struct ftp_session_s *f);
+static void data_timeout(FILE_DESCRIPTOR_OR_ERROR socket_fd);
 static int write_fully(FILE_DESCRIPTOR_OR_ERROR file_descriptor, const char *buf, int buflen);
 static void init_passive_port(void);
 static int get_passive_port(void);
@@ -59,32 +61,33 @@ static void do_mdtm(struct ftp_session_s *f, const struct ftp_command_s *cmd);
 static struct {
 	char *name;
 	void (*func) (struct ftp_session_s * f, const struct ftp_command_s * cmd);
+	int quick;					// no bus or data connection, the listener answers
 } command_func[] = {
 	{
-	"USER", do_user}, {
-	"PASS", do_pass}, {
-	"CWD", do_cwd}, {
-	"CDUP", do_cdup}, {
-	"QUIT", do_quit}, {
-	"PORT", do_port}, {
-	"PASV", do_pasv}, {
-	"LPRT", do_lprt}, {
-	"LPSV", do_lpsv}, {
-	"EPRT", do_eprt}, {
-	"EPSV", do_epsv}, {
-	"TYPE", do_type}, {
-	"STRU", do_stru}, {
-	"MODE", do_mode}, {
-	"RETR", do_retr}, {
-	"STOR", do_stor}, {
-	"PWD", do_pwd}, {
-	"NLST", do_nlst}, {
-	"LIST", do_list}, {
-	"SYST", do_syst}, {
-	"NOOP", do_noop}, {
-	"REST", do_rest}, {
-	"SIZE", do_size}, {
-	"MDTM", do_mdtm}
+	"USER", do_user, 1}, {
+	"PASS", do_pass, 1}, {
+	"CWD", do_cwd, 0}, {
+	"CDUP", do_cdup, 0}, {
+	"QUIT", do_quit, 1}, {
+	"PORT", do_port, 1}, {
+	"PASV", do_pasv, 1}, {
+	"LPRT", do_lprt, 1}, {
+	"LPSV", do_lpsv, 1}, {
+	"EPRT", do_eprt, 1}, {
+	"EPSV", do_epsv, 1}, {
+	"TYPE", do_type, 1}, {
+	"STRU", do_stru, 1}, {
+	"MODE", do_mode, 1}, {
+	"RETR", do_retr, 0}, {
+	"STOR", do_stor, 0}, {
+	"PWD", do_pwd, 1}, {
+	"NLST", do_nlst, 0}, {
+	"LIST", do_list, 0}, {
+	"SYST", do_syst, 1}, {
+	"NOOP", do_noop, 1}, {
+	"REST", do_rest, 1}, {
+	"SIZE", do_size, 0}, {
+	"MDTM", do_mdtm, 0}
 };
 
 #define NUM_COMMAND_FUNC (sizeof(command_func) / sizeof(command_func[0]))
@@ -156,6 +159,8 @@ int ftp_session_init(struct ftp_session_s *f,
 	f->data_port = *client_addr;
 	f->server_fd = FILE_DESCRIPTOR_BAD;
 
+	f->skip_line = 0;
+
 	daemon_assert(invariant(f));
 
 	return 1;
@@ -172,73 +177,89 @@ void ftp_session_drop(struct ftp_session_s *f, const char *reason)
 	daemon_assert(invariant(f));
 }
 
-void ftp_session_run(struct ftp_session_s *f, struct watched_s *watched)
+/* greet a new connection */
+void ftp_session_hello(struct ftp_session_s *f)
+{
+	daemon_assert(invariant(f));
+
+	send_readme(f, 220);
+	reply(f, 220, "Service ready for new user.");
+
+	daemon_assert(invariant(f));
+}
+
+/* one line read from the control connection (by the listener) */
+void ftp_session_command(struct ftp_session_s *f, const char *line)
 {
-	char buf[2048];
 	int len;
 	struct ftp_command_s cmd;
 	size_t i;
 
 	daemon_assert(invariant(f));
-	daemon_assert(watched != NULL);
+	daemon_assert(line != NULL);
 
-	/* record our watchdog */
-	f->watched = watched;
-
-	/* say hello */
-	send_readme(f, 220);
-	reply(f, 220, "Service ready for new user.");
+	/* increase our command count */
+	if (f->command_number == ULONG_MAX) {
+		f->command_number = 0;
+	} else {
+		f->command_number++;
+	}
 
-	/* process commands */
-	while (f->session_active && telnet_session_readln(f->telnet_session, buf, sizeof(buf))) {
+	/* make sure we read a whole line, else throw away the rest of it */
+	len = strlen(line);
+	if (f->skip_line) {
+		f->skip_line = (len == 0 || line[len - 1] != '\n');
+		return;
+	}
+	if (len == 0 || line[len - 1] != '\n') {
+		reply(f, 500, "Command line too long.");
+		f->skip_line = 1;
+		return;
+	}
 
-		/* delay our timeout based on this input */
-		watchdog_defer_watched(f->watched);
+	syslog(LOG_DEBUG, "%s %s", f->client_addr_str, line);
 
-		/* increase our command count */
-		if (f->command_number == ULONG_MAX) {
-			f->command_number = 0;
-		} else {
-			f->command_number++;
-		}
+	/* parse the line */
+	if (!ftp_command_parse(line, &cmd)) {
+		reply(f, 500, "Syntax error, command unrecognized.");
+		return;
+	}
 
-		/* make sure we read a whole line */
-		len = strlen(buf);
-		if (buf[len - 1] != '\n') {
-			reply(f, 500, "Command line too long.");
-			while (telnet_session_readln(f->telnet_session, buf, sizeof(buf))) {
-				len = strlen(buf);
-				if (buf[len - 1] == '\n') {
-					break;
-				}
-			}
-			goto next_command;
+	/* dispatch the command */
+	for (i = 0; i < NUM_COMMAND_FUNC; i++) {
+		if (strcmp(cmd.command, command_func[i].name) == 0) {
+			(command_func[i].func) (f, &cmd);
+			daemon_assert(invariant(f));
+			return;
 		}
+	}
 
-		syslog(LOG_DEBUG, "%s %s", f->client_addr_str, buf);
-
-		/* parse the line */
-		if (!ftp_command_parse(buf, &cmd)) {
-			reply(f, 500, "Syntax error, command unrecognized.");
-			goto next_command;
-		}
+	/* oops, we don't have this command (shouldn't happen - shrug) */
+	reply(f, 502, "Command not implemented.");
 
-		/* dispatch the command */
-		for (i = 0; i < NUM_COMMAND_FUNC; i++) {
-			if (strcmp(cmd.command, command_func[i].name) == 0) {
-				(command_func[i].func) (f, &cmd);
-				goto next_command;
-			}
-		}
+	daemon_assert(invariant(f));
+}
 
-		/* oops, we don't have this command (shouldn't happen - shrug) */
-		reply(f, 502, "Command not implemented.");
+/* a line the listener can answer itself -- nothing on the bus or a data connection.
+   Only lines ftp_session_command will reject or throw away, and quick commands */
+int ftp_session_quick(const struct ftp_session_s *f, const char *line)
+{
+	int len = strlen(line);
+	struct ftp_command_s cmd;
+	size_t i;
 
-	  next_command:{
+	if (f->skip_line || len == 0 || line[len - 1] != '\n') {
+		return 1;
+	}
+	if (!ftp_command_parse(line, &cmd)) {
+		return 1;
+	}
+	for (i = 0; i < NUM_COMMAND_FUNC; i++) {
+		if (strcmp(cmd.command, command_func[i].name) == 0) {
+			return command_func[i].quick;
 		}
 	}
-
-	daemon_assert(invariant(f));
+	return 1;
 }
 
 void ftp_session_destroy(struct ftp_session_s *f)
@@ -287,7 +308,7 @@ static int invariant(const struct ftp_session_s *f)
 		if (!ip_equal(&f->client_addr, &f->data_port)) {
 			return 0;
 		}
-		if ( FILE_DESCRIPTOR_NOT_VALID(f->server_fd)) {
+		if ( FILE_DESCRIPTOR_VALID(f->server_fd)) {
 			return 0;
 		}
 		break;
@@ -1000,8 +1021,6 @@ static void do_retr(struct ftp_session_s *f, const struct ftp_command_s *cmd)
 		goto exit_retr;
 	}
 
-	watchdog_defer_watched(f->watched);
-
 	/* disconnect */
 	Test_and_Close(&socket_fd);
 
@@ -1035,7 +1054,7 @@ static void do_stor(struct ftp_session_s *f, const struct ftp_command_s *cmd)
 	struct timeval start_timestamp;
 	struct timeval end_timestamp;
 	struct timeval transfer_time;
-	struct timeval limit_time = { Globals.timeout_ftp, 0 };
+	struct timeval limit_time = { DATA_TIMEOUT, 0 };
 
 	size_t size_read;
 	off_t offset = 0 ;
@@ -1111,8 +1130,6 @@ static void do_stor(struct ftp_session_s *f, const struct ftp_command_s *cmd)
 		}
 	}
 
-	watchdog_defer_watched(f->watched);
-
 	/* disconnect */
 	Test_and_Close(&socket_fd) ;
 
@@ -1177,8 +1194,17 @@ static FILE_DESCRIPTOR_OR_ERROR open_connection(struct ftp_session_s *f)
 			return FILE_DESCRIPTOR_BAD;
 		}
 	} else {
+		struct pollfd pfd;
+
 		daemon_assert(f->data_channel == DATA_PASSIVE);
 
+		/* a client that never connects mustn't hold a worker */
+		pfd.fd = f->server_fd;
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, DATA_TIMEOUT * 1000) <= 0) {
+			reply(f, 425, "Error accepting connection; timed out.");
+			return FILE_DESCRIPTOR_BAD;
+		}
 		addr_len = sizeof(struct sockaddr_in);
 		socket_fd = accept(f->server_fd, (struct sockaddr *) &addr, &addr_len);
 		if ( FILE_DESCRIPTOR_NOT_VALID(socket_fd) ) {
@@ -1204,9 +1230,21 @@ static FILE_DESCRIPTOR_OR_ERROR open_connection(struct ftp_session_s *f)
 		}
 #endif
 	}
+	data_timeout(socket_fd);
 	return socket_fd;
 }
 
+/* a stalled data connection times out rather than blocking a worker */
+static void data_timeout(FILE_DESCRIPTOR_OR_ERROR socket_fd)
+{
+	struct timeval tv = { DATA_TIMEOUT, 0 };
+
+	if (setsockopt(socket_fd, SOL_SOCKET, SO_SNDTIMEO, (void *) &tv, sizeof(tv)) != 0
+		|| setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, (void *) &tv, sizeof(tv)) != 0) {
+		ERROR_CONNECT("Cannot set data connection timeout");
+	}
+}
+
 /* convert any '\n' to '\r\n' */
 /* destination should be twice the size of the source for safety */
 static int convert_newlines(char *dst, const char *src, int srclen)
@@ -1257,13 +1295,16 @@ static void do_pwd(struct ftp_session_s *f, const struct ftp_command_s *cmd)
 static void both_list(struct ftp_session_s *f, const struct ftp_command_s *cmd, enum file_list_e fle)
 {
 	struct file_parse_s fps;
+	struct memblob list;
+	char *filespec;
 
 	strcpy(fps.buffer, f->dir);
 	fps.rest = NULL;
 	fps.pse = parse_status_init;
 	fps.fle = fle;
 	fps.out = FILE_DESCRIPTOR_BAD;
-
+	fps.list = &list;
+	MemblobInit(&list, 1024);
 
 	daemon_assert(invariant(f));
 	daemon_assert(cmd != NULL);
@@ -1271,14 +1312,19 @@ static void both_list(struct ftp_session_s *f, const struct ftp_command_s *cmd,
 
 	/* figure out what parameters to use */
 	if (cmd->num_arg == 0) {
-		fps.rest = strdup("*");
+		filespec = owstrdup("*");
 	} else {
 		daemon_assert(cmd->num_arg == 1);
 
 		/* ignore attempts to send options to "ls" by silently dropping */
 		/* We don't use "ls" so can just pass on literal text */
-		fps.rest = strdup(cmd->arg[0].string);
+		filespec = owstrdup(cmd->arg[0].string);
+	}
+	if (filespec == NULL) {
+		reply(f, 451, "Out of memory.");
+		goto exit_blst;
 	}
+	fps.rest = filespec;
 
 	/* ready to list */
 	reply(f, 150, "About to send name list.");
@@ -1289,8 +1335,9 @@ static void both_list(struct ftp_session_s *f, const struct ftp_command_s *cmd,
 		goto exit_blst;
 	}
 
-	/* send any files */
+	/* send any files -- one directory pass, sent as it goes */
 	FileLexParse(&fps);
+	FileListFlush(&fps);
 
 	/* strange handshake for Netscape's benefit */
 	netscape_hack(fps.out);
@@ -1303,6 +1350,8 @@ static void both_list(struct ftp_session_s *f, const struct ftp_command_s *cmd,
 
 	/* clean up and exit */
   exit_blst:
+	SAFEFREE(filespec);
+	MemblobClear(&list);
 	Test_and_Close( & fps.out ) ;
 	daemon_assert(invariant(f));
 }
@@ -42,6 +42,7 @@ static int use_incoming_char(struct telnet_session_s *t);
 static void write_outgoing_data(struct telnet_session_s *t);
 static void add_outgoing_char(struct telnet_session_s *t, int c);
 static int max_input_read(struct telnet_session_s *t);
+static int line_ready(struct telnet_session_s *t, int buflen);
 
 /* initialize a telnet session */
 void telnet_session_init(struct telnet_session_s *t, FILE_DESCRIPTOR_OR_ERROR in, FILE_DESCRIPTOR_OR_ERROR out)
@@ -125,44 +126,62 @@ int telnet_session_println(struct telnet_session_s *t, const char *s)
 	return 1;
 }
 
-/* read a line */
+/* read a line without waiting -- 1 if buf has a line (or as much as fits),
+   0 if the line isn't all here yet, -1 if the connection is closed */
 int telnet_session_readln(struct telnet_session_s *t, char *buf, int buflen)
 {
 	int amt_read;
 
 	daemon_assert(invariant(t));
-	amt_read = 0;
-	for (;;) {
-		if ((t->in_errno != 0) || (t->in_eof != 0)) {
+
+	if (!line_ready(t, buflen)) {
+		process_data(t, 0);
+		if (!line_ready(t, buflen)) {
 			daemon_assert(invariant(t));
-			return 0;
+			return ((t->in_errno != 0) || (t->in_eof != 0)) ? -1 : 0;
 		}
-		while (t->in_buflen > 0) {
-			if (amt_read == buflen - 1) {
-				buf[amt_read] = '\0';
-				daemon_assert(invariant(t));
-				return 1;
-			}
-			daemon_assert(amt_read >= 0);
-			daemon_assert(amt_read < buflen);
-			buf[amt_read] = use_incoming_char(t);
-			if (buf[amt_read] == '\012') {
-				daemon_assert(amt_read + 1 >= 0);
-				daemon_assert(amt_read + 1 < buflen);
-				buf[amt_read + 1] = '\0';
-				daemon_assert(invariant(t));
-				return 1;
-			}
-			amt_read++;
+	}
+
+	for (amt_read = 0; amt_read < buflen - 1; ++amt_read) {
+		buf[amt_read] = use_incoming_char(t);
+		if (buf[amt_read] == '\012') {
+			++amt_read;
+			break;
+		}
+	}
+	buf[amt_read] = '\0';
+	daemon_assert(invariant(t));
+	return 1;
+}
+
+/* a whole line, or a buffer's worth, waiting in the input */
+static int line_ready(struct telnet_session_s *t, int buflen)
+{
+	int i;
+	int take = t->in_take;
+
+	if (t->in_buflen >= buflen - 1) {
+		return 1;
+	}
+	for (i = 0; i < t->in_buflen; ++i) {
+		if (t->in_buf[take] == '\012') {
+			return 1;
+		}
+		if (++take == BUF_LEN) {
+			take = 0;
 		}
-		process_data(t, 1);
 	}
+	return 0;
 }
 
 void telnet_session_destroy(struct telnet_session_s *t)
 {
 	daemon_assert(invariant(t));
 
+	if (t->out_fd == t->in_fd) {
+		// one socket, don't close a number another thread may have reused
+		t->out_fd = FILE_DESCRIPTOR_BAD;
+	}
 	Test_and_Close( & t->in_fd);
 	Test_and_Close( & t->out_fd);
 }
@@ -175,13 +194,17 @@ static void process_data(struct telnet_session_s *t, int wait_flag)
 	fd_set exceptfds;
 	struct timeval tv_zero;
 	struct timeval *tv;
+	int select_ret;
 
 	/* set up our select() variables */
 	FD_ZERO(&readfds);
 	FD_ZERO(&writefds);
 	FD_ZERO(&exceptfds);
 	if (wait_flag) {
-		tv = NULL;
+		// a client that stops reading our replies is dropped
+		tv_zero.tv_sec = DATA_TIMEOUT;
+		tv_zero.tv_usec = 0;
+		tv = &tv_zero;
 	} else {
 		tv_zero.tv_sec = 0;
 		tv_zero.tv_usec = 0;
@@ -201,7 +224,11 @@ static void process_data(struct telnet_session_s *t, int wait_flag)
 	}
 
 	/* see if there's anything to do */
-	if (select(FD_SETSIZE, &readfds, &writefds, &exceptfds, tv) > 0) {
+	select_ret = select(FD_SETSIZE, &readfds, &writefds, &exceptfds, tv);
+	if (select_ret == 0 && wait_flag && FD_ISSET(t->out_fd, &writefds)) {
+		LEVEL_DEBUG("FTP client not reading replies");
+		t->out_errno = ETIMEDOUT;
+	} else if (select_ret > 0) {
 
 		if (FD_ISSET(t->in_fd, &exceptfds)) {
 			t->in_eof = 1;
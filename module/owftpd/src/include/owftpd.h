@@ -91,6 +91,11 @@ typedef struct sockaddr_in sockaddr_storage_t;
 /* default port FTP server listens on (use 0 to listen on default port) */
 #define DEFAULT_PORTNAME "0.0.0.0:21"
 
+/* seconds a client may leave a data connection unconnected or stalled, or a
+   reply unread, while a worker or the listener waits on it -- the idle
+   session itself times out after timeout_ftp */
+#define DATA_TIMEOUT 30
+
 /* bounds on command-line specified number of clients */
 #define MIN_NUM_CLIENTS 1
 #define MAX_NUM_CLIENTS 300
@@ -115,6 +120,7 @@ struct file_parse_s {
 	enum parse_status_e pse;	// state machine
 	enum file_list_e fle;		// long or short listing flag
 	FILE_DESCRIPTOR_OR_ERROR out;					// file descriptor to send result
+	struct memblob *list;		// listing not yet sent, shared by recursive copies
 	int ret;					// return status
 	int start;
 };
@@ -129,43 +135,9 @@ struct cd_parse_s {
 };
 
 void FileLexParse(struct file_parse_s *fps);
+void FileListFlush(struct file_parse_s *fps);
 void FileLexCD(struct cd_parse_s *cps);
 
-/* each watched thread gets one of these structures */
-struct watched_s {
-	/* thread to monitor */
-	pthread_t watched_thread;
-
-	/* flag whether in a watchdog list */
-	int in_list;
-
-	/* time when to cancel thread if no activity */
-	time_t alarm_time;
-
-	/* for location in doubly-linked list */
-	struct watched_s *older;
-	struct watched_s *newer;
-
-	/* watchdog that this watched_s is in */
-	void *watchdog;
-};
-
-/* the watchdog keeps track of all information */
-struct watchdog_s {
-	pthread_mutex_t mutex;
-	int inactivity_timeout;
-
-	/* the head and tail of our list */
-	struct watched_s *oldest;
-	struct watched_s *newest;
-};
-
-int watchdog_init(struct watchdog_s *w, int inactivity_timeout);
-void watchdog_add_watched(struct watchdog_s *w, struct watched_s *watched);
-void watchdog_defer_watched(struct watched_s *watched);
-void watchdog_remove_watched(struct watched_s *watched);
-
-
 /* size of buffer */
 #define BUF_LEN 2048
 
@@ -268,14 +240,16 @@ struct ftp_session_s {
 	sockaddr_storage_t data_port;
 	FILE_DESCRIPTOR_OR_ERROR server_fd;
 
-	/* watchdog to handle timeout */
-	struct watched_s *watched;
+	/* rest of an overlong command line still to be thrown away */
+	int skip_line;
 };
 
 int ftp_session_init(struct ftp_session_s *f,
 					 const sockaddr_storage_t * client_addr, const sockaddr_storage_t * server_addr, struct telnet_session_s *t, const char *dir);
 void ftp_session_drop(struct ftp_session_s *f, const char *reason);
-void ftp_session_run(struct ftp_session_s *f, struct watched_s *watched);
+void ftp_session_hello(struct ftp_session_s *f);
+void ftp_session_command(struct ftp_session_s *f, const char *line);
+int ftp_session_quick(const struct ftp_session_s *f, const char *line);
 void ftp_session_destroy(struct ftp_session_s *f);
 
 struct ftp_listener_s {
@@ -292,9 +266,6 @@ struct ftp_listener_s {
 	/* timeout (in seconds) for connections */
 	int inactivity_timeout;
 
-	/* watchdog monitoring this listener's connections */
-	struct watchdog_s watchdog;
-
 	/* mutext to lock changes to this structure */
 	pthread_mutex_t mutex;
 
@@ -311,6 +282,9 @@ struct ftp_listener_s {
 	/* end of pipe listening thread waits on */
 	FILE_DESCRIPTOR_OR_ERROR shutdown_request_fd[2];
 
+	/* same, for workers finishing a command */
+	FILE_DESCRIPTOR_OR_ERROR wake_fd[2];
+
 	/* condition to signal thread requesting shutdown */
 	pthread_cond_t shutdown_cond;
 
@@ -347,7 +321,7 @@ int ftp_command_parse(const char *input, struct ftp_command_s *cmd);
 void telnet_session_init(struct telnet_session_s *t, FILE_DESCRIPTOR_OR_ERROR in, FILE_DESCRIPTOR_OR_ERROR out);
 int telnet_session_print(struct telnet_session_s *t, const char *s);
 int telnet_session_println(struct telnet_session_s *t, const char *s);
-int telnet_session_readln(struct telnet_session_s *t, char *buf, int buflen);
+int telnet_session_readln(struct telnet_session_s *t, char *buf, int buflen);	// 1 line, 0 not yet, -1 closed
 void telnet_session_destroy(struct telnet_session_s *t);
 
 #endif							/* OWFTPD_H */
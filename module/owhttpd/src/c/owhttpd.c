@@ -97,6 +97,10 @@ int main(int argc, char *argv[])
 	set_exit_signal_handlers(exit_handler);
 	set_signal_handlers(NULL);
 
+	if ( BAD(HttpReactorStart()) ) {
+		ow_exit(1);
+	}
+
 	ServerProcess(Acceptor);
 
 	LEVEL_DEBUG("ServerProcess done");
@@ -107,10 +111,9 @@ int main(int argc, char *argv[])
 
 static void Acceptor(int listenfd)
 {
-	FILE *fp = fdopen(listenfd, "w+");
-	if (fp) {
-		handle_socket(fp);
-		fflush(fp);
-		fclose(fp);
+	// ServerProcess closes its copy when we return
+	FILE_DESCRIPTOR_OR_ERROR file_descriptor = dup(listenfd);
+	if ( FILE_DESCRIPTOR_VALID(file_descriptor) ) {
+		HttpReactorAdd(file_descriptor);
 	}
 }
@@ -0,0 +1,320 @@
+/*
+ * owhttpd_batch.c for owhttpd (1-wire web server)
+ * By Paul Alfille 2003, using libow
+ * offshoot of the owfs ( 1wire file system )
+ *
+ * GPL license ( Gnu Public Lincense )
+ *
+ * Many reads and writes in one request
+ *
+ */
+
+#include "owhttpd.h"
+#include "jsmn.h"
+
+/* POST /batch with a JSON list. A string is a read, an object with "path"
+ * and "value" is a write:
+ *
+ *   [ "/10.67C6697351FF/temperature", {"path":"/05.4AEC29CDBAAB/PIO","value":"1"} ]
+ *
+ * The answer is a list in request order, one entry per item (a path may
+ * well appear twice, e.g. written then read back):
+ *
+ *   [ {"path":"/10.67C6697351FF/temperature","error":0,"value":"     21.5"},
+ *     {"path":"/05.4AEC29CDBAAB/PIO","error":-2,"message":"No such file or directory"} ]
+ *
+ * Each run of reads between writes goes to FS_read_many, which works the
+ * ports in parallel and starts one simultaneous conversion for a bus with
+ * several temperatures. Writes are done in turn, so a read after a write
+ * sees the new value.
+ */
+
+#define BATCH_ITEMS_MAX  1024
+
+#define BatchText( mb, text )  MemblobAdd( (const BYTE *) (text), strlen( text ), (mb) )
+
+struct batch_item {
+	char * path ;
+	char * value ;                    // NULL for a read
+	ZERO_OR_ERROR error ;
+	struct memblob result ;           // a read as a JSON string, hex for binary
+} ;
+
+struct batch_struct {
+	struct batch_item * items ;
+	int nitems ;
+} ;
+
+static ZERO_OR_ERROR BatchParse( struct batch_struct * bs, const char * body, size_t body_length ) ;
+static char * BatchString( const char * body, jsmntok_t * token ) ;
+static void BatchReads( struct batch_item * items, int nitems ) ;
+static void BatchWrite( struct batch_item * item ) ;
+static void BatchShow( struct OutputControl * oc, struct batch_struct * bs ) ;
+static void BatchFree( struct batch_struct * bs ) ;
+
+/* Returns 0 once answered, -EINVAL for a body that is not a batch list */
+ZERO_OR_ERROR ShowBatch( struct OutputControl * oc, const char * body, size_t body_length )
+{
+	struct batch_struct s_bs = { NULL, 0, } ;
+	struct batch_struct * bs = &s_bs ;
+	int item_index ;
+	int run_start ;
+
+	if ( body == NULL ) {
+		return -EINVAL ;
+	}
+	if ( BatchParse( bs, body, body_length ) != 0 ) {
+		BatchFree( bs ) ;
+		return -EINVAL ;
+	}
+	LEVEL_DEBUG("Batch of %d items", bs->nitems ) ;
+
+	// writes in turn, the reads between them together
+	run_start = 0 ;
+	for ( item_index = 0 ; item_index <= bs->nitems ; ++item_index ) {
+		if ( item_index < bs->nitems && bs->items[item_index].value == NULL ) {
+			continue ;
+		}
+		BatchReads( &bs->items[run_start], item_index - run_start ) ;
+		if ( item_index < bs->nitems ) {
+			BatchWrite( &bs->items[item_index] ) ;
+		}
+		run_start = item_index + 1 ;
+	}
+
+	BatchShow( oc, bs ) ;
+	BatchFree( bs ) ;
+	return 0 ;
+}
+
+/* Items from the JSON list, 0 if good */
+static ZERO_OR_ERROR BatchParse( struct batch_struct * bs, const char * body, size_t body_length )
+{
+	jsmn_parser parser ;
+	jsmntok_t * tokens ;
+	int ntokens = body_length / 2 + 2 ; // every token takes at least 2 characters
+	int token_index ;
+	ZERO_OR_ERROR ret = 0 ;
+
+	tokens = owcalloc( ntokens, sizeof( jsmntok_t ) ) ;
+	if ( tokens == NULL ) {
+		return -ENOMEM ;
+	}
+	jsmn_init( &parser ) ;
+	if ( jsmn_parse( &parser, body, tokens, ntokens ) != JSMN_SUCCESS || parser.toknext < 1 || tokens[0].type != JSMN_ARRAY ) {
+		LEVEL_DEBUG("Batch body is not a JSON list");
+		owfree( tokens ) ;
+		return -EINVAL ;
+	}
+	if ( tokens[0].size > BATCH_ITEMS_MAX ) {
+		LEVEL_DEBUG("Batch of %d items is too large", tokens[0].size);
+		owfree( tokens ) ;
+		return -EINVAL ;
+	}
+	bs->items = owcalloc( tokens[0].size + 1, sizeof( struct batch_item ) ) ;
+	if ( bs->items == NULL ) {
+		owfree( tokens ) ;
+		return -ENOMEM ;
+	}
+
+	token_index = 1 ;
+	while ( ret == 0 && token_index < parser.toknext && tokens[token_index].start < tokens[0].end ) {
+		struct batch_item * item = &bs->items[bs->nitems] ;
+		jsmntok_t * token = &tokens[token_index] ;
+
+		MemblobInit( &item->result, 64 ) ;
+		++bs->nitems ;
+		switch ( token->type ) {
+			case JSMN_STRING:
+				// read
+				item->path = BatchString( body, token ) ;
+				++token_index ;
+				break ;
+			case JSMN_OBJECT:
+				// write -- "path" and "value" members
+				for ( ++token_index ; token_index + 1 < parser.toknext && tokens[token_index].start < token->end ; token_index += 2 ) {
+					jsmntok_t * key = &tokens[token_index] ;
+					jsmntok_t * value = &tokens[token_index + 1] ;
+					int key_length = key->end - key->start ;
+
+					if ( key->type != JSMN_STRING || ( value->type != JSMN_STRING && value->type != JSMN_PRIMITIVE ) ) {
+						ret = -EINVAL ;
+						break ;
+					}
+					if ( key_length == 4 && strncmp( &body[key->start], "path", 4 ) == 0 ) {
+						SAFEFREE( item->path ) ;
+						item->path = BatchString( body, value ) ;
+					} else if ( key_length == 5 && strncmp( &body[key->start], "value", 5 ) == 0 ) {
+						SAFEFREE( item->value ) ;
+						item->value = BatchString( body, value ) ;
+					}
+				}
+				if ( item->value == NULL ) {
+					ret = -EINVAL ;
+				}
+				break ;
+			default:
+				ret = -EINVAL ;
+				break ;
+		}
+		if ( item->path == NULL ) {
+			ret = -EINVAL ;
+		}
+	}
+
+	owfree( tokens ) ;
+	return ret ;
+}
+
+/* Copy of a string or primitive token, escapes undone */
+static char * BatchString( const char * body, jsmntok_t * token )
+{
+	const char * text = &body[token->start] ;
+	int length = token->end - token->start ;
+	char * copy = owmalloc( length + 1 ) ;
+	int i ;
+	int j = 0 ;
+
+	if ( copy == NULL ) {
+		return NULL ;
+	}
+	for ( i = 0 ; i < length ; ++i ) {
+		if ( text[i] == '\\' && i + 1 < length ) {
+			switch ( text[++i] ) {
+				case 'n':
+					copy[j++] = '\n' ;
+					break ;
+				case 'r':
+					copy[j++] = '\r' ;
+					break ;
+				case 't':
+					copy[j++] = '\t' ;
+					break ;
+				default:
+					// \" \\ \/ -- \u is not decoded
+					copy[j++] = text[i] ;
+					break ;
+			}
+		} else {
+			copy[j++] = text[i] ;
+		}
+	}
+	copy[j] = '\0' ;
+	return copy ;
+}
+
+/* Reads in one FS_read_many, values in the owhttpd JSON form */
+static void BatchReads( struct batch_item * items, int nitems )
+{
+	struct many_read * reads ;
+	int item_index ;
+
+	if ( nitems == 0 ) {
+		return ;
+	}
+	reads = owcalloc( nitems, sizeof( struct many_read ) ) ;
+	if ( reads == NULL ) {
+		for ( item_index = 0 ; item_index < nitems ; ++item_index ) {
+			items[item_index].error = -ENOMEM ;
+		}
+		return ;
+	}
+	for ( item_index = 0 ; item_index < nitems ; ++item_index ) {
+		// no buffer -- FS_read_many sizes one as it parses the path
+		reads[item_index].path = items[item_index].path ;
+	}
+	FS_read_many( reads, nitems ) ;
+
+	for ( item_index = 0 ; item_index < nitems ; ++item_index ) {
+		struct batch_item * item = &items[item_index] ;
+		struct many_read * mr = &reads[item_index] ;
+
+		if ( mr->read_return < 0 ) {
+			item->error = mr->read_return ;
+		} else if ( mr->binary ) {
+			JSON_hex( &item->result, (const BYTE *) mr->buffer, mr->read_return ) ;
+		} else {
+			JSON_string( &item->result, mr->buffer, mr->read_return ) ;
+		}
+		SAFEFREE( mr->buffer ) ;
+	}
+	owfree( reads ) ;
+}
+
+/* Same as a GET with a value */
+static void BatchWrite( struct batch_item * item )
+{
+	struct one_wire_query * owq ;
+	SIZE_OR_ERROR write_return ;
+
+	if ( item->error != 0 ) {
+		// already failed
+		return ;
+	}
+	owq = OWQ_create_from_path( item->path ) ;
+	if ( owq == NO_ONE_WIRE_QUERY ) {
+		item->error = -ENOENT ;
+		return ;
+	}
+	if ( BAD( OWQ_allocate_write_buffer( item->value, strlen( item->value ), 0, owq ) ) ) {
+		item->error = -ENOMEM ;
+	} else {
+		LEVEL_DETAIL("Batch write path=%s value=%s", item->path, item->value);
+		write_return = ChangeData( owq ) ;
+		item->error = ( write_return < 0 ) ? write_return : 0 ;
+	}
+	OWQ_destroy( owq ) ;
+}
+
+/* Results list, in request order */
+static void BatchShow( struct OutputControl * oc, struct batch_struct * bs )
+{
+	struct memblob mb ;
+	int item_index ;
+
+	MemblobInit( &mb, 1024 ) ;
+	MemblobAddChar( '[', 1, &mb ) ;
+	for ( item_index = 0 ; item_index < bs->nitems ; ++item_index ) {
+		struct batch_item * item = &bs->items[item_index] ;
+		char error[32] ;
+
+		if ( item_index > 0 ) {
+			MemblobAddChar( ',', 1, &mb ) ;
+		}
+		BatchText( &mb, "\n{\"path\":" ) ;
+		JSON_string( &mb, item->path, strlen( item->path ) ) ;
+		snprintf( error, sizeof(error), ",\"error\":%d", (int) item->error ) ;
+		BatchText( &mb, error ) ;
+		if ( item->error != 0 ) {
+			BatchText( &mb, ",\"message\":" ) ;
+			JSON_string( &mb, strerror( -item->error ), strlen( strerror( -item->error ) ) ) ;
+		} else if ( item->value == NULL ) {
+			BatchText( &mb, ",\"value\":" ) ;
+			MemblobAdd( MemblobData( &item->result ), MemblobLength( &item->result ), &mb ) ;
+		}
+		MemblobAddChar( '}', 1, &mb ) ;
+	}
+	BatchText( &mb, "\n]\n" ) ;
+
+	if ( MemblobPure( &mb ) ) {
+		HTTPstart( oc, "200 OK", ct_json ) ;
+		fwrite( MemblobData( &mb ), 1, MemblobLength( &mb ), oc->out ) ;
+	} else {
+		LEVEL_DEBUG("Out of memory for the batch answer");
+		HTTPstart( oc, "500 Internal Server Error", ct_json ) ;
+		fprintf( oc->out, "[]\n" ) ;
+	}
+	MemblobClear( &mb ) ;
+}
+
+static void BatchFree( struct batch_struct * bs )
+{
+	int item_index ;
+
+	for ( item_index = 0 ; item_index < bs->nitems ; ++item_index ) {
+		SAFEFREE( bs->items[item_index].path ) ;
+		SAFEFREE( bs->items[item_index].value ) ;
+		MemblobClear( &bs->items[item_index].result ) ;
+	}
+	SAFEFREE( bs->items ) ;
+}
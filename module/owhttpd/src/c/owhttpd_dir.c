@@ -202,3 +202,18 @@ static void ShowDirJson(struct OutputControl * oc, struct parsedname * pn)
 	fprintf(out, "}" );
 	return;
 }
+
+/* Every device with its values, streamed as each device is read */
+static void ShowSnapshotCallback(void *v, const char *text, size_t length)
+{
+	// each device goes out as it is read
+	HTTPchunk(v, text, length) ;
+}
+
+void ShowSnapshot(struct OutputControl * oc, struct parsedname * pn)
+{
+	HTTPstream(oc, "200 OK", ct_json);
+
+	pn->control_flags |= ALIAS_REQUEST ; // as FS_dir does for local queries
+	FS_snapshot(ShowSnapshotCallback, oc, pn);
+}
@@ -0,0 +1,447 @@
+/*
+ * owhttpd_events.c for owhttpd (1-wire web server)
+ * By Paul Alfille 2003, using libow
+ * offshoot of the owfs ( 1wire file system )
+ *
+ * GPL license ( Gnu Public Lincense )
+ *
+ * Server-Sent Events change stream
+ *
+ */
+
+#include "owhttpd.h"
+
+/* /events?path=/10.67C6697351FF/temperature&path=/bus.0&interval=5
+ *
+ * The connection stays open as a text/event-stream. A property path sends
+ * a "value" event when its value changes. A directory path sends "added"
+ * and "removed" events as devices come and go. New viewers get the current
+ * state first.
+ *
+ * Each distinct (path, interval) is a "watch" sampled by a single sampler
+ * thread, however many browsers are viewing it. Bus load depends on what
+ * is watched, not on the number of viewers.
+ */
+
+#define EVENTS_INTERVAL_DEFAULT  10   // seconds
+#define EVENTS_HEARTBEAT         15   // seconds between comments, finds departed clients
+#define EVENTS_PATHS_MAX         16   // per request
+
+struct event_subscriber {
+	struct event_subscriber * next ;
+	struct http_connection * hc ;
+	int minor_version ;
+} ;
+
+struct event_watch {
+	struct event_watch * next ;
+	char * path ;
+	int interval ;
+	int directory ;                   // device list rather than a value
+	time_t next_sample ;
+	int sampled ;                     // state below is valid
+	char * value ;                    // JSON value for a property
+	struct memblob devices ;          // names, \0 separated, for a directory
+	struct event_subscriber * subscribers ;
+} ;
+
+static pthread_mutex_t events_mutex = PTHREAD_MUTEX_INITIALIZER ;
+static pthread_cond_t events_cond = PTHREAD_COND_INITIALIZER ;
+
+#define EVENTSLOCK     _MUTEX_LOCK(   events_mutex )
+#define EVENTSUNLOCK   _MUTEX_UNLOCK( events_mutex )
+#define EVENTSSIGNAL   my_pthread_cond_signal( &events_cond )
+
+static struct event_watch * watch_list = NULL ;
+static int sampler_running = 0 ;
+static int sampler_again = 0 ;   // new work arrived during a pass
+
+static GOOD_OR_BAD EventsSubscribe( struct OutputControl * oc, const char * path, int directory, int interval ) ;
+static void * EventsSampler( void * v ) ;
+static void EventsSample( struct event_watch * watch, char ** value, struct memblob * devices ) ;
+static void EventsDirCallback( void * v, const struct parsedname * pn_entry ) ;
+static void EventsUpdate( struct event_watch * watch, char * value, struct memblob * devices ) ;
+static void EventsInitial( struct event_watch * watch, struct event_subscriber * es ) ;
+static void EventsSend( struct event_watch * watch, struct event_subscriber * only, const char * text, size_t length ) ;
+static void EventsDevice( struct event_watch * watch, struct event_subscriber * only, const char * event, const char * device ) ;
+static void EventsValue( struct event_watch * watch, struct event_subscriber * only ) ;
+static int EventsHasDevice( struct memblob * devices, const char * device ) ;
+static void EventsWatchFree( struct event_watch * watch ) ;
+
+/* Returns 0 once the stream is started, -EINVAL for a bad query, -ENOENT for a bad path */
+ZERO_OR_ERROR ShowEvents( struct OutputControl * oc, char * query )
+{
+	char * paths[EVENTS_PATHS_MAX] ;
+	int directory[EVENTS_PATHS_MAX] ;
+	int npaths = 0 ;
+	int interval = EVENTS_INTERVAL_DEFAULT ;
+	char * field ;
+	int i ;
+
+	if ( query == NULL ) {
+		return -EINVAL ;
+	}
+	// query ends at the HTTP version
+	field = strchr( query, ' ' ) ;
+	if ( field != NULL ) {
+		field[0] = '\0' ;
+	}
+
+	while ( (field = strsep( &query, "&" )) != NULL ) {
+		char * value = strchr( field, '=' ) ;
+		if ( value == NULL ) {
+			continue ;
+		}
+		*value++ = '\0' ;
+		httpunescape( (BYTE *) value ) ;
+		if ( strcmp( field, "path" ) == 0 ) {
+			if ( npaths == EVENTS_PATHS_MAX ) {
+				LEVEL_DEBUG("Too many event paths") ;
+				return -EINVAL ;
+			}
+			paths[npaths++] = value ;
+		} else if ( strcmp( field, "interval" ) == 0 ) {
+			interval = atoi( value ) ;
+			if ( interval < 1 ) {
+				interval = 1 ;
+			}
+		}
+	}
+	if ( npaths == 0 ) {
+		LEVEL_DEBUG("No path for events") ;
+		return -EINVAL ;
+	}
+
+	// check all the paths before starting the stream
+	for ( i = 0 ; i < npaths ; ++i ) {
+		struct parsedname s_pn ;
+		struct parsedname * pn = &s_pn ;
+
+		if ( FS_ParsedName( paths[i], pn ) != 0 ) {
+			LEVEL_DEBUG("Event path %s not understood", paths[i]) ;
+			return -ENOENT ;
+		}
+		if ( pn->selected_device == NO_DEVICE ) {
+			directory[i] = 1 ;
+		} else if ( pn->selected_filetype != NO_FILETYPE && pn->selected_filetype->format != ft_directory && pn->selected_filetype->read != NO_READ_FUNCTION ) {
+			directory[i] = 0 ;
+		} else {
+			LEVEL_DEBUG("Event path %s is not a directory or readable property", paths[i]) ;
+			FS_ParsedName_destroy( pn ) ;
+			return -EINVAL ;
+		}
+		FS_ParsedName_destroy( pn ) ;
+	}
+
+	// the stream lasts until the client leaves
+	oc->keep_alive = 0 ;
+	oc->held = 1 ;
+	HTTPstream( oc, "200 OK", ct_event ) ;
+
+	for ( i = 0 ; i < npaths ; ++i ) {
+		if ( BAD( EventsSubscribe( oc, paths[i], directory[i], interval ) ) ) {
+			break ;
+		}
+	}
+	return 0 ;
+}
+
+static GOOD_OR_BAD EventsSubscribe( struct OutputControl * oc, const char * path, int directory, int interval )
+{
+	struct event_watch * watch ;
+	struct event_subscriber * es = owcalloc( 1, sizeof( struct event_subscriber ) ) ;
+
+	if ( es == NULL ) {
+		return gbBAD ;
+	}
+	es->hc = oc->connection ;
+	es->minor_version = oc->minor_version ;
+	HttpHold( es->hc ) ;
+
+	EVENTSLOCK ;
+	for ( watch = watch_list ; watch != NULL ; watch = watch->next ) {
+		if ( watch->interval == interval && strcmp( watch->path, path ) == 0 ) {
+			break ;
+		}
+	}
+	if ( watch == NULL ) {
+		watch = owcalloc( 1, sizeof( struct event_watch ) ) ;
+		if ( watch == NULL || (watch->path = owstrdup( path )) == NULL ) {
+			EVENTSUNLOCK ;
+			SAFEFREE( watch ) ;
+			HttpRelease( es->hc ) ;
+			owfree( es ) ;
+			return gbBAD ;
+		}
+		watch->interval = interval ;
+		watch->directory = directory ;
+		MemblobInit( &watch->devices, 256 ) ;
+		watch->next = watch_list ;
+		watch_list = watch ;
+		LEVEL_DEBUG("New event watch %s every %d seconds", path, interval) ;
+	}
+
+	es->next = watch->subscribers ;
+	watch->subscribers = es ;
+	EventsInitial( watch, es ) ;
+	sampler_again = 1 ;
+
+	if ( ! sampler_running ) {
+		pthread_t thread ;
+		if ( pthread_create( &thread, DEFAULT_THREAD_ATTR, EventsSampler, NULL ) == 0 ) {
+			sampler_running = 1 ;
+		} else {
+			LEVEL_DEFAULT("Cannot start the owhttpd event sampler") ;
+		}
+	}
+	EVENTSSIGNAL ;
+	EVENTSUNLOCK ;
+	return gbGOOD ;
+}
+
+/* The one thread reading watched paths */
+static void * EventsSampler( void * v )
+{
+	time_t next_heartbeat = NOW_TIME + EVENTS_HEARTBEAT ;
+
+	(void) v ;
+	DETACH_THREAD ;
+
+	EVENTSLOCK ;
+	while (1) {
+		struct event_watch ** link = &watch_list ;
+		time_t now = NOW_TIME ;
+		time_t next_wake = next_heartbeat ;
+		struct timespec until ;
+		int heartbeat = ( now >= next_heartbeat ) ;
+
+		if ( heartbeat ) {
+			next_heartbeat = now + EVENTS_HEARTBEAT ;
+			next_wake = next_heartbeat ;
+		}
+
+		while ( *link != NULL ) {
+			struct event_watch * watch = *link ;
+
+			if ( heartbeat ) {
+				EventsSend( watch, NULL, ":\n\n", 3 ) ;
+			}
+			if ( watch->subscribers == NULL ) {
+				// last viewer gone
+				LEVEL_DEBUG("End event watch %s", watch->path) ;
+				*link = watch->next ;
+				EventsWatchFree( watch ) ;
+				continue ;
+			}
+
+			if ( watch->next_sample <= now ) {
+				char * value = NULL ;
+				struct memblob devices ;
+
+				// only this thread changes or removes watches, so watch stays valid
+				EVENTSUNLOCK ;
+				EventsSample( watch, &value, &devices ) ;
+				EVENTSLOCK ;
+				EventsUpdate( watch, value, &devices ) ;
+				watch->next_sample = NOW_TIME + watch->interval ;
+			}
+			if ( watch->next_sample < next_wake ) {
+				next_wake = watch->next_sample ;
+			}
+			link = &watch->next ;
+		}
+
+		if ( sampler_again ) {
+			sampler_again = 0 ;
+		} else if ( next_wake > NOW_TIME ) {
+			until.tv_sec = next_wake ;
+			until.tv_nsec = 0 ;
+			// new subscriptions signal; timeout is the normal case
+			pthread_cond_timedwait( &events_cond, &events_mutex, &until ) ;
+		}
+	}
+	EVENTSUNLOCK ;
+	return VOID_RETURN ;
+}
+
+/* Read the current state of a watch (no lock held) */
+static void EventsSample( struct event_watch * watch, char ** value, struct memblob * devices )
+{
+	MemblobInit( devices, 256 ) ;
+
+	if ( watch->directory ) {
+		struct parsedname s_pn ;
+		struct parsedname * pn = &s_pn ;
+
+		if ( FS_ParsedName( watch->path, pn ) == 0 ) {
+			FS_dir( EventsDirCallback, devices, pn ) ;
+			FS_ParsedName_destroy( pn ) ;
+		}
+	} else {
+		struct one_wire_query * owq = OWQ_create_from_path( watch->path ) ;
+		struct memblob mb ;
+
+		MemblobInit( &mb, 64 ) ;
+		if ( owq == NO_ONE_WIRE_QUERY || BAD( OWQ_allocate_read_buffer( owq ) ) ) {
+			MemblobAdd( (const BYTE *) "null", 4, &mb ) ;
+		} else {
+			SIZE_OR_ERROR read_return = FS_read_postparse( owq ) ;
+			if ( read_return < 0 ) {
+				MemblobAdd( (const BYTE *) "null", 4, &mb ) ;
+			} else if ( PN(owq)->selected_filetype->format == ft_binary ) {
+				JSON_hex( &mb, (const BYTE *) OWQ_buffer(owq), read_return ) ;
+			} else {
+				JSON_string( &mb, OWQ_buffer(owq), read_return ) ;
+			}
+		}
+		if ( owq != NO_ONE_WIRE_QUERY ) {
+			OWQ_destroy( owq ) ;
+		}
+		MemblobAddChar( '\0', 1, &mb ) ;
+		*value = owstrdup( (const char *) MemblobData( &mb ) ) ;
+		MemblobClear( &mb ) ;
+	}
+}
+
+/* Real devices only (no interface, simultaneous, alarm), by name */
+static void EventsDirCallback( void * v, const struct parsedname * pn_entry )
+{
+	struct memblob * devices = v ;
+	const char * name ;
+
+	if ( pn_entry->selected_device == NO_DEVICE || pn_entry->selected_device == DeviceSimultaneous ) {
+		return ;
+	}
+	if ( NotRealDir( pn_entry ) ) {
+		return ;
+	}
+	name = FS_DirName( pn_entry ) ;
+	MemblobAdd( (const BYTE *) name, strlen( name ) + 1, devices ) ;
+}
+
+/* Compare with the last sample and tell the viewers what changed */
+static void EventsUpdate( struct event_watch * watch, char * value, struct memblob * devices )
+{
+	if ( watch->directory ) {
+		const char * device ;
+		const char * end ;
+
+		device = (const char *) MemblobData( devices ) ;
+		end = device + MemblobLength( devices ) ;
+		for ( ; device < end ; device += strlen( device ) + 1 ) {
+			if ( ! EventsHasDevice( &watch->devices, device ) ) {
+				EventsDevice( watch, NULL, "added", device ) ;
+			}
+		}
+		device = (const char *) MemblobData( &watch->devices ) ;
+		end = device + MemblobLength( &watch->devices ) ;
+		for ( ; device < end ; device += strlen( device ) + 1 ) {
+			if ( ! EventsHasDevice( devices, device ) ) {
+				EventsDevice( watch, NULL, "removed", device ) ;
+			}
+		}
+		MemblobClear( &watch->devices ) ;
+		watch->devices = *devices ;
+	} else {
+		MemblobClear( devices ) ;
+		if ( value == NULL ) {
+			return ;
+		}
+		if ( watch->value != NULL && strcmp( watch->value, value ) == 0 ) {
+			owfree( value ) ;
+		} else {
+			SAFEFREE( watch->value ) ;
+			watch->value = value ;
+			EventsValue( watch, NULL ) ;
+		}
+	}
+	watch->sampled = 1 ;
+}
+
+/* Current state for a new viewer */
+static void EventsInitial( struct event_watch * watch, struct event_subscriber * es )
+{
+	if ( ! watch->sampled ) {
+		// comes with the first sample
+		watch->next_sample = 0 ;
+	} else if ( watch->directory ) {
+		const char * device = (const char *) MemblobData( &watch->devices ) ;
+		const char * end = device + MemblobLength( &watch->devices ) ;
+		for ( ; device < end ; device += strlen( device ) + 1 ) {
+			EventsDevice( watch, es, "added", device ) ;
+		}
+	} else if ( watch->value != NULL ) {
+		EventsValue( watch, es ) ;
+	}
+}
+
+static void EventsValue( struct event_watch * watch, struct event_subscriber * only )
+{
+	struct memblob mb ;
+
+	MemblobInit( &mb, 128 ) ;
+	MemblobAdd( (const BYTE *) "event: value\ndata: {\"path\":", 27, &mb ) ;
+	JSON_string( &mb, watch->path, strlen( watch->path ) ) ;
+	MemblobAdd( (const BYTE *) ",\"value\":", 9, &mb ) ;
+	MemblobAdd( (const BYTE *) watch->value, strlen( watch->value ), &mb ) ;
+	MemblobAdd( (const BYTE *) "}\n\n", 3, &mb ) ;
+	EventsSend( watch, only, (const char *) MemblobData( &mb ), MemblobLength( &mb ) ) ;
+	MemblobClear( &mb ) ;
+}
+
+static void EventsDevice( struct event_watch * watch, struct event_subscriber * only, const char * event, const char * device )
+{
+	struct memblob mb ;
+
+	MemblobInit( &mb, 128 ) ;
+	MemblobAdd( (const BYTE *) "event: ", 7, &mb ) ;
+	MemblobAdd( (const BYTE *) event, strlen( event ), &mb ) ;
+	MemblobAdd( (const BYTE *) "\ndata: {\"path\":", 15, &mb ) ;
+	JSON_string( &mb, watch->path, strlen( watch->path ) ) ;
+	MemblobAdd( (const BYTE *) ",\"device\":", 10, &mb ) ;
+	JSON_string( &mb, device, strlen( device ) ) ;
+	MemblobAdd( (const BYTE *) "}\n\n", 3, &mb ) ;
+	EventsSend( watch, only, (const char *) MemblobData( &mb ), MemblobLength( &mb ) ) ;
+	MemblobClear( &mb ) ;
+}
+
+/* To one subscriber, or all of a watch's (only == NULL). Drops viewers that are gone. */
+static void EventsSend( struct event_watch * watch, struct event_subscriber * only, const char * text, size_t length )
+{
+	struct event_subscriber ** link = &watch->subscribers ;
+
+	while ( *link != NULL ) {
+		struct event_subscriber * es = *link ;
+
+		if ( only != NULL && es != only ) {
+			link = &es->next ;
+		} else if ( BAD( HTTPchunk_connection( es->hc, es->minor_version, text, length ) ) ) {
+			*link = es->next ;
+			HttpRelease( es->hc ) ;
+			owfree( es ) ;
+		} else {
+			link = &es->next ;
+		}
+	}
+}
+
+static int EventsHasDevice( struct memblob * devices, const char * device )
+{
+	const char * name = (const char *) MemblobData( devices ) ;
+	const char * end = name + MemblobLength( devices ) ;
+
+	for ( ; name < end ; name += strlen( name ) + 1 ) {
+		if ( strcmp( name, device ) == 0 ) {
+			return 1 ;
+		}
+	}
+	return 0 ;
+}
+
+static void EventsWatchFree( struct event_watch * watch )
+{
+	MemblobClear( &watch->devices ) ;
+	SAFEFREE( watch->value ) ;
+	owfree( watch->path ) ;
+	owfree( watch ) ;
+}
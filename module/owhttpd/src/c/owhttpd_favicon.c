@@ -131,12 +131,6 @@ static const char favicon[] = {
 
 void Favicon(struct OutputControl * oc)
 {
-	FILE * out = oc->out ;
-	int i;
-	
 	HTTPstart(oc, "200 OK", ct_icon);
-	for (i = 0; i < 894; ++i) {
-		fprintf(out, "%c", favicon[i]);
-	}
-	HTTPfoot(oc);
+	fwrite(favicon, 1, sizeof(favicon), oc->out);
 }
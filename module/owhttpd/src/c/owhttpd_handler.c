@@ -24,7 +24,7 @@ struct urlparse {
 	char *value;
 };
 
-enum http_return { http_ok, http_dir, http_icon, http_400, http_404 } ;
+enum http_return { http_ok, http_dir, http_icon, http_snapshot, http_events, http_batch, http_400, http_404 } ;
 
 	/* Error page functions */
 enum content_type PoorMansParser( char * bad_url ) ;
@@ -35,31 +35,51 @@ static void Bad404( struct OutputControl * oc, const enum content_type ct);
 static void URLparse(struct urlparse *up);
 static enum http_return handle_GET( struct OutputControl * oc, struct urlparse * up) ;
 static enum http_return handle_POST( struct OutputControl * oc, struct urlparse * up) ;
-static void ReadToCRLF( struct OutputControl * oc ) ;
 static void TrimBoundary( char ** boundary ) ;
 static int GetPostData( char * boundary, struct memblob * mb, struct OutputControl * oct ) ;
 static char * GetPostPath(  struct OutputControl * oc ) ;
-static GOOD_OR_BAD GetHostURL( struct OutputControl * oc ) ;
 
 /* --------------- Functions ---------------- */
 
-/* Main handler for a web page */
-int handle_socket(FILE * out)
+/* Main handler for a web page. Returns true if the connection can take another request */
+int handle_request( struct http_connection * hc, struct http_request * hr )
 {
 	enum http_return http_code ;
 	enum content_type pmp = ct_html;
 
 	struct urlparse up;
+	char * events_query = NULL ;
 	
-	struct OutputControl s_oc = { out, 0, NULL, NULL, } ;
+	struct OutputControl s_oc ;
 	struct OutputControl * oc = &s_oc ;
 
 	struct parsedname s_pn;
 	struct parsedname * pn = &s_pn ;
+
+	memset( oc, 0, sizeof(struct OutputControl) ) ;
+	oc->connection = hc ;
+	oc->minor_version = hr->minor_version ;
+	oc->keep_alive = hr->keep_alive ;
+	oc->host = hr->host ;
+	oc->if_none_match = hr->if_none_match ;
+	oc->max_age = -1 ;
+	// response body is collected so it can be sent with its length
+	oc->out = open_memstream( &oc->body, &oc->body_length ) ;
+	if ( oc->out == NULL ) {
+		LEVEL_DEBUG("No memory for HTTP response") ;
+		return 0 ;
+	}
+	if ( hr->body != NULL ) {
+		oc->in = fmemopen( hr->body, hr->body_length, "r" ) ;
+	}
 	
-	up.line = NULL ; // prep for getline with null. Will be allocated by getline.
-	if ( getline(&(up.line), &(up.line_length), out) >= 0 ) {
+	if ( hr->line != NULL ) {
+		up.line = hr->line ;
 		LEVEL_CALL("PreParse line=%s", up.line);
+		if ( strncmp( up.line, "GET /events?", 12 ) == 0 ) {
+			// several form fields, URLparse keeps only the first
+			events_query = owstrdup( &up.line[12] ) ;
+		}
 		URLparse(&up);				/* Break up URL */
 		httpunescape((BYTE *) up.file    );
 		httpunescape((BYTE *) up.request );
@@ -72,8 +92,8 @@ int handle_socket(FILE * out)
 
 		oc->base_url = owstrdup( up.file==NULL ? "" : up.file ) ;
 
-		if ( BAD( GetHostURL(oc) ) ) {
-			// No command line in request
+		if ( oc->host == NULL ) {
+			LEVEL_DEBUG("Couldn't find Host: line in HTTP header") ;
 			pn = NO_PARSEDNAME ;
 			http_code = http_400 ;
 		} else if (up.cmd == NULL) {
@@ -87,19 +107,37 @@ int handle_socket(FILE * out)
 		} else if (strcasecmp(up.file, "/favicon.ico") == 0) {
 			// special case for the icon
 			LEVEL_DEBUG("http icon request.");
-			ReadToCRLF(oc) ;
 			pn = NO_PARSEDNAME ;
 			http_code = http_icon ;
+		} else if (strcmp(up.file, "/events") == 0) {
+			// change stream, stays open
+			LEVEL_DEBUG("http events request.");
+			pn = NO_PARSEDNAME ;
+			http_code = http_events ;
+		} else if (strcmp(up.file, "/batch") == 0) {
+			// many values in one request
+			LEVEL_DEBUG("http batch request.");
+			pn = NO_PARSEDNAME ;
+			http_code = (strcmp(up.cmd, "POST") == 0) ? http_batch : http_400 ;
+		} else if (strncasecmp(up.file, "/snapshot", 9) == 0 && (up.file[9] == '\0' || up.file[9] == '/')) {
+			// whole tree as JSON -- optional directory after, e.g. /snapshot/bus.0
+			LEVEL_DEBUG("http snapshot request.");
+			if (FS_ParsedName(up.file[9] == '\0' ? "/" : &up.file[9], pn) != 0) {
+				pn = NO_PARSEDNAME ;
+				http_code = http_404 ;
+			} else if (pn->selected_device != NO_DEVICE) {
+				http_code = http_404 ;
+			} else {
+				http_code = http_snapshot ;
+			}
 		} else 	if (FS_ParsedName(up.file, pn) != 0) {
 			// Can't understand the file name = URL
 			LEVEL_DEBUG("http %s not understood.",up.file);
-			ReadToCRLF(oc) ;
 			pn = NO_PARSEDNAME ;
 			http_code = http_404 ;
 		} else if (pn->selected_device == NO_DEVICE) {
 			// directory!
 			LEVEL_DEBUG("http directory request.");
-			ReadToCRLF(oc) ;
 			http_code = http_dir ;
 		} else if (strcmp(up.cmd, "POST") == 0) {
 			LEVEL_DEBUG("http POST request.");
@@ -123,7 +161,6 @@ int handle_socket(FILE * out)
 				}
 			}
 		} else {
-			ReadToCRLF(oc) ;
 			http_code = http_400 ;
 		}
 		switch ( http_code ) {
@@ -136,17 +173,13 @@ int handle_socket(FILE * out)
 				// not an error
 				break ;
 		}
-		// allocated by getline
-		free(up.line) ;
 	} else {
 		LEVEL_DEBUG("No http data.");
 		pn = NO_PARSEDNAME ;
 		http_code = http_400 ;
+		oc->keep_alive = 0 ;
 	}
 
-	// This is necessary for SunOS
-	fflush(out);
-	
 	switch ( http_code ) {
 		case http_icon:
 			Favicon(oc);
@@ -160,6 +193,26 @@ int handle_socket(FILE * out)
 		case http_dir:
 			ShowDir(oc, pn);
 			break ;
+		case http_snapshot:
+			ShowSnapshot(oc, pn);
+			break ;
+		case http_events:
+			switch ( ShowEvents(oc, events_query) ) {
+				case 0:
+					break ;
+				case -ENOENT:
+					Bad404(oc, ct_text);
+					break ;
+				default:
+					Bad400(oc, ct_text);
+					break ;
+			}
+			break ;
+		case http_batch:
+			if ( ShowBatch(oc, hr->body, hr->body_length) != 0 ) {
+				Bad400(oc, ct_json);
+			}
+			break ;
 		case http_ok:
 			ShowDevice(oc, pn);
 			break ;
@@ -167,25 +220,28 @@ int handle_socket(FILE * out)
 	if ( pn != NO_PARSEDNAME ) {
 		FS_ParsedName_destroy(pn);
 	}
-	
+
+	if ( BAD( HTTPsend(oc) ) ) {
+		oc->keep_alive = 0 ;
+	}
+
+	fclose( oc->out ) ;
+	free( oc->body ) ; // allocated by open_memstream with malloc, not owmalloc
+	if ( oc->in != NULL ) {
+		fclose( oc->in ) ;
+	}
 	if ( oc->base_url != NULL ) {
 		owfree( oc->base_url ) ;
 	}
-	if ( oc->host != NULL ) {
-		owfree( oc->host ) ;
-	}
+	SAFEFREE( events_query ) ;
 	
-	return 0 ;
+	return oc->keep_alive ;
 }	
 
 /* The HTTP request is a GET message */
 static enum http_return handle_GET( struct OutputControl * oc, struct urlparse * up)
 {
-	/* read lines until blank */
-	if (up->version) {
-		ReadToCRLF( oc ) ;
-	}
-	
+	(void) oc ; // request was already read whole
 	if (up->request == NULL) {
 		// NO request -- just a read or dir, not a write
 		LEVEL_DEBUG("Simple GET request -- read a value or directory");
@@ -235,19 +291,20 @@ static enum http_return handle_GET( struct OutputControl * oc, struct urlparse *
 /* The HTTP request is a POST message */
 static enum http_return handle_POST( struct OutputControl * oc, struct urlparse * up)
 {
-	FILE* out = oc->out ;
+	FILE* in = oc->in ;
 	enum http_return http_code = http_404 ; // default error mode
 
 	char * boundary = NULL ;
 	size_t boundary_length ;
 	
-	/* read lines until blank */
-	if (up->version) {
-		ReadToCRLF( oc ) ;
+	(void) up ; // path came through the form data
+	if ( in == NULL ) {
+		LEVEL_DEBUG("POST without a body");
+		return http_400 ;
 	}
-	
+
 	// use getline because it handles null chars
-	if ( getline(&boundary,&boundary_length,out) > 2 ) {
+	if ( getline(&boundary,&boundary_length,in) > 2 ) {
 		char * post_path  = GetPostPath( oc ) ;
 
 		TrimBoundary( &boundary) ;
@@ -418,27 +475,6 @@ static void Bad404(struct OutputControl * oc, const enum content_type ct)
 }	}
 
 
-static void ReadToCRLF( struct OutputControl * oc )
-{
-	FILE * out = oc->out ;
-	char * text_in = NULL ;
-	size_t length_in = 0 ;
-	ssize_t getline_length ;
-
-	/* read lines until blank */
-	while ( (getline_length = getline(&text_in, &length_in, out)) > 0 )  {
-		LEVEL_DEBUG("More (%d) data:%s",(int)getline_length,text_in);
-		if ( strcmp(text_in, "\r\n")==0 || strcmp(text_in, "\n")==0 ) {
-			break ;
-		}
-	}
-	
-	
-	if ( text_in != NULL ) {
-		free( text_in) ;
-	}
-}
-
 static void TrimBoundary( char ** boundary )
 {
 	char * remove_char ;
@@ -456,13 +492,13 @@ static void TrimBoundary( char ** boundary )
 
 static char * GetPostPath(struct OutputControl * oc )
 {
-	FILE * out = oc->out ;
+	FILE * in = oc->in ;
 	char * text_in = NULL ;
 	size_t length_in = 0 ;
 	char * path_found = NO_PATH ;
 	
 	/* read lines until blank */
-	while (getline(&text_in, &length_in, out)>-1)  {
+	while (getline(&text_in, &length_in, in)>-1)  {
 		char * namestart ;
 		LEVEL_DEBUG("Post data:%s",SAFESTRING(text_in));
 		if ( strcmp(text_in, "\r\n")==0 || strcmp(text_in, "\n")==0 ) {
@@ -493,14 +529,14 @@ static char * GetPostPath(struct OutputControl * oc )
 // read data from file upload
 static int GetPostData( char * boundary, struct memblob * mb, struct OutputControl * oc )
 {
-	FILE * out = oc->out ;
+	FILE * in = oc->in ;
 	char * data = NULL ;
 	size_t data_length ;
 
 	ssize_t read_this_pass ;
 
 	MemblobInit( mb, 1000 ) ; // increqment in 1K amounts (arbitrary)
-	while ( (read_this_pass = getline(&data, &data_length, out)) > -1 ) {
+	while ( (read_this_pass = getline(&data, &data_length, in)) > -1 ) {
 		Debug_Bytes(boundary,(BYTE *)data,(size_t)read_this_pass);
 		if ( strstr( data, boundary ) != NULL ) {
 			free(data) ; // allocated by getline with malloc, not owmalloc
@@ -543,34 +579,3 @@ enum content_type PoorMansParser( char * bad_url )
 	LEVEL_DEBUG("Error on http request <%s> assume html",bad_url);
 	return ct_html ;
 }
-			
-static GOOD_OR_BAD GetHostURL( struct OutputControl * oc )
-{
-	FILE * out = oc->out ;
-	char * line = NULL ;
-	static regex_t rx_host ;
-	struct ow_regmatch orm ;
-	
-	orm.number = 1 ;	
-	
-	ow_regcomp( &rx_host, "host *: *([^ ]+) *\r", REG_ICASE ) ;
-
-	do {
-		size_t s ;
-
-		if ( getline( &line, &s, out ) < 0 ) {
-			free( line ) ;
-			LEVEL_DEBUG("Couldn't find Host: line in HTTP header") ;
-			return gbBAD ;
-		}
-		LEVEL_DEBUG("Test line <%s>",line ) ;
-		if ( ow_regexec( &rx_host, line, &orm ) != 0 ) {
-			LEVEL_DEBUG("No match <%s>",line) ;
-			continue ;
-		}
-		oc->host = owstrdup( orm.match[1] ) ;
-		ow_regexec_free( &orm ) ;
-		free(line) ;
-		return gbGOOD ;				
-	} while (1) ;
-}
@@ -18,35 +18,203 @@
 	/* Utility HTML page display functions */
 void HTTPstart(struct OutputControl * oc, const char *status, const enum content_type ct)
 {
-	FILE * out = oc->out ;
+	// headers are written by HTTPsend once the body length is known
+	oc->status = status ;
+	oc->content = ct ;
+}
+
+/* Page freshness is that of its shortest lived value */
+void HTTPlifetime(struct OutputControl * oc, const struct parsedname * pn)
+{
+	struct filetype * ft = pn->selected_filetype ;
+	time_t remaining ;
+
+	if ( ft == NO_FILETYPE || ft->read == NO_READ_FUNCTION || ft->format == ft_directory || ft->format == ft_subdir || IsStructureDir(pn) ) {
+		// not a value
+		return ;
+	}
+	if ( ft->change == fc_static ) {
+		// address, id, type ... never expire, so set no limit
+		return ;
+	}
+	// 0 if not in the local cache (e.g. read through owserver, links, pages)
+	remaining = Cache_Remaining(pn) ;
+	if ( oc->max_age < 0 || remaining < oc->max_age ) {
+		oc->max_age = remaining ;
+	}
+}
+
+/* Entity tag from the response body (FNV-1a), quoted */
+static void HTTPetag(struct OutputControl * oc, char * etag, size_t size)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL ;
+	size_t i ;
+
+	for ( i = 0 ; i < oc->body_length ; ++i ) {
+		hash ^= (BYTE) oc->body[i] ;
+		hash *= 0x100000001b3ULL ;
+	}
+	snprintf(etag, size, "\"%016llx\"", (unsigned long long) hash) ;
+}
+
+/* Status line and headers. Content-Length framing unless streaming */
+static int HTTPheaders(struct OutputControl * oc, const char * etag, char * header, size_t size)
+{
 	char d[44];
 	time_t t = NOW_TIME;
 	size_t l = strftime(d, sizeof(d), "%a, %d %b %Y %T GMT", gmtime(&t));
+	const char * content = "" ;
+	char framing[40] ;
+	char connection[60] ;
+	char validators[80] ;
+	int not_modified = ( strncmp(oc->status, "304", 3) == 0 ) ;
 
-	fprintf(out, "HTTP/1.0 %s\r\n", status);
-	fprintf(out, "Date: %*s\r\n", (int) l, d);
-	fprintf(out, "Server: %s\r\n", SVERSION);
-	fprintf(out, "Last-Modified: %*s\r\n", (int) l, d);
-	/*
-	 * fprintf( out, "MIME-version: 1.0\r\n" );
-	 */
-	switch (ct) {
+	switch (oc->content) {
 	case ct_html:
-		fprintf(out, "Content-Type: text/html\r\n");
+		content = "Content-Type: text/html\r\n" ;
 		break;
 	case ct_icon:
-		fprintf(out, "Content-Length: 894\r\n");
-		fprintf(out, "Connection: close\r\n");
+		content = "Content-Type: image/x-icon\r\n" ;
 		break ;
 	case ct_text:
-		fprintf(out, "Content-Type: text/plain\r\n");
+		content = "Content-Type: text/plain\r\n" ;
 		break ;
 	case ct_json:
-		fprintf(out, "Access-Control-Allow-Origin: *\r\n");
-		fprintf(out, "Content-Type: application/json\r\n");
+		content = "Access-Control-Allow-Origin: *\r\nContent-Type: application/json\r\n" ;
+		break ;
+	case ct_event:
+		content = "Access-Control-Allow-Origin: *\r\nContent-Type: text/event-stream\r\n" ;
 		break ;
 	}
-	fprintf(out, "\r\n");
+
+	if ( not_modified ) {
+		// no body
+		framing[0] = '\0' ;
+	} else if ( ! oc->streaming ) {
+		snprintf(framing, sizeof(framing), "Content-Length: %lu\r\n", (unsigned long) oc->body_length);
+	} else if ( oc->minor_version > 0 ) {
+		snprintf(framing, sizeof(framing), "Transfer-Encoding: chunked\r\n");
+	} else {
+		// HTTP/1.0 stream ends when the connection closes
+		framing[0] = '\0' ;
+	}
+
+	if ( oc->keep_alive ) {
+		snprintf(connection, sizeof(connection), "Connection: keep-alive\r\nKeep-Alive: timeout=%d\r\n", Globals.timeout_http);
+	} else {
+		snprintf(connection, sizeof(connection), "Connection: close\r\n");
+	}
+
+	// a cache may keep the page as long as the values it shows
+	if ( etag != NULL && oc->max_age > 0 ) {
+		snprintf(validators, sizeof(validators), "ETag: %s\r\nCache-Control: max-age=%ld\r\n", etag, oc->max_age);
+	} else if ( etag != NULL ) {
+		snprintf(validators, sizeof(validators), "ETag: %s\r\nCache-Control: no-cache\r\n", etag);
+	} else {
+		snprintf(validators, sizeof(validators), "Cache-Control: no-cache\r\n");
+	}
+
+	return snprintf(header, size,
+		"HTTP/1.1 %s\r\n"
+		"Date: %*s\r\n"
+		"Server: %s\r\n"
+		"Last-Modified: %*s\r\n"
+		"%s%s%s%s\r\n",
+		oc->status, (int) l, d, SVERSION, (int) l, d, validators, content, framing, connection);
+}
+
+/* Queue the headers now, the body follows in pieces from HTTPchunk */
+void HTTPstream(struct OutputControl * oc, const char *status, const enum content_type ct)
+{
+	char header[512] ;
+	struct iovec io[1] ;
+
+	HTTPstart(oc, status, ct) ;
+	oc->streaming = 1 ;
+	if ( oc->minor_version == 0 ) {
+		oc->keep_alive = 0 ;
+	}
+
+	io[0].iov_base = header ;
+	io[0].iov_len = HTTPheaders(oc, NULL, header, sizeof(header)) ;
+	if ( BAD( HttpQueue(oc->connection, io, 1) ) ) {
+		oc->keep_alive = 0 ;
+	}
+}
+
+void HTTPchunk(struct OutputControl * oc, const char * data, size_t length)
+{
+	if ( BAD( HTTPchunk_connection(oc->connection, oc->minor_version, data, length) ) ) {
+		oc->keep_alive = 0 ;
+	}
+}
+
+/* One piece of a streamed body, also for streams outliving the request (events) */
+GOOD_OR_BAD HTTPchunk_connection(struct http_connection * hc, int minor_version, const char * data, size_t length)
+{
+	char chunk_size[20] ;
+	struct iovec io[3] ;
+
+	if ( length == 0 ) {
+		// would look like the end of the stream
+		return gbGOOD ;
+	}
+	if ( minor_version == 0 ) {
+		io[0].iov_base = (void *) (uintptr_t) data ; // only copied
+		io[0].iov_len = length ;
+		return HttpQueue(hc, io, 1) ;
+	}
+
+	io[0].iov_base = chunk_size ;
+	io[0].iov_len = snprintf(chunk_size, sizeof(chunk_size), "%lX\r\n", (unsigned long) length) ;
+	io[1].iov_base = (void *) (uintptr_t) data ; // only copied
+	io[1].iov_len = length ;
+	io[2].iov_base = "\r\n" ;
+	io[2].iov_len = 2 ;
+	return HttpQueue(hc, io, 3) ;
+}
+
+/* Queue the response -- headers and the body collected in oc->out */
+GOOD_OR_BAD HTTPsend(struct OutputControl * oc)
+{
+	char header[512] ;
+	char etag[20] ;
+	struct iovec io[2] ;
+
+	if ( oc->streaming ) {
+		if ( oc->held ) {
+			// still going, ended by the client
+			return gbGOOD ;
+		}
+		if ( oc->minor_version > 0 ) {
+			// last chunk
+			io[0].iov_base = "0\r\n\r\n" ;
+			io[0].iov_len = 5 ;
+			return HttpQueue(oc->connection, io, 1) ;
+		}
+		return gbGOOD ;
+	}
+
+	fflush(oc->out) ;
+	if ( oc->status == NULL ) {
+		HTTPstart(oc, "500 Internal Server Error", ct_html) ;
+	}
+
+	io[1].iov_base = oc->body ;
+	io[1].iov_len = oc->body_length ;
+	if ( strncmp(oc->status, "200", 3) != 0 ) {
+		io[0].iov_len = HTTPheaders(oc, NULL, header, sizeof(header)) ;
+	} else {
+		HTTPetag(oc, etag, sizeof(etag)) ;
+		if ( oc->if_none_match != NULL && ( strstr(oc->if_none_match, etag) != NULL || strcmp(oc->if_none_match, "*") == 0 ) ) {
+			// client already has this page
+			oc->status = "304 Not Modified" ;
+			io[1].iov_len = 0 ;
+		}
+		io[0].iov_len = HTTPheaders(oc, etag, header, sizeof(header)) ;
+	}
+	io[0].iov_base = header ;
+	return HttpQueue(oc->connection, io, 2) ;
 }
 
 void HTTPtitle(struct OutputControl * oc, const char *title)
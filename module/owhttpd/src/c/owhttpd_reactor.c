@@ -0,0 +1,497 @@
+/*
+ * owhttpd_reactor.c for owhttpd (1-wire web server)
+ * By Paul Alfille 2003, using libow
+ * offshoot of the owfs ( 1wire file system )
+ *
+ * GPL license ( Gnu Public Lincense )
+ *
+ * Connection handling
+ *
+ */
+
+#include "owhttpd.h"
+
+/* One thread (the reactor) owns every client socket. It reads requests
+ * and writes responses without blocking, so a slow client costs only the
+ * memory for its reply.
+ *
+ * A complete request is handed to a fixed pool of workers, the only
+ * threads that read the 1-wire bus. A worker builds the response in
+ * memory and queues it on the connection. The reactor writes it out.
+ *
+ * A connection has one request at a time with a worker. Pipelined
+ * requests wait in the read buffer until the response is written.
+ * A held connection (event stream) stays open after the worker is done
+ * and takes more output until it is released.
+ */
+
+struct http_output {
+	struct http_output * next ;
+	size_t length ;
+	size_t sent ;
+	// data follows
+} ;
+
+#define HttpOutputData(ho)   ( (char *) ( (ho) + 1 ) )
+
+struct http_connection {
+	struct http_connection * next ;     // reactor list
+	struct http_connection * next_job ; // worker queue
+	FILE_DESCRIPTOR_OR_ERROR file_descriptor ;
+	char * buffer ;                     // unprocessed input
+	size_t length ;
+	struct http_request request ;       // being handled by a worker
+	int working ;                       // reactor only -- a worker has the request
+	time_t last_active ;
+	time_t write_since ;                // reactor only -- output waiting for the client since, 0 if none
+
+	/* shared with the worker, under output_mutex */
+	struct http_output * output_head ;
+	struct http_output * output_tail ;
+	int done ;                          // response complete
+	int keep_alive ;
+	int broken ;                        // client gone, drop output
+	int holds ;                         // streams still writing
+} ;
+
+static pthread_mutex_t output_mutex = PTHREAD_MUTEX_INITIALIZER ;
+static pthread_mutex_t job_mutex = PTHREAD_MUTEX_INITIALIZER ;
+static pthread_cond_t job_cond = PTHREAD_COND_INITIALIZER ;
+
+#define OUTPUTLOCK     _MUTEX_LOCK(   output_mutex )
+#define OUTPUTUNLOCK   _MUTEX_UNLOCK( output_mutex )
+#define JOBLOCK        _MUTEX_LOCK(   job_mutex )
+#define JOBUNLOCK      _MUTEX_UNLOCK( job_mutex )
+#define JOBWAIT        my_pthread_cond_wait(   &job_cond, &job_mutex )
+#define JOBSIGNAL      my_pthread_cond_signal( &job_cond )
+
+static struct http_connection * job_head = NULL ;
+static struct http_connection * job_tail = NULL ;
+
+static struct http_connection * connection_list = NULL ; // reactor only
+static struct http_connection * connection_new = NULL ;  // under output_mutex
+
+static FILE_DESCRIPTOR_OR_ERROR wake_pipe[2] = { FILE_DESCRIPTOR_BAD, FILE_DESCRIPTOR_BAD, } ;
+
+static void * HttpReactor( void * v ) ;
+static void * HttpWorker( void * v ) ;
+static void HttpWake( void ) ;
+static void HttpDispatch( struct http_connection * hc ) ;
+static GOOD_OR_BAD HttpRead( struct http_connection * hc ) ;
+static GOOD_OR_BAD HttpWrite( struct http_connection * hc ) ;
+static void HttpOutputClear( struct http_connection * hc ) ;
+static void HttpClose( struct http_connection * hc ) ;
+static GOOD_OR_BAD HttpNonBlocking( FILE_DESCRIPTOR_OR_ERROR file_descriptor ) ;
+
+/* Start the reactor and the worker pool */
+GOOD_OR_BAD HttpReactorStart( void )
+{
+	pthread_t thread ;
+	int worker ;
+
+	_MUTEX_INIT( output_mutex ) ;
+	_MUTEX_INIT( job_mutex ) ;
+
+	if ( pipe( wake_pipe ) != 0 ) {
+		ERROR_DEFAULT("Cannot create the owhttpd reactor pipe") ;
+		return gbBAD ;
+	}
+	RETURN_BAD_IF_BAD( HttpNonBlocking( wake_pipe[fd_pipe_read] ) ) ;
+	RETURN_BAD_IF_BAD( HttpNonBlocking( wake_pipe[fd_pipe_write] ) ) ;
+
+	if ( pthread_create( &thread, DEFAULT_THREAD_ATTR, HttpReactor, NULL ) != 0 ) {
+		ERROR_DEFAULT("Cannot start the owhttpd reactor thread") ;
+		return gbBAD ;
+	}
+
+	for ( worker = 0 ; worker < Globals.http_workers ; ++worker ) {
+		if ( pthread_create( &thread, DEFAULT_THREAD_ATTR, HttpWorker, NULL ) != 0 ) {
+			if ( worker == 0 ) {
+				ERROR_DEFAULT("Cannot start any owhttpd worker threads") ;
+				return gbBAD ;
+			}
+			LEVEL_DEFAULT("Only %d owhttpd worker threads started", worker) ;
+			break ;
+		}
+	}
+	LEVEL_DEBUG("owhttpd reactor with %d workers", worker) ;
+	return gbGOOD ;
+}
+
+/* Take over a newly accepted client socket (the caller keeps its own copy) */
+void HttpReactorAdd( FILE_DESCRIPTOR_OR_ERROR file_descriptor )
+{
+	struct http_connection * hc ;
+
+	if ( file_descriptor >= FD_SETSIZE ) {
+		LEVEL_DEBUG("Too many open files for another http connection") ;
+		close( file_descriptor ) ;
+		return ;
+	}
+
+	hc = owcalloc( 1, sizeof( struct http_connection ) ) ;
+	if ( hc == NULL ) {
+		close( file_descriptor ) ;
+		return ;
+	}
+	hc->buffer = owmalloc( HTTP_REQUEST_MAX ) ;
+	if ( hc->buffer == NULL || BAD( HttpNonBlocking( file_descriptor ) ) ) {
+		SAFEFREE( hc->buffer ) ;
+		owfree( hc ) ;
+		close( file_descriptor ) ;
+		return ;
+	}
+	hc->file_descriptor = file_descriptor ;
+	hc->last_active = NOW_TIME ;
+
+	OUTPUTLOCK ;
+	hc->next = connection_new ;
+	connection_new = hc ;
+	OUTPUTUNLOCK ;
+	HttpWake() ;
+}
+
+/* Add to a connection's response (worker side). Pieces are copied into one buffer. */
+GOOD_OR_BAD HttpQueue( struct http_connection * hc, const struct iovec * io, int nio )
+{
+	struct http_output * ho ;
+	size_t length = 0 ;
+	char * data ;
+	int i ;
+
+	for ( i = 0 ; i < nio ; ++i ) {
+		length += io[i].iov_len ;
+	}
+	ho = owmalloc( sizeof( struct http_output ) + length ) ;
+	if ( ho == NULL ) {
+		return gbBAD ;
+	}
+	ho->next = NULL ;
+	ho->length = length ;
+	ho->sent = 0 ;
+	data = HttpOutputData( ho ) ;
+	for ( i = 0 ; i < nio ; ++i ) {
+		memcpy( data, io[i].iov_base, io[i].iov_len ) ;
+		data += io[i].iov_len ;
+	}
+
+	OUTPUTLOCK ;
+	if ( hc->broken ) {
+		OUTPUTUNLOCK ;
+		owfree( ho ) ;
+		return gbBAD ;
+	}
+	if ( hc->output_tail == NULL ) {
+		hc->output_head = ho ;
+	} else {
+		hc->output_tail->next = ho ;
+	}
+	hc->output_tail = ho ;
+	OUTPUTUNLOCK ;
+
+	HttpWake() ;
+	return gbGOOD ;
+}
+
+/* Keep the connection after the request is answered (worker side) */
+void HttpHold( struct http_connection * hc )
+{
+	OUTPUTLOCK ;
+	++hc->holds ;
+	OUTPUTUNLOCK ;
+}
+
+/* Stream is finished with the connection -- don't use hc after this */
+void HttpRelease( struct http_connection * hc )
+{
+	OUTPUTLOCK ;
+	--hc->holds ;
+	OUTPUTUNLOCK ;
+	HttpWake() ;
+}
+
+static void HttpWake( void )
+{
+	ignore_result = write( wake_pipe[fd_pipe_write], "W", 1 ) ; // full pipe is already awake
+}
+
+static void * HttpWorker( void * v )
+{
+	(void) v ;
+	DETACH_THREAD ;
+
+	while (1) {
+		struct http_connection * hc ;
+		int keep_alive ;
+
+		JOBLOCK ;
+		while ( job_head == NULL ) {
+			JOBWAIT ;
+		}
+		hc = job_head ;
+		job_head = hc->next_job ;
+		if ( job_head == NULL ) {
+			job_tail = NULL ;
+		}
+		JOBUNLOCK ;
+
+		keep_alive = handle_request( hc, &hc->request ) ;
+		HttpRequestClear( &hc->request ) ;
+
+		OUTPUTLOCK ;
+		hc->done = 1 ;
+		hc->keep_alive = keep_alive ;
+		OUTPUTUNLOCK ;
+		HttpWake() ;
+	}
+	return VOID_RETURN ;
+}
+
+static void * HttpReactor( void * v )
+{
+	(void) v ;
+	DETACH_THREAD ;
+
+	while (1) {
+		fd_set readset ;
+		fd_set writeset ;
+		FILE_DESCRIPTOR_OR_ERROR maxfd = wake_pipe[fd_pipe_read] ;
+		struct timeval tv = { 1, 0, } ; // for idle timeouts
+		struct http_connection ** link ;
+		time_t now = NOW_TIME ;
+		int select_result ;
+
+		FD_ZERO( &readset ) ;
+		FD_ZERO( &writeset ) ;
+		FD_SET( wake_pipe[fd_pipe_read], &readset ) ;
+
+		OUTPUTLOCK ;
+		while ( connection_new != NULL ) {
+			struct http_connection * hc = connection_new ;
+			connection_new = hc->next ;
+			hc->next = connection_list ;
+			connection_list = hc ;
+		}
+		for ( link = &connection_list ; *link != NULL ; link = &(*link)->next ) {
+			struct http_connection * hc = *link ;
+			if ( ! hc->working ) {
+				FD_SET( hc->file_descriptor, &readset ) ;
+			} else if ( hc->output_head != NULL ) {
+				FD_SET( hc->file_descriptor, &writeset ) ;
+				if ( hc->write_since == 0 ) {
+					// the stall clock starts once there is something to send
+					hc->write_since = now ;
+				}
+			} else {
+				continue ;
+			}
+			if ( hc->file_descriptor > maxfd ) {
+				maxfd = hc->file_descriptor ;
+			}
+		}
+		OUTPUTUNLOCK ;
+
+		select_result = select( maxfd + 1, &readset, &writeset, NULL, &tv ) ;
+		if ( select_result < 0 ) {
+			if ( errno != EINTR ) {
+				ERROR_DEBUG("owhttpd reactor select") ;
+			}
+			continue ;
+		}
+		if ( FD_ISSET( wake_pipe[fd_pipe_read], &readset ) ) {
+			char drain[64] ;
+			while ( read( wake_pipe[fd_pipe_read], drain, sizeof(drain) ) > 0 ) {
+			}
+		}
+
+		now = NOW_TIME ;
+		link = &connection_list ;
+		while ( *link != NULL ) {
+			struct http_connection * hc = *link ;
+			int close_connection = 0 ;
+
+			if ( hc->working ) {
+				int stalled ;
+				int finished ;
+
+				if ( FD_ISSET( hc->file_descriptor, &writeset ) ) {
+					if ( BAD( HttpWrite( hc ) ) ) {
+						HttpOutputClear( hc ) ;
+					} else {
+						hc->write_since = now ;
+					}
+				}
+
+				// a slow worker or a quiet stream is not a stall, only output the client will not take
+				OUTPUTLOCK ;
+				if ( hc->output_head == NULL ) {
+					hc->write_since = 0 ;
+				}
+				stalled = hc->write_since != 0 && now - hc->write_since > Globals.timeout_http ;
+				OUTPUTUNLOCK ;
+				if ( stalled ) {
+					LEVEL_DEBUG("http client not reading its response") ;
+					HttpOutputClear( hc ) ;
+				}
+
+				OUTPUTLOCK ;
+				finished = hc->done && hc->output_head == NULL && hc->holds == 0 ;
+				OUTPUTUNLOCK ;
+
+				if ( finished ) {
+					hc->working = 0 ;
+					hc->done = 0 ;
+					hc->last_active = now ;
+					if ( hc->broken || ! hc->keep_alive ) {
+						close_connection = 1 ;
+					} else {
+						// a pipelined request may already be here
+						HttpDispatch( hc ) ;
+					}
+				}
+			} else if ( FD_ISSET( hc->file_descriptor, &readset ) ) {
+				if ( BAD( HttpRead( hc ) ) ) {
+					close_connection = 1 ;
+				} else {
+					hc->last_active = now ;
+					HttpDispatch( hc ) ;
+				}
+			} else if ( now - hc->last_active > Globals.timeout_http ) {
+				LEVEL_DEBUG("http connection idle") ;
+				close_connection = 1 ;
+			}
+
+			if ( close_connection ) {
+				*link = hc->next ;
+				HttpClose( hc ) ;
+			} else {
+				link = &hc->next ;
+			}
+		}
+	}
+	return VOID_RETURN ;
+}
+
+/* Hand a complete request in the buffer to a worker */
+static void HttpDispatch( struct http_connection * hc )
+{
+	SIZE_OR_ERROR used = HttpParseRequest( hc->buffer, hc->length, &hc->request ) ;
+
+	if ( used == 0 ) {
+		// wait for more
+		return ;
+	}
+	if ( used < 0 ) {
+		// worker answers with 400 and the connection closes
+		LEVEL_DEBUG("Malformed HTTP request: %s", strerror(-used) ) ;
+		memset( &hc->request, 0, sizeof( struct http_request ) ) ;
+		hc->length = 0 ;
+	} else {
+		hc->length -= used ;
+		memmove( hc->buffer, hc->buffer + used, hc->length ) ;
+	}
+
+	hc->working = 1 ;
+	hc->next_job = NULL ;
+	JOBLOCK ;
+	if ( job_tail == NULL ) {
+		job_head = hc ;
+	} else {
+		job_tail->next_job = hc ;
+	}
+	job_tail = hc ;
+	JOBSIGNAL ;
+	JOBUNLOCK ;
+}
+
+static GOOD_OR_BAD HttpRead( struct http_connection * hc )
+{
+	ssize_t read_length = read( hc->file_descriptor, hc->buffer + hc->length, HTTP_REQUEST_MAX - hc->length ) ;
+
+	if ( read_length > 0 ) {
+		hc->length += read_length ;
+		return gbGOOD ;
+	}
+	if ( read_length < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ) ) {
+		return gbGOOD ;
+	}
+	LEVEL_DEBUG("http connection closed") ;
+	return gbBAD ;
+}
+
+/* Write as much of the queued response as the socket will take */
+static GOOD_OR_BAD HttpWrite( struct http_connection * hc )
+{
+	struct iovec io[16] ;
+	struct http_output * ho ;
+	int nio = 0 ;
+	ssize_t written ;
+
+	OUTPUTLOCK ;
+	for ( ho = hc->output_head ; ho != NULL && nio < 16 ; ho = ho->next ) {
+		io[nio].iov_base = HttpOutputData( ho ) + ho->sent ;
+		io[nio].iov_len = ho->length - ho->sent ;
+		++nio ;
+	}
+	OUTPUTUNLOCK ;
+
+	written = writev( hc->file_descriptor, io, nio ) ;
+	if ( written < 0 ) {
+		if ( errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ) {
+			return gbGOOD ;
+		}
+		LEVEL_DEBUG("Cannot write HTTP response") ;
+		return gbBAD ;
+	}
+
+	OUTPUTLOCK ;
+	while ( ( ho = hc->output_head ) != NULL && written > 0 ) {
+		size_t left = ho->length - ho->sent ;
+		if ( (size_t) written < left ) {
+			ho->sent += written ;
+			break ;
+		}
+		written -= left ;
+		hc->output_head = ho->next ;
+		if ( hc->output_head == NULL ) {
+			hc->output_tail = NULL ;
+		}
+		owfree( ho ) ;
+	}
+	OUTPUTUNLOCK ;
+	return gbGOOD ;
+}
+
+/* Client is gone -- throw away the response, and any more the worker adds */
+static void HttpOutputClear( struct http_connection * hc )
+{
+	OUTPUTLOCK ;
+	hc->broken = 1 ;
+	while ( hc->output_head != NULL ) {
+		struct http_output * ho = hc->output_head ;
+		hc->output_head = ho->next ;
+		owfree( ho ) ;
+	}
+	hc->output_tail = NULL ;
+	OUTPUTUNLOCK ;
+}
+
+/* Only called when no worker has the connection */
+static void HttpClose( struct http_connection * hc )
+{
+	HttpOutputClear( hc ) ;
+	Test_and_Close( &( hc->file_descriptor ) ) ;
+	owfree( hc->buffer ) ;
+	owfree( hc ) ;
+}
+
+static GOOD_OR_BAD HttpNonBlocking( FILE_DESCRIPTOR_OR_ERROR file_descriptor )
+{
+	int flags = fcntl( file_descriptor, F_GETFL, 0 ) ;
+
+	if ( flags < 0 || fcntl( file_descriptor, F_SETFL, flags | O_NONBLOCK ) < 0 ) {
+		ERROR_DEBUG("Cannot make file descriptor non-blocking") ;
+		return gbBAD ;
+	}
+	return gbGOOD ;
+}
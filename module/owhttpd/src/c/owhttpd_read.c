@@ -63,6 +63,9 @@ static void Show(struct OutputControl * oc, const struct parsedname *pn_entry)
 		ShowDirectory(oc, pn_entry);
 	} else if ( pn_entry->extension == EXTENSION_UNKNOWN  && ft->ag != NON_AGGREGATE && ft->ag->combined == ag_sparse ) {
 		Extension(oc, pn_entry ) ; // flag as generic needing an extension chosen
+	} else if ( ReadAheadLazy(oc, pn_entry) ) {
+		// large memory only on its own page
+		fprintf(out, "<A HREF='%s'>%d bytes</A>", pn_entry->path, (int) FullFileLength(pn_entry));
 	} else if (ft->write == NO_WRITE_FUNCTION || Globals.readonly) {
 		// Unwritable
 		if (ft->read != NO_READ_FUNCTION) {
@@ -78,6 +81,7 @@ static void Show(struct OutputControl * oc, const struct parsedname *pn_entry)
 		}
 	}
 	fprintf(out, "</TD></TR>\r\n");
+	HTTPlifetime(oc, pn_entry);
 	OWQ_destroy(owq);
 }
 
@@ -88,7 +92,7 @@ static void ShowReadWrite(struct OutputControl * oc, struct one_wire_query *owq)
 	FILE * out = oc->out ;
 	struct parsedname * pn = PN(owq) ;
 	const char *file = FS_DirName(pn);
-	SIZE_OR_ERROR read_return = FS_read_postparse(owq);
+	SIZE_OR_ERROR read_return = ReadAheadValue(oc, owq);
 	if (read_return < 0) {
 		fprintf(out, "Error: %s", strerror(-read_return));
 		return;
@@ -151,7 +155,7 @@ static void Extension( struct OutputControl * oc, const struct parsedname * pn )
 static void ShowReadonly(struct OutputControl * oc, struct one_wire_query *owq)
 {
 	FILE * out = oc->out ;
-	SIZE_OR_ERROR read_return = FS_read_postparse(owq);
+	SIZE_OR_ERROR read_return = ReadAheadValue(oc, owq);
 	struct parsedname * pn = PN(owq) ;
 	if (read_return < 0) {
 		fprintf(out, "Error: %s", strerror(-read_return));
@@ -196,7 +200,7 @@ static void ShowReadonly(struct OutputControl * oc, struct one_wire_query *owq)
 static void ShowStructure(struct OutputControl * oc, struct one_wire_query *owq)
 {
 	FILE * out = oc->out ;
-	SIZE_OR_ERROR read_return = FS_read_postparse(owq);
+	SIZE_OR_ERROR read_return = ReadAheadValue(oc, owq);
 	if (read_return < 0) {
 		fprintf(out, "Error: %s", strerror(-read_return));
 		return;
@@ -363,6 +367,7 @@ static void ShowText(struct OutputControl * oc, const struct parsedname *pn_entr
 		}
 	}
 	fprintf(out, "\r\n");
+	HTTPlifetime(oc, pn_entry);
 	OWQ_destroy(owq);
 }
 
@@ -370,7 +375,7 @@ static void ShowText(struct OutputControl * oc, const struct parsedname *pn_entr
 static void ShowTextStructure(struct OutputControl * oc, struct one_wire_query *owq)
 {
 	FILE * out = oc->out ;
-	SIZE_OR_ERROR read_return = FS_read_postparse(owq);
+	SIZE_OR_ERROR read_return = ReadAheadValue(oc, owq);
 	if (read_return < 0) {
 		//fprintf(out, "error: %s", strerror(-read_return));
 		return;
@@ -383,7 +388,7 @@ static void ShowTextStructure(struct OutputControl * oc, struct one_wire_query *
 static void ShowTextReadWrite(struct OutputControl * oc, struct one_wire_query *owq)
 {
 	FILE * out = oc->out ;
-	SIZE_OR_ERROR read_return = FS_read_postparse(owq);
+	SIZE_OR_ERROR read_return = ReadAheadValue(oc, owq);
 	if (read_return < 0) {
 		//fprintf(out, "error: %s", strerror(-read_return));
 		return;
@@ -450,7 +455,9 @@ static void ShowDeviceText(struct OutputControl * oc, struct parsedname *pn)
 
 	if (pn->selected_filetype == NO_DEVICE) {	/* whole device */
 		//printf("whole directory path=%s \n", pn->path);
+		ReadAhead(oc, pn, 0);
 		FS_dir(ShowDeviceTextCallback, oc, pn);
+		ReadAheadClear(oc);
 	} else {					/* Single item */
 		//printf("single item path=%s\n", pn->path);
 		ShowText(oc, pn);
@@ -486,6 +493,7 @@ static void ShowJson(struct OutputControl * oc, const struct parsedname *pn_entr
 			ShowJsonReadWrite(oc, owq);
 		}
 	}
+	HTTPlifetime(oc, pn_entry);
 	OWQ_destroy(owq);
 }
 
@@ -493,7 +501,7 @@ static void ShowJson(struct OutputControl * oc, const struct parsedname *pn_entr
 static void ShowJsonStructure(struct OutputControl * oc, struct one_wire_query *owq)
 {
 	FILE * out = oc->out ;
-	SIZE_OR_ERROR read_return = FS_read_postparse(owq);
+	SIZE_OR_ERROR read_return = ReadAheadValue(oc, owq);
 	if (read_return < 0) {
 		fprintf(out, "null");
 		return;
@@ -597,7 +605,7 @@ static void ShowJsonReadWrite(struct OutputControl * oc, struct one_wire_query *
 {
 	FILE * out = oc->out ;
 	struct parsedname * pn = PN(owq) ;
-	SIZE_OR_ERROR read_return = FS_read_postparse(owq);
+	SIZE_OR_ERROR read_return = ReadAheadValue(oc, owq);
 
 	if (read_return < 0) {
 		fprintf(out, "null");
@@ -665,7 +673,9 @@ static void ShowDeviceJson(struct OutputControl * oc, struct parsedname *pn)
 	if (pn->selected_filetype == NO_DEVICE) {	/* whole device */
 		JSON_dir_init( oc ) ;
 		fprintf(out, "{\n" ) ;
+		ReadAhead(oc, pn, 0);
 		FS_dir(ShowDeviceJsonCallback, oc, pn);
+		ReadAheadClear(oc);
 		JSON_dir_finish(oc) ;
 		fprintf(out, "}" );
 	} else {					/* Single item */
@@ -701,7 +711,9 @@ void ShowDevice(struct OutputControl * oc, struct parsedname *pn)
 
 
 	if (pn->selected_filetype == NO_FILETYPE) {	/* whole device */
+		ReadAhead(oc, pn, 1);
 		FS_dir(ShowDeviceCallback, oc, pn);
+		ReadAheadClear(oc);
 	} else {					/* single item */
 		Show(oc, pn);
 	}
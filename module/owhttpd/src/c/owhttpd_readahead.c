@@ -0,0 +1,247 @@
+/*
+ * owhttpd_readahead.c for owhttpd (1-wire web server)
+ * By Paul Alfille 2003, using libow
+ * offshoot of the owfs ( 1wire file system )
+ *
+ * GPL license ( Gnu Public Lincense )
+ *
+ * Device page values read before the page is drawn
+ *
+ */
+
+#include "owhttpd.h"
+
+/* A whole device page shows every property. Rather than reading each one
+ * as its table line is drawn, all readable values are read first by a few
+ * threads at once. On an owserver bus the round trips overlap, on a local
+ * bus the bus lock still takes them in turn.
+ *
+ * If several temperature properties need a conversion (not cached) one
+ * simultaneous conversion is started for the bus first, by the same rule
+ * as FS_read_many, and those properties are read last so the other reads
+ * use up the conversion time.
+ *
+ * The HTML page does not read large memory properties at all, it links
+ * to them instead.
+ */
+
+#define READ_AHEAD_THREADS     4
+#define READ_AHEAD_LAZY_BYTES  64    // larger binary properties only on their own page
+
+struct read_ahead_value {
+	char * path ;
+	int temperature ;                 // waits on a simultaneous conversion
+	SIZE_OR_ERROR read_return ;
+	BYTE * data ;
+} ;
+
+struct read_ahead {
+	struct read_ahead_value * values ;
+	int nvalues ;
+	int allocated ;
+	int lazy ;                        // skip large memory properties
+	int next ;                        // read order, see ReadAheadNext
+	pthread_mutex_t mutex ;
+} ;
+
+static void ReadAheadCallback( void * v, const struct parsedname * pn_entry ) ;
+static int ReadAheadLarge( const struct parsedname * pn_entry ) ;
+static void * ReadAheadThread( void * v ) ;
+static struct read_ahead_value * ReadAheadNext( struct read_ahead * ra ) ;
+static void ReadAheadOne( struct read_ahead_value * rav ) ;
+
+/* Read the values of a whole device, lazy to skip large memory (HTML page) */
+void ReadAhead( struct OutputControl * oc, struct parsedname * pn_device, int lazy )
+{
+	struct read_ahead * ra ;
+	pthread_t threads[READ_AHEAD_THREADS] ;
+	int threadbad[READ_AHEAD_THREADS] ;
+	int nthreads ;
+	int value_index ;
+	int temperatures = 0 ;
+	int thread_index ;
+
+	ra = owcalloc( 1, sizeof( struct read_ahead ) ) ;
+	if ( ra == NULL ) {
+		// values will be read as drawn
+		return ;
+	}
+	ra->lazy = lazy ;
+	_MUTEX_INIT( ra->mutex ) ;
+	FS_dir( ReadAheadCallback, ra, pn_device ) ;
+	oc->read_ahead = ra ;
+	if ( ra->nvalues == 0 ) {
+		return ;
+	}
+
+	for ( value_index = 0 ; value_index < ra->nvalues ; ++value_index ) {
+		temperatures += ra->values[value_index].temperature ;
+	}
+	if ( KnownBus( pn_device ) ) {
+		FS_simultaneous_start( pn_device->selected_connection, temperatures ) ;
+	}
+
+	// this thread is one of the readers
+	nthreads = ( ra->nvalues < READ_AHEAD_THREADS ) ? ra->nvalues : READ_AHEAD_THREADS ;
+	for ( thread_index = 1 ; thread_index < nthreads ; ++thread_index ) {
+		threadbad[thread_index] = pthread_create( &threads[thread_index], DEFAULT_THREAD_ATTR, ReadAheadThread, (void *) ra ) ;
+		if ( threadbad[thread_index] != 0 ) {
+			LEVEL_DEBUG("Cannot create read ahead thread");
+		}
+	}
+	ReadAheadThread( ra ) ;
+	for ( thread_index = 1 ; thread_index < nthreads ; ++thread_index ) {
+		if ( threadbad[thread_index] == 0 ) {
+			pthread_join( threads[thread_index], NULL ) ;
+		}
+	}
+	LEVEL_DEBUG("Read %d values of %s ahead", ra->nvalues, pn_device->path ) ;
+}
+
+void ReadAheadClear( struct OutputControl * oc )
+{
+	struct read_ahead * ra = oc->read_ahead ;
+	int value_index ;
+
+	if ( ra == NULL ) {
+		return ;
+	}
+	for ( value_index = 0 ; value_index < ra->nvalues ; ++value_index ) {
+		SAFEFREE( ra->values[value_index].path ) ;
+		SAFEFREE( ra->values[value_index].data ) ;
+	}
+	SAFEFREE( ra->values ) ;
+	_MUTEX_DESTROY( ra->mutex ) ;
+	owfree( ra ) ;
+	oc->read_ahead = NULL ;
+}
+
+/* Value read ahead, else read now */
+SIZE_OR_ERROR ReadAheadValue( struct OutputControl * oc, struct one_wire_query * owq )
+{
+	struct read_ahead * ra = oc->read_ahead ;
+	int value_index ;
+
+	if ( ra != NULL ) {
+		for ( value_index = 0 ; value_index < ra->nvalues ; ++value_index ) {
+			struct read_ahead_value * rav = &ra->values[value_index] ;
+			if ( strcmp( rav->path, PN(owq)->path ) == 0 ) {
+				if ( rav->read_return <= 0 ) {
+					return rav->read_return ;
+				}
+				if ( (size_t) rav->read_return > OWQ_size(owq) ) {
+					// buffer differs, read again
+					break ;
+				}
+				memcpy( OWQ_buffer(owq), rav->data, rav->read_return ) ;
+				return rav->read_return ;
+			}
+		}
+	}
+	return FS_read_postparse( owq ) ;
+}
+
+/* Large memory property left out of the HTML device page */
+int ReadAheadLazy( struct OutputControl * oc, const struct parsedname * pn_entry )
+{
+	return oc->read_ahead != NULL && oc->read_ahead->lazy && ReadAheadLarge( pn_entry ) ;
+}
+
+static int ReadAheadLarge( const struct parsedname * pn_entry )
+{
+	return pn_entry->selected_filetype->format == ft_binary && FullFileLength( pn_entry ) > READ_AHEAD_LAZY_BYTES ;
+}
+
+/* Readable values only -- the same choice Show makes */
+static void ReadAheadCallback( void * v, const struct parsedname * pn_entry )
+{
+	struct read_ahead * ra = v ;
+	struct filetype * ft = pn_entry->selected_filetype ;
+	struct read_ahead_value * rav ;
+
+	if ( ft == NO_FILETYPE || IsStructureDir( pn_entry ) || ft->format == ft_directory || ft->format == ft_subdir ) {
+		return ;
+	}
+	if ( ft->read == NO_READ_FUNCTION ) {
+		return ;
+	}
+	if ( pn_entry->extension == EXTENSION_UNKNOWN && ft->ag != NON_AGGREGATE && ft->ag->combined == ag_sparse ) {
+		return ;
+	}
+	if ( ra->lazy && ReadAheadLarge( pn_entry ) ) {
+		return ;
+	}
+
+	if ( ra->nvalues == ra->allocated ) {
+		int allocated = ( ra->allocated == 0 ) ? 32 : 2 * ra->allocated ;
+		struct read_ahead_value * values = owrealloc( ra->values, allocated * sizeof( struct read_ahead_value ) ) ;
+		if ( values == NULL ) {
+			// rest are read as drawn
+			return ;
+		}
+		ra->values = values ;
+		ra->allocated = allocated ;
+	}
+	rav = &ra->values[ra->nvalues] ;
+	rav->path = owstrdup( pn_entry->path ) ;
+	if ( rav->path == NULL ) {
+		return ;
+	}
+	rav->temperature = FS_simultaneous_wanted( pn_entry ) ;
+	rav->read_return = -EINVAL ;
+	rav->data = NULL ;
+	++ra->nvalues ;
+}
+
+static void * ReadAheadThread( void * v )
+{
+	struct read_ahead * ra = v ;
+	struct read_ahead_value * rav ;
+
+	while ( (rav = ReadAheadNext( ra )) != NULL ) {
+		ReadAheadOne( rav ) ;
+	}
+	return VOID_RETURN ;
+}
+
+/* Other values first, then the ones waiting on the conversion */
+static struct read_ahead_value * ReadAheadNext( struct read_ahead * ra )
+{
+	struct read_ahead_value * rav = NULL ;
+
+	_MUTEX_LOCK( ra->mutex ) ;
+	while ( rav == NULL && ra->next < 2 * ra->nvalues ) {
+		int pass = ra->next / ra->nvalues ;
+		struct read_ahead_value * candidate = &ra->values[ra->next % ra->nvalues] ;
+		++ra->next ;
+		if ( candidate->temperature == pass ) {
+			rav = candidate ;
+		}
+	}
+	_MUTEX_UNLOCK( ra->mutex ) ;
+	return rav ;
+}
+
+static void ReadAheadOne( struct read_ahead_value * rav )
+{
+	struct one_wire_query * owq = OWQ_create_from_path( rav->path ) ;
+
+	if ( owq == NO_ONE_WIRE_QUERY ) {
+		rav->read_return = -ENOENT ;
+		return ;
+	}
+	if ( BAD( OWQ_allocate_read_buffer( owq ) ) ) {
+		rav->read_return = -ENOMEM ;
+	} else {
+		rav->read_return = FS_read_postparse( owq ) ;
+		if ( rav->read_return > 0 ) {
+			rav->data = owmalloc( rav->read_return ) ;
+			if ( rav->data == NULL ) {
+				rav->read_return = -ENOMEM ;
+			} else {
+				memcpy( rav->data, OWQ_buffer(owq), rav->read_return ) ;
+			}
+		}
+	}
+	OWQ_destroy( owq ) ;
+}
@@ -0,0 +1,241 @@
+/*
+ * owhttpd_request.c for owhttpd (1-wire web server)
+ * By Paul Alfille 2003, using libow
+ * offshoot of the owfs ( 1wire file system )
+ *
+ * GPL license ( Gnu Public Lincense )
+ *
+ * Request framing for persistent connections
+ *
+ */
+
+#include "owhttpd.h"
+
+/* A request is parsed only once it is complete -- the request line,
+ * headers, blank line and Content-Length bytes of body. Anything after
+ * it in the buffer is the next (pipelined) request.
+ */
+
+static const char * HttpHeaderEnd( const char * buffer, size_t length, size_t * header_length ) ;
+static char * HttpHeaderValue( const char * line, const char * line_end, const char * name ) ;
+static int HttpMinorVersion( const char * request_line ) ;
+static int HttpHasToken( const char * value, const char * token ) ;
+static SIZE_OR_ERROR HttpContentLength( const char * value ) ;
+
+void HttpRequestClear( struct http_request * hr )
+{
+	SAFEFREE( hr->line ) ;
+	SAFEFREE( hr->host ) ;
+	SAFEFREE( hr->if_none_match ) ;
+	SAFEFREE( hr->body ) ;
+	hr->body_length = 0 ;
+}
+
+/* returns bytes used for a whole request, 0 if more input is needed, <0 if malformed */
+SIZE_OR_ERROR HttpParseRequest( const char * buffer, size_t length, struct http_request * hr )
+{
+	size_t skip = 0 ;
+	size_t header_length ;
+	const char * header_end ;
+	const char * line ;
+	const char * line_end ;
+	size_t content_length = 0 ;
+
+	memset( hr, 0, sizeof( struct http_request ) ) ;
+
+	// stray line ends between requests are allowed
+	while ( skip < length && ( buffer[skip] == '\r' || buffer[skip] == '\n' ) ) {
+		++skip ;
+	}
+	buffer += skip ;
+	length -= skip ;
+
+	header_end = HttpHeaderEnd( buffer, length, &header_length ) ;
+	if ( header_end == NULL ) {
+		return ( skip + length < HTTP_REQUEST_MAX ) ? 0 : -EMSGSIZE ;
+	}
+
+	// request line
+	line = memchr( buffer, '\n', header_length ) ;
+	hr->line = owmalloc( line - buffer + 1 ) ;
+	if ( hr->line == NULL ) {
+		return -ENOMEM ;
+	}
+	memcpy( hr->line, buffer, line - buffer ) ;
+	hr->line[line - buffer] = '\0' ;
+	if ( line > buffer && hr->line[line - buffer - 1] == '\r' ) {
+		hr->line[line - buffer - 1] = '\0' ;
+	}
+	hr->minor_version = HttpMinorVersion( hr->line ) ;
+	// HTTP/1.1 persists unless told otherwise, HTTP/1.0 only when asked
+	hr->keep_alive = ( hr->minor_version > 0 ) ;
+
+	// headers, one per line
+	for ( ++line ; line < header_end ; line = line_end + 1 ) {
+		char * value ;
+
+		line_end = memchr( line, '\n', header_end - line ) ;
+
+		if ( (value = HttpHeaderValue( line, line_end, "Host" )) != NULL ) {
+			SAFEFREE( hr->host ) ;
+			hr->host = value ;
+		} else if ( (value = HttpHeaderValue( line, line_end, "If-None-Match" )) != NULL ) {
+			SAFEFREE( hr->if_none_match ) ;
+			hr->if_none_match = value ;
+		} else if ( (value = HttpHeaderValue( line, line_end, "Connection" )) != NULL ) {
+			if ( HttpHasToken( value, "close" ) ) {
+				hr->keep_alive = 0 ;
+			} else if ( HttpHasToken( value, "keep-alive" ) ) {
+				hr->keep_alive = 1 ;
+			}
+			owfree( value ) ;
+		} else if ( (value = HttpHeaderValue( line, line_end, "Content-Length" )) != NULL ) {
+			SIZE_OR_ERROR parsed_length = HttpContentLength( value ) ;
+			owfree( value ) ;
+			if ( parsed_length < 0 ) {
+				HttpRequestClear( hr ) ;
+				return parsed_length ;
+			}
+			content_length = parsed_length ;
+		} else if ( (value = HttpHeaderValue( line, line_end, "Transfer-Encoding" )) != NULL ) {
+			// chunked uploads are not supported
+			LEVEL_DEBUG("HTTP request body with Transfer-Encoding: %s", value ) ;
+			owfree( value ) ;
+			HttpRequestClear( hr ) ;
+			return -EINVAL ;
+		}
+	}
+
+	if ( skip + header_length + content_length > HTTP_REQUEST_MAX ) {
+		// could never fit in the connection buffer
+		HttpRequestClear( hr ) ;
+		return -EMSGSIZE ;
+	}
+	if ( header_length + content_length > length ) {
+		// body not all here yet
+		HttpRequestClear( hr ) ;
+		return 0 ;
+	}
+
+	if ( content_length > 0 ) {
+		hr->body = owmalloc( content_length + 1 ) ;
+		if ( hr->body == NULL ) {
+			HttpRequestClear( hr ) ;
+			return -ENOMEM ;
+		}
+		memcpy( hr->body, buffer + header_length, content_length ) ;
+		hr->body[content_length] = '\0' ;
+		hr->body_length = content_length ;
+	}
+
+	return skip + header_length + content_length ;
+}
+
+/* Find the blank line, returns pointer to it (NULL if not yet received) and full header length */
+static const char * HttpHeaderEnd( const char * buffer, size_t length, size_t * header_length )
+{
+	const char * line = buffer ;
+	const char * end = buffer + length ;
+
+	while ( line < end ) {
+		const char * newline = memchr( line, '\n', end - line ) ;
+		if ( newline == NULL ) {
+			return NULL ;
+		}
+		if ( line > buffer && ( newline == line || ( newline == line + 1 && line[0] == '\r' ) ) ) {
+			*header_length = newline + 1 - buffer ;
+			return line ;
+		}
+		line = newline + 1 ;
+	}
+	return NULL ;
+}
+
+/* Value of a "Name: value" header line (owmalloc-ed), NULL if not this header
+ * line_end is the line's newline -- the line may hold NUL bytes */
+static char * HttpHeaderValue( const char * line, const char * line_end, const char * name )
+{
+	size_t name_length = strlen( name ) ;
+	const char * value ;
+	const char * value_end = line_end ;
+	char * copy ;
+
+	if ( (size_t) ( line_end - line ) <= name_length || strncasecmp( line, name, name_length ) != 0 ) {
+		return NULL ;
+	}
+	value = line + name_length ;
+	while ( value < line_end && ( *value == ' ' || *value == '\t' ) ) {
+		++value ;
+	}
+	if ( value == line_end || *value != ':' ) {
+		return NULL ;
+	}
+	++value ;
+	while ( value < line_end && ( *value == ' ' || *value == '\t' ) ) {
+		++value ;
+	}
+	while ( value_end > value && ( value_end[-1] == '\r' || value_end[-1] == ' ' || value_end[-1] == '\t' ) ) {
+		--value_end ;
+	}
+
+	copy = owmalloc( value_end - value + 1 ) ;
+	if ( copy != NULL ) {
+		memcpy( copy, value, value_end - value ) ;
+		copy[value_end - value] = '\0' ;
+	}
+	return copy ;
+}
+
+/* Content-Length value, digits only and no more than fits in the connection buffer */
+static SIZE_OR_ERROR HttpContentLength( const char * value )
+{
+	char * end ;
+	unsigned long content_length ;
+
+	if ( ! isdigit( (unsigned char) value[0] ) ) {
+		// empty, signed or not a number
+		return -EINVAL ;
+	}
+	errno = 0 ;
+	content_length = strtoul( value, &end, 10 ) ;
+	if ( *end != '\0' ) {
+		return -EINVAL ;
+	}
+	if ( errno == ERANGE || content_length > HTTP_REQUEST_MAX ) {
+		return -EMSGSIZE ;
+	}
+	return content_length ;
+}
+
+/* x in HTTP/1.x at the end of the request line, 0 if none */
+static int HttpMinorVersion( const char * request_line )
+{
+	const char * version = strrchr( request_line, ' ' ) ;
+
+	if ( version != NULL && strncmp( version, " HTTP/1.", 8 ) == 0 && isdigit( (unsigned char) version[8] ) ) {
+		return version[8] - '0' ;
+	}
+	return 0 ;
+}
+
+/* Is token in the comma separated header value? */
+static int HttpHasToken( const char * value, const char * token )
+{
+	size_t token_length = strlen( token ) ;
+
+	while ( *value != '\0' ) {
+		while ( *value == ' ' || *value == ',' ) {
+			++value ;
+		}
+		if ( strncasecmp( value, token, token_length ) == 0 ) {
+			char after = value[token_length] ;
+			if ( after == '\0' || after == ',' || after == ' ' ) {
+				return 1 ;
+			}
+		}
+		while ( *value != '\0' && *value != ',' ) {
+			++value ;
+		}
+	}
+	return 0 ;
+}
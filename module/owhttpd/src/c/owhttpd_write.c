@@ -28,8 +28,8 @@ void PostData(struct one_wire_query *owq)
 	FS_write_postparse(owq);
 }
 
-// Standard Data via GET
-void ChangeData(struct one_wire_query *owq)
+// Standard Data via GET (and batch writes)
+SIZE_OR_ERROR ChangeData(struct one_wire_query *owq)
 {
 	struct parsedname *pn = PN(owq);
 	ASCII *value_string = OWQ_buffer(owq);
@@ -45,7 +45,7 @@ void ChangeData(struct one_wire_query *owq)
 			OWQ_size(owq) = strlen(value_string);
 			break;
 	}
-	FS_write_postparse(owq);
+	return FS_write_postparse(owq);
 }
 
 /* reads an as ascii hex string, strips out non-hex, converts in place */
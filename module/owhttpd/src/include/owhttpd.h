@@ -29,30 +29,81 @@
 #define DEVTABLE "BGCOLOR='#DDDDDD' BORDER='1'"
 #define VALTABLE "BGCOLOR='#DDDDDD' BORDER='1'"
 
+/* in owhttpd_reactor.c */
+struct http_connection ;
+GOOD_OR_BAD HttpReactorStart( void ) ;
+void HttpReactorAdd( FILE_DESCRIPTOR_OR_ERROR file_descriptor ) ;
+GOOD_OR_BAD HttpQueue( struct http_connection * hc, const struct iovec * io, int nio ) ;
+void HttpHold( struct http_connection * hc ) ;
+void HttpRelease( struct http_connection * hc ) ;
+
+/* in owhttpd_request.c */
+#define HTTP_REQUEST_MAX  (64*1024)  // request line, headers and body
+
+struct http_request {
+	char * line ;         // request line
+	int minor_version ;   // HTTP/1.x, 0 for none
+	int keep_alive ;      // client will reuse the connection
+	char * host ;         // Host: header
+	char * if_none_match ; // If-None-Match: header (entity tags)
+	char * body ;         // Content-Length bytes (POST)
+	size_t body_length ;
+} ;
+
+SIZE_OR_ERROR HttpParseRequest( const char * buffer, size_t length, struct http_request * hr ) ;
+void HttpRequestClear( struct http_request * hr ) ;
+
 /*
  * Main routine for actually handling a request
- * deals with a conncection
+ * runs on a worker thread, returns true to keep the connection
  */
 /* in owhttpd_handler.c */
-int handle_socket(FILE * out);
+int handle_request( struct http_connection * hc, struct http_request * hr ) ;
+
+enum content_type { ct_text, ct_html, ct_icon, ct_json, ct_event, };
+
+struct read_ahead ;
 
 struct OutputControl {
-	FILE * out ;
+	FILE * out ;          // response body, collected in memory
 	int not_first ;
 	char * base_url ;
 	char * host ;
+	FILE * in ;           // request body
+	struct http_connection * connection ; // response is queued here
+	int minor_version ;
+	int keep_alive ;
+	const char * status ; // from HTTPstart
+	enum content_type content ;
+	int streaming ;       // header already sent by HTTPstream
+	int held ;            // stream outlives the request (events)
+	const char * if_none_match ; // from the request
+	long max_age ;        // shortest cache life of the values shown, -1 for none
+	struct read_ahead * read_ahead ; // device page values, already read
+	char * body ;         // storage for out
+	size_t body_length ;
 } ;
 
 /* in owhttpd_present */
-enum content_type { ct_text, ct_html, ct_icon, ct_json, };
 void HTTPstart( struct OutputControl * oc, const char *status, const enum content_type ct);
+void HTTPstream( struct OutputControl * oc, const char *status, const enum content_type ct);
+void HTTPchunk( struct OutputControl * oc, const char * data, size_t length);
+GOOD_OR_BAD HTTPchunk_connection( struct http_connection * hc, int minor_version, const char * data, size_t length);
+GOOD_OR_BAD HTTPsend( struct OutputControl * oc);
+void HTTPlifetime( struct OutputControl * oc, const struct parsedname * pn);
 void HTTPtitle( struct OutputControl * oc, const char *title);
 void HTTPheader( struct OutputControl * oc, const char *head);
 void HTTPfoot( struct OutputControl * oc);
 
 /* in owhttpd_write.c */
 void PostData(struct one_wire_query *owq);
-void ChangeData(struct one_wire_query *owq);
+SIZE_OR_ERROR ChangeData(struct one_wire_query *owq);
+
+/* in owhttpd_readahead.c */
+void ReadAhead( struct OutputControl * oc, struct parsedname * pn_device, int lazy ) ;
+void ReadAheadClear( struct OutputControl * oc ) ;
+SIZE_OR_ERROR ReadAheadValue( struct OutputControl * oc, struct one_wire_query * owq ) ;
+int ReadAheadLazy( struct OutputControl * oc, const struct parsedname * pn_entry ) ;
 
 /* in owhttpd_read.c */
 void ShowDevice( struct OutputControl * oc, struct parsedname *const pn);
@@ -64,11 +115,18 @@ struct JsonCBstruct {
 } ;
 
 void ShowDir( struct OutputControl * oc, struct parsedname * pn);
+void ShowSnapshot( struct OutputControl * oc, struct parsedname * pn);
 int Backup(const char *path);
 void JSON_dir_init(  struct OutputControl * oc ) ;
 void JSON_dir_entry(  struct OutputControl * oc, const char * format, const char * data ) ;
 void JSON_dir_finish(  struct OutputControl * oc ) ;
 
+/* in owhttpd_events.c */
+ZERO_OR_ERROR ShowEvents( struct OutputControl * oc, char * query ) ;
+
+/* in owhttpd_batch.c */
+ZERO_OR_ERROR ShowBatch( struct OutputControl * oc, const char * body, size_t body_length ) ;
+
 /* in ow_favicon.c */
 void Favicon( struct OutputControl * oc);
 
@@ -53,6 +53,8 @@ struct global Globals = {
 
 	.readonly = 0,
 	.max_clients = 250,
+	.http_workers = 4,
+	.ftp_workers = 4,
 
 	.cache_size = 0,
 
@@ -73,6 +75,7 @@ struct global Globals = {
 	.timeout_network = 1,
 	.timeout_server = 10,
 	.timeout_ftp = 900,
+	.timeout_http = 15,
 	.timeout_ha7 = 60,
 	.timeout_w1 = 30,
 	.timeout_persistent_low = 600,
@@ -95,6 +98,9 @@ struct global Globals = {
 
 	.templow = GLOBAL_UNTOUCHED_TEMP_LIMIT,
 	.temphigh = GLOBAL_UNTOUCHED_TEMP_LIMIT,
+	.timed_latency = 1000, // roughly a DS9490 USB round trip
+	.timed_errors = 0,
+	.timed_parasitic = 0,
 	
 	.argc = 0,
 	.argv = NULL,
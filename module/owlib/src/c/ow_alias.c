@@ -158,10 +158,12 @@ void FS_dir_entry_aliased(void (*dirfunc) (void *, const struct parsedname *), v
 		struct parsedname * pn_copy = & s_pn_copy ;
 
 		ASCII path[PATH_MAX+3] ;
+		ASCII alias_path[PATH_MAX+3] ;
 		ASCII * path_pointer = path ; // current location in original path
 
-		// Shallow copy
+		// Shallow copy, but with its own path (the original path is shared)
 		memcpy( pn_copy, pn, sizeof(struct parsedname) ) ;
+		pn_copy->path = alias_path ;
 		pn_copy->path[0] = '\0' ;
 
 		// path copy to use for separation
@@ -207,6 +209,7 @@ void FS_dir_entry_aliased(void (*dirfunc) (void *, const struct parsedname *), v
 			}
 			//LEVEL_DEBUG( "Alias path so far: %s",pn_copy->path ) ;
 		}
+		pn_copy->path_length = strlen( pn_copy->path ) ;
 
 		if ( dirfunc != NULL ) {
 			DIRLOCK;
@@ -0,0 +1,134 @@
+/*
+    OW -- One-Wire filesystem
+    version 0.4 7/2/2003
+
+    Written 2003 Paul H Alfille
+    GPL license
+    See the header file: ow.h for full attribution
+    ---------------------------------------------------------------------------
+    Implementation:
+    binaryvalue -- raw property values for owserver clients
+*/
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+
+/*
+    The encoding itself is in ow_parseoutput.c (in place of the text).
+    Here are the type and length rules shared with FullFileLength,
+    and a decoder for clients linking owlib (the swig bindings).
+*/
+
+/* Binary type of a property read, bv_none if returned as is */
+enum binary_value_type BinaryValueType(const struct parsedname *pn)
+{
+	if (pn->type == ePN_structure || IsDir(pn)) {
+		return bv_none;
+	}
+	if (pn->extension == EXTENSION_BYTE) {
+		return bv_unsigned;
+	}
+	switch (pn->selected_filetype->format) {
+	case ft_integer:
+		return bv_integer;
+	case ft_unsigned:
+		return bv_unsigned;
+	case ft_float:
+	case ft_pressure:
+	case ft_temperature:
+	case ft_tempgap:
+		return bv_float;
+	case ft_yesno:
+	case ft_bitfield:
+		return bv_yesno;
+	case ft_date:
+		return bv_date;
+	default:
+		return bv_none;
+	}
+}
+
+size_t BinaryValueElementSize(enum binary_value_type type)
+{
+	switch (type) {
+	case bv_integer:
+	case bv_unsigned:
+		return 4;
+	case bv_float:
+	case bv_date:
+		return 8;
+	case bv_yesno:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/* Length of the encoded value (0 if not encoded) */
+size_t BinaryValueLength(const struct parsedname *pn)
+{
+	enum binary_value_type type = BinaryValueType(pn);
+	size_t elements = 1;
+
+	if (type == bv_none) {
+		return 0;
+	}
+	if (pn->extension == EXTENSION_ALL) {
+		elements = pn->selected_filetype->ag->elements;
+	}
+	return BINARY_VALUE_HEADER + elements * BinaryValueElementSize(type);
+}
+
+static uint64_t BinaryValueGet(const BYTE * data, size_t size)
+{
+	uint64_t u = 0;
+
+	while (size-- > 0) {
+		u = (u << 8) | data[size];
+	}
+	return u;
+}
+
+/* Element index of an encoded value as a number */
+GOOD_OR_BAD BinaryValueDecode(const BYTE * data, size_t length, size_t index, _FLOAT * value)
+{
+	enum binary_value_type type;
+	size_t elements;
+	size_t element_size;
+	uint64_t u;
+
+	if (length < BINARY_VALUE_HEADER || data[0] != BINARY_VALUE_MAGIC) {
+		return gbBAD;
+	}
+	type = (enum binary_value_type) data[1];
+	elements = BinaryValueGet(&data[2], 2);
+	element_size = BinaryValueElementSize(type);
+	if (element_size == 0 || length != BINARY_VALUE_HEADER + elements * element_size || index >= elements) {
+		return gbBAD;
+	}
+
+	u = BinaryValueGet(&data[BINARY_VALUE_HEADER + index * element_size], element_size);
+	switch (type) {
+	case bv_integer:
+		*value = (int32_t) (uint32_t) u;
+		break;
+	case bv_unsigned:
+	case bv_yesno:
+		*value = u;
+		break;
+	case bv_date:
+		*value = (int64_t) u;
+		break;
+	case bv_float:
+		{
+			double d;
+			memcpy(&d, &u, sizeof(d));
+			*value = d;
+		}
+		break;
+	default:
+		return gbBAD;
+	}
+	return gbGOOD;
+}
@@ -57,6 +57,12 @@ struct cache_data {
 	time_t time_to_kill;				// deathtime of older
 	time_t retired_lifespan;			// lifetime of older
 	UINT added;					// items added
+	void *parsedname_tree_new;			// parsed path memo
+	void *parsedname_tree_old;			// older parsed path memo
+	UINT parsedname_added;				// memo items added
+	UINT parsedname_generation;			// memo drops, see Cache_ParsedName_Generation
+	struct cache_generation *generation_new;	// node pools for temporary_tree_new
+	struct cache_generation *generation_old;	// node pools for temporary_tree_old
 };
 static struct cache_data cache;
 
@@ -101,8 +107,27 @@ struct tree_node {
 	struct tree_key tk;
 	time_t expires;
 	size_t dsize;
+	struct slab_pool *pool;		// where allocated, NULL for heap
 };
 
+/* Nodes (with data) are allocated from size-classed slab pools
+   Each temporary tree has its own generation of pools, so when a tree
+   is retired (FlipTree) all its nodes are released in a few block frees.
+   Nodes too large for any class come from the heap.
+*/
+#define CACHE_SLAB_CLASSES  4
+
+static const size_t cache_slab_size[CACHE_SLAB_CLASSES] = { 64, 128, 256, 512, };
+static struct slab_stats * const cache_slab_stats[CACHE_SLAB_CLASSES] = {
+	&slab_cache_64, &slab_cache_128, &slab_cache_256, &slab_cache_512,
+};
+
+struct cache_generation {
+	struct slab_pool pool[CACHE_SLAB_CLASSES];
+};
+static struct cache_generation cache_generations[2];
+static struct cache_generation cache_persistent_generation;
+
 struct alias_tree_node {
 	size_t size;
 	time_t expires;
@@ -126,15 +151,60 @@ struct tree_opaque {
 #define ALIAS_TREE_DATA(atn)    ( (ASCII *)(atn) + sizeof(struct alias_tree_node) )
 #define CONST_ALIAS_TREE_DATA(atn)    ( (const ASCII *)(atn) + sizeof(struct alias_tree_node) )
 
+/* Parsed path memo
+   Repeated requests for the same path skip FS_ParsedName's work
+   (alias lookup, device and property search, presence check).
+   Key is the path and the control flags at the start of parsing,
+   data is the parse result including the path_to_server and sparse_name strings.
+   Lifetime is the presence timeout, and the whole memo is dropped
+   whenever aliases, device locations or the bus list change.
+   DS2409 branch paths are not stored (allocated branch list).
+*/
+struct parsedname_node {
+	uint32_t control_flags;		// key
+	const char *path;			// key (points into trailing data)
+	time_t expires;
+	enum ePN_type type;
+	enum ePS_state state;
+	BYTE sn[SERIAL_NUMBER_SIZE];
+	struct device *selected_device;
+	struct filetype *selected_filetype;
+	struct filetype *subdir;
+	int extension;
+	int dirlength;
+	int device_name_offset;		// in path, or -1 for none
+	struct connection_in *known_bus;
+	struct connection_in *selected_connection;
+	uint32_t result_flags;		// control flags after parsing
+	const char *path_to_server;	// points into trailing data
+	const char *sparse_name;	// points into trailing data or NULL
+};
+
+struct parsedname_opaque {
+	struct parsedname_node *key;
+	void *other;
+};
+
+#define PARSEDNAME_DATA(pnn)    ( (char *)(pnn) + sizeof(struct parsedname_node) )
+
+// Entries before the memo is flipped (old entries dropped)
+#define PARSEDNAME_CACHE_SIZE   4096
+
 enum cache_task_return { ctr_ok, ctr_not_found, ctr_expired, ctr_size_mismatch, } ;
 
 static void FlipTree( void ) ;
 
+static void Cache_Generation_Init(struct cache_generation *cg);
+static void Cache_Generation_Clear(struct cache_generation *cg);
+static struct tree_node *Cache_Node_Alloc(struct cache_generation *cg, const struct tree_node *tn, const void *data, size_t datasize);
+static void Cache_Node_Free(struct tree_node *tn);
+static void Cache_Node_Release(void *node);
+
 static int IsThisPersistent( const struct parsedname * pn ) ;
 
 static GOOD_OR_BAD Cache_Add(const void *data, const size_t datasize, const struct parsedname *pn);
-static GOOD_OR_BAD Cache_Add_Common(struct tree_node *tn);
-static GOOD_OR_BAD Cache_Add_Persistent(struct tree_node *tn);
+static GOOD_OR_BAD Cache_Add_Common(const struct tree_node *tn, const void *data, size_t datasize);
+static GOOD_OR_BAD Cache_Add_Persistent(const struct tree_node *tn, const void *data, size_t datasize);
 
 static enum cache_task_return Cache_Get_Common(void *data, size_t * dsize, time_t * duration, const struct tree_node *tn);
 static enum cache_task_return Cache_Get_Common_Dir(struct dirblob *db, time_t * duration, const struct tree_node *tn);
@@ -163,6 +233,8 @@ static GOOD_OR_BAD Get_Stat(struct cache_stats *scache, const enum cache_task_re
 static void Del_Stat(struct cache_stats *scache, const int result);
 
 static int tree_compare(const void *a, const void *b);
+static int parsedname_tree_compare(const void *a, const void *b);
+static void FlipParsedName( void ) ;
 static time_t TimeOut(const enum fc_change change);
 static void Aliaslistaction(const void *node, const VISIT which, const int depth) ;
 static void LoadTK( const BYTE * sn, void * p, int extension, struct tree_node * tn ) ;
@@ -176,6 +248,17 @@ static int tree_compare(const void *a, const void *b)
 
 /* used for the sort/search b-tree routines */
 /* big voodoo pointer fuss to just do a standard memory compare of the "key" */
+static int parsedname_tree_compare(const void *a, const void *b)
+{
+	const struct parsedname_node *pnna = (const struct parsedname_node *) a;
+	const struct parsedname_node *pnnb = (const struct parsedname_node *) b;
+
+	if (pnna->control_flags != pnnb->control_flags) {
+		return (pnna->control_flags < pnnb->control_flags) ? -1 : 1;
+	}
+	return strcmp(pnna->path, pnnb->path);
+}
+
 static int alias_tree_compare(const void *a, const void *b)
 {
 	int da = ((const struct alias_tree_node *) a)->size ;
@@ -268,6 +351,12 @@ void Cache_Open(void)
 {
 	memset(&cache, 0, sizeof(struct cache_data));
 
+	Cache_Generation_Init(&cache_generations[0]);
+	Cache_Generation_Init(&cache_generations[1]);
+	Cache_Generation_Init(&cache_persistent_generation);
+	cache.generation_new = &cache_generations[0];
+	cache.generation_old = &cache_generations[1];
+
 	cache.retired_lifespan = TimeOut(fc_stable);
 	if (cache.retired_lifespan > 3600) {
 		cache.retired_lifespan = 3600;	/* 1 hour tops */
@@ -281,7 +370,8 @@ void Cache_Open(void)
 void Cache_Close(void)
 {
 	Cache_Clear() ;
-	SAFETDESTROY( cache.persistent_tree, owfree_func);
+	SAFETDESTROY( cache.persistent_tree, Cache_Node_Release);
+	Cache_Generation_Clear(&cache_persistent_generation);
 	SAFETDESTROY( cache.persistent_alias_tree, owfree_func);
 }
 
@@ -290,17 +380,20 @@ static void FlipTree( void )
 {
 	void * flip = cache.temporary_tree_old; // old old saved for later clearing
 	void * flip_alias = cache.temporary_alias_tree_old; // old old saved for later clearing
+	struct cache_generation * flip_generation = cache.generation_old; // its node pools
 
 	/* Flip caches! old = new. New truncated, reset time and counters and flag */
 	LEVEL_DEBUG("Flipping cache tree (purging timed-out data)");
 
 	// move "new" pointers to "old"
 	cache.temporary_tree_old = cache.temporary_tree_new;
+	cache.generation_old = cache.generation_new;
 	cache.old_ram_size = cache.new_ram_size;
 	cache.temporary_alias_tree_old = cache.temporary_alias_tree_new;
 
 	// New cache setup
 	cache.temporary_tree_new = NULL;
+	cache.generation_new = flip_generation; // reused once cleared below
 	cache.temporary_alias_tree_new = NULL;
 	cache.new_ram_size = 0;
 	cache.added = 0;
@@ -311,8 +404,10 @@ static void FlipTree( void )
 
 	// delete really old tree
 	LEVEL_DEBUG("flip cache. tdestroy() will be called.");
-	SAFETDESTROY( flip, owfree_func);
+	SAFETDESTROY( flip, Cache_Node_Release);
+	Cache_Generation_Clear(flip_generation);
 	SAFETDESTROY( flip_alias, owfree_func);
+	FlipParsedName() ;
 	STATLOCK;
 	++cache_flips;			/* statistics */
 	memcpy(&old_avg, &new_avg, sizeof(struct average));
@@ -329,6 +424,76 @@ void Cache_Clear(void)
 	CACHE_WUNLOCK;
 }
 
+static void Cache_Generation_Init(struct cache_generation *cg)
+{
+	int i;
+	for (i = 0; i < CACHE_SLAB_CLASSES; ++i) {
+		SlabInit(&cg->pool[i], cache_slab_size[i], cache_slab_stats[i]);
+	}
+}
+
+/* All nodes from this generation are released at once */
+/* tree should already be destroyed with Cache_Node_Release */
+static void Cache_Generation_Clear(struct cache_generation *cg)
+{
+	int i;
+	for (i = 0; i < CACHE_SLAB_CLASSES; ++i) {
+		SlabClear(&cg->pool[i]);
+	}
+}
+
+/* Copy of the template node and its data, from the smallest pool that fits */
+/* Call with the lock held for the tree (and so generation) */
+static struct tree_node *Cache_Node_Alloc(struct cache_generation *cg, const struct tree_node *tn, const void *data, size_t datasize)
+{
+	size_t size = sizeof(struct tree_node) + datasize;
+	struct tree_node *tn_new = NULL;
+	int i;
+
+	for (i = 0; i < CACHE_SLAB_CLASSES; ++i) {
+		if (size <= cache_slab_size[i]) {
+			tn_new = (struct tree_node *) SlabAlloc(&cg->pool[i]);
+			if (tn_new != NULL) {
+				tn_new->pool = &cg->pool[i];
+			}
+			break;
+		}
+	}
+	if (tn_new == NULL) {
+		tn_new = (struct tree_node *) owmalloc(size);
+		if (tn_new == NULL) {
+			return NULL;
+		}
+		tn_new->pool = NULL;
+	}
+
+	memcpy(&tn_new->tk, &tn->tk, sizeof(struct tree_key));
+	tn_new->expires = tn->expires;
+	tn_new->dsize = tn->dsize;
+	if (datasize) {
+		memcpy(TREE_DATA(tn_new), data, datasize);
+	}
+	return tn_new;
+}
+
+static void Cache_Node_Free(struct tree_node *tn)
+{
+	if (tn->pool == NULL) {
+		owfree(tn);
+	} else {
+		SlabFree(tn->pool, tn);
+	}
+}
+
+/* tdestroy function: heap nodes are freed, pool nodes go with their generation */
+static void Cache_Node_Release(void *node)
+{
+	struct tree_node *tn = (struct tree_node *) node;
+	if (tn->pool == NULL) {
+		owfree(tn);
+	}
+}
+
 /* Wrapper to perform a cache function and add statistics */
 static GOOD_OR_BAD Add_Stat(struct cache_stats *scache, GOOD_OR_BAD result)
 {
@@ -393,7 +558,7 @@ GOOD_OR_BAD OWQ_Cache_Add(const struct one_wire_query *owq)
 /* return 0 if good, 1 if not */
 static GOOD_OR_BAD Cache_Add(const void *data, const size_t datasize, const struct parsedname *pn)
 {
-	struct tree_node *tn;
+	struct tree_node tn;
 	time_t duration;
 	int persistent ;
 
@@ -412,24 +577,15 @@ static GOOD_OR_BAD Cache_Add(const void *data, const size_t datasize, const stru
 		}
 	}
 
-	// allocate space for the node and data
-	tn = (struct tree_node *) owmalloc(sizeof(struct tree_node) + datasize);
-	if (!tn) {
-		return gbBAD;
-	}
-
 	LEVEL_DEBUG(SNformat " size=%d", SNvar(pn->sn), (int) datasize);
 
-	// populate the node structure with data
-	LoadTK( pn->sn, pn->selected_filetype, pn->extension, tn );
-	tn->expires = duration + NOW_TIME;
-	tn->dsize = datasize;
-	if (datasize) {
-		memcpy(TREE_DATA(tn), data, datasize);
-	}
+	// populate the node structure (data copied when stored)
+	LoadTK( pn->sn, pn->selected_filetype, pn->extension, &tn );
+	tn.expires = duration + NOW_TIME;
+	tn.dsize = datasize;
 	return persistent ?
-		Add_Stat(&cache_pst, Cache_Add_Persistent(tn)) :
-		Add_Stat(&cache_ext, Cache_Add_Common(tn)) ;
+		Add_Stat(&cache_pst, Cache_Add_Persistent(&tn, data, datasize)) :
+		Add_Stat(&cache_ext, Cache_Add_Common(&tn, data, datasize)) ;
 }
 
 /* Add a directory entry to the cache */
@@ -437,7 +593,7 @@ static GOOD_OR_BAD Cache_Add(const void *data, const size_t datasize, const stru
 GOOD_OR_BAD Cache_Add_Dir(const struct dirblob *db, const struct parsedname *pn)
 {
 	time_t duration = TimeOut(fc_directory);
-	struct tree_node *tn;
+	struct tree_node tn;
 	size_t size = DirblobElements(db) * SERIAL_NUMBER_SIZE;
 	struct parsedname pn_directory;
 
@@ -469,23 +625,14 @@ GOOD_OR_BAD Cache_Add_Dir(const struct dirblob *db, const struct parsedname *pn)
 		return gbGOOD ;
 	}
 	
-	// allocate space for the node and data
-	tn = (struct tree_node *) owmalloc(sizeof(struct tree_node) + size);
-	if (!tn) {
-		return gbBAD;
-	}
-	
 	LEVEL_DEBUG("Adding directory for " SNformat " elements=%d", SNvar(pn->sn), DirblobElements(db));
 	
 	// populate node with directory name and dirblob
 	FS_LoadDirectoryOnly(&pn_directory, pn);
-	LoadTK( pn_directory.sn, Directory_Marker, pn->selected_connection->index, tn );
-	tn->expires = duration + NOW_TIME;
-	tn->dsize = size;
-	if (size) {
-		memcpy(TREE_DATA(tn), db->snlist, size);
-	}
-	return Add_Stat(&cache_dir, Cache_Add_Common(tn));
+	LoadTK( pn_directory.sn, Directory_Marker, pn->selected_connection->index, &tn );
+	tn.expires = duration + NOW_TIME;
+	tn.dsize = size;
+	return Add_Stat(&cache_dir, Cache_Add_Common(&tn, db->snlist, size));
 }
 
 /* Add a Simultaneous entry to the cache */
@@ -494,7 +641,7 @@ GOOD_OR_BAD Cache_Add_Simul(const struct internal_prop *ip, const struct parsedn
 {
 	// Note: pn already points to directory
 	time_t duration = TimeOut(ip->change);
-	struct tree_node *tn;
+	struct tree_node tn;
 
 	if (pn==NO_PARSEDNAME || pn->selected_connection==NO_CONNECTION) {
 		return gbGOOD;				// do check here to avoid needless processing
@@ -506,21 +653,14 @@ GOOD_OR_BAD Cache_Add_Simul(const struct internal_prop *ip, const struct parsedn
 		return gbGOOD;				/* in case timeout set to 0 */
 	}
 	
-	// allocate space for the node and data
 	LEVEL_DEBUG("Adding for conversion time for "SNformat, SNvar(pn->sn));
-	tn = (struct tree_node *) owmalloc(sizeof(struct tree_node));
-	if (!tn) {
-		return gbBAD;
-	}
-	
-	LEVEL_DEBUG(SNformat, SNvar(pn->sn));
 	
-	// populate node with directory name and dirblob
-	LoadTK( pn->sn, ip->name, 0, tn) ;
+	// populate node with directory name (no data)
+	LoadTK( pn->sn, ip->name, 0, &tn) ;
 	LEVEL_DEBUG("Simultaneous add type=%s",ip->name);
-	tn->expires = duration + NOW_TIME;
-	tn->dsize = 0;
-	return Add_Stat(&cache_dir, Cache_Add_Common(tn));
+	tn.expires = duration + NOW_TIME;
+	tn.dsize = 0;
+	return Add_Stat(&cache_dir, Cache_Add_Common(&tn, NULL, 0));
 }
 
 /* Add a device entry to the cache */
@@ -528,7 +668,7 @@ GOOD_OR_BAD Cache_Add_Simul(const struct internal_prop *ip, const struct parsedn
 GOOD_OR_BAD Cache_Add_Device(const int bus_nr, const BYTE * sn)
 {
 	time_t duration = TimeOut(fc_presence);
-	struct tree_node *tn;
+	struct tree_node tn;
 
 	if (duration <= 0) {
 		return gbGOOD;				/* in case timeout set to 0 */
@@ -538,17 +678,11 @@ GOOD_OR_BAD Cache_Add_Device(const int bus_nr, const BYTE * sn)
 		return gbGOOD ;
 	}
 
-	tn = (struct tree_node *) owmalloc(sizeof(struct tree_node) + sizeof(int));
-	if (!tn) {
-		return gbBAD;
-	}
-
 	LEVEL_DEBUG("Adding device location " SNformat " bus=%d", SNvar(sn), (int) bus_nr);
-	LoadTK(sn, Device_Marker, 0, tn );
-	tn->expires = duration + NOW_TIME;
-	tn->dsize = sizeof(int);
-	memcpy(TREE_DATA(tn), &bus_nr, sizeof(int));
-	return Add_Stat(&cache_dev, Cache_Add_Common(tn));
+	LoadTK(sn, Device_Marker, 0, &tn );
+	tn.expires = duration + NOW_TIME;
+	tn.dsize = sizeof(int);
+	return Add_Stat(&cache_dev, Cache_Add_Common(&tn, &bus_nr, sizeof(int)));
 }
 
 /* What do we cache?
@@ -564,7 +698,7 @@ property   device sn      extension             *ft       binary data
 /* return 0 if good, 1 if not */
 GOOD_OR_BAD Cache_Add_SlaveSpecific(const void *data, const size_t datasize, const struct internal_prop *ip, const struct parsedname *pn)
 {
-	struct tree_node *tn;
+	struct tree_node tn;
 	time_t duration;
 	//printf("Cache_Add_SlaveSpecific\n");
 	if (!pn) {
@@ -576,25 +710,17 @@ GOOD_OR_BAD Cache_Add_SlaveSpecific(const void *data, const size_t datasize, con
 		return gbGOOD;				/* in case timeout set to 0 */
 	}
 
-	tn = (struct tree_node *) owmalloc(sizeof(struct tree_node) + datasize);
-	if (!tn) {
-		return gbBAD;
-	}
-
 	LEVEL_DEBUG("Adding internal data for "SNformat " size=%d", SNvar(pn->sn), (int) datasize);
-	LoadTK( pn->sn, ip->name, EXTENSION_INTERNAL, tn );
-	tn->expires = duration + NOW_TIME;
-	tn->dsize = datasize;
-	if (datasize) {
-		memcpy(TREE_DATA(tn), data, datasize);
-	}
+	LoadTK( pn->sn, ip->name, EXTENSION_INTERNAL, &tn );
+	tn.expires = duration + NOW_TIME;
+	tn.dsize = datasize;
 	//printf("ADD INTERNAL name= %s size=%d \n",tn->tk.p.nm,tn->dsize);
 	//printf("  ADD INTERNAL data[0]=%d size=%d \n",((BYTE *)data)[0],datasize);
 	switch (ip->change) {
 	case fc_persistent:
-		return Add_Stat(&cache_pst, Cache_Add_Persistent(tn));
+		return Add_Stat(&cache_pst, Cache_Add_Persistent(&tn, data, datasize));
 	default:
-		return Add_Stat(&cache_int, Cache_Add_Common(tn));
+		return Add_Stat(&cache_int, Cache_Add_Common(&tn, data, datasize));
 	}
 }
 
@@ -602,33 +728,29 @@ GOOD_OR_BAD Cache_Add_SlaveSpecific(const void *data, const size_t datasize, con
 /* return 0 if good, 1 if not */
 GOOD_OR_BAD Cache_Add_Alias(const ASCII *name, const BYTE * sn)
 {
-	struct tree_node *tn;
+	struct tree_node tn;
 	size_t size = strlen(name) ;
 
 	if ( size == 0 ) {
 		return gbGOOD ;
 	}
 
-	tn = (struct tree_node *) owmalloc(sizeof(struct tree_node) + size + 1 );
-	if (!tn) {
-		return gbBAD;
-	}
-
 	LEVEL_DEBUG("Adding alias for " SNformat " = %s", SNvar(sn), name);
-	LoadTK( sn, Alias_Marker, 0, tn );
-	tn->expires = NOW_TIME;
-	tn->dsize = size;
-	memcpy((ASCII *)TREE_DATA(tn), name, size+1 ); // includes NULL
+	LoadTK( sn, Alias_Marker, 0, &tn );
+	tn.expires = NOW_TIME;
+	tn.dsize = size;
 	Cache_Add_Alias_SN( name, sn ) ;
-	return Add_Stat(&cache_pst, Cache_Add_Persistent(tn));
+	return Add_Stat(&cache_pst, Cache_Add_Persistent(&tn, name, size+1)); // includes NULL
 }
 
 /* Add an item to the cache */
 /* retire the cache (flip) if too old, and start a new one (keep the old one for a while) */
+/* tn is a template (key, expires, dsize), the stored node is allocated here */
 /* return 0 if good, 1 if not */
-static GOOD_OR_BAD Cache_Add_Common(struct tree_node *tn)
+static GOOD_OR_BAD Cache_Add_Common(const struct tree_node *tn, const void *data, size_t datasize)
 {
 	struct tree_opaque *opaque;
+	struct tree_node *tn_new;
 	enum { no_add, yes_add, just_update } state = no_add;
 
 	node_show(tn);
@@ -639,21 +761,31 @@ static GOOD_OR_BAD Cache_Add_Common(struct tree_node *tn)
 	}
 	if (Globals.cache_size && (cache.old_ram_size + cache.new_ram_size > Globals.cache_size)) {
 		// failed size test
-		owfree(tn);
 	} else if ((opaque = tsearch(tn, &cache.temporary_tree_new, tree_compare))) {
 		//printf("Cache_Add_Common to %p\n",opaque);
-		if (tn != opaque->key) {
+		if (tn != opaque->key && tn->dsize == opaque->key->dsize) {
+			// same size -- just refresh in place
+			opaque->key->expires = tn->expires;
+			if (datasize) {
+				memcpy(TREE_DATA(opaque->key), data, datasize);
+			}
+			state = just_update;
+		} else if ((tn_new = Cache_Node_Alloc(cache.generation_new, tn, data, datasize)) == NULL) {
+			if (tn == opaque->key) {
+				// don't leave the template in the tree
+				tdelete(tn, &cache.temporary_tree_new, tree_compare);
+			}
+		} else if (tn != opaque->key) {
 			cache.new_ram_size += sizeof(tn) - sizeof(opaque->key);
-			owfree(opaque->key);
-			opaque->key = tn;
+			Cache_Node_Free(opaque->key);
+			opaque->key = tn_new;
 			state = just_update;
 		} else {
+			opaque->key = tn_new;
 			state = yes_add;
 			cache.new_ram_size += sizeof(tn);
 		}
-	} else {					// nothing found or added?!? free our memory segment
-		owfree(tn);
-	}
+	}							// else nothing found or added?!?
 	CACHE_WUNLOCK;
 	/* Added or updated, update statistics */
 	switch (state) {
@@ -677,9 +809,10 @@ static GOOD_OR_BAD Cache_Add_Common(struct tree_node *tn)
 /* Add an item to the cache */
 /* retire the cache (flip) if too old, and start a new one (keep the old one for a while) */
 /* return 0 if good, 1 if not */
-static GOOD_OR_BAD Cache_Add_Persistent(struct tree_node *tn)
+static GOOD_OR_BAD Cache_Add_Persistent(const struct tree_node *tn, const void *data, size_t datasize)
 {
 	struct tree_opaque *opaque;
+	struct tree_node *tn_new;
 	enum { no_add, yes_add, just_update } state = no_add;
 	LEVEL_DEBUG("Adding data to permanent store");
 
@@ -687,16 +820,27 @@ static GOOD_OR_BAD Cache_Add_Persistent(struct tree_node *tn)
 	opaque = tsearch(tn, &cache.persistent_tree, tree_compare) ;
 	if ( opaque != NULL ) {
 		//printf("CACHE ADD pointer=%p, key=%p\n",tn,opaque->key);
-		if (tn != opaque->key) {
-			owfree(opaque->key);
-			opaque->key = tn;
+		if (tn != opaque->key && tn->dsize == opaque->key->dsize) {
+			// same size -- just refresh in place
+			opaque->key->expires = tn->expires;
+			if (datasize) {
+				memcpy(TREE_DATA(opaque->key), data, datasize);
+			}
+			state = just_update;
+		} else if ((tn_new = Cache_Node_Alloc(&cache_persistent_generation, tn, data, datasize)) == NULL) {
+			if (tn == opaque->key) {
+				// don't leave the template in the tree
+				tdelete(tn, &cache.persistent_tree, tree_compare);
+			}
+		} else if (tn != opaque->key) {
+			Cache_Node_Free(opaque->key);
+			opaque->key = tn_new;
 			state = just_update;
 		} else {
+			opaque->key = tn_new;
 			state = yes_add;
 		}
-	} else {					// nothing found or added?!? free our memory segment
-		owfree(tn);
-	}
+	}							// else nothing found or added?!?
 	PERSISTENT_WUNLOCK;
 
 	switch (state) {
@@ -839,6 +983,59 @@ GOOD_OR_BAD Cache_Get(void *data, size_t * dsize, const struct parsedname *pn)
 		Get_Stat(&cache_ext, Cache_Get_Common(data, dsize, &duration, &tn));
 }
 
+/* Seconds of life left for a cached value, 0 if not cached here.
+ * Just a look -- no data copied and not counted in the cache statistics */
+time_t Cache_Remaining(const struct parsedname *pn)
+{
+	time_t duration;
+	struct tree_node tn;
+	size_t dsize = 0;
+
+	if (pn->selected_filetype == NO_FILETYPE || IsUncachedDir(pn) || IsAlarmDir(pn) || IsThisPersistent(pn)) {
+		return 0;
+	}
+	duration = TimeOut(pn->selected_filetype->change);
+	if (duration <= 0) {
+		return 0;
+	}
+
+	LoadTK( pn->sn, pn->selected_filetype, pn->extension, &tn );
+	switch (Cache_Get_Common(NULL, &dsize, &duration, &tn)) {
+	case ctr_ok:
+	case ctr_size_mismatch:
+		// found and not expired, duration is the time left
+		return duration;
+	default:
+		return 0;
+	}
+}
+
+/* Seconds a client may keep the attributes or listing of this node without asking again.
+ * Follows the cache timeouts -- devices as presence, directories as directory listings */
+time_t Cache_Lifespan(const struct parsedname *pn)
+{
+	if (IsUncachedDir(pn) || IsAlarmDir(pn)) {
+		return 0;
+	}
+	if (pn->selected_filetype == NO_FILETYPE) {
+		return (pn->selected_device == NO_DEVICE) ? TimeOut(fc_directory) : TimeOut(fc_presence);
+	}
+	switch (pn->selected_filetype->format) {
+	case ft_directory:
+	case ft_subdir:
+		return TimeOut(fc_presence);
+	default:
+		break;
+	}
+	switch (pn->selected_filetype->change) {
+	case fc_static:
+		// never changes, but isn't cached since it costs nothing to compute
+		return TimeOut(fc_stable);
+	default:
+		return TimeOut(pn->selected_filetype->change);
+	}
+}
+
 /* Look in caches, 0=found and valid, 1=not or uncachable in the first place */
 GOOD_OR_BAD Cache_Get_Dir(struct dirblob *db, const struct parsedname *pn)
 {
@@ -1190,8 +1387,7 @@ void OWQ_Cache_Del_parts(struct one_wire_query *owq)
 void Cache_Del_Alias(const BYTE * sn)
 {
 	ASCII * alias_name ;
-	struct tree_node *tn;
-	size_t size ;
+	struct tree_node tn;
 
 	alias_name = Cache_Get_Alias( sn ) ;
 	if ( alias_name == NULL ) {
@@ -1201,16 +1397,9 @@ void Cache_Del_Alias(const BYTE * sn)
 	}
 
 	LEVEL_DEBUG("Deleting alias %s from "SNformat, alias_name, SNvar(sn)) ;
-	size = strlen( alias_name ) ;
-	tn = (struct tree_node *) owmalloc(sizeof(struct tree_node) + size + 1 );
-	if ( tn != NULL ) {
-		tn->expires = NOW_TIME;
-		tn->dsize = size;
-		memcpy((ASCII *)TREE_DATA(tn), alias_name, size+1); // includes NULL
-		LoadTK( sn, Alias_Marker, 0, tn ) ;
-		Del_Stat(&cache_pst, Cache_Del_Persistent(tn));
-		Cache_Del_Alias_SN( alias_name ) ;
-	}
+	LoadTK( sn, Alias_Marker, 0, &tn ) ;
+	Del_Stat(&cache_pst, Cache_Del_Persistent(&tn));
+	Cache_Del_Alias_SN( alias_name ) ;
 	owfree( alias_name ) ;
 }
 
@@ -1327,6 +1516,7 @@ void Cache_Del_Device(const struct parsedname *pn)
 
 	LoadTK(pn->sn, Device_Marker, 0, &tn) ;
 	Del_Stat(&cache_dev, Cache_Del_Common(&tn));
+	Cache_Del_ParsedName() ; // memo holds the old location
 }
 
 void Cache_Del_Internal(const struct internal_prop *ip, const struct parsedname *pn)
@@ -1389,6 +1579,7 @@ static GOOD_OR_BAD Cache_Del_Persistent(const struct tree_node *tn)
 	if ( opaque != NULL ) {
 		tn_found = opaque->key;
 		tdelete(tn, &cache.persistent_tree, tree_compare);
+		Cache_Node_Free(tn_found); // pool is protected by the persistent lock
 	}
 	PERSISTENT_WUNLOCK;
 
@@ -1396,7 +1587,6 @@ static GOOD_OR_BAD Cache_Del_Persistent(const struct tree_node *tn)
 		return gbBAD;
 	}
 
-	owfree(tn_found);
 	STATLOCK;
 	AVERAGE_OUT(&store_avg);
 	STATUNLOCK;
@@ -1482,6 +1672,7 @@ void Cache_Add_Alias_Bus(const ASCII * alias_name, INDEX_OR_ERROR bus)
 	memcpy( ALIAS_TREE_DATA(atn), alias_name, datasize + 1 ) ;
 	
 	Cache_Add_Alias_Common( atn ) ;
+	Cache_Del_ParsedName() ;
 }
 
 /* Add an item to the alias cache */
@@ -1535,6 +1726,7 @@ static void Cache_Add_Alias_SN(const ASCII * alias_name, const BYTE * sn)
 	memcpy( ALIAS_TREE_DATA(atn), alias_name, datasize+1 ) ;
 	
 	Cache_Add_Alias_Persistent( atn ) ;
+	Cache_Del_ParsedName() ;
 }
 
 static void Cache_Add_Alias_Persistent(struct alias_tree_node *atn)
@@ -1664,6 +1856,7 @@ static void Cache_Del_Alias_SN(const ASCII * alias_name)
 	memcpy( ALIAS_TREE_DATA(atn), alias_name, datasize+1 ) ;
 	
 	Cache_Del_Alias_Persistent( atn ) ;
+	Cache_Del_ParsedName() ;
 }
 
 /* look in persistent alias->sn tree */
@@ -1689,3 +1882,170 @@ void Cache_Del_Alias_Bus(const ASCII * alias_name)
 	LEVEL_DEBUG("Hide %s",alias_name) ;
 	Cache_Add_Alias_Bus( alias_name, INDEX_BAD ) ;
 }
+
+/* Moves new parsed path memo to old, and clears former old */
+/* Cache should be write locked */
+static void FlipParsedName( void )
+{
+	void * flip = cache.parsedname_tree_old;
+
+	cache.parsedname_tree_old = cache.parsedname_tree_new;
+	cache.parsedname_tree_new = NULL;
+	cache.parsedname_added = 0;
+	SAFETDESTROY( flip, owfree_func);
+}
+
+/* Store the result of a successful FS_ParsedName */
+/* control_flags are the ones at the start of parsing (part of the key) */
+GOOD_OR_BAD Cache_Add_ParsedName(uint32_t control_flags, const struct parsedname *pn)
+{
+	time_t duration = TimeOut(fc_presence);
+	size_t path_length = pn->path_length + 1;
+	size_t server_length = strlen(pn->path_to_server) + 1;
+	size_t sparse_length = (pn->sparse_name == NULL) ? 0 : strlen(pn->sparse_name) + 1;
+	struct parsedname_node *pnn;
+	struct parsedname_opaque *opaque;
+	char *data;
+	enum { no_add, yes_add, just_update } state = no_add;
+
+	if (duration <= 0) {
+		return gbGOOD;				/* in case timeout set to 0 */
+	}
+
+	if (pn->ds2409_depth > 0) {
+		return gbGOOD;				/* branch list is allocated -- not stored */
+	}
+
+	pnn = (struct parsedname_node *) owmalloc(sizeof(struct parsedname_node) + path_length + server_length + sparse_length);
+	if (pnn == NULL) {
+		return gbBAD;
+	}
+
+	data = PARSEDNAME_DATA(pnn);
+	memcpy(data, pn->path, path_length);
+	pnn->path = data;
+	data += path_length;
+	memcpy(data, pn->path_to_server, server_length);
+	pnn->path_to_server = data;
+	data += server_length;
+	if (sparse_length > 0) {
+		memcpy(data, pn->sparse_name, sparse_length);
+		pnn->sparse_name = data;
+	} else {
+		pnn->sparse_name = NULL;
+	}
+
+	pnn->control_flags = control_flags;
+	pnn->expires = duration + NOW_TIME;
+	pnn->type = pn->type;
+	pnn->state = pn->state;
+	memcpy(pnn->sn, pn->sn, SERIAL_NUMBER_SIZE);
+	pnn->selected_device = pn->selected_device;
+	pnn->selected_filetype = pn->selected_filetype;
+	pnn->subdir = pn->subdir;
+	pnn->extension = pn->extension;
+	pnn->dirlength = pn->dirlength;
+	pnn->device_name_offset = (pn->device_name == NULL) ? -1 : (int) (pn->device_name - pn->path);
+	pnn->known_bus = pn->known_bus;
+	pnn->selected_connection = pn->selected_connection;
+	pnn->result_flags = pn->control_flags;
+
+	CACHE_WLOCK;
+	if (cache.parsedname_added >= PARSEDNAME_CACHE_SIZE) {
+		FlipParsedName() ;
+	}
+	opaque = tsearch(pnn, &cache.parsedname_tree_new, parsedname_tree_compare) ;
+	if (opaque == NULL) {
+		owfree(pnn);
+	} else if (pnn != opaque->key) {
+		owfree(opaque->key);
+		opaque->key = pnn;
+		state = just_update;
+	} else {
+		++cache.parsedname_added;
+		state = yes_add;
+	}
+	CACHE_WUNLOCK;
+
+	return Add_Stat(&cache_pn, (state == no_add) ? gbBAD : gbGOOD);
+}
+
+/* Fill pn from the memo if this path was parsed recently */
+/* pn has already been set up by FS_ParsedName_setup (path, locks) */
+GOOD_OR_BAD Cache_Get_ParsedName(uint32_t control_flags, struct parsedname *pn)
+{
+	time_t duration = TimeOut(fc_presence);
+	struct parsedname_node pnn_key;
+	struct parsedname_opaque *opaque;
+	enum cache_task_return ctr_ret = ctr_not_found;
+
+	if (duration <= 0) {
+		return gbBAD;
+	}
+
+	pnn_key.control_flags = control_flags;
+	pnn_key.path = pn->path;
+
+	CACHE_RLOCK;
+	opaque = tfind(&pnn_key, &cache.parsedname_tree_new, parsedname_tree_compare) ;
+	if ( opaque == NULL ) {
+		opaque = tfind(&pnn_key, &cache.parsedname_tree_old, parsedname_tree_compare) ;
+	}
+	if ( opaque != NULL ) {
+		struct parsedname_node *pnn = opaque->key;
+		if ( pnn->expires < NOW_TIME ) {
+			ctr_ret = ctr_expired;
+		} else if ( pnn->sparse_name != NULL && (pn->sparse_name = MemarenaStrdup(pnn->sparse_name)) == NULL ) {
+			ctr_ret = ctr_not_found;
+		} else {
+			strcpy(pn->path_to_server, pnn->path_to_server);	// same path, so fits the allocation
+			pn->type = pnn->type;
+			pn->state = pnn->state;
+			memcpy(pn->sn, pnn->sn, SERIAL_NUMBER_SIZE);
+			pn->selected_device = pnn->selected_device;
+			pn->selected_filetype = pnn->selected_filetype;
+			pn->subdir = pnn->subdir;
+			pn->extension = pnn->extension;
+			pn->dirlength = pnn->dirlength;
+			pn->device_name = (pnn->device_name_offset < 0) ? NULL : pn->path + pnn->device_name_offset;
+			pn->known_bus = pnn->known_bus;
+			pn->selected_connection = pnn->selected_connection;
+			pn->control_flags = pnn->result_flags;
+			ctr_ret = ctr_ok;
+		}
+	}
+	CACHE_RUNLOCK;
+
+	return Get_Stat(&cache_pn, ctr_ret);
+}
+
+/* Aliases, device locations or the bus list changed -- forget all parsed paths */
+void Cache_Del_ParsedName(void)
+{
+	CACHE_WLOCK;
+	if ( cache.parsedname_tree_new != NULL || cache.parsedname_tree_old != NULL ) {
+		LEVEL_DEBUG("Clear parsed path memo");
+		FlipParsedName() ;
+		FlipParsedName() ;
+		STAT_ADD1(cache_pn.deletes);
+	}
+	++cache.parsedname_generation;
+	CACHE_WUNLOCK;
+}
+
+/* Parsed paths kept outside the memo (open files) hold while this is unchanged */
+UINT Cache_ParsedName_Generation(void)
+{
+	UINT generation;
+
+	CACHE_RLOCK;
+	generation = cache.parsedname_generation;
+	CACHE_RUNLOCK;
+	return generation;
+}
+
+/* ... and for as long as a memo entry would */
+time_t Cache_ParsedName_Lifespan(void)
+{
+	return TimeOut(fc_presence);
+}
@@ -26,6 +26,7 @@ struct inbound_control Inbound_Control = {
 	.next_fake = 0,
 	.next_tester = 0,
 	.next_mock = 0,
+	.next_timed = 0,
 	.w1_monitor = NO_CONNECTION ,
 	.external = NO_CONNECTION ,
 };
@@ -120,8 +121,7 @@ static struct connection_in *AllocIn(const struct connection_in *old_in)
 		++Inbound_Control.active ;
 		new_in->index = Inbound_Control.next_index++;
 		_MUTEX_INIT(new_in->bus_mutex);
-		_MUTEX_INIT(new_in->dev_mutex);
-		new_in->dev_db = NULL;
+		DeviceLockTreeInit(new_in);
 	} else {
 		LEVEL_DEFAULT("Cannot allocate memory for bus master structure");
 	}
@@ -179,6 +179,7 @@ struct port_in *LinkPort(struct port_in *pin)
 		// Locking done at a higher level
 		pin->next = Inbound_Control.head_port;	/* put in linked list at start */
 		Inbound_Control.head_port = pin ;
+		Cache_Del_ParsedName() ; // bus list changed
 
 		_MUTEX_INIT(pin->port_mutex);
 	}
@@ -240,11 +241,11 @@ void RemoveIn( struct connection_in * conn )
 	if ( conn->index == Inbound_Control.next_index-1 ) {
 		Inbound_Control.next_index-- ;
 	}
+	Cache_Del_ParsedName() ; // bus list changed
 
 	/* Now free up thread-sync resources */
 	_MUTEX_DESTROY(conn->bus_mutex);
-	_MUTEX_DESTROY(conn->dev_mutex);
-	SAFETDESTROY( conn->dev_db, owfree_func);
+	DeviceLockTreeDestroy(conn);
 
 	/* Free port */
 	COM_free( conn ) ;
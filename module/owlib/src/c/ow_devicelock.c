@@ -11,6 +11,7 @@
 #include <config.h>
 #include "owfs_config.h"
 #include "ow.h"
+#include "ow_counters.h"
 #include "ow_connection.h"
 
 // dynamically created access control for a 1-wire device
@@ -24,6 +25,8 @@ struct devlock {
 
 /*
 We keep all the devlocks, organized in a tree for faster searching.
+The devlocks themselves come from a per-bus slab pool (dev_slab),
+protected like the tree by dev_mutex.
 */
 #define DEVTREE_LOCK(pn)           _MUTEX_LOCK(   ((pn)->selected_connection)->dev_mutex )
 #define DEVTREE_UNLOCK(pn)         _MUTEX_UNLOCK( ((pn)->selected_connection)->dev_mutex )
@@ -47,12 +50,28 @@ static int dev_compare(const void *a, const void *b)
 	return memcmp(&((const struct devlock *) a)->sn, &((const struct devlock *) b)->sn, SERIAL_NUMBER_SIZE);
 }
 
+/* Set up the (empty) devlock tree for a new bus */
+void DeviceLockTreeInit(struct connection_in *in)
+{
+	_MUTEX_INIT(in->dev_mutex);
+	in->dev_db = NULL;
+	SlabInit(&(in->dev_slab), sizeof(struct devlock), &slab_devlock);
+}
+
+/* Remove the devlock tree and all its devlocks at once */
+void DeviceLockTreeDestroy(struct connection_in *in)
+{
+	_MUTEX_DESTROY(in->dev_mutex);
+	SAFETDESTROY( in->dev_db, SlabTreeKeep);
+	SlabClear(&(in->dev_slab));
+}
+
 /* Grabs a device lock, either one already matching, or creates one */
 /* called per-adapter */
 /* The device locks (devlock) are kept in a tree */
 ZERO_OR_ERROR DeviceLockGet(struct parsedname *pn)
 {
-	struct devlock *local_devicelock;
+	struct devlock search_devicelock;
 	struct devlock *tree_devicelock;
 	struct dev_opaque *opaque;
 
@@ -90,30 +109,32 @@ ZERO_OR_ERROR DeviceLockGet(struct parsedname *pn)
 			break;
 	}
 
-	// Create a devlock block to add to the tree
-	local_devicelock = owmalloc(sizeof(struct devlock)) ;
-	if ( local_devicelock == NULL ) {
-		return -ENOMEM;
-	}
-	memcpy(local_devicelock->sn, pn->sn, SERIAL_NUMBER_SIZE);
+	// Search key only -- a devlock is allocated just for a new device slot
+	memcpy(search_devicelock.sn, pn->sn, SERIAL_NUMBER_SIZE);
 
 	DEVTREE_LOCK(pn);
 	/* in->dev_db points to the root of a tree of queries that are using this device */
-	opaque = (struct dev_opaque *)tsearch(local_devicelock, &(pn->selected_connection->dev_db), dev_compare) ;
+	opaque = (struct dev_opaque *)tsearch(&search_devicelock, &(pn->selected_connection->dev_db), dev_compare) ;
 	if ( opaque == NULL ) {	// unfound and uncreatable
 		DEVTREE_UNLOCK(pn);
-		owfree(local_devicelock); // kill the allocated devlock
 		return -ENOMEM;
 	}
 	
-	tree_devicelock = opaque->key ;
-	if ( local_devicelock == tree_devicelock) {	// new device slot
-		// No longer "local" -- the local_device lock now belongs to the device_tree
+	if ( opaque->key == &search_devicelock) {	// new device slot
+		// Replace the search key in the tree with a real devlock
 		// It will need to be freed later, when the user count returns to zero.
+		tree_devicelock = SlabAlloc(&(pn->selected_connection->dev_slab)) ;
+		if ( tree_devicelock == NULL ) {
+			tdelete(&search_devicelock, &(pn->selected_connection->dev_db), dev_compare);
+			DEVTREE_UNLOCK(pn);
+			return -ENOMEM;
+		}
+		memcpy(tree_devicelock->sn, pn->sn, SERIAL_NUMBER_SIZE);
 		_MUTEX_INIT(tree_devicelock->lock);	// create a mutex
 		tree_devicelock->users = 0 ;
+		opaque->key = tree_devicelock ;
 	} else {					// existing device slot
-		owfree(local_devicelock); // kill the locally allocated devlock (since there already is a matching devlock)	
+		tree_devicelock = opaque->key ;
 	}
 	++(tree_devicelock->users); // add our claim to the device
 	DEVTREE_UNLOCK(pn);
@@ -136,7 +157,7 @@ void DeviceLockRelease(struct parsedname *pn)
 			// Nobody's interested!
 			tdelete(pn->lock, &(pn->selected_connection->dev_db), dev_compare); /* Serg: Address 0x5A0D750 is 0 bytes inside a block of size 32 free'd */
 			_MUTEX_DESTROY(pn->lock->lock);
-			owfree(pn->lock);
+			SlabFree(&(pn->selected_connection->dev_slab), pn->lock);
 		}
 		DEVTREE_UNLOCK(pn);
 		pn->lock = NULL;
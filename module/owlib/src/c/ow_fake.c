@@ -23,6 +23,11 @@ static void Fake_close(struct connection_in *in);
 static enum search_status Fake_next_both(struct device_search *ds, const struct parsedname *pn);
 static const ASCII *namefind(const char *name);
 static void Fake_setroutines(struct connection_in *in);
+static void Timed_setroutines(struct connection_in *in);
+static RESET_TYPE Timed_reset(const struct parsedname *pn);
+static enum search_status Timed_next_both(struct device_search *ds, const struct parsedname *pn);
+static GOOD_OR_BAD Timed_sendback_data(const BYTE * data, BYTE * resp, const size_t len, const struct parsedname *pn);
+static GOOD_OR_BAD Timed_sendback_bits(const BYTE * data, BYTE * resp, const size_t len, const struct parsedname *pn);
 static GOOD_OR_BAD Fake_sendback_data(const BYTE * data, BYTE * resp, const size_t len, const struct parsedname *pn);
 static void GetNextByte( const ASCII ** strpointer, BYTE default_byte, BYTE * sn ) ;
 static void GetDeviceName(const ASCII ** strpointer, struct connection_in * in) ;
@@ -52,6 +57,16 @@ static void Fake_setroutines(struct connection_in *in)
 	DirblobInit( &(in->master.fake.alarm) );
 }
 
+/* Same as fake, but the bus takes real time */
+static void Timed_setroutines(struct connection_in *in)
+{
+	Fake_setroutines(in);
+	in->iroutines.reset = Timed_reset;
+	in->iroutines.next_both = Timed_next_both;
+	in->iroutines.sendback_data = Timed_sendback_data;
+	in->iroutines.sendback_bits = Timed_sendback_bits;
+}
+
 static GOOD_OR_BAD Fake_sendback_data(const BYTE * data, BYTE * resp, const size_t len, const struct parsedname *pn)
 {
 	(void) pn;
@@ -238,6 +253,26 @@ GOOD_OR_BAD Tester_detect(struct port_in *pin)
 	return gbGOOD;
 }
 
+/* Device-specific functions */
+/* Since this is simulated bus master, it's creation cannot fail */
+/* Same device list as fake, but timing follows the real bus */
+GOOD_OR_BAD Timed_detect(struct port_in *pin)
+{
+	struct connection_in * in = pin->first ;
+	Timed_setroutines(in);		// set up close, reconnect, reset, ...
+	in->iroutines.detect = Timed_detect;
+
+	in->adapter_name = "Simulated-Timed";
+	in->Adapter = adapter_timed;
+	SetConninData( Inbound_Control.next_timed++, "timed", pin  );
+
+	in->master.timed.latency_us = Globals.timed_latency ;
+	in->master.timed.error_percent = Globals.timed_errors ;
+	in->master.timed.parasitic = Globals.timed_parasitic ;
+
+	return gbGOOD;
+}
+
 static RESET_TYPE Fake_reset(const struct parsedname *pn)
 {
 	(void) pn;
@@ -259,6 +294,31 @@ static GOOD_OR_BAD Fake_sendback_bits(const BYTE * data, BYTE * resp, const size
 	return gbGOOD;
 }
 
+static RESET_TYPE Timed_reset(const struct parsedname *pn)
+{
+	Timed_charge( 1, 0, pn ) ;
+	return GOOD( Timed_inject_error(pn) ) ? BUS_RESET_OK : BUS_RESET_ERROR ;
+}
+
+/* 1-wire echoes what is written, so reads (0xFF) return the idle bus */
+static GOOD_OR_BAD Timed_sendback_data(const BYTE * data, BYTE * resp, const size_t len, const struct parsedname *pn)
+{
+	Timed_charge( 0, 8*len, pn ) ;
+	if ( resp != NULL ) {
+		memmove( resp, data, len ) ;
+	}
+	return Timed_inject_error(pn) ;
+}
+
+static GOOD_OR_BAD Timed_sendback_bits(const BYTE * data, BYTE * resp, const size_t length, const struct parsedname *pn)
+{
+	Timed_charge( 0, length, pn ) ;
+	if ( resp != NULL ) {
+		memmove( resp, data, length ) ;
+	}
+	return Timed_inject_error(pn) ;
+}
+
 static void Fake_close(struct connection_in *in)
 {
 	DirblobClear( &(in->master.fake.main) );
@@ -278,6 +338,18 @@ static enum search_status Fake_next_both(struct device_search *ds, const struct
 	return search_good;
 }
 
+/* Each device found costs a reset, search command and 64 triplets */
+static enum search_status Timed_next_both(struct device_search *ds, const struct parsedname *pn)
+{
+	if (ds->search != _1W_CONDITIONAL_SEARCH_ROM) {
+		Timed_charge( 1, 8 + 3*64, pn ) ;
+		if ( BAD( Timed_inject_error(pn) ) ) {
+			return search_error ;
+		}
+	}
+	return Fake_next_both( ds, pn ) ;
+}
+
 /* Need to lock struct global_namefind_struct since twalk requires global data -- can't pass void pointer */
 /* Except all *_detect routines are done sequentially, not concurrently */
 struct {
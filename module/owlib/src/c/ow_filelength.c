@@ -56,6 +56,11 @@ size_t FileLength(const struct parsedname *pn)
 size_t FullFileLength(const struct parsedname * pn)
 {
 	size_t entry_length = FileLength(pn);
+
+	if (ShouldReturnBinary(pn) && BinaryValueType(pn) != bv_none) {
+		// raw value instead of text
+		return BinaryValueLength(pn);
+	}
 	if (pn->type == ePN_structure) {
 		return entry_length;
 	} else if (pn->extension != EXTENSION_ALL) {
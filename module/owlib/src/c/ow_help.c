@@ -127,6 +127,7 @@ void ow_help_cache(void)
 	"  --timeout_network   [%3d] Timeout for each network transaction\n"
 	"  --timeout_server    [%3d] Timeout for first server connection\n"
 	"  --timeout_ftp       [%3d] Timeout for FTP session\n"
+	"  --timeout_http      [%3d] Timeout for idle HTTP keep-alive connection\n"
 	"  --timeout_ha7       [%3d] Timeout for HA7Net bus master\n"
 	"  --timeout_w1        [%3d] Timeout for w1 kernel netlink\n"
 	, Globals.timeout_volatile
@@ -138,6 +139,7 @@ void ow_help_cache(void)
 	, Globals.timeout_network
 	, Globals.timeout_server
 	, Globals.timeout_ftp
+	, Globals.timeout_http
 	, Globals.timeout_ha7
 	, Globals.timeout_w1
 		   );
@@ -167,6 +169,7 @@ void ow_help_program(void)
 	"  --zero                Announce service via zeroconf\n"
 	"  --announce name       Name for service given in zeroconf broadcast\n"
 	"  --nozero              Don't announce service via zeroconf\n"
+	"  --http_workers n      Threads building pages (reading the bus), default 4\n"
 	"\n"
 	" owserver (OWFS server)\n"
 	"  -p --port [ip:]port   TCP address and port number for access\n"
@@ -180,6 +183,7 @@ void ow_help_program(void)
 	" owftpd (ftp server)\n"
 	"  -p --port [ip:]port   TCP address and port number for access\n"
 	"                           has default port 22 (root only)\n"
+	"  --ftp_workers n       Threads running commands (reading the bus), default 4\n"
 	"  --zero                Announce service via zeroconf\n"
 	"  --announce name       Name for service given in zeroconf broadcast\n"
 	"  --nozero              Don't announce service via zeroconf\n" "\n"
@@ -244,6 +248,9 @@ void ow_help_device(void)
 	"                   e.g. 1F,10,21 for DS2409,DS18S20,DS1921\n"
 	"  --tester=list   List of devices to simulate (non-random ID, non-random data)\n"
 	"  --temperature_low=0.0   --temperature_high=100.0 temperature range for fake readings\n"
+	"  --timed=list    List of devices to simulate (random data, real bus timing)\n"
+	"  --timed_latency=usec|none|usb|serial|network  adapter round trip for timed\n"
+	"  --timed_errors=percent  inject bus errors   --timed_parasitic  strong pull-up conversions\n"
 	"\n"
 	" Linux Kernel Device\n"
 	"  --w1            Scan for kernel-managed bus masters\n"
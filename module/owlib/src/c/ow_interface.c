@@ -40,6 +40,8 @@ READ_FUNCTION(FS_r_baud);
 WRITE_FUNCTION(FS_w_baud);
 READ_FUNCTION(FS_r_templimit);
 WRITE_FUNCTION(FS_w_templimit);
+READ_FUNCTION(FS_r_timing);
+WRITE_FUNCTION(FS_w_timing);
 //#define DEBUG_DS2490
 #ifdef DEBUG_DS2490
 READ_FUNCTION(FS_r_ds2490status);
@@ -147,12 +149,23 @@ static enum e_visibility VISIBLE_K1WM( const struct parsedname * pn )
 	}
 }
 
+static enum e_visibility VISIBLE_TIMED( const struct parsedname * pn )
+{
+	switch ( get_busmode(pn->selected_connection) ) {
+		case bus_timed:
+			return visible_now ;
+		default:
+			return visible_not_now ;
+	}
+}
+
 static enum e_visibility VISIBLE_PSEUDO( const struct parsedname * pn )
 {
 	switch ( get_busmode(pn->selected_connection) ) {
 		case bus_fake:
 		case bus_tester:
 		case bus_mock:
+		case bus_timed:
 			return visible_now ;
 		default:
 			return visible_not_now ;
@@ -215,6 +228,9 @@ static struct filetype interface_settings[] = {
 	{"simulated", PROPERTY_LENGTH_SUBDIR, NON_AGGREGATE, ft_subdir, fc_subdir, NO_READ_FUNCTION, NO_WRITE_FUNCTION, VISIBLE_PSEUDO, NO_FILETYPE_DATA, },
 	{"simulated/templow", PROPERTY_LENGTH_TEMP, NON_AGGREGATE, ft_temperature, fc_stable, FS_r_templimit, FS_w_templimit, VISIBLE_PSEUDO, {.i=1}, },
 	{"simulated/temphigh", PROPERTY_LENGTH_TEMP, NON_AGGREGATE, ft_temperature, fc_stable, FS_r_templimit, FS_w_templimit, VISIBLE_PSEUDO, {.i=0}, },
+	{"simulated/latency", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_static, FS_r_timing, FS_w_timing, VISIBLE_TIMED, {.i=0}, },
+	{"simulated/error_percent", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_static, FS_r_timing, FS_w_timing, VISIBLE_TIMED, {.i=1}, },
+	{"simulated/parasitic", PROPERTY_LENGTH_YESNO, NON_AGGREGATE, ft_yesno, fc_static, FS_r_yesno, FS_w_yesno, VISIBLE_TIMED, {.s=offsetof(struct connection_in,master.timed.parasitic),}, },
 };
 struct device d_interface_settings = { 
 	"settings", 
@@ -223,7 +239,8 @@ struct device d_interface_settings = {
 	COUNT_OF_FILETYPES(interface_settings), 
 	interface_settings,
 	NO_GENERIC_READ,
-	NO_GENERIC_WRITE
+	NO_GENERIC_WRITE,
+	NULL
 };
 
 static struct filetype interface_statistics[] = {
@@ -265,7 +282,8 @@ struct device d_interface_statistics = {
 	COUNT_OF_FILETYPES(interface_statistics), 
 	interface_statistics,
 	NO_GENERIC_READ,
-	NO_GENERIC_WRITE
+	NO_GENERIC_WRITE,
+	NULL
 };
 
 
@@ -369,6 +387,7 @@ static ZERO_OR_ERROR FS_r_templimit(struct one_wire_query *owq)
 		case bus_fake:
 		case bus_mock:
 		case bus_tester:
+		case bus_timed:
 			OWQ_F(owq) = pn->selected_filetype->data.i ? pn->selected_connection->master.fake.templow : pn->selected_connection->master.fake.temphigh;
 			return 0;
 		default:
@@ -383,6 +402,7 @@ static ZERO_OR_ERROR FS_w_templimit(struct one_wire_query *owq)
 		case bus_fake:
 		case bus_mock:
 		case bus_tester:
+		case bus_timed:
 			if (pn->selected_filetype->data.i) {
 				pn->selected_connection->master.fake.templow = OWQ_F(owq);
 			} else {
@@ -395,6 +415,38 @@ static ZERO_OR_ERROR FS_w_templimit(struct one_wire_query *owq)
 	return 0 ;
 }
 
+/* timed adapter round trip (usec) and error injection (percent) */
+static ZERO_OR_ERROR FS_r_timing(struct one_wire_query *owq)
+{
+	struct parsedname *pn = PN(owq);
+	if ( get_busmode(pn->selected_connection) != bus_timed ) {
+		return -ENOTSUP ;
+	}
+	if (pn->selected_filetype->data.i) {
+		OWQ_U(owq) = pn->selected_connection->master.timed.error_percent;
+	} else {
+		OWQ_U(owq) = pn->selected_connection->master.timed.latency_us;
+	}
+	return 0;
+}
+
+static ZERO_OR_ERROR FS_w_timing(struct one_wire_query *owq)
+{
+	struct parsedname *pn = PN(owq);
+	if ( get_busmode(pn->selected_connection) != bus_timed ) {
+		return -ENOTSUP ;
+	}
+	if (pn->selected_filetype->data.i) {
+		if ( OWQ_U(owq) > 100 ) {
+			return -EINVAL ;
+		}
+		pn->selected_connection->master.timed.error_percent = OWQ_U(owq);
+	} else {
+		pn->selected_connection->master.timed.latency_us = OWQ_U(owq);
+	}
+	return 0;
+}
+
 /* Serial baud rate */
 static ZERO_OR_ERROR FS_r_baud(struct one_wire_query *owq)
 {
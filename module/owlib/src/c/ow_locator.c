@@ -52,6 +52,7 @@ static GOOD_OR_BAD OW_any_locator(BYTE * loc, const struct parsedname *pn)
 		case bus_fake:
 		case bus_tester:
 		case bus_mock:
+		case bus_timed:
 			return OW_fake_locator(loc, pn);
 		default:
 			return OW_locator(loc, pn);
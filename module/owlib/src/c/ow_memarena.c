@@ -0,0 +1,173 @@
+/*
+    OW -- One-Wire filesystem
+    version 0.4 7/2/2003
+
+    Written 2003 Paul H Alfille
+    GPL license
+    See the header file: ow.h for full attribution
+    ---------------------------------------------------------------------------
+    Implementation:
+    memarena -- per-request bump allocator
+*/
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+
+/*
+    A "memarena" is a list of chunks carved up sequentially.
+
+    Nothing is freed individually. The whole arena is rewound
+    by MemarenaReset when the request is finished, keeping one
+    chunk for the next request on a persistent connection.
+
+    Each allocation is preceded by a tag so MemarenaFree can
+    tell arena memory (ignored) from heap fallback (owfree).
+*/
+
+#define MEMARENA_ALIGN          16
+#define MEMARENA_ROUND(x)       ( ((x) + MEMARENA_ALIGN - 1) & ~((size_t) MEMARENA_ALIGN - 1) )
+
+#define MEMARENA_FROM_ARENA     0x4D41524EUL
+#define MEMARENA_FROM_HEAP      0x48454150UL
+
+struct memarena_tag {
+	unsigned long origin ;
+};
+
+struct memarena_chunk {
+	struct memarena_chunk * next ;
+	size_t used ;
+};
+
+#define MEMARENA_TAG_SIZE       MEMARENA_ROUND(sizeof(struct memarena_tag))
+#define MEMARENA_CHUNK_HEADER   MEMARENA_ROUND(sizeof(struct memarena_chunk))
+#define MEMARENA_CHUNK_DATA(c)  ( ((BYTE *)(c)) + MEMARENA_CHUNK_HEADER )
+
+/* The arena each thread allocates from (NULL for the heap) */
+static pthread_key_t memarena_key ;
+static pthread_once_t memarena_key_once = PTHREAD_ONCE_INIT;
+
+static void memarena_key_init(void)
+{
+	pthread_key_create( &memarena_key, NULL ) ;
+}
+
+static void * memarena_tag( void * block, unsigned long origin )
+{
+	((struct memarena_tag *) block)->origin = origin ;
+	return ((BYTE *) block) + MEMARENA_TAG_SIZE ;
+}
+
+static void * memarena_heap( size_t size )
+{
+	void * block = owmalloc( MEMARENA_TAG_SIZE + size ) ;
+	if ( block == NULL ) {
+		return NULL ;
+	}
+	return memarena_tag( block, MEMARENA_FROM_HEAP ) ;
+}
+
+void MemarenaInit(struct memarena *ma)
+{
+	ma->chunk = NULL ;
+	ma->allocated = 0 ;
+}
+
+/* Free every chunk */
+void MemarenaClear(struct memarena *ma)
+{
+	while ( ma->chunk != NULL ) {
+		struct memarena_chunk * next = ma->chunk->next ;
+		owfree( ma->chunk ) ;
+		ma->chunk = next ;
+	}
+	MemarenaInit(ma) ;
+}
+
+/* Release all allocations at once, keep a chunk for reuse */
+void MemarenaReset(struct memarena *ma)
+{
+	struct memarena_chunk * keep = ma->chunk ;
+
+	if ( keep == NULL ) {
+		return ;
+	}
+	ma->chunk = keep->next ;
+	MemarenaClear(ma) ;
+	keep->next = NULL ;
+	keep->used = 0 ;
+	ma->chunk = keep ;
+}
+
+/* Choose the arena for MemarenaMalloc in this thread */
+void MemarenaSelect(struct memarena *ma)
+{
+	pthread_once( &memarena_key_once, memarena_key_init ) ;
+	pthread_setspecific( memarena_key, ma ) ;
+}
+
+void *MemarenaAlloc(struct memarena *ma, size_t size)
+{
+	size_t needed = MEMARENA_TAG_SIZE + MEMARENA_ROUND(size) ;
+	struct memarena_chunk * chunk ;
+	BYTE * block ;
+
+	if ( ma == NULL || size > MEMARENA_MAX_ALLOC ) {
+		return memarena_heap( size ) ;
+	}
+
+	chunk = ma->chunk ;
+	if ( chunk == NULL || chunk->used + needed > MEMARENA_CHUNK_SIZE ) {
+		chunk = owmalloc( MEMARENA_CHUNK_HEADER + MEMARENA_CHUNK_SIZE ) ;
+		if ( chunk == NULL ) {
+			return memarena_heap( size ) ;
+		}
+		chunk->used = 0 ;
+		chunk->next = ma->chunk ;
+		ma->chunk = chunk ;
+	}
+
+	block = MEMARENA_CHUNK_DATA(chunk) + chunk->used ;
+	chunk->used += needed ;
+	ma->allocated += needed ;
+	return memarena_tag( block, MEMARENA_FROM_ARENA ) ;
+}
+
+void *MemarenaMalloc(size_t size)
+{
+	pthread_once( &memarena_key_once, memarena_key_init ) ;
+	return MemarenaAlloc( pthread_getspecific( memarena_key ), size ) ;
+}
+
+char *MemarenaStrdup(const char * s)
+{
+	size_t length = strlen(s) + 1 ;
+	char * copy = MemarenaMalloc( length ) ;
+
+	if ( copy != NULL ) {
+		memcpy( copy, s, length ) ;
+	}
+	return copy ;
+}
+
+void MemarenaFree(void * ptr)
+{
+	struct memarena_tag * tag ;
+
+	if ( ptr == NULL ) {
+		return ;
+	}
+	tag = (struct memarena_tag *) (((BYTE *) ptr) - MEMARENA_TAG_SIZE) ;
+	switch ( tag->origin ) {
+		case MEMARENA_FROM_ARENA:
+			// released with the whole arena
+			break ;
+		case MEMARENA_FROM_HEAP:
+			owfree( tag ) ;
+			break ;
+		default:
+			LEVEL_DEBUG("Not memarena memory %p", ptr ) ;
+			break ;
+	}
+}
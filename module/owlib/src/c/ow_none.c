@@ -67,7 +67,7 @@ struct filetype NoDev[] = {
 	F_r_id,
 };
 
-struct device UnknownDevice = { "XX", "generic", ePN_real, COUNT_OF_FILETYPES(NoDev), NoDev, NO_GENERIC_READ, NO_GENERIC_WRITE };
-struct device RemoteDevice = { "YY", "remote_alias", ePN_real, COUNT_OF_FILETYPES(NoDev), NoDev,  NO_GENERIC_READ, NO_GENERIC_WRITE };
+struct device UnknownDevice = { "XX", "generic", ePN_real, COUNT_OF_FILETYPES(NoDev), NoDev, NO_GENERIC_READ, NO_GENERIC_WRITE, NULL };
+struct device RemoteDevice = { "YY", "remote_alias", ePN_real, COUNT_OF_FILETYPES(NoDev), NoDev,  NO_GENERIC_READ, NO_GENERIC_WRITE, NULL };
 
 /* ------- Functions ------------ */
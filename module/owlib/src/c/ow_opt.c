@@ -34,6 +34,7 @@ static GOOD_OR_BAD ConfigurationFile(const ASCII * file);
 static int ParseInterp(struct lineparse *lp);
 static GOOD_OR_BAD OW_parsevalue_I(long long int *var, const ASCII * str);
 static GOOD_OR_BAD OW_parsevalue_F(_FLOAT *var, const ASCII * str);
+static GOOD_OR_BAD OW_parse_timed_latency(const ASCII * str);
 
 #define NO_LINKED_VAR NULL
 
@@ -123,6 +124,12 @@ const struct option owopts_long[] = {
 	{"max_clients", required_argument, NO_LINKED_VAR, e_max_clients},	/* ftp max connections */
 	{"max-clients", required_argument, NO_LINKED_VAR, e_max_clients},	/* ftp max connections */
 	{"maxclients", required_argument, NO_LINKED_VAR, e_max_clients},	/* ftp max connections */
+	{"http_workers", required_argument, NO_LINKED_VAR, e_http_workers},	/* owhttpd page builders */
+	{"http-workers", required_argument, NO_LINKED_VAR, e_http_workers},	/* owhttpd page builders */
+	{"httpworkers", required_argument, NO_LINKED_VAR, e_http_workers},	/* owhttpd page builders */
+	{"ftp_workers", required_argument, NO_LINKED_VAR, e_ftp_workers},	/* owftpd command runners */
+	{"ftp-workers", required_argument, NO_LINKED_VAR, e_ftp_workers},	/* owftpd command runners */
+	{"ftpworkers", required_argument, NO_LINKED_VAR, e_ftp_workers},	/* owftpd command runners */
 
 	{"passive", required_argument, NO_LINKED_VAR, e_passive},	/* DS9097 passive */
 	{"PASSIVE", required_argument, NO_LINKED_VAR, e_passive},	/* DS9097 passive */
@@ -174,6 +181,9 @@ const struct option owopts_long[] = {
 	{"mock", required_argument, NO_LINKED_VAR, e_mock},	/* Mock */
 	{"Mock", required_argument, NO_LINKED_VAR, e_mock},	/* Mock */
 	{"MOCK", required_argument, NO_LINKED_VAR, e_mock},	/* Mock */
+	{"timed", required_argument, NO_LINKED_VAR, e_timed},	/* Timed */
+	{"Timed", required_argument, NO_LINKED_VAR, e_timed},	/* Timed */
+	{"TIMED", required_argument, NO_LINKED_VAR, e_timed},	/* Timed */
 	{"etherweather", required_argument, NO_LINKED_VAR, e_etherweather},	/* EtherWeather */
 	{"EtherWeather", required_argument, NO_LINKED_VAR, e_etherweather},	/* EtherWeather */
 	{"zero", no_argument, &Globals.announce_off, 0},
@@ -228,6 +238,7 @@ const struct option owopts_long[] = {
 	{"timeout_network", required_argument, NO_LINKED_VAR, e_timeout_network,},	// timeout -- tcp wait
 	{"timeout_server", required_argument, NO_LINKED_VAR, e_timeout_server,},	// timeout -- server wait
 	{"timeout_ftp", required_argument, NO_LINKED_VAR, e_timeout_ftp,},	// timeout -- ftp wait
+	{"timeout_http", required_argument, NO_LINKED_VAR, e_timeout_http,},	// timeout -- http keep-alive wait
 	{"timeout_HA7", required_argument, NO_LINKED_VAR, e_timeout_ha7,},	// timeout -- HA7Net wait
 	{"timeout_ha7", required_argument, NO_LINKED_VAR, e_timeout_ha7,},	// timeout -- HA7Net wait
 	{"timeout_HA7Net", required_argument, NO_LINKED_VAR, e_timeout_ha7,},	// timeout -- HA7Net wait
@@ -250,6 +261,13 @@ const struct option owopts_long[] = {
 	{"hi_temperature", required_argument, NO_LINKED_VAR, e_temphigh,},
 	{"temphi", required_argument, NO_LINKED_VAR, e_temphigh,},
 
+	{"timed_latency", required_argument, NO_LINKED_VAR, e_timed_latency,},	// timed adapter round trip
+	{"timed-latency", required_argument, NO_LINKED_VAR, e_timed_latency,},	// timed adapter round trip
+	{"timed_errors", required_argument, NO_LINKED_VAR, e_timed_errors,},	// timed adapter failure percent
+	{"timed-errors", required_argument, NO_LINKED_VAR, e_timed_errors,},	// timed adapter failure percent
+	{"timed_parasitic", no_argument, &Globals.timed_parasitic, 1},
+	{"timed_powered", no_argument, &Globals.timed_parasitic, 0},
+
 	{"one_device", no_argument, &Globals.one_device, 1},
 	{"1_device", no_argument, &Globals.one_device, 1},
 
@@ -761,6 +779,14 @@ GOOD_OR_BAD owopt(const int option_char, const char *arg)
 		RETURN_BAD_IF_BAD(OW_parsevalue_I(&arg_to_integer, arg)) ;
 		Globals.max_clients = (int) arg_to_integer;
 		break;
+	case e_http_workers:
+		RETURN_BAD_IF_BAD(OW_parsevalue_I(&arg_to_integer, arg)) ;
+		Globals.http_workers = (arg_to_integer < 1) ? 1 : (int) arg_to_integer;
+		break;
+	case e_ftp_workers:
+		RETURN_BAD_IF_BAD(OW_parsevalue_I(&arg_to_integer, arg)) ;
+		Globals.ftp_workers = (arg_to_integer < 1) ? 1 : (int) arg_to_integer;
+		break;
 	case e_want_background:
 		switch (Globals.daemon_status) {
 			case e_daemon_sd:
@@ -815,6 +841,8 @@ GOOD_OR_BAD owopt(const int option_char, const char *arg)
 		return ARG_Tester(arg);
 	case e_mock:
 		return ARG_Mock(arg);
+	case e_timed:
+		return ARG_Timed(arg);
 	case e_etherweather:
 		return ARG_EtherWeather(arg);
 	case e_masterhub:
@@ -865,6 +893,7 @@ GOOD_OR_BAD owopt(const int option_char, const char *arg)
 	case e_timeout_network:
 	case e_timeout_server:
 	case e_timeout_ftp:
+	case e_timeout_http:
 	case e_timeout_ha7:
 	case e_timeout_w1:
 	case e_timeout_persistent_low:
@@ -887,6 +916,16 @@ GOOD_OR_BAD owopt(const int option_char, const char *arg)
 		RETURN_BAD_IF_BAD(OW_parsevalue_F(&arg_to_float, arg)) ;
 		Globals.temphigh = arg_to_float;
 		break;
+	case e_timed_latency:
+		return OW_parse_timed_latency(arg);
+	case e_timed_errors:
+		RETURN_BAD_IF_BAD(OW_parsevalue_I(&arg_to_integer, arg)) ;
+		if ( arg_to_integer < 0 || arg_to_integer > 100 ) {
+			LEVEL_DEFAULT("Simulated error rate %d%% out of range",(int) arg_to_integer);
+			return gbBAD;
+		}
+		Globals.timed_errors = (int) arg_to_integer;
+		break;
 	case e_safemode:
 		LocalControlFlags |= SAFEMODE ;
 		break ;
@@ -922,3 +961,27 @@ static GOOD_OR_BAD OW_parsevalue_F(_FLOAT *var, const ASCII * str)
 	}
 	return gbGOOD;
 }
+
+/* Adapter round trip for the timed adapter -- microseconds or a typical adapter type */
+static GOOD_OR_BAD OW_parse_timed_latency(const ASCII * str)
+{
+	long long int arg_to_integer;
+
+	if ( strcasecmp(str,"none") == 0 ) {
+		Globals.timed_latency = 0 ;
+	} else if ( strcasecmp(str,"usb") == 0 ) {
+		Globals.timed_latency = 1000 ; // DS9490 -- one USB frame
+	} else if ( strcasecmp(str,"serial") == 0 ) {
+		Globals.timed_latency = 2500 ; // DS9097U at 9600 baud plus tty latency
+	} else if ( strcasecmp(str,"network") == 0 ) {
+		Globals.timed_latency = 5000 ; // HA7Net, ENET or remote LINK
+	} else {
+		RETURN_BAD_IF_BAD(OW_parsevalue_I(&arg_to_integer, str)) ;
+		if ( arg_to_integer < 0 ) {
+			ERROR_DETAIL("Bad simulated latency %s", str);
+			return gbBAD ;
+		}
+		Globals.timed_latency = (unsigned long) arg_to_integer ;
+	}
+	return gbGOOD ;
+}
@@ -8,8 +8,6 @@
     1wire/iButton system from Dallas Semiconductor
 */
 
-// regex
-
 #include <config.h>
 #include "owfs_config.h"
 #include "ow_devices.h"
@@ -48,78 +46,71 @@ static void ReplaceAliasInPath( char * filename, struct parsedname * pn);
 
 static ZERO_OR_ERROR FS_ParsedName_anywhere(const char *path, enum parse_pass remote_status, struct parsedname *pn);
 static ZERO_OR_ERROR FS_ParsedName_setup(struct parsedname_pointers *pp, const char *path, struct parsedname *pn);
+static ZERO_OR_ERROR FS_ParsedName_path(const char *path, struct parsedname *pn);
 static char * find_segment_in_path( char * segment, char * path ) ;
 
 #define BRANCH_INCR (9)
 
-static regex_t rx_bus;
-static regex_t rx_set;
-static regex_t rx_sta;
-static regex_t rx_str;
-static regex_t rx_sys;
-static regex_t rx_int;
-static regex_t rx_tex;
-static regex_t rx_jso;
-static regex_t rx_unc;
-static regex_t rx_una;
-static regex_t rx_ala;
-static regex_t rx_sim;
-static regex_t rx_the;
-static regex_t rx_p_bus;
-static regex_t rx_extension;
-static regex_t rx_all;
-static regex_t rx_byte;
-static regex_t rx_number;
-static regex_t rx_letter;
-
-static void regex_fini(void)
-{
-	regfree(&rx_bus);
-	regfree(&rx_set);
-	regfree(&rx_sta);
-	regfree(&rx_str);
-	regfree(&rx_sys);
-	regfree(&rx_int);
-	regfree(&rx_tex);
-	regfree(&rx_jso);
-	regfree(&rx_unc);
-	regfree(&rx_una);
-	regfree(&rx_ala);
-	regfree(&rx_sim);
-	regfree(&rx_the);
-	regfree(&rx_p_bus);
-	regfree(&rx_extension);
-	regfree(&rx_all);
-	regfree(&rx_byte);
-	regfree(&rx_number);
-	regfree(&rx_letter);
-}
-
-static pthread_once_t regex_init_once = PTHREAD_ONCE_INIT;
-
-static void regex_init(void)
-{
-	ow_regcomp(&rx_bus, "^bus\\.([[:digit:]]+)/?", REG_ICASE);
-	ow_regcomp(&rx_set, "^settings/?", REG_ICASE | REG_NOSUB);
-	ow_regcomp(&rx_sta, "^statistics/?", REG_ICASE | REG_NOSUB);
-	ow_regcomp(&rx_str, "^structure/?", REG_ICASE | REG_NOSUB);
-	ow_regcomp(&rx_sys, "^system/?", REG_ICASE | REG_NOSUB);
-	ow_regcomp(&rx_int, "^interface/?", REG_ICASE | REG_NOSUB);
-	ow_regcomp(&rx_tex, "^text/?", REG_ICASE | REG_NOSUB);
-	ow_regcomp(&rx_jso, "^json/?", REG_ICASE | REG_NOSUB);
-	ow_regcomp(&rx_unc, "^uncached/?", REG_ICASE | REG_NOSUB);
-	ow_regcomp(&rx_una, "^unaliased/?", REG_ICASE | REG_NOSUB);
-	ow_regcomp(&rx_ala, "^alarm\?", REG_ICASE | REG_NOSUB);
-	ow_regcomp(&rx_sim, "^simultaneous/?", REG_ICASE | REG_NOSUB);
-	ow_regcomp(&rx_the, "^thermostat/?", REG_ICASE | REG_NOSUB);
-	ow_regcomp(&rx_p_bus, "^/bus\\.[[:digit:]]+/?", REG_ICASE);
-	ow_regcomp(&rx_extension, "\\.", 0);
-	ow_regcomp(&rx_all, "\\.all$", REG_ICASE);
-	ow_regcomp(&rx_byte, "\\.byte$", REG_ICASE);
-	ow_regcomp(&rx_number, "\\.[[:digit:]]+$", 0);
-	ow_regcomp(&rx_letter, "\\.[[:alpha:]]$", REG_ICASE);
-
-	atexit(regex_fini);
+/* An alias path segment (at least 1 char) can become a 14 char serial number in path_to_server */
+#define ALIAS_GROWTH (14-1)
+
+/* path for placeholder (and destroyed) parsednames -- never written or freed */
+static char empty_path[] = "" ;
+
+/* ---------------------------------------------- */
+/* Path segment tokens                            */
+/* ---------------------------------------------- */
+/* Segments are already split on '/' so each test is a simple scan.
+ * Keywords match as a case-insensitive prefix (as the original "^keyword/?" did) */
+static int segment_keyword( const char * segment, const char * keyword )
+{
+	return strncasecmp( segment, keyword, strlen(keyword) ) == 0 ;
+}
+
+/* "bus.n" -- number is in the leading digits */
+static int segment_bus( const char * segment, INDEX_OR_ERROR * bus_number )
+{
+	if ( strncasecmp( segment, "bus.", 4 ) != 0 || ! isdigit( (unsigned char) segment[4] ) ) {
+		return 0 ;
+	}
+	*bus_number = (INDEX_OR_ERROR) atoi( &segment[4] ) ;
+	return 1 ;
+}
+
+/* Final extension (after the last '.') if all digits, else NULL */
+static const char * extension_number( const char * filename )
+{
+	const char * dot = strrchr( filename, '.' ) ;
+	const char * c ;
+
+	if ( dot == NULL || dot[1] == '\0' ) {
+		return NULL ;
+	}
+	for ( c = &dot[1] ; *c != '\0' ; ++c ) {
+		if ( ! isdigit( (unsigned char) *c ) ) {
+			return NULL ;
+		}
+	}
+	return &dot[1] ;
+}
+
+/* Final extension if a single letter, else NULL */
+static const char * extension_letter( const char * filename )
+{
+	const char * dot = strrchr( filename, '.' ) ;
+
+	if ( dot == NULL || ! isalpha( (unsigned char) dot[1] ) || dot[2] != '\0' ) {
+		return NULL ;
+	}
+	return &dot[1] ;
+}
+
+/* Final extension matches (case-insensitive) */
+static int extension_is( const char * filename, const char * extension )
+{
+	const char * dot = strrchr( filename, '.' ) ;
+
+	return dot != NULL && strcasecmp( &dot[1], extension ) == 0 ;
 }
 
 /* ---------------------------------------------- */
@@ -133,8 +124,14 @@ void FS_ParsedName_destroy(struct parsedname *pn)
 	LEVEL_DEBUG("%s", SAFESTRING(pn->path));
 	CONNIN_RUNLOCK ;
 	Detail_Free( pn ) ;
-	SAFEFREE(pn->sparse_name);
+	MemarenaFree(pn->sparse_name);
+	pn->sparse_name = NULL ;
 	SAFEFREE(pn->bp) ;
+	if ( pn->path != empty_path ) {
+		SAFEFREE(pn->path) ;
+	}
+	pn->path = pn->path_to_server = empty_path ;
+	pn->path_length = 0 ;
 }
 
 /* 
@@ -145,6 +142,7 @@ void FS_ParsedName_destroy(struct parsedname *pn)
  * An initial / is added to the path, and the full length has to be less than MAX_PATH (2048)
  * 
  * For efficiency, the two path copies are allocated in the same memory allocation call, and so can be removed together.
+ * The allocation is sized to the path, with room for every segment of path_to_server to grow into a serial number (alias).
  * */
 
 /* Parse a path to check it's validity and attach to the propery data structures */
@@ -166,6 +164,7 @@ static ZERO_OR_ERROR FS_ParsedName_anywhere(const char *path, enum parse_pass re
 	struct parsedname_pointers *pp = &s_pp;
 	ZERO_OR_ERROR parse_error_status = 0;
 	enum parse_enum pe = parse_first;
+	uint32_t setup_flags ;
 
 	// To make the debug output useful it's cleared here.
 	// Even on normal glibc, errno isn't cleared on good system calls
@@ -179,6 +178,13 @@ static ZERO_OR_ERROR FS_ParsedName_anywhere(const char *path, enum parse_pass re
 		RETURN_CODE_RETURN( 0 ) ; // success (by default)
 	}
 
+	// Same path parsed recently?
+	setup_flags = pn->control_flags ;
+	if ( remote_status == parse_pass_pre_remote && GOOD( Cache_Get_ParsedName( setup_flags, pn ) ) ) {
+		Detail_Test( pn ) ;
+		return 0 ;
+	}
+
 	while (1) {
 		// Check for extreme conditions (done, error)
 		switch (pe) {
@@ -226,6 +232,9 @@ static ZERO_OR_ERROR FS_ParsedName_anywhere(const char *path, enum parse_pass re
 					break ;
 			}
 			//printf("%s: Parse %s after  corrections: %.4X -- state = %d\n\n",(back_from_remote)?"BACK":"FORE",pn->path,pn->state,pn->type) ;
+			if ( remote_status == parse_pass_pre_remote ) {
+				Cache_Add_ParsedName( setup_flags, pn ) ;
+			}
 			// set up detail debugging
 			Detail_Test( pn ) ; // turns on debug mode only during this device's query
 			return 0;
@@ -305,6 +314,34 @@ static ZERO_OR_ERROR FS_ParsedName_anywhere(const char *path, enum parse_pass re
 	}
 }
 
+/* Allocate path and path_to_server together, with an initial slash */
+static ZERO_OR_ERROR FS_ParsedName_path(const char *path, struct parsedname *pn)
+{
+	const char * path_start = (path[0]=='/') ? path+1 : path ;
+	size_t path_length = strlen(path_start) + 1 ;
+	size_t segments = 1 ;
+	const char * c ;
+
+	for ( c = path_start ; *c != '\0' ; ++c ) {
+		if ( *c == '/' ) {
+			++segments ;
+		}
+	}
+
+	pn->path = owmalloc( 2 * (path_length + 1) + segments * ALIAS_GROWTH ) ;
+	if ( pn->path == NULL ) {
+		pn->path = pn->path_to_server = empty_path ;
+		RETURN_CODE_RETURN( 79 ) ; // unable to allocate memory
+	}
+	pn->path_to_server = pn->path + path_length + 1 ;
+	pn->path_length = path_length ;
+
+	pn->path[0] = '/' ; // initial slash
+	memcpy( &pn->path[1], path_start, path_length ) ; // includes '\0'
+	memcpy( pn->path_to_server, pn->path, path_length + 1 ) ;
+	return 0 ;
+}
+
 /* Initial memory allocation and pn setup */
 static ZERO_OR_ERROR FS_ParsedName_setup(struct parsedname_pointers *pp, const char *path, struct parsedname *pn)
 {
@@ -354,6 +391,7 @@ static ZERO_OR_ERROR FS_ParsedName_setup(struct parsedname_pointers *pp, const c
 
 	/* minimal structure for initial bus "detect" use -- really has connection and LocalControlFlags only */
 	pn->dirlength = -1 ;
+	pn->path = pn->path_to_server = empty_path ;
 	if (path == NO_PATH) {
 		return 0; // success
 	}
@@ -363,15 +401,13 @@ static ZERO_OR_ERROR FS_ParsedName_setup(struct parsedname_pointers *pp, const c
 	}
 
 	/* Have to save pn->path at once */
-	strcpy(pn->path, "/"); // initial slash
-	strcpy(pn->path+1, path[0]=='/'?path+1:path);
-	strcpy(pn->path_to_server, pn->path);
+	RETURN_CODE_ERROR_RETURN( FS_ParsedName_path(path, pn) ) ;
 
 	/* make a copy for destructive parsing  without initial '/'*/
 	strcpy(pp->pathcpy,&pn->path[1]);
 	/* pointer to rest of path after current token peeled off */
 	pp->pathnext = pp->pathcpy;
-	pn->dirlength = strlen(pn->path) ;
+	pn->dirlength = pn->path_length ;
 	
 	/* device name */
 	pn->device_name = NULL ;
@@ -411,48 +447,43 @@ static enum parse_enum set_type( enum ePN_type epntype, struct parsedname * pn )
 // Early parsing -- only bus entries, uncached and text may have preceeded
 static enum parse_enum Parse_Unspecified(char *pathnow, enum parse_pass remote_status, struct parsedname *pn)
 {
-	pthread_once(&regex_init_once, regex_init);
-
-	struct ow_regmatch orm ;
-	orm.number = 1 ; // for bus
+	INDEX_OR_ERROR bus_number ;
 
-	if ( ow_regexec( &rx_bus, pathnow, &orm ) == 0) {
-		INDEX_OR_ERROR bus_number = (INDEX_OR_ERROR) atoi(orm.match[1]) ;
-		ow_regexec_free( &orm ) ;
+	if ( segment_bus( pathnow, &bus_number ) ) {
 		return Parse_Bus( bus_number, pn);
 
-	} else if (ow_regexec( &rx_set, pathnow, NULL ) == 0) {
+	} else if (segment_keyword( pathnow, "settings" )) {
 		return set_type( ePN_settings, pn ) ;
 
-	} else if (ow_regexec( &rx_sta, pathnow, NULL ) == 0) {
+	} else if (segment_keyword( pathnow, "statistics" )) {
 		return set_type( ePN_statistics, pn ) ;
 
-	} else if (ow_regexec( &rx_str, pathnow, NULL ) == 0) {
+	} else if (segment_keyword( pathnow, "structure" )) {
 		return set_type( ePN_structure, pn ) ;
 
-	} else if (ow_regexec( &rx_sys, pathnow, NULL ) == 0) {
+	} else if (segment_keyword( pathnow, "system" )) {
 		return set_type( ePN_system, pn ) ;
 
-	} else if (ow_regexec( &rx_int, pathnow, NULL ) == 0) {
+	} else if (segment_keyword( pathnow, "interface" )) {
 		if (!SpecifiedBus(pn)) {
 			return parse_error;
 		}
 		pn->type = ePN_interface;
 		return parse_nonreal;
 
-	} else if (ow_regexec( &rx_tex, pathnow, NULL ) == 0) {
+	} else if (segment_keyword( pathnow, "text" )) {
 		pn->state |= ePS_text;
 		return parse_first;
 
-	} else if (ow_regexec( &rx_jso, pathnow, NULL ) == 0) {
+	} else if (segment_keyword( pathnow, "json" )) {
 		pn->state |= ePS_json;
 		return parse_first;
 
-	} else if (ow_regexec( &rx_unc, pathnow, NULL ) == 0) {
+	} else if (segment_keyword( pathnow, "uncached" )) {
 		pn->state |= ePS_uncached;
 		return parse_first;
 
-	} else if (ow_regexec( &rx_una, pathnow, NULL ) == 0) {
+	} else if (segment_keyword( pathnow, "unaliased" )) {
 		pn->state |= ePS_unaliased;
 		return parse_first;
 
@@ -464,9 +495,8 @@ static enum parse_enum Parse_Unspecified(char *pathnow, enum parse_pass remote_s
 
 static enum parse_enum Parse_Branch(char *pathnow, enum parse_pass remote_status, struct parsedname *pn)
 {
-	pthread_once(&regex_init_once, regex_init);
-
-	if (ow_regexec( &rx_ala, pathnow, NULL ) == 0) {
+	// "alar" -- the original pattern "^alarm\?" left the 'm' optional
+	if (segment_keyword( pathnow, "alar" )) {
 		pn->state |= ePS_alarm;
 		pn->type = ePN_real;
 		return parse_real;
@@ -476,29 +506,27 @@ static enum parse_enum Parse_Branch(char *pathnow, enum parse_pass remote_status
 
 static enum parse_enum Parse_Real(char *pathnow, enum parse_pass remote_status, struct parsedname *pn)
 {
-	pthread_once(&regex_init_once, regex_init);
-
-	if (ow_regexec( &rx_sim, pathnow, NULL ) == 0) {
+	if (segment_keyword( pathnow, "simultaneous" )) {
 		pn->selected_device = DeviceSimultaneous;
 		return parse_prop;
 
-	} else if (ow_regexec( &rx_tex, pathnow, NULL ) == 0) {
+	} else if (segment_keyword( pathnow, "text" )) {
 		pn->state |= ePS_text;
 		return parse_real;
 
-	} else if (ow_regexec( &rx_jso, pathnow, NULL ) == 0) {
+	} else if (segment_keyword( pathnow, "json" )) {
 		pn->state |= ePS_json;
 		return parse_real;
 
-	} else if (ow_regexec( &rx_the, pathnow, NULL ) == 0) {
+	} else if (segment_keyword( pathnow, "thermostat" )) {
 		pn->selected_device = DeviceThermostat;
 		return parse_prop;
 
-	} else if (ow_regexec( &rx_unc, pathnow, NULL ) == 0) {
+	} else if (segment_keyword( pathnow, "uncached" )) {
 		pn->state |= ePS_uncached;
 		return parse_real;
 
-	} else if (ow_regexec( &rx_una, pathnow, NULL ) == 0) {
+	} else if (segment_keyword( pathnow, "unaliased" )) {
 		pn->state |= ePS_unaliased;
 		return parse_real;
 
@@ -509,21 +537,19 @@ static enum parse_enum Parse_Real(char *pathnow, enum parse_pass remote_status,
 
 static enum parse_enum Parse_NonReal(char *pathnow, struct parsedname *pn)
 {
-	pthread_once(&regex_init_once, regex_init);
-
-	if (ow_regexec( &rx_tex, pathnow, NULL )  == 0) {
+	if (segment_keyword( pathnow, "text" )) {
 		pn->state |= ePS_text;
 		return parse_nonreal;
 
-	} else if (ow_regexec( &rx_jso, pathnow, NULL )  == 0) {
+	} else if (segment_keyword( pathnow, "json" )) {
 		pn->state |= ePS_json;
 		return parse_nonreal;
 
-	} else if (ow_regexec( &rx_unc, pathnow, NULL )  == 0) {
+	} else if (segment_keyword( pathnow, "uncached" )) {
 		pn->state |= ePS_uncached;
 		return parse_nonreal;
 
-	} else if (ow_regexec( &rx_una, pathnow, NULL )  == 0) {
+	} else if (segment_keyword( pathnow, "unaliased" )) {
 		pn->state |= ePS_unaliased;
 		return parse_nonreal;
 
@@ -537,10 +563,7 @@ static enum parse_enum Parse_NonReal(char *pathnow, struct parsedname *pn)
 /* We've reached a /bus.n entry */
 static enum parse_enum Parse_Bus( INDEX_OR_ERROR bus_number, struct parsedname *pn)
 {
-	pthread_once(&regex_init_once, regex_init);
-
-	struct ow_regmatch orm ;
-	orm.number = 0 ;
+	INDEX_OR_ERROR leading_bus ;
 
 	/* Processing for bus.X directories -- eventually will make this more generic */
 	if ( INDEX_NOT_VALID(bus_number) ) {
@@ -572,11 +595,17 @@ static enum parse_enum Parse_Bus( INDEX_OR_ERROR bus_number, struct parsedname *
 	}
 
 	/* Create the path without the "bus.x" part in pn->path_to_server */
-	if ( ow_regexec( &rx_p_bus, pn->path, &orm ) == 0 ) {
-		strcpy( pn->path_to_server, orm.pre[0] ) ;
-		strcat( pn->path_to_server, "/" ) ;
-		strcat( pn->path_to_server, orm.post[0] ) ;
-		ow_regexec_free( &orm ) ;
+	/* (only when the path starts with it) */
+	if ( pn->path[0] == '/' && segment_bus( &pn->path[1], &leading_bus ) ) {
+		const char * post = &pn->path[5] ;
+		while ( isdigit( (unsigned char) *post ) ) {
+			++post ;
+		}
+		if ( *post == '/' ) {
+			++post ;
+		}
+		strcpy( pn->path_to_server, "/" ) ;
+		strcat( pn->path_to_server, post ) ;
 	}
 	return parse_first;
 }
@@ -755,15 +784,11 @@ static enum parse_enum Parse_NonRealDevice(char *filename, struct parsedname *pn
 
 static enum parse_enum Parse_Property(char *filename, struct parsedname *pn)
 {
-	pthread_once(&regex_init_once, regex_init);
-
 	struct device * pdev = pn->selected_device ;
 	struct filetype * ft ;
 	
-	int extension_given ;
-
-	struct ow_regmatch orm ;
-	orm.number = 0 ;
+	char * dot ;
+	const char * extension ;
 
 	//printf("FilePart: %s %s\n", filename, pn->path);
 
@@ -775,20 +800,9 @@ static enum parse_enum Parse_Property(char *filename, struct parsedname *pn)
 
 	// separate filename.dot
 //	filename = strsep(&dot, ".");
-	if ( ow_regexec( &rx_extension, filename, &orm ) == 0 ) {
-		// extension given
-		extension_given = 1 ;
-		ft =
-			 bsearch(orm.pre[0], pdev->filetype_array,
-					 (size_t) pdev->count_of_filetypes, sizeof(struct filetype), filetype_cmp) ;
-		ow_regexec_free( &orm ) ;
-	} else {
-		// no extension given
-		extension_given = 0 ;
-		ft =
-			 bsearch(filename, pdev->filetype_array,
-					 (size_t) pdev->count_of_filetypes, sizeof(struct filetype), filetype_cmp) ;
-	}
+	dot = strchr( filename, '.' ) ;
+	// look up the name before the first '.' (if an extension is given)
+	ft = FS_filetype_find( filename, (dot != NULL) ? (size_t) (dot - filename) : strlen(filename), pdev ) ;
 	
 	pn->selected_filetype = ft ;			 
 	if (ft == NO_FILETYPE ) {
@@ -798,7 +812,7 @@ static enum parse_enum Parse_Property(char *filename, struct parsedname *pn)
 		
 	//printf("FP known filetype %s\n",pn->selected_filetype->name) ;
 	/* Filetype found, now process extension */
-	if (extension_given==0) {	/* no extension */
+	if (dot == NULL) {	/* no extension */
 		if (ft->ag != NON_AGGREGATE) {
 			return parse_error;	/* aggregate filetypes need an extension */
 		}
@@ -812,14 +826,11 @@ static enum parse_enum Parse_Property(char *filename, struct parsedname *pn)
 	} else if (ft->ag->combined==ag_sparse)  { /* Sparse */
 		if (ft->ag->letters == ag_letters) {	/* text string */
 			pn->extension = 0;	/* text extension, not number */
-			ow_regexec( &rx_extension, filename, &orm ) ; // don't need to test -- already succesful
-			pn->sparse_name = owstrdup(orm.post[0]) ;
-			ow_regexec_free( &orm ) ;
+			pn->sparse_name = MemarenaStrdup(&dot[1]) ;
 			LEVEL_DEBUG("Sparse alpha extension found: <%s>",pn->sparse_name);
 		} else {			/* Numbers */
-			if ( ow_regexec( &rx_number, filename, &orm ) == 0 ) { 
-				pn->extension = atoi( &orm.match[0][1] );	/* Number conversion */
-				ow_regexec_free( &orm ) ;
+			if ( (extension = extension_number( filename )) != NULL ) {
+				pn->extension = atoi( extension );	/* Number conversion */
 				LEVEL_DEBUG("Sparse numeric extension found: <%ld>",(long int) pn->extension);
 			} else {
 				LEVEL_DEBUG("Non numeric extension for %s",filename ) ;
@@ -828,12 +839,12 @@ static enum parse_enum Parse_Property(char *filename, struct parsedname *pn)
 		}
 
 	// Non-sparse "ALL"
-	} else if (ow_regexec( &rx_all, filename, NULL ) == 0) {
+	} else if (extension_is( filename, "all" )) {
 		//printf("FP ALL\n");
 		pn->extension = EXTENSION_ALL;	/* ALL */
 	
 	// Non-sparse "BYTE"
-	} else if (ft->format == ft_bitfield && ow_regexec( &rx_byte, filename, NULL) == 0) {
+	} else if (ft->format == ft_bitfield && extension_is( filename, "byte" )) {
 		pn->extension = EXTENSION_BYTE;	/* BYTE */
 		//printf("FP BYTE\n") ;
 
@@ -841,16 +852,14 @@ static enum parse_enum Parse_Property(char *filename, struct parsedname *pn)
 	} else {				/* specific extension */
 		if (ft->ag->letters == ag_letters) {	/* Letters */
 			//printf("FP letters\n") ;
-			if ( ow_regexec( &rx_letter, filename, &orm ) == 0 ) {
-				pn->extension = toupper(orm.match[0][1]) - 'A';	/* Letter extension */
-				ow_regexec_free( &orm ) ;
+			if ( (extension = extension_letter( filename )) != NULL ) {
+				pn->extension = toupper(extension[0]) - 'A';	/* Letter extension */
 			} else {
 				return parse_error;
 			}
 		} else {			/* Numbers */
-			if ( ow_regexec( &rx_number, filename, &orm ) == 0 ) { 
-				pn->extension = atoi( &orm.match[0][1] );	/* Number conversion */
-				ow_regexec_free( &orm ) ;
+			if ( (extension = extension_number( filename )) != NULL ) {
+				pn->extension = atoi( extension );	/* Number conversion */
 			} else {
 				return parse_error;
 			}
@@ -978,6 +987,176 @@ ZERO_OR_ERROR FS_ParsedNamePlusText(const char *path, const char *file, const ch
 	return FS_ParsedNamePlus(path, name, pn);
 }
 
+/* Extension text for a sibling, as the parser would accept it */
+/* Returns length or -1 if the sibling can't use the original extension */
+static int sibling_extension( char * extension, const struct filetype * ft, const struct parsedname * pn_original )
+{
+	char digits[OW_FULLNAME_MAX] ;
+	int digit_count = 0 ;
+	int ext = pn_original->extension ;
+
+	if ( ft->ag == NON_AGGREGATE ) {
+		extension[0] = '\0' ;
+		return 0 ;
+	}
+	if ( pn_original->selected_filetype == NO_FILETYPE || pn_original->selected_filetype->ag == NON_AGGREGATE ) {
+		// no extension to copy
+		return -1 ;
+	}
+	if ( ft->ag->combined == ag_sparse ) {
+		return -1 ;
+	}
+	if ( ext == EXTENSION_ALL ) {
+		strcpy( extension, ".ALL" ) ;
+		return 4 ;
+	}
+	if ( ext == EXTENSION_BYTE ) {
+		if ( ft->format != ft_bitfield ) {
+			return -1 ;
+		}
+		strcpy( extension, ".BYTE" ) ;
+		return 5 ;
+	}
+	if ( ext < 0 || ext >= ft->ag->elements ) {
+		return -1 ;
+	}
+	if ( ft->ag->letters == ag_letters ) {
+		extension[0] = '.' ;
+		extension[1] = 'A' + ext ;
+		extension[2] = '\0' ;
+		return 2 ;
+	}
+	do {
+		digits[digit_count++] = '0' + ext % 10 ;
+		ext /= 10 ;
+	} while ( ext > 0 ) ;
+	extension[0] = '.' ;
+	for ( ext = 0 ; ext < digit_count ; ++ext ) {
+		extension[ext+1] = digits[digit_count-ext-1] ;
+	}
+	extension[digit_count+1] = '\0' ;
+	return digit_count + 1 ;
+}
+
+/* Sibling property of a parsed property -- same device and directory
+ * The original is cloned with the sibling filetype and extension swapped in,
+ * so no path is built and parsed, and presence isn't checked again.
+ * Returns non-zero if the sibling needs the full parser (sparse, subdir, branch, not found)
+ * Needs FS_ParsedName_destroy like FS_ParsedName
+ * */
+ZERO_OR_ERROR FS_ParsedName_Sibling(const char *sibling, const struct parsedname *pn_original, struct parsedname *pn)
+{
+	struct filetype * ft ;
+	struct filetype * subdir = NO_SUBDIR ;
+	const char * slash ;
+	char extension[OW_FULLNAME_MAX] ;
+	int extension_length ;
+	size_t sibling_length = strlen( sibling ) ;
+	size_t property_length ;
+	size_t server_length ;
+	size_t path_length ;
+	size_t server_dirlength ;
+	char * path ;
+
+	if ( pn_original->selected_device == NO_DEVICE || pn_original->selected_device == &RemoteDevice ) {
+		return -ENOENT ;
+	}
+	if ( pn_original->selected_filetype == NO_FILETYPE && pn_original->subdir == NO_SUBDIR ) {
+		// not a filetype or a subdir
+		return -ENOENT ;
+	}
+	if ( pn_original->dirlength < 1 || (size_t) pn_original->dirlength > pn_original->path_length ) {
+		return -ENOENT ;
+	}
+	if ( pn_original->sparse_name != NULL ) {
+		return -EINVAL ;
+	}
+
+	ft = FS_filetype_find( sibling, sibling_length, pn_original->selected_device ) ;
+	if ( ft == NO_FILETYPE ) {
+		return -ENOENT ;
+	}
+	switch ( ft->format ) {
+		case ft_directory:
+		case ft_subdir:
+			return -EINVAL ;
+		default:
+			break ;
+	}
+
+	slash = strrchr( sibling, '/' ) ;
+	if ( slash != NULL ) {
+		subdir = FS_filetype_find( sibling, slash - sibling, pn_original->selected_device ) ;
+		if ( subdir == NO_SUBDIR ) {
+			return -ENOENT ;
+		}
+	}
+
+	extension_length = sibling_extension( extension, ft, pn_original ) ;
+	if ( extension_length < 0 ) {
+		return -EINVAL ;
+	}
+
+	// path_to_server differs from path only before the property
+	property_length = pn_original->path_length - pn_original->dirlength ;
+	server_length = strlen( pn_original->path_to_server ) ;
+	if ( server_length < property_length ) {
+		return -EINVAL ;
+	}
+	server_dirlength = server_length - property_length ;
+
+	path_length = pn_original->dirlength + sibling_length + extension_length ;
+	server_length = server_dirlength + sibling_length + extension_length ;
+	path = owmalloc( path_length + 1 + server_length + 1 ) ;
+	if ( path == NULL ) {
+		RETURN_CODE_RETURN( 79 ) ; // unable to allocate memory
+	}
+
+	memcpy( pn, pn_original, sizeof(struct parsedname) ) ; // shallow copy, then replace the owned parts
+	RETURN_CODE_INIT(pn);
+
+	pn->path = path ;
+	memcpy( path, pn_original->path, pn_original->dirlength ) ;
+	memcpy( &path[pn_original->dirlength], sibling, sibling_length ) ;
+	strcpy( &path[pn_original->dirlength + sibling_length], extension ) ;
+	pn->path_length = path_length ;
+
+	pn->path_to_server = path + path_length + 1 ;
+	memcpy( pn->path_to_server, pn_original->path_to_server, server_dirlength ) ;
+	memcpy( &pn->path_to_server[server_dirlength], sibling, sibling_length ) ;
+	strcpy( &pn->path_to_server[server_dirlength + sibling_length], extension ) ;
+
+	if ( pn_original->device_name != NULL ) {
+		pn->device_name = pn->path + ( pn_original->device_name - pn_original->path ) ;
+	}
+
+	pn->selected_filetype = ft ;
+	pn->subdir = subdir ;
+	pn->extension = (ft->ag == NON_AGGREGATE) ? 0 : pn_original->extension ;
+	pn->sparse_name = NULL ;
+
+	if ( pn_original->ds2409_depth > 0 ) {
+		size_t bp_size = pn_original->ds2409_depth * sizeof(struct ds2409_hubs) ;
+		pn->bp = owmalloc( bp_size ) ;
+		if ( pn->bp == NULL ) {
+			owfree( path ) ;
+			RETURN_CODE_RETURN( 79 ) ; // unable to allocate memory
+		}
+		memcpy( pn->bp, pn_original->bp, bp_size ) ;
+	}
+
+	// not inherited
+	pn->lock = NULL ;
+	pn->tokens = 0 ;
+	pn->tokenstring = NULL ;
+	pn->detail_flag = 0 ;
+
+	// held until FS_ParsedName_destroy, as in parsing
+	CONNIN_RLOCK;
+	Detail_Test( pn ) ;
+	return 0 ;
+}
+
 void FS_ParsedName_Placeholder( struct parsedname * pn )
 {
 	FS_ParsedName( NULL, pn ) ; // minimal parsename -- no destroy needed
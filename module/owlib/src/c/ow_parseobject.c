@@ -49,6 +49,35 @@ struct one_wire_query * OWQ_create_from_path(const char *path)
 	return NO_ONE_WIRE_QUERY ;
 }
 
+/* Clone the original parsedname with the sibling property (no path parsing) */
+static struct one_wire_query * OWQ_create_sibling_direct(const char *sibling, struct one_wire_query *owq_original)
+{
+	int sz = sizeof( struct one_wire_query ) + OWQ_DEFAULT_READ_BUFFER_SIZE;
+	struct one_wire_query * owq_sib = owmalloc( sz );
+
+	if ( owq_sib == NO_ONE_WIRE_QUERY) {
+		return NO_ONE_WIRE_QUERY ;
+	}
+
+	memset(owq_sib, 0, sz);
+	OWQ_cleanup(owq_sib) = owq_cleanup_owq ;
+
+	if ( FS_ParsedName_Sibling( sibling, PN(owq_original), PN(owq_sib) ) != 0 ) {
+		owfree( owq_sib ) ;
+		return NO_ONE_WIRE_QUERY ;
+	}
+	OWQ_cleanup(owq_sib) |= owq_cleanup_pn ;
+
+	if ( GOOD( OWQ_allocate_array(owq_sib)) ) {
+		OWQ_buffer(owq_sib) = (char *) (& owq_sib[1]) ; // point just beyond the one_wire_query struct
+		OWQ_size(owq_sib) = OWQ_DEFAULT_READ_BUFFER_SIZE ;
+		LEVEL_DEBUG("Create sibling %s from %s as %s", sibling, PN(owq_original)->path, PN(owq_sib)->path);
+		return owq_sib ;
+	}
+	OWQ_destroy(owq_sib);
+	return NO_ONE_WIRE_QUERY ;
+}
+
 /* Create the Parsename structure and load the relevant fields */
 struct one_wire_query * OWQ_create_sibling(const char *sibling, struct one_wire_query *owq_original)
 {
@@ -57,6 +86,13 @@ struct one_wire_query * OWQ_create_sibling(const char *sibling, struct one_wire_
 	int dirlength = pn_original->dirlength ;
 	struct one_wire_query * owq_sib ;
 
+	// Usually the parsedname can just be copied with the sibling property
+	owq_sib = OWQ_create_sibling_direct( sibling, owq_original ) ;
+	if ( owq_sib != NO_ONE_WIRE_QUERY ) {
+		return owq_sib ;
+	}
+
+	// Otherwise build the sibling path and parse it
 	strncpy(path, pn_original->path,dirlength) ;
 	strcpy(&path[dirlength],sibling) ;
 	
@@ -68,8 +104,7 @@ struct one_wire_query * OWQ_create_sibling(const char *sibling, struct one_wire_
 	// Add extension only if original property is aggregate
 	} else if ( pn_original->selected_filetype->ag != NON_AGGREGATE ) {
 		// search for sibling in the filetype array
-		struct filetype * sib_filetype = bsearch(sibling, pn_original->selected_device->filetype_array,
-				 (size_t) pn_original->selected_device->count_of_filetypes, sizeof(struct filetype), filetype_cmp) ;
+		struct filetype * sib_filetype = FS_filetype_find(sibling, strlen(sibling), pn_original->selected_device) ;
 		// see if sibling is also an aggregate property
 		LEVEL_DEBUG("Path %s is an agggregate",SAFESTRING(pn_original->path));
 		if ( sib_filetype != NO_FILETYPE && sib_filetype->ag != NON_AGGREGATE ) {
@@ -254,7 +289,7 @@ GOOD_OR_BAD OWQ_allocate_read_buffer(struct one_wire_query * owq )
 	size_t size = FullFileLength(pn);
 
 	if ( size > 0 ) {
-		char * buffer = owmalloc(size+1) ;
+		char * buffer = MemarenaMalloc(size+1) ;
 		if ( buffer == NULL ) {
 			return gbBAD ;
 		}
@@ -278,7 +313,7 @@ GOOD_OR_BAD OWQ_allocate_write_buffer( const char * write_buffer, size_t buffer_
 		return gbGOOD ;
 	}
 	
-	buffer_copy = owmalloc( buffer_length+1) ;
+	buffer_copy = MemarenaMalloc( buffer_length+1) ;
 	if ( buffer_copy == NULL) {
 		// cannot allocate space for buffer
 		LEVEL_DEBUG("Cannot allocate %ld bytes for buffer", buffer_length) ;
@@ -304,7 +339,7 @@ void OWQ_destroy(struct one_wire_query *owq)
 	}
 	
 	if ( OWQ_cleanup(owq) & owq_cleanup_buffer ) {
-		owfree(OWQ_buffer(owq)) ;
+		MemarenaFree(OWQ_buffer(owq)) ;
 	}
 	
 	if ( OWQ_cleanup(owq) & owq_cleanup_rbuffer ) {
@@ -25,8 +25,13 @@ static SIZE_OR_ERROR OWQ_parse_output_ascii(struct one_wire_query *owq);
 static SIZE_OR_ERROR OWQ_parse_output_array_with_commas(struct one_wire_query *owq);
 static SIZE_OR_ERROR OWQ_parse_output_array_no_commas(struct one_wire_query *owq);
 static SIZE_OR_ERROR OWQ_parse_output_ascii_array(struct one_wire_query *owq);
+static SIZE_OR_ERROR OWQ_parse_output_binary(struct one_wire_query *owq, enum binary_value_type type);
 static SIZE_OR_ERROR OWQ_parse_output_offset_and_size_z(const char *string, struct one_wire_query *owq) ;
 static SIZE_OR_ERROR OWQ_parse_output_offset_and_size(const char *string, size_t length, struct one_wire_query *owq) ;
+static char *Format_unsigned(char *end, UINT U);
+static char *Format_pad(char *start, char *end, size_t width);
+static int Format_float(char *c, _FLOAT F);
+static _FLOAT Output_scale(_FLOAT F, const struct parsedname *pn);
 
 /*
 Change in strategy 6/2006:
@@ -45,6 +50,14 @@ Can break down cases into:
 
 SIZE_OR_ERROR OWQ_parse_output(struct one_wire_query *owq)
 {
+	// owserver client asked for the raw value -- skip the text entirely
+	if (ShouldReturnBinary(PN(owq))) {
+		enum binary_value_type type = BinaryValueType(PN(owq));
+		if (type != bv_none) {
+			return OWQ_parse_output_binary(owq, type);
+		}
+	}
+
 	// have to check if offset is beyond the filesize.
 	if (OWQ_offset(owq)) {
 		size_t file_length = 0;
@@ -105,44 +118,170 @@ SIZE_OR_ERROR OWQ_parse_output(struct one_wire_query *owq)
 	return -EINVAL;				// should never be reached if all the cases are truly covered
 }
 
+/* Numbers are formatted by hand rather than snprintf -- this is the hot path for cached reads.
+   Digits are written backwards from the end of the buffer, then padded to the property width
+   (unless trimmed). Output matches the "%*d", "%*u" and "%*G" formats exactly. */
+
+/* Write U as decimal digits ending at end, return the first character */
+static char *Format_unsigned(char *end, UINT U)
+{
+	do {
+		*--end = '0' + (U % 10);
+		U /= 10;
+	} while (U > 0);
+	return end;
+}
+
+/* Right-align in a field of width (space padded), return the first character */
+static char *Format_pad(char *start, char *end, size_t width)
+{
+	while ((size_t) (end - start) < width) {
+		*--start = ' ';
+	}
+	return start;
+}
+
 static SIZE_OR_ERROR OWQ_parse_output_integer(struct one_wire_query *owq)
 {
-	/* should only need suglen+1, but uClibc's snprintf()
-	   seem to trash 'len' if not increased */
-	int len;
 	char c[PROPERTY_LENGTH_INTEGER + 2];
-
-	UCLIBCLOCK;
-	if ( ShouldTrim(PN(owq)) ) {
-		len = snprintf(c, PROPERTY_LENGTH_INTEGER + 1, "%1d", OWQ_I(owq));
+	char *end = &c[sizeof(c)];
+	char *start;
+	int I = OWQ_I(owq);
+
+	if (I < 0) {
+		// negate as unsigned so INT_MIN works
+		start = Format_unsigned(end, - (UINT) I);
+		*--start = '-';
 	} else {
-		len = snprintf(c, PROPERTY_LENGTH_INTEGER + 1, "%*d", PROPERTY_LENGTH_INTEGER, OWQ_I(owq));
+		start = Format_unsigned(end, (UINT) I);
 	}
-	UCLIBCUNLOCK;
-	if ((len < 0) || ((size_t) len > PROPERTY_LENGTH_INTEGER)) {
+	if ( ! ShouldTrim(PN(owq)) ) {
+		start = Format_pad(start, end, PROPERTY_LENGTH_INTEGER);
+	}
+	if ((size_t) (end - start) > PROPERTY_LENGTH_INTEGER) {
 		return -EMSGSIZE;
 	}
-	return OWQ_parse_output_offset_and_size(c, len, owq);
+	return OWQ_parse_output_offset_and_size(start, end - start, owq);
 }
 
 static SIZE_OR_ERROR OWQ_parse_output_unsigned(struct one_wire_query *owq)
 {
-	/* should only need suglen+1, but uClibc's snprintf()
-	   seem to trash 'len' if not increased */
-	int len;
 	char c[PROPERTY_LENGTH_UNSIGNED + 2];
+	char *end = &c[sizeof(c)];
+	char *start = Format_unsigned(end, OWQ_U(owq));
 
-	UCLIBCLOCK;
-	if ( ShouldTrim(PN(owq)) ) {
-		len = snprintf(c, PROPERTY_LENGTH_UNSIGNED + 1, "%1u", OWQ_U(owq));
-	} else {
-		len = snprintf(c, PROPERTY_LENGTH_UNSIGNED + 1, "%*u", PROPERTY_LENGTH_UNSIGNED, OWQ_U(owq));
+	if ( ! ShouldTrim(PN(owq)) ) {
+		start = Format_pad(start, end, PROPERTY_LENGTH_UNSIGNED);
 	}
-	UCLIBCUNLOCK;
-	if ((len < 0) || ((size_t) len > PROPERTY_LENGTH_UNSIGNED)) {
+	if ((size_t) (end - start) > PROPERTY_LENGTH_UNSIGNED) {
 		return -EMSGSIZE;
 	}
-	return OWQ_parse_output_offset_and_size(c, len, owq);
+	return OWQ_parse_output_offset_and_size(start, end - start, owq);
+}
+
+/* "%G" with the default 6 significant digits, in fixed notation only
+   (decimal exponent -4 to 5 after rounding). Returns the length written to c,
+   or -1 for anything else (exponent notation, zero, inf, nan, near rounding ties)
+   which is left to snprintf. */
+#define FLOAT_DIGITS 6
+static int Format_float(char *c, _FLOAT F)
+{
+	// exact powers of ten, 10^(FLOAT_DIGITS-1-exponent) for exponent 5 .. -4
+	static const double power10[] = { 1E0, 1E1, 1E2, 1E3, 1E4, 1E5, 1E6, 1E7, 1E8, 1E9, };
+	char digits[FLOAT_DIGITS];
+	char *p = c;
+	double A = (F < 0) ? -F : F;
+	double scaled;
+	UINT N;
+	int exponent;
+	int last;
+	int i;
+
+	if (!(A > 0.0) || A > 1E7) {
+		// zero, nan, inf or clearly exponent notation
+		return -1;
+	}
+
+	// first guess of the decimal exponent
+	for (exponent = 5; exponent > -4 && A * power10[FLOAT_DIGITS - 1 - exponent] < 1E5; --exponent) {
+	}
+
+	// settle on the exponent of the rounded value: 6 digits in [100000,999999]
+	// (99999.95 and up rounds to 1000000 one exponent down)
+	for (;;) {
+		scaled = A * power10[FLOAT_DIGITS - 1 - exponent];
+		if ((scaled > 999999.4999 && scaled < 999999.5001) || (scaled > 99999.94999 && scaled < 99999.95001)) {
+			// rounding boundary -- too close to call
+			return -1;
+		} else if (scaled >= 999999.5) {
+			if (++exponent > 5) {
+				return -1;
+			}
+		} else if (scaled < 99999.95) {
+			if (--exponent < -4) {
+				return -1;
+			}
+		} else {
+			break;
+		}
+	}
+
+	N = (UINT) scaled;
+	if ((scaled - N) > 0.4999 && (scaled - N) < 0.5001) {
+		// too close to call -- snprintf rounds the exact binary value
+		return -1;
+	}
+	if (scaled - N >= 0.5) {
+		++N;
+	}
+
+	for (i = FLOAT_DIGITS - 1; i >= 0; --i) {
+		digits[i] = '0' + (N % 10);
+		N /= 10;
+	}
+	// trailing zeros of the fraction are dropped
+	for (last = FLOAT_DIGITS - 1; last > exponent && digits[last] == '0'; --last) {
+	}
+
+	if (F < 0) {
+		*p++ = '-';
+	}
+	if (exponent < 0) {
+		*p++ = '0';
+		*p++ = '.';
+		for (i = -1; i > exponent; --i) {
+			*p++ = '0';
+		}
+		for (i = 0; i <= last; ++i) {
+			*p++ = digits[i];
+		}
+	} else {
+		for (i = 0; i <= exponent; ++i) {
+			*p++ = digits[i];
+		}
+		if (last > exponent) {
+			*p++ = '.';
+			for (; i <= last; ++i) {
+				*p++ = digits[i];
+			}
+		}
+	}
+	return p - c;
+}
+
+/* Float in the user's temperature / pressure scale */
+static _FLOAT Output_scale(_FLOAT F, const struct parsedname *pn)
+{
+	switch (pn->selected_filetype->format) {
+	case ft_pressure:
+		return Pressure(F, pn);
+	case ft_temperature:
+		return Temperature(F, pn);
+	case ft_tempgap:
+		return TemperatureGap(F, pn);
+	default:
+		return F;
+	}
 }
 
 static SIZE_OR_ERROR OWQ_parse_output_float(struct one_wire_query *owq)
@@ -151,21 +290,20 @@ static SIZE_OR_ERROR OWQ_parse_output_float(struct one_wire_query *owq)
 	   seem to trash 'len' if not increased */
 	int len;
 	char c[PROPERTY_LENGTH_FLOAT + 2];
-	_FLOAT F;
+	_FLOAT F = Output_scale(OWQ_F(owq), PN(owq));
 
-	switch (OWQ_pn(owq).selected_filetype->format) {
-	case ft_pressure:
-		F = Pressure(OWQ_F(owq), PN(owq));
-		break;
-	case ft_temperature:
-		F = Temperature(OWQ_F(owq), PN(owq));
-		break;
-	case ft_tempgap:
-		F = TemperatureGap(OWQ_F(owq), PN(owq));
-		break;
-	default:
-		F = OWQ_F(owq);
-		break;
+	len = Format_float(c, F);
+	if (len >= 0) {
+		char *end = &c[sizeof(c)];
+		char *start = end - len;
+
+		if ( ShouldTrim(PN(owq)) ) {
+			return OWQ_parse_output_offset_and_size(c, len, owq);
+		}
+		// right-align in the field
+		memmove(start, c, len);
+		start = Format_pad(start, end, PROPERTY_LENGTH_FLOAT);
+		return OWQ_parse_output_offset_and_size(start, end - start, owq);
 	}
 
 	UCLIBCLOCK;
@@ -271,11 +409,13 @@ static SIZE_OR_ERROR OWQ_parse_output_array_with_commas(struct one_wire_query *o
 	size_t remaining_size = OWQ_size(owq);
 	size_t elements = OWQ_pn(owq).selected_filetype->ag->elements;
 
+	// Prepare a copy of owq that only points to a single element
+	// (only the element fields change in the loop)
+	memcpy(&owq_single, owq, sizeof(owq_single));
+
 	// loop though all array elements
 	for (extension = 0; extension < elements; ++extension) {
 		//printf("OWQ_parse_output_array_with_commas element=%d, size_used=%d, remaining=%d\n",(int)extension,(int)used_size,(int)remaining_size) ;
-		// Prepare a copy of owq that only points to a single element
-		memcpy(&owq_single, owq, sizeof(owq_single));
 		OWQ_pn(&owq_single).extension = extension;
 		memcpy(&OWQ_val(&owq_single), &OWQ_array(owq)[extension], sizeof(union value_object));
 		// add the comma first (if not the first element and enough room)
@@ -333,3 +473,64 @@ static SIZE_OR_ERROR OWQ_parse_output_array_no_commas(struct one_wire_query *owq
 	}
 	return total_length;
 }
+
+/* Store n bytes of U little-endian */
+static BYTE *Binary_put(BYTE * p, uint64_t U, size_t n)
+{
+	while (n-- > 0) {
+		*p++ = BYTE_MASK(U);
+		U >>= 8;
+	}
+	return p;
+}
+
+/* Raw value(s) in the layout of ow_binaryvalue.h */
+static SIZE_OR_ERROR OWQ_parse_output_binary(struct one_wire_query *owq, enum binary_value_type type)
+{
+	struct parsedname *pn = PN(owq);
+	size_t elements = (pn->extension == EXTENSION_ALL) ? pn->selected_filetype->ag->elements : 1;
+	size_t length = BINARY_VALUE_HEADER + elements * BinaryValueElementSize(type);
+	BYTE *p = (BYTE *) OWQ_buffer(owq);
+	size_t extension;
+
+	if (OWQ_offset(owq) != 0) {
+		// only read whole
+		return -EINVAL;
+	}
+	if (length > OWQ_size(owq) || elements > 0xFFFF) {
+		return -EMSGSIZE;
+	}
+
+	*p++ = BINARY_VALUE_MAGIC;
+	*p++ = (BYTE) type;
+	p = Binary_put(p, elements, 2);
+
+	for (extension = 0; extension < elements; ++extension) {
+		union value_object *value = (pn->extension == EXTENSION_ALL) ? &OWQ_array(owq)[extension] : &OWQ_val(owq);
+		switch (type) {
+		case bv_integer:
+			p = Binary_put(p, (uint32_t) value->I, 4);
+			break;
+		case bv_unsigned:
+			p = Binary_put(p, (uint32_t) value->U, 4);
+			break;
+		case bv_float:
+			{
+				double F = Output_scale(value->F, pn);
+				uint64_t U;
+				memcpy(&U, &F, sizeof(U));
+				p = Binary_put(p, U, 8);
+			}
+			break;
+		case bv_yesno:
+			*p++ = (value->Y & 0x1);
+			break;
+		case bv_date:
+			p = Binary_put(p, (uint64_t) (int64_t) value->D, 8);
+			break;
+		default:
+			return -EINVAL;
+		}
+	}
+	return length;
+}
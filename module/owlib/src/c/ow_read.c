@@ -377,6 +377,9 @@ static SIZE_OR_ERROR FS_r_local(struct one_wire_query *owq)
 				}
 				LEVEL_DEBUG("Mock value NOT in cache");
 				return FS_read_fake(owq);
+			case adapter_timed:
+				/* Special case for "timed" adapter */
+				return FS_read_timed(owq);
 			default:
 				break ;
 		}
@@ -0,0 +1,243 @@
+/*
+    OW -- One-Wire filesystem
+    version 0.4 7/2/2003
+
+    Written 2003 Paul H Alfille
+    GPL license
+    See the header file: ow.h for full attribution
+    ---------------------------------------------------------------------------
+    Implementation:
+    read many -- a list of values in one call
+*/
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+
+/*
+    FS_read_many reads a list of paths straight into the caller's buffers.
+
+    Each path is parsed once. Reads are then grouped by port and each port
+    with work gets its own thread, the channels of a port in turn since
+    they share the wire. A bus with several temperature reads has one
+    simultaneous conversion started first. Reads on no particular bus
+    (settings, statistics, ...) are done last by the calling thread.
+
+    Results are in read_return, in the caller's order. A read with no
+    buffer gets one sized for the value, so the caller need not parse the
+    path itself to find the length.
+*/
+
+struct many_state {
+	struct many_read *read;
+	struct one_wire_query *owq;	// NO_ONE_WIRE_QUERY once done or failed
+	struct connection_in *in;	// NO_CONNECTION if not on a known bus
+	int temperature;			// would be served by a simultaneous conversion
+};
+
+struct many_list {
+	struct many_state *states;
+	int nstates;
+};
+
+struct many_port {
+	struct many_list *ml;
+	struct port_in *pin;
+	pthread_t thread;
+	int threadbad;
+};
+
+static void Many_locate(struct many_state *ms);
+static void *Many_port(void *v);
+static void Many_connection(struct many_list *ml, struct connection_in *in);
+static void Many_one(struct many_state *ms);
+
+void FS_read_many(struct many_read *reads, int nreads)
+{
+	struct many_list s_ml = { NULL, nreads, };
+	struct many_list *ml = &s_ml;
+	struct many_port *ports = NULL;
+	struct port_in *pin;
+	int nports = 0;
+	int port_index;
+	int read_index;
+
+	if (nreads <= 0) {
+		return;
+	}
+	ml->states = owcalloc(nreads, sizeof(struct many_state));
+	if (ml->states == NULL) {
+		for (read_index = 0; read_index < nreads; ++read_index) {
+			reads[read_index].read_return = -ENOMEM;
+		}
+		return;
+	}
+	for (read_index = 0; read_index < nreads; ++read_index) {
+		ml->states[read_index].read = &reads[read_index];
+		Many_locate(&ml->states[read_index]);
+	}
+
+	// a thread for each port with work
+	for (pin = Inbound_Control.head_port; pin != NULL; pin = pin->next) {
+		++nports;
+	}
+	if (nports > 0) {
+		ports = owcalloc(nports, sizeof(struct many_port));
+	}
+	port_index = 0;
+	for (pin = Inbound_Control.head_port; pin != NULL && ports != NULL; pin = pin->next) {
+		struct many_port *mp = &ports[port_index++];
+
+		mp->ml = ml;
+		mp->threadbad = 1;
+		for (read_index = 0; read_index < nreads; ++read_index) {
+			struct connection_in *in = ml->states[read_index].in;
+			if (in != NO_CONNECTION && in->pown == pin) {
+				mp->pin = pin;
+				break;
+			}
+		}
+		if (mp->pin == NULL) {
+			// nothing for this port
+			continue;
+		}
+		mp->threadbad = pthread_create(&mp->thread, DEFAULT_THREAD_ATTR, Many_port, (void *) mp);
+		if (mp->threadbad != 0) {
+			// no thread -- do this port here
+			LEVEL_DEBUG("Cannot create read many thread");
+			Many_port(mp);
+		}
+	}
+	for (port_index = 0; port_index < nports && ports != NULL; ++port_index) {
+		if (ports[port_index].threadbad == 0) {
+			pthread_join(ports[port_index].thread, NULL);
+		}
+	}
+	SAFEFREE(ports);
+
+	// anything left -- no known bus, or no threads
+	for (read_index = 0; read_index < nreads; ++read_index) {
+		Many_one(&ml->states[read_index]);
+	}
+	owfree(ml->states);
+}
+
+/* Parse the path and find its bus */
+static void Many_locate(struct many_state *ms)
+{
+	struct many_read *mr = ms->read;
+	struct parsedname *pn;
+
+	ms->in = NO_CONNECTION;
+	if (mr->path == NULL) {
+		ms->owq = NO_ONE_WIRE_QUERY;
+		mr->read_return = -EINVAL;
+		return;
+	}
+	ms->owq = OWQ_create_from_path(mr->path);
+	if (ms->owq == NO_ONE_WIRE_QUERY) {
+		mr->read_return = -ENOENT;
+		return;
+	}
+	pn = PN(ms->owq);
+	if (pn->selected_filetype == NO_FILETYPE || IsDir(pn)) {
+		// device or directory, not a value
+		OWQ_destroy(ms->owq);
+		ms->owq = NO_ONE_WIRE_QUERY;
+		mr->read_return = -EISDIR;
+		return;
+	}
+	mr->binary = (pn->selected_filetype->format == ft_binary);
+	if (mr->buffer == NULL) {
+		mr->size = FullFileLength(pn);
+		mr->offset = 0;
+		mr->buffer = owcalloc(mr->size + 1, 1);
+		if (mr->buffer == NULL) {
+			OWQ_destroy(ms->owq);
+			ms->owq = NO_ONE_WIRE_QUERY;
+			mr->read_return = -ENOMEM;
+			return;
+		}
+	}
+	if (KnownBus(pn)) {
+		ms->in = pn->selected_connection;
+		ms->temperature = FS_simultaneous_wanted(pn);
+	}
+}
+
+/* A temperature read that a simultaneous conversion serves, and not already cached */
+int FS_simultaneous_wanted(const struct parsedname *pn)
+{
+	struct filetype *ft = pn->selected_filetype;
+
+	if (ft == NO_FILETYPE || pn->selected_device == NO_DEVICE || (pn->selected_device->flags & DEV_temp) == 0) {
+		return 0;
+	}
+	if (ft->format != ft_temperature || (ft->change != fc_simultaneous_temperature && ft->change != fc_link)) {
+		return 0;
+	}
+	return Cache_Remaining(pn) == 0;
+}
+
+/* One conversion for the bus when it serves more than one read, the reads only wait out the remainder.
+ * A single read is left to convert on its own rather than tie up the whole bus */
+void FS_simultaneous_start(struct connection_in *in, int wanted)
+{
+	char convert_path[40];
+
+	if (wanted < 2) {
+		return;
+	}
+	UCLIBCLOCK;
+	snprintf(convert_path, sizeof(convert_path), "/bus.%d/simultaneous/temperature", in->index);
+	UCLIBCUNLOCK;
+	FS_write(convert_path, "1", 1, 0);
+}
+
+/* Thread per port */
+static void *Many_port(void *v)
+{
+	struct many_port *mp = v;
+	struct connection_in *in;
+
+	for (in = mp->pin->first; in != NO_CONNECTION; in = in->next) {
+		Many_connection(mp->ml, in);
+	}
+	return VOID_RETURN;
+}
+
+/* Reads on one bus, in the caller's order */
+static void Many_connection(struct many_list *ml, struct connection_in *in)
+{
+	int temperatures = 0;
+	int read_index;
+
+	for (read_index = 0; read_index < ml->nstates; ++read_index) {
+		struct many_state *ms = &ml->states[read_index];
+		if (ms->in == in && ms->owq != NO_ONE_WIRE_QUERY && ms->temperature) {
+			++temperatures;
+		}
+	}
+	FS_simultaneous_start(in, temperatures);
+
+	for (read_index = 0; read_index < ml->nstates; ++read_index) {
+		if (ml->states[read_index].in == in) {
+			Many_one(&ml->states[read_index]);
+		}
+	}
+}
+
+/* Read into the caller's buffer, once */
+static void Many_one(struct many_state *ms)
+{
+	struct many_read *mr = ms->read;
+
+	if (ms->owq == NO_ONE_WIRE_QUERY) {
+		// done, or failed to parse
+		return;
+	}
+	OWQ_assign_read_buffer(mr->buffer, mr->size, mr->offset, ms->owq);
+	mr->read_return = FS_read_postparse(ms->owq);
+	OWQ_destroy(ms->owq);
+	ms->owq = NO_ONE_WIRE_QUERY;
+}
@@ -75,6 +75,7 @@ GOOD_OR_BAD Zero_detect(struct port_in *pin)
 	RETURN_BAD_IF_BAD( COM_open(in) ) ;
 	in->Adapter = adapter_tcp;
 	in->adapter_name = "tcp";
+	Server_pool_seed(in) ;
 	Zero_setroutines(&(in->iroutines));
 	return gbGOOD;
 }
@@ -95,6 +96,7 @@ GOOD_OR_BAD Server_detect(struct port_in *pin)
 	in->Adapter = adapter_tcp;
 	in->adapter_name = "tcp";
 	pin->busmode = bus_server;
+	Server_pool_seed(in) ;
 	Server_setroutines(&(in->iroutines));
 	return gbGOOD;
 }
@@ -103,6 +105,7 @@ GOOD_OR_BAD Server_detect(struct port_in *pin)
 // actual connections opened and closed independently
 static void Server_close(struct connection_in *in)
 {
+	Server_pool_clear(in) ;
 	SAFEFREE(in->master.server.type) ;
 	SAFEFREE(in->master.server.domain) ;
 	SAFEFREE(in->master.server.name) ;
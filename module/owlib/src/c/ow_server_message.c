@@ -16,6 +16,7 @@
 #include "ow.h"
 #include "ow_connection.h"
 #include "ow_standard.h" // for FS_?_alias
+#include <poll.h>
 
 struct server_connection_state {
 	FILE_DESCRIPTOR_OR_ERROR file_descriptor ;
@@ -41,6 +42,9 @@ static ZERO_OR_ERROR Directory_Element( char * current_file, struct directory_el
 
 static void Close_Persistent( struct server_connection_state * scs) ;
 static void Release_Persistent( struct server_connection_state * scs, int granted ) ;
+static FILE_DESCRIPTOR_OR_ERROR Pool_take( struct connection_in * in ) ;
+static int Pool_healthy( FILE_DESCRIPTOR_OR_ERROR file_descriptor, time_t put_back ) ;
+static FILE_DESCRIPTOR_OR_ERROR Server_connect( struct connection_in * in ) ;
 
 static GOOD_OR_BAD To_Server( struct server_connection_state * scs, struct server_msg * sm, struct serverpackage *sp) ;
 static SIZE_OR_ERROR WriteToServer(int file_descriptor, struct server_msg *sm, struct serverpackage *sp);
@@ -512,89 +516,32 @@ static SIZE_OR_ERROR From_Server( struct server_connection_state * scs, struct c
 	return cm->payload;
 }
 
+/* Persistent connections
+   Each remote owserver keeps up to SERVER_POOL_SIZE idle connections
+   (in->master.server.pool). A request takes the most recently used one,
+   or connects anew if none is idle, so concurrent requests each have
+   their own persistent connection. Afterwards the connection goes back
+   to the pool if the owserver granted persistence and there is room,
+   else it is closed.
+
+   An idle connection is only checked when taken (Pool_healthy).
+*/
 static GOOD_OR_BAD To_Server( struct server_connection_state * scs, struct server_msg * sm, struct serverpackage *sp)
 {
 	struct connection_in * in = scs->in ; // for convenience
-	struct port_in * pin = in->pown ;
-	BYTE test_read[1] ;
-	int old_flags ;
-	ssize_t rcv_value ;
-	int saved_errno ;
-	
+	int pooled = 0 ;
+
 	// initialize the variables
 	scs->file_descriptor = FILE_DESCRIPTOR_BAD ;
 	scs->persistence = Globals.no_persistence ? persistent_no : persistent_yes ;
 
-	// First set up the file descriptor based on persistent state
-	if (scs->persistence == persistent_no) {		
-		// no persistence wanted
-		scs->file_descriptor = ClientConnect(in);
-	} else {
-		// Persistence desired
-		BUSLOCKIN(in);
-		switch ( pin->file_descriptor ) {
-			case FILE_DESCRIPTOR_PERSISTENT_IN_USE:
-				// Currently in use, so make new non-persistent connection
-				scs->file_descriptor = ClientConnect(in);
-				scs->persistence = persistent_no ;
-				break ;
-			case FILE_DESCRIPTOR_BAD:
-				// no conection currently, so make a new one
-				scs->file_descriptor = ClientConnect(in);
-				if ( FILE_DESCRIPTOR_VALID( scs->file_descriptor ) ) {
-					pin->file_descriptor = FILE_DESCRIPTOR_PERSISTENT_IN_USE ;
-				}	
-				break ;
-			default:
-				// persistent connection idle and waiting for use
-				// connection_in is locked so this is safe
-				scs->file_descriptor = pin->file_descriptor;
-				pin->file_descriptor = FILE_DESCRIPTOR_PERSISTENT_IN_USE;
-			break ;
-		}
-		BUSUNLOCKIN(in);
-	}
-	
-	// Check if the server closed the connection
-	// This is contributed by Jacob Joseph to fix a timeout problem.
-	// http://permalink.gmane.org/gmane.comp.file-systems.owfs.devel/7306
-	//rcv_value = recv(scs->file_descriptor, test_read, 1, MSG_DONTWAIT | MSG_PEEK) ;
-	old_flags = fcntl( scs->file_descriptor, F_GETFL, 0 ) ; // save socket flags
-	if ( old_flags == -1 ) {
-		rcv_value = -2 ;
-	} else if ( fcntl( scs->file_descriptor, F_SETFL, old_flags | O_NONBLOCK ) == -1 ) { // set non-blocking
-		rcv_value = -2 ;
-	} else {
-		rcv_value = recv(scs->file_descriptor, test_read, 1, MSG_PEEK) ; // test read the socket to see if closed
-		saved_errno = errno ;
-		if ( fcntl( scs->file_descriptor, F_SETFL, old_flags ) == -1 ) { // restore  socket flags
-			rcv_value = -2 ;
-		}
+	// First an idle persistent connection, if any
+	if (scs->persistence == persistent_yes) {
+		scs->file_descriptor = Pool_take( in ) ;
+		pooled = FILE_DESCRIPTOR_VALID( scs->file_descriptor ) ;
 	}
-
-	switch ( rcv_value ) {
-		case -1:
-			if ( saved_errno==EAGAIN || saved_errno==EWOULDBLOCK ) {
-				// No data to be read -- so connection healthy
-				break ;
-			}
-			// real error, fall through to close connection case
-			__attribute__ ((fallthrough));
-		case -2:
-			// fnctl error, fall through again
-			;
-			__attribute__ ((fallthrough));
-		case 0:
-			LEVEL_DEBUG("Server connection was closed.  Reconnecting.");
-			Close_Persistent( scs);
-			scs->file_descriptor = ClientConnect(in);
-			if ( FILE_DESCRIPTOR_VALID( scs->file_descriptor ) ) {
-				in->pown->file_descriptor = FILE_DESCRIPTOR_PERSISTENT_IN_USE ;
-			}
-			break ;
-		default:
-			// data to be read, so a good connection
-			break ;
+	if ( ! pooled ) {
+		scs->file_descriptor = Server_connect( in ) ;
 	}
 
 	// Now test
@@ -610,16 +557,17 @@ static GOOD_OR_BAD To_Server( struct server_connection_state * scs, struct serve
 		return gbGOOD;
 	}
 
-	// This is where it gets a bit tricky. For non-persistent conections we're done'
-	if ( scs->persistence == persistent_no ) {
-		// not persistent, so no reconnection needed
+	// This is where it gets a bit tricky. A new connection failed, so we're done
+	if ( ! pooled ) {
 		Close_Persistent( scs ) ;
 		return gbBAD ;
 	}
 	
 	// perhaps the persistent connection is stale?
 	// Make a new one
-	scs->file_descriptor = ClientConnect(in) ;
+	STAT_ADD1(server_pool.stale);
+	Test_and_Close( &(scs->file_descriptor) ) ;
+	scs->file_descriptor = Server_connect(in) ;
 
 	// Now retest
 	if ( FILE_DESCRIPTOR_NOT_VALID( scs->file_descriptor ) ) {
@@ -629,8 +577,6 @@ static GOOD_OR_BAD To_Server( struct server_connection_state * scs, struct serve
 		return gbBAD ;
 	}
 	
-	// Leave in->file_descriptor = FILE_DESCRIPTOR_PERSISTENT_IN_USE
-
 	// Second attempt at the write, now with new connection
 	if (WriteToServer(scs->file_descriptor, sm, sp) >= 0) {
 		// successful message
@@ -642,16 +588,98 @@ static GOOD_OR_BAD To_Server( struct server_connection_state * scs, struct serve
 	return gbBAD ;
 }
 
-static void Close_Persistent( struct server_connection_state * scs)
+static FILE_DESCRIPTOR_OR_ERROR Server_connect( struct connection_in * in )
 {
-	// First set up the file descriptor based on persistent state
-	if (scs->persistence == persistent_yes) {
-		// no persistence wanted
-		BUSLOCKIN(scs->in);
-			scs->in->pown->file_descriptor = FILE_DESCRIPTOR_BAD ;
-		BUSUNLOCKIN(scs->in);
+	FILE_DESCRIPTOR_OR_ERROR file_descriptor = ClientConnect(in) ;
+
+	if ( FILE_DESCRIPTOR_VALID( file_descriptor ) ) {
+		STAT_ADD1(server_pool.connections);
 	}
-	
+	return file_descriptor ;
+}
+
+/* Most recently used idle connection that is still good */
+static FILE_DESCRIPTOR_OR_ERROR Pool_take( struct connection_in * in )
+{
+	struct master_server * ms = &(in->master.server) ;
+	FILE_DESCRIPTOR_OR_ERROR file_descriptor = FILE_DESCRIPTOR_BAD ;
+
+	BUSLOCKIN(in);
+	while ( ms->pool_count > 0 && FILE_DESCRIPTOR_NOT_VALID( file_descriptor ) ) {
+		--ms->pool_count ;
+		STATLOCK ;
+		--server_pool.idle ;
+		STATUNLOCK ;
+		file_descriptor = ms->pool[ms->pool_count] ;
+		if ( Pool_healthy( file_descriptor, ms->pool_time[ms->pool_count] ) ) {
+			STAT_ADD1(server_pool.reused);
+		} else {
+			LEVEL_DEBUG("Server connection was closed.  Reconnecting.");
+			STAT_ADD1(server_pool.stale);
+			Test_and_Close( &file_descriptor ) ;
+		}
+	}
+	BUSUNLOCKIN(in);
+	return file_descriptor ;
+}
+
+/* Replaces the MSG_PEEK test read on every request
+   (contributed by Jacob Joseph to fix a timeout problem
+   http://permalink.gmane.org/gmane.comp.file-systems.owfs.devel/7306 )
+   An idle connection has nothing to read;
+   readable means closed by the owserver, or out of step.
+   The age test uses our own timeout_persistent_low -- the remote
+   owserver's setting is not known here, this only guesses it is the
+   same (both default). A shorter remote timeout is caught by the poll,
+   or by the retry in To_Server if the close is still in flight.
+*/
+static int Pool_healthy( FILE_DESCRIPTOR_OR_ERROR file_descriptor, time_t put_back )
+{
+	struct pollfd pfd = { file_descriptor, POLLIN, 0, } ;
+
+	if ( NOW_TIME - put_back >= Globals.timeout_persistent_low ) {
+		return 0 ;
+	}
+	return poll( &pfd, 1, 0 ) == 0 ;
+}
+
+/* The connection COM_open made at detect is the first idle one */
+void Server_pool_seed( struct connection_in * in )
+{
+	struct master_server * ms = &(in->master.server) ;
+
+	ms->pool_count = 0 ;
+	if ( FILE_DESCRIPTOR_NOT_VALID( in->pown->file_descriptor ) ) {
+		return ;
+	}
+	BUSLOCKIN(in);
+	ms->pool[0] = in->pown->file_descriptor ;
+	ms->pool_time[0] = NOW_TIME ;
+	ms->pool_count = 1 ;
+	BUSUNLOCKIN(in);
+	STAT_ADD1(server_pool.connections);
+	STAT_ADD1(server_pool.idle);
+	in->pown->file_descriptor = FILE_DESCRIPTOR_BAD ; // the pool owns it now
+}
+
+/* Close the idle connections (bus closed) */
+void Server_pool_clear( struct connection_in * in )
+{
+	struct master_server * ms = &(in->master.server) ;
+
+	BUSLOCKIN(in);
+	while ( ms->pool_count > 0 ) {
+		--ms->pool_count ;
+		STATLOCK ;
+		--server_pool.idle ;
+		STATUNLOCK ;
+		Test_and_Close( &(ms->pool[ms->pool_count]) ) ;
+	}
+	BUSUNLOCKIN(in);
+}
+
+static void Close_Persistent( struct server_connection_state * scs)
+{
 	scs->persistence = persistent_no ;
 	Test_and_Close( &(scs->file_descriptor) ) ;
 }
@@ -793,11 +821,13 @@ static uint32_t SetupControlFlags(const struct parsedname *pn)
 }
 
 /* Clean up at end of routine,
-   either leave connection open and persistent flag available,
-   or close
+   either put the connection back in the pool, or close
 */
 static void Release_Persistent( struct server_connection_state * scs, int granted )
 {
+	struct master_server * ms = &(scs->in->master.server) ;
+	time_t now = NOW_TIME ;
+
 	if ( granted == 0 ) {
 		Close_Persistent( scs ) ;
 		return ;
@@ -814,10 +844,34 @@ static void Release_Persistent( struct server_connection_state * scs, int grante
 		return ;
 	}
 
-	// mark as available
 	BUSLOCKIN(scs->in);
-	scs->in->pown->file_descriptor = scs->file_descriptor;
+	// oldest first -- drop those the owserver will have closed
+	while ( ms->pool_count > 0 && now - ms->pool_time[0] >= Globals.timeout_persistent_low ) {
+		int index ;
+		Test_and_Close( &(ms->pool[0]) ) ;
+		--ms->pool_count ;
+		for ( index = 0 ; index < ms->pool_count ; ++index ) {
+			ms->pool[index] = ms->pool[index+1] ;
+			ms->pool_time[index] = ms->pool_time[index+1] ;
+		}
+		STATLOCK ;
+		--server_pool.idle ;
+		++server_pool.stale ;
+		STATUNLOCK ;
+	}
+	if ( ms->pool_count < SERVER_POOL_SIZE ) {
+		// mark as available
+		ms->pool[ms->pool_count] = scs->file_descriptor ;
+		ms->pool_time[ms->pool_count] = now ;
+		++ms->pool_count ;
+		STAT_ADD1(server_pool.idle);
+		scs->file_descriptor = FILE_DESCRIPTOR_BAD ;
+	}
 	BUSUNLOCKIN(scs->in);
-	scs->persistence = persistent_no ; // we no longer own this connection
-	scs->file_descriptor = FILE_DESCRIPTOR_BAD ;
+
+	if ( FILE_DESCRIPTOR_VALID( scs->file_descriptor ) ) {
+		// pool full
+		STAT_ADD1(server_pool.overflow);
+	}
+	Close_Persistent( scs ) ; // we no longer own this connection
 }
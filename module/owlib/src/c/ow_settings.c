@@ -42,12 +42,13 @@ static struct filetype set_timeout[] = {
 	{"network", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_static, FS_r_timeout, FS_w_timeout, VISIBLE, {.v=&Globals.timeout_network}, },
 	{"server", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_static, FS_r_timeout, FS_w_timeout, VISIBLE, {.v=&Globals.timeout_server}, },
 	{"ftp", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_static, FS_r_timeout, FS_w_timeout, VISIBLE, {.v=&Globals.timeout_ftp}, },
+	{"http", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_static, FS_r_timeout, FS_w_timeout, VISIBLE, {.v=&Globals.timeout_http}, },
 	{"ha7", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_static, FS_r_timeout, FS_w_timeout, VISIBLE, {.v=&Globals.timeout_ha7}, },
 	{"w1", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_static, FS_r_timeout, FS_w_timeout, VISIBLE, {.v=&Globals.timeout_w1}, },
 	{"uncached", PROPERTY_LENGTH_YESNO, NON_AGGREGATE, ft_yesno, fc_static, FS_r_yesno, FS_w_yesno, VISIBLE, {.v=&Globals.uncached}, },
 };
 struct device d_set_timeout = { "timeout", "timeout", ePN_settings, COUNT_OF_FILETYPES(set_timeout),
-	set_timeout, NO_GENERIC_READ, NO_GENERIC_WRITE
+	set_timeout, NO_GENERIC_READ, NO_GENERIC_WRITE, NULL
 };
 
 static struct filetype set_units[] = {
@@ -55,7 +56,7 @@ static struct filetype set_units[] = {
  	{"pressure_scale", 12, NON_AGGREGATE, ft_ascii, fc_static, FS_r_PS, FS_w_PS, VISIBLE, NO_FILETYPE_DATA, },
 };
 struct device d_set_units = { "units", "units", ePN_settings, COUNT_OF_FILETYPES(set_units),
-	set_units, NO_GENERIC_READ, NO_GENERIC_WRITE
+	set_units, NO_GENERIC_READ, NO_GENERIC_WRITE, NULL
 };
 
 static struct filetype set_alias[] = {
@@ -63,7 +64,7 @@ static struct filetype set_alias[] = {
 	{"unaliased", PROPERTY_LENGTH_YESNO, NON_AGGREGATE, ft_yesno, fc_static, FS_r_yesno, FS_w_yesno, VISIBLE, {.v=&Globals.unaliased}, },
 };
 struct device d_set_alias = { "alias", "alias", ePN_settings, COUNT_OF_FILETYPES(set_alias),
-	set_alias, NO_GENERIC_READ, NO_GENERIC_WRITE
+	set_alias, NO_GENERIC_READ, NO_GENERIC_WRITE, NULL
 };
 
 static struct aggregate Areturn_code = { N_RETURN_CODES, ag_numbers, ag_separate, };
@@ -72,7 +73,7 @@ static struct filetype set_return_code[] = {
 };
 
 struct device d_set_return_code = { "return_codes", "return_codes", 0, COUNT_OF_FILETYPES(set_return_code),
-	set_return_code, NO_GENERIC_READ, NO_GENERIC_WRITE
+	set_return_code, NO_GENERIC_READ, NO_GENERIC_WRITE, NULL
 };
 
 
@@ -154,7 +154,12 @@ static ZERO_OR_ERROR FS_w_convert_temp(struct one_wire_query *owq)
 
 	// Get Power status
 	LEVEL_DEBUG("TEST if bus powered");
-	RETURN_BAD_IF_BAD(BUS_transaction(tpower, pn_directory)) ;
+	if ( in->Adapter == adapter_timed ) {
+		// simulated devices answer as set by --timed_parasitic or simulated/parasitic
+		pow[0] = in->master.timed.parasitic ? 0x00 : 0xFF ;
+	} else {
+		RETURN_BAD_IF_BAD(BUS_transaction(tpower, pn_directory)) ;
+	}
 	
 	Cache_Add_Simul(pn->selected_filetype->data.v, pn_directory);	// Mark start time
 	if ( pow[0] != 0 ) {
@@ -282,6 +287,10 @@ static ZERO_OR_ERROR FS_r_present(struct one_wire_query *owq)
 	struct parsedname *pn = PN(owq);
 
 	switch (pn->selected_connection->Adapter) {
+		case adapter_timed:
+			// timed adapter -- memory look-up, no fall through
+			OWQ_Y(owq) = (DirblobElements(&(pn->selected_connection->master.timed.main)) > 0);
+			break ;
 		case adapter_fake:
 		case adapter_mock:
 		case adapter_tester:
@@ -334,6 +343,7 @@ static ZERO_OR_ERROR FS_r_single(struct one_wire_query *owq)
 		case adapter_fake:
 		case adapter_tester:
 		case adapter_mock:
+		case adapter_timed:
 			if (DirblobElements(&(pn->selected_connection->master.fake.main)) == 1) {
 				DirblobGet(0, resp, &(pn->selected_connection->master.fake.main));
 				FS_devicename(ad, sizeof(ad), resp, pn);
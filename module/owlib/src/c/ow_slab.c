@@ -0,0 +1,171 @@
+/*
+    OW -- One-Wire filesystem
+    version 0.4 7/2/2003
+
+    Written 2003 Paul H Alfille
+    GPL license
+    See the header file: ow.h for full attribution
+    ---------------------------------------------------------------------------
+    Implementation:
+    slab -- fixed size object pools
+*/
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+#include "ow_counters.h"
+
+/*
+    A "slab" is a block of equal size objects.
+
+    Objects are threaded on the pool's free list when the
+    block is created, so allocation and free are a pointer swap.
+    Blocks are only returned to the heap by SlabClear.
+*/
+
+#define SLAB_ALIGN          16
+#define SLAB_ROUND(x)       ( ((x) + SLAB_ALIGN - 1) & ~((size_t) SLAB_ALIGN - 1) )
+
+struct slab_block {
+	struct slab_block * next ;
+};
+
+#define SLAB_BLOCK_HEADER   SLAB_ROUND(sizeof(struct slab_block))
+
+/*
+    The statistics are shared by every pool of a class (the device locks
+    of all buses, both cache generations), whose owners hold different
+    locks. They are updated atomically rather than under STATLOCK, which
+    every other counter in the program contends for.
+*/
+#if defined(__GNUC__)
+#define SLAB_STAT_ADD(x, n)   __sync_add_and_fetch( &(x), (n) )
+#define SLAB_STAT_SUB(x, n)   __sync_sub_and_fetch( &(x), (n) )
+#else							/* __GNUC__ */
+static UINT SlabStatChange(UINT * x, UINT add, UINT sub)
+{
+	UINT value ;
+
+	STATLOCK;
+	value = (*x += add - sub) ;
+	STATUNLOCK;
+	return value ;
+}
+#define SLAB_STAT_ADD(x, n)   SlabStatChange( &(x), (n), 0 )
+#define SLAB_STAT_SUB(x, n)   SlabStatChange( &(x), 0, (n) )
+#endif							/* __GNUC__ */
+
+/* Raise the high water mark to in_use */
+static void SlabStatMax(UINT * max, UINT in_use)
+{
+#if defined(__GNUC__)
+	UINT old = *max ;
+
+	while ( in_use > old && ! __sync_bool_compare_and_swap( max, old, in_use ) ) {
+		old = *max ;
+	}
+#else							/* __GNUC__ */
+	STATLOCK;
+	if ( in_use > *max ) {
+		*max = in_use ;
+	}
+	STATUNLOCK;
+#endif							/* __GNUC__ */
+}
+
+/* free list link, stored in the free object itself */
+struct slab_free {
+	struct slab_free * next ;
+};
+
+void SlabInit(struct slab_pool *sp, size_t size, struct slab_stats *stats)
+{
+	sp->size = SLAB_ROUND( size < sizeof(struct slab_free) ? sizeof(struct slab_free) : size ) ;
+	sp->per_block = (SLAB_BLOCK_SIZE - SLAB_BLOCK_HEADER) / sp->size ;
+	if ( sp->per_block < 8 ) {
+		sp->per_block = 8 ;
+	}
+	sp->in_use = 0 ;
+	sp->free_list = NULL ;
+	sp->blocks = NULL ;
+	sp->stats = stats ;
+}
+
+/* Add a block and thread its objects on the free list */
+static GOOD_OR_BAD SlabGrow(struct slab_pool *sp)
+{
+	struct slab_block * block = owmalloc( SLAB_BLOCK_HEADER + sp->per_block * sp->size ) ;
+	BYTE * object ;
+	UINT i ;
+
+	if ( block == NULL ) {
+		return gbBAD ;
+	}
+	block->next = sp->blocks ;
+	sp->blocks = block ;
+
+	object = ((BYTE *) block) + SLAB_BLOCK_HEADER ;
+	for ( i = 0 ; i < sp->per_block ; ++i, object += sp->size ) {
+		((struct slab_free *) object)->next = sp->free_list ;
+		sp->free_list = object ;
+	}
+
+	SLAB_STAT_ADD( sp->stats->blocks, 1 ) ;
+	return gbGOOD ;
+}
+
+void *SlabAlloc(struct slab_pool *sp)
+{
+	struct slab_free * object ;
+	UINT in_use ;
+
+	if ( sp->free_list == NULL && BAD( SlabGrow(sp) ) ) {
+		return NULL ;
+	}
+	object = sp->free_list ;
+	sp->free_list = object->next ;
+	++sp->in_use ;
+
+	SLAB_STAT_ADD( sp->stats->allocations, 1 ) ;
+	in_use = SLAB_STAT_ADD( sp->stats->in_use, 1 ) ;
+	SlabStatMax( &sp->stats->max, in_use ) ;
+	return object ;
+}
+
+void SlabFree(struct slab_pool *sp, void *object)
+{
+	if ( object == NULL ) {
+		return ;
+	}
+	((struct slab_free *) object)->next = sp->free_list ;
+	sp->free_list = object ;
+	--sp->in_use ;
+
+	SLAB_STAT_ADD( sp->stats->frees, 1 ) ;
+	SLAB_STAT_SUB( sp->stats->in_use, 1 ) ;
+}
+
+/* Release every block -- all objects from this pool become invalid */
+void SlabClear(struct slab_pool *sp)
+{
+	UINT blocks = 0 ;
+
+	while ( sp->blocks != NULL ) {
+		struct slab_block * next = sp->blocks->next ;
+		owfree( sp->blocks ) ;
+		sp->blocks = next ;
+		++blocks ;
+	}
+
+	SLAB_STAT_SUB( sp->stats->blocks, blocks ) ;
+	SLAB_STAT_ADD( sp->stats->frees, sp->in_use ) ;
+	SLAB_STAT_SUB( sp->stats->in_use, sp->in_use ) ;
+
+	sp->in_use = 0 ;
+	sp->free_list = NULL ;
+}
+
+void SlabTreeKeep(void *object)
+{
+	(void) object ;
+}
@@ -0,0 +1,384 @@
+/*
+    OW -- One-Wire filesystem
+    version 0.4 7/2/2003
+
+    Written 2003 Paul H Alfille
+    GPL license
+    See the header file: ow.h for full attribution
+    ---------------------------------------------------------------------------
+    Implementation:
+    snapshot -- every device and readable property as one JSON object
+*/
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+
+/*
+    A snapshot walks each bus in turn, one thread per port (like
+    FS_dir_all_connections). On each bus the device list is taken first,
+    simultaneous conversions are started, and then every readable property
+    of each device is read.
+
+    Output is JSON text handed to chunkfunc as it is ready -- an opening
+    brace, one chunk per device, and the closing brace. Device chunks from
+    different buses arrive in completion order, serialized by a mutex.
+
+    { "10.67C6697351FF":{"address":"10...","temperature":"     21.5", ... },
+      ... }
+
+    Values match the owhttpd JSON device view. Subdirectories of a device
+    become nested objects, DS2409 branches are not followed.
+*/
+
+struct snapshot_struct {
+	void (*chunkfunc) (void *, const char *, size_t);
+	void *v;
+	uint32_t control_flags;		// client settings for every query
+	int uncached;
+	int tokens;
+	BYTE *tokenstring;
+	pthread_mutex_t chunk_mutex;
+	int devices;				// device chunks sent so far
+};
+
+struct snapshot_port {
+	struct snapshot_struct *ss;
+	struct port_in *pin;
+};
+
+static void Snapshot_port(struct snapshot_struct *ss, struct port_in *pin);
+static void Snapshot_connection(struct snapshot_struct *ss, struct connection_in *in);
+static void Snapshot_device(struct snapshot_struct *ss, const char *path, const char *name);
+static void Snapshot_properties(struct snapshot_struct *ss, struct memblob *mb, const char *path);
+static void Snapshot_value(struct memblob *mb, struct one_wire_query *owq);
+static void Snapshot_settings(struct snapshot_struct *ss, struct parsedname *pn);
+
+#define Snapshot_text(mb, text)	MemblobAdd((const BYTE *) (text), strlen(text), (mb))
+
+ZERO_OR_ERROR FS_snapshot(void (*chunkfunc) (void *, const char *, size_t), void *v, const struct parsedname *pn_directory)
+{
+	struct snapshot_struct ss;
+
+	if (pn_directory == NO_PARSEDNAME) {
+		return -ENODEV;
+	}
+	if (pn_directory->selected_device != NO_DEVICE) {
+		return -ENOTDIR;
+	}
+
+	ss.chunkfunc = chunkfunc;
+	ss.v = v;
+	ss.control_flags = pn_directory->control_flags & ~BINARY_VALUE;
+	ss.uncached = !NotUncachedDir(pn_directory);
+	ss.tokens = pn_directory->tokens;
+	ss.tokenstring = pn_directory->tokenstring;
+	ss.devices = 0;
+	_MUTEX_INIT(ss.chunk_mutex);
+
+	chunkfunc(v, "{\n", 2);
+	if (SpecifiedBus(pn_directory)) {
+		Snapshot_connection(&ss, pn_directory->selected_connection);
+	} else {
+		Snapshot_port(&ss, Inbound_Control.head_port);
+	}
+	if (ss.devices > 0) {
+		chunkfunc(v, "\n}\n", 3);
+	} else {
+		chunkfunc(v, "}\n", 2);
+	}
+
+	_MUTEX_DESTROY(ss.chunk_mutex);
+	return 0;
+}
+
+/* Carry the client settings over to a freshly parsed name */
+static void Snapshot_settings(struct snapshot_struct *ss, struct parsedname *pn)
+{
+	pn->control_flags = ss->control_flags;
+	if (ss->uncached) {
+		pn->state |= ePS_uncached;
+	}
+	pn->tokens = ss->tokens;
+	pn->tokenstring = ss->tokenstring;
+}
+
+/* Thread per port, channels of a port in turn since they share the wire */
+static void *Snapshot_port_callback(void *v)
+{
+	struct snapshot_port *sp = v;
+	Snapshot_port(sp->ss, sp->pin);
+	return VOID_RETURN;
+}
+
+static void Snapshot_port(struct snapshot_struct *ss, struct port_in *pin)
+{
+	struct snapshot_port sp_next = { ss, NULL, };
+	struct connection_in *in;
+	pthread_t thread;
+	int threadbad = 1;
+
+	if (pin == NULL) {
+		return;
+	}
+
+	sp_next.pin = pin->next;
+	if (sp_next.pin != NULL) {
+		threadbad = pthread_create(&thread, DEFAULT_THREAD_ATTR, Snapshot_port_callback, (void *) (&sp_next));
+		if (threadbad != 0) {
+			// no thread -- do the rest of the ports after this one
+			LEVEL_DEBUG("Cannot create snapshot thread");
+		}
+	}
+
+	for (in = pin->first; in != NO_CONNECTION; in = in->next) {
+		Snapshot_connection(ss, in);
+	}
+
+	if (sp_next.pin != NULL) {
+		if (threadbad == 0) {
+			pthread_join(thread, NULL);
+		} else {
+			Snapshot_port(ss, sp_next.pin);
+		}
+	}
+}
+
+/* Directory entries as path\0name\0 pairs */
+static void Snapshot_entry_callback(void *v, const struct parsedname *pn_entry)
+{
+	struct memblob *mb = v;
+	MemblobAdd((const BYTE *) pn_entry->path, strlen(pn_entry->path) + 1, mb);
+	MemblobAdd((const BYTE *) FS_DirName(pn_entry), strlen(FS_DirName(pn_entry)) + 1, mb);
+}
+
+/* Only real devices from a bus listing (no interface, simultaneous, alarm) */
+static void Snapshot_device_callback(void *v, const struct parsedname *pn_entry)
+{
+	if (pn_entry->selected_device == NO_DEVICE || pn_entry->selected_device == DeviceSimultaneous) {
+		return;
+	}
+	if (NotRealDir(pn_entry)) {
+		return;
+	}
+	Snapshot_entry_callback(v, pn_entry);
+}
+
+/* List a directory into a memblob, flags collects the device types */
+static ZERO_OR_ERROR Snapshot_list(struct snapshot_struct *ss, void (*dirfunc) (void *, const struct parsedname *), struct memblob *mb, const char *path, uint32_t * flags)
+{
+	struct parsedname s_pn_directory;
+	struct parsedname *pn_directory = &s_pn_directory;
+	ZERO_OR_ERROR ret;
+
+	if (FS_ParsedName(path, pn_directory) != 0) {
+		return -ENOENT;
+	}
+	Snapshot_settings(ss, pn_directory);
+	ret = FS_dir_remote(dirfunc, mb, pn_directory, flags);
+	FS_ParsedName_destroy(pn_directory);
+	return ret;
+}
+
+static void Snapshot_connection(struct snapshot_struct *ss, struct connection_in *in)
+{
+	char bus_path[OW_FULLNAME_MAX];
+	char convert_path[OW_FULLNAME_MAX + 25];
+	struct memblob mb;
+	uint32_t flags = 0;
+	const char *entry;
+	const char *end;
+
+	UCLIBCLOCK;
+	snprintf(bus_path, OW_FULLNAME_MAX, "/bus.%d", in->index);
+	UCLIBCUNLOCK;
+
+	MemblobInit(&mb, 1024);
+	if (Snapshot_list(ss, Snapshot_device_callback, &mb, bus_path, &flags) != 0 || !MemblobPure(&mb)) {
+		LEVEL_DEBUG("Cannot list %s for snapshot", bus_path);
+		MemblobClear(&mb);
+		return;
+	}
+
+	// start conversions for the whole bus, later reads only wait out the remainder
+	if (flags & DEV_temp) {
+		UCLIBCLOCK;
+		snprintf(convert_path, sizeof(convert_path), "%s/simultaneous/temperature", bus_path);
+		UCLIBCUNLOCK;
+		FS_write(convert_path, "1", 1, 0);
+	}
+	if (flags & DEV_volt) {
+		UCLIBCLOCK;
+		snprintf(convert_path, sizeof(convert_path), "%s/simultaneous/voltage", bus_path);
+		UCLIBCUNLOCK;
+		FS_write(convert_path, "1", 1, 0);
+	}
+
+	entry = (const char *) MemblobData(&mb);
+	end = entry + MemblobLength(&mb);
+	while (entry < end) {
+		const char *name = entry + strlen(entry) + 1;
+		Snapshot_device(ss, entry, name);
+		entry = name + strlen(name) + 1;
+	}
+	MemblobClear(&mb);
+}
+
+/* One device as a chunk -- "name":{...} */
+static void Snapshot_device(struct snapshot_struct *ss, const char *path, const char *name)
+{
+	struct memblob mb;
+	const char *chunk;
+	size_t length;
+
+	MemblobInit(&mb, 1024);
+	// leading separator, skipped for the first device
+	Snapshot_text(&mb, ",\n");
+	JSON_string(&mb, name, strlen(name));
+	Snapshot_text(&mb, ":{");
+	Snapshot_properties(ss, &mb, path);
+	MemblobAdd((const BYTE *) "}", 2, &mb);	// with terminating null
+
+	if (!MemblobPure(&mb)) {
+		LEVEL_DEBUG("Out of memory for snapshot of %s", path);
+		MemblobClear(&mb);
+		return;
+	}
+
+	chunk = (const char *) MemblobData(&mb);
+	length = MemblobLength(&mb) - 1;
+
+	_MUTEX_LOCK(ss->chunk_mutex);
+	if (ss->devices++ == 0) {
+		chunk += 2;
+		length -= 2;
+	}
+	ss->chunkfunc(ss->v, chunk, length);
+	_MUTEX_UNLOCK(ss->chunk_mutex);
+
+	MemblobClear(&mb);
+}
+
+/* Members of a device (or subdirectory) object */
+static void Snapshot_properties(struct snapshot_struct *ss, struct memblob *mb, const char *path)
+{
+	struct memblob entries;
+	uint32_t flags;
+	const char *entry;
+	const char *end;
+	int not_first = 0;
+
+	MemblobInit(&entries, 1024);
+	if (Snapshot_list(ss, Snapshot_entry_callback, &entries, path, &flags) != 0) {
+		MemblobClear(&entries);
+		return;
+	}
+
+	entry = (const char *) MemblobData(&entries);
+	end = entry + MemblobLength(&entries);
+	while (entry < end) {
+		const char *name = entry + strlen(entry) + 1;
+		struct one_wire_query *owq = OWQ_create_from_path(entry);
+		struct filetype *ft;
+
+		if (owq == NO_ONE_WIRE_QUERY) {
+			entry = name + strlen(name) + 1;
+			continue;
+		}
+		Snapshot_settings(ss, PN(owq));
+		ft = PN(owq)->selected_filetype;
+
+		if (ft == NO_FILETYPE && PN(owq)->subdir != NO_SUBDIR) {
+			if (not_first++) {
+				Snapshot_text(mb, ",");
+			}
+			JSON_string(mb, name, strlen(name));
+			Snapshot_text(mb, ":{");
+			Snapshot_properties(ss, mb, entry);
+			Snapshot_text(mb, "}");
+		} else if (ft == NO_FILETYPE || ft->format == ft_directory) {
+			// a branch to more devices
+		} else if (ft->read != NO_READ_FUNCTION) {
+			if (not_first++) {
+				Snapshot_text(mb, ",");
+			}
+			JSON_string(mb, name, strlen(name));
+			Snapshot_text(mb, ":");
+			Snapshot_value(mb, owq);
+		}
+		OWQ_destroy(owq);
+		entry = name + strlen(name) + 1;
+	}
+	MemblobClear(&entries);
+}
+
+/* Value in the owhttpd JSON form, null for a failed read */
+static void Snapshot_value(struct memblob *mb, struct one_wire_query *owq)
+{
+	struct parsedname *pn = PN(owq);
+	SIZE_OR_ERROR read_return;
+
+	if (BAD(OWQ_allocate_read_buffer(owq))) {
+		Snapshot_text(mb, "null");
+		return;
+	}
+	read_return = FS_read_postparse(owq);
+	if (read_return < 0) {
+		Snapshot_text(mb, "null");
+		return;
+	}
+
+	switch (pn->selected_filetype->format) {
+	case ft_binary:
+		JSON_hex(mb, (const BYTE *) OWQ_buffer(owq), read_return);
+		break;
+	case ft_yesno:
+	case ft_bitfield:
+		if (pn->extension >= 0) {
+			Snapshot_text(mb, OWQ_buffer(owq)[0] == '0' ? "\"false\"" : "\"true\"");
+			break;
+		}
+		// fall through
+	default:
+		JSON_string(mb, OWQ_buffer(owq), read_return);
+		break;
+	}
+}
+
+/* Quoted JSON string -- also used by the owhttpd JSON views */
+void JSON_string(struct memblob *mb, const char *text, size_t length)
+{
+	size_t i;
+
+	MemblobAddChar('"', 1, mb);
+	for (i = 0; i < length; ++i) {
+		BYTE c = (BYTE) text[i];
+		if (c == '"' || c == '\\') {
+			MemblobAddChar('\\', 1, mb);
+			MemblobAddChar(c, 1, mb);
+		} else if (c < 0x20) {
+			char escape[7];
+			UCLIBCLOCK;
+			snprintf(escape, sizeof(escape), "\\u%.4X", c);
+			UCLIBCUNLOCK;
+			Snapshot_text(mb, escape);
+		} else {
+			MemblobAddChar(c, 1, mb);
+		}
+	}
+	MemblobAddChar('"', 1, mb);
+}
+
+/* Binary data as a quoted JSON string of hex digits */
+void JSON_hex(struct memblob *mb, const BYTE *data, size_t length)
+{
+	char hex[3];
+	size_t i;
+
+	MemblobAddChar('"', 1, mb);
+	for (i = 0; i < length; ++i) {
+		num2string(hex, data[i]);
+		MemblobAdd((const BYTE *) hex, 2, mb);
+	}
+	MemblobAddChar('"', 1, mb);
+}
@@ -59,6 +59,15 @@ struct cache_stats cache_int = { 0L, 0L, 0L, 0L, 0L, };
 struct cache_stats cache_dir = { 0L, 0L, 0L, 0L, 0L, };
 struct cache_stats cache_pst = { 0L, 0L, 0L, 0L, 0L, };
 struct cache_stats cache_dev = { 0L, 0L, 0L, 0L, 0L, };
+struct cache_stats cache_pn = { 0L, 0L, 0L, 0L, 0L, };
+
+struct slab_stats slab_cache_64 = { 0L, 0L, 0L, 0L, 0L, };
+struct slab_stats slab_cache_128 = { 0L, 0L, 0L, 0L, 0L, };
+struct slab_stats slab_cache_256 = { 0L, 0L, 0L, 0L, 0L, };
+struct slab_stats slab_cache_512 = { 0L, 0L, 0L, 0L, 0L, };
+struct slab_stats slab_devlock = { 0L, 0L, 0L, 0L, 0L, };
+
+struct server_pool_stats server_pool = { 0L, 0L, 0L, 0L, 0L, };
 
 UINT read_calls = 0;
 UINT read_cache = 0;
@@ -178,9 +187,16 @@ static struct filetype stats_cache[] = {
 	{"device/added", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&cache_dev.adds}, },
 	{"device/expired", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&cache_dev.expires,}, },
 	{"device/deleted", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&cache_dev.deletes,}, },
+
+	{"parsedname", PROPERTY_LENGTH_SUBDIR, NON_AGGREGATE, ft_subdir, fc_subdir, NO_READ_FUNCTION, NO_WRITE_FUNCTION, VISIBLE, NO_FILETYPE_DATA, },
+	{"parsedname/tries", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&cache_pn.tries}, },
+	{"parsedname/hits", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&cache_pn.hits}, },
+	{"parsedname/added", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&cache_pn.adds}, },
+	{"parsedname/expired", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&cache_pn.expires,}, },
+	{"parsedname/cleared", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&cache_pn.deletes,}, },
 };
 
-struct device d_stats_cache = { "cache", "cache", 0, COUNT_OF_FILETYPES(stats_cache), stats_cache, NO_GENERIC_READ, NO_GENERIC_WRITE };
+struct device d_stats_cache = { "cache", "cache", 0, COUNT_OF_FILETYPES(stats_cache), stats_cache, NO_GENERIC_READ, NO_GENERIC_WRITE, NULL };
 
 	// Note, the store hit rate and deletions are not shown -- too much information!
 
@@ -194,7 +210,7 @@ static struct filetype stats_read[] = {
 	{"tries", PROPERTY_LENGTH_UNSIGNED, &Aread, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&read_tries}, },
 };
 
-struct device d_stats_read = { "read", "read", 0, COUNT_OF_FILETYPES(stats_read), stats_read, NO_GENERIC_READ, NO_GENERIC_WRITE };
+struct device d_stats_read = { "read", "read", 0, COUNT_OF_FILETYPES(stats_read), stats_read, NO_GENERIC_READ, NO_GENERIC_WRITE, NULL };
 
 static struct filetype stats_write[] = {
 	{"calls", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&write_calls}, },
@@ -203,7 +219,7 @@ static struct filetype stats_write[] = {
 	{"tries", PROPERTY_LENGTH_UNSIGNED, &Aread, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&write_tries}, },
 };
 
-struct device d_stats_write = { "write", "write", 0, COUNT_OF_FILETYPES(stats_write), stats_write, NO_GENERIC_READ, NO_GENERIC_WRITE };
+struct device d_stats_write = { "write", "write", 0, COUNT_OF_FILETYPES(stats_write), stats_write, NO_GENERIC_READ, NO_GENERIC_WRITE, NULL };
 
 static struct filetype stats_directory[] = {
 	{"maxdepth", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&dir_depth}, },
@@ -219,7 +235,7 @@ static struct filetype stats_directory[] = {
 
 ;
 struct device d_stats_directory = { "directory", "directory", 0, COUNT_OF_FILETYPES(stats_directory),
-	stats_directory, NO_GENERIC_READ, NO_GENERIC_WRITE
+	stats_directory, NO_GENERIC_READ, NO_GENERIC_WRITE, NULL
 };
 
 static struct filetype stats_thread[] = {
@@ -249,7 +265,7 @@ static struct filetype stats_thread[] = {
 };
 
 struct device d_stats_thread = { "threads", "threads", 0, COUNT_OF_FILETYPES(stats_thread),
-	stats_thread, NO_GENERIC_READ, NO_GENERIC_WRITE
+	stats_thread, NO_GENERIC_READ, NO_GENERIC_WRITE, NULL
 };
 
 static struct aggregate Areturn_code = { N_RETURN_CODES, ag_numbers, ag_separate, };
@@ -258,7 +274,62 @@ static struct filetype stats_return_code[] = {
 };
 
 struct device d_stats_return_code = { "return_codes", "return_codes", 0, COUNT_OF_FILETYPES(stats_return_code),
-	stats_return_code, NO_GENERIC_READ, NO_GENERIC_WRITE
+	stats_return_code, NO_GENERIC_READ, NO_GENERIC_WRITE, NULL
+};
+
+/* Slab pools for cache nodes (by size) and device locks */
+static struct filetype stats_slab[] = {
+	{"cache64", PROPERTY_LENGTH_SUBDIR, NON_AGGREGATE, ft_subdir, fc_subdir, NO_READ_FUNCTION, NO_WRITE_FUNCTION, VISIBLE, NO_FILETYPE_DATA, },
+	{"cache64/blocks", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_64.blocks}, },
+	{"cache64/in_use", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_64.in_use}, },
+	{"cache64/max", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_64.max}, },
+	{"cache64/allocations", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_64.allocations}, },
+	{"cache64/frees", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_64.frees}, },
+
+	{"cache128", PROPERTY_LENGTH_SUBDIR, NON_AGGREGATE, ft_subdir, fc_subdir, NO_READ_FUNCTION, NO_WRITE_FUNCTION, VISIBLE, NO_FILETYPE_DATA, },
+	{"cache128/blocks", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_128.blocks}, },
+	{"cache128/in_use", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_128.in_use}, },
+	{"cache128/max", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_128.max}, },
+	{"cache128/allocations", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_128.allocations}, },
+	{"cache128/frees", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_128.frees}, },
+
+	{"cache256", PROPERTY_LENGTH_SUBDIR, NON_AGGREGATE, ft_subdir, fc_subdir, NO_READ_FUNCTION, NO_WRITE_FUNCTION, VISIBLE, NO_FILETYPE_DATA, },
+	{"cache256/blocks", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_256.blocks}, },
+	{"cache256/in_use", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_256.in_use}, },
+	{"cache256/max", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_256.max}, },
+	{"cache256/allocations", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_256.allocations}, },
+	{"cache256/frees", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_256.frees}, },
+
+	{"cache512", PROPERTY_LENGTH_SUBDIR, NON_AGGREGATE, ft_subdir, fc_subdir, NO_READ_FUNCTION, NO_WRITE_FUNCTION, VISIBLE, NO_FILETYPE_DATA, },
+	{"cache512/blocks", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_512.blocks}, },
+	{"cache512/in_use", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_512.in_use}, },
+	{"cache512/max", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_512.max}, },
+	{"cache512/allocations", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_512.allocations}, },
+	{"cache512/frees", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_cache_512.frees}, },
+
+	{"devlock", PROPERTY_LENGTH_SUBDIR, NON_AGGREGATE, ft_subdir, fc_subdir, NO_READ_FUNCTION, NO_WRITE_FUNCTION, VISIBLE, NO_FILETYPE_DATA, },
+	{"devlock/blocks", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_devlock.blocks}, },
+	{"devlock/in_use", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_devlock.in_use}, },
+	{"devlock/max", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_devlock.max}, },
+	{"devlock/allocations", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_devlock.allocations}, },
+	{"devlock/frees", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&slab_devlock.frees}, },
+};
+
+struct device d_stats_slab = { "slab", "slab", 0, COUNT_OF_FILETYPES(stats_slab),
+	stats_slab, NO_GENERIC_READ, NO_GENERIC_WRITE, NULL
+};
+
+/* Persistent connections to remote owservers */
+static struct filetype stats_server_pool[] = {
+	{"connections", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&server_pool.connections}, },
+	{"reused", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&server_pool.reused}, },
+	{"stale", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&server_pool.stale}, },
+	{"overflow", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&server_pool.overflow}, },
+	{"idle", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&server_pool.idle}, },
+};
+
+struct device d_stats_server_pool = { "server_pool", "server_pool", 0, COUNT_OF_FILETYPES(stats_server_pool),
+	stats_server_pool, NO_GENERIC_READ, NO_GENERIC_WRITE, NULL
 };
 
 #define FS_stat_ROW(var) {"" #var "",PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE  , ft_unsigned, fc_statistic,   FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v= & var,}, }
@@ -305,7 +376,8 @@ struct device d_stats_errors = {
 	COUNT_OF_FILETYPES(stats_errors),
 	stats_errors,
 	NO_GENERIC_READ,
-	NO_GENERIC_WRITE
+	NO_GENERIC_WRITE,
+	NULL
 };
 
 
@@ -0,0 +1,195 @@
+/*
+    OWFS -- One-Wire filesystem
+    OWHTTPD -- One-Wire Web Server
+    Written 2003 Paul H Alfille
+    email: paul.alfille@gmail.com
+    Released under the GPL
+    See the header file: ow.h for full attribution
+    1wire/iButton system from Dallas Semiconductor
+$ID: $
+*/
+
+/* The "timed" adapter is a fake adapter that takes as long as real hardware.
+ * Values are the same random data as the fake adapter, but every bus
+ * transaction is charged the time a real 1-wire bus would need:
+ *   reset/presence, bit slots (standard or overdrive), conversion delays,
+ *   strong pull-up, and the adapter round trip (serial, usb, network).
+ * Failures can be injected at a given percentage.
+ * Useful for benchmarking scheduling and bundling without hardware.
+ * */
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+#include "ow_counters.h"
+#include "ow_connection.h"
+
+/* 1-wire timing in microseconds (from the Maxim application note 126) */
+#define TIMED_RESET_STANDARD     960	// tRSTL + tRSTH
+#define TIMED_RESET_OVERDRIVE    146
+#define TIMED_SLOT_STANDARD       70	// tSLOT + tREC
+#define TIMED_SLOT_OVERDRIVE      10
+
+/* Device timing in milliseconds */
+#define TIMED_TEMPERATURE_CONVERSION  750	// 12 bit, halved for each bit less
+#define TIMED_VOLTAGE_CONVERSION       10
+#define TIMED_EEPROM_PROGRAM           10	// copy scratchpad per page
+
+#define TIMED_SCRATCHPAD_BYTES   9	// typical status read including CRC8
+#define TIMED_PAGE_BYTES        32
+
+/* ------- Prototypes ----------- */
+static size_t Timed_select_bits(void);
+static size_t Timed_data_bits(struct one_wire_query *owq);
+static GOOD_OR_BAD Timed_conversion(struct one_wire_query *owq);
+
+/* ---------------------------------------------- */
+/* Bus timing                                     */
+/* ---------------------------------------------- */
+
+/* One adapter round trip with some resets and bit slots */
+/* Bus should be locked */
+void Timed_charge(int resets, size_t bits, const struct parsedname *pn)
+{
+	struct connection_in *in = pn->selected_connection;
+	unsigned long usec = in->master.timed.latency_us;
+
+	if (in->overdrive) {
+		usec += resets * TIMED_RESET_OVERDRIVE + bits * TIMED_SLOT_OVERDRIVE;
+	} else {
+		usec += resets * TIMED_RESET_STANDARD + bits * TIMED_SLOT_STANDARD;
+	}
+	UT_delay_us(usec);
+}
+
+/* Randomly fail a transaction at the configured rate */
+GOOD_OR_BAD Timed_inject_error(const struct parsedname *pn)
+{
+	int percent = pn->selected_connection->master.timed.error_percent;
+
+	if (percent > 0 && (rand() % 100) < percent) {
+		LEVEL_DEBUG("Simulated bus error on %s", SAFESTRING(DEVICENAME(pn->selected_connection)));
+		return gbBAD;
+	}
+	return gbGOOD;
+}
+
+/* Match ROM (or Skip ROM for a single device) */
+static size_t Timed_select_bits(void)
+{
+	return Globals.one_device ? 8 : 8 * (1 + SERIAL_NUMBER_SIZE);
+}
+
+/* Function command plus the data that moves for this property */
+static size_t Timed_data_bits(struct one_wire_query *owq)
+{
+	switch (OWQ_pn(owq).selected_filetype->format) {
+	case ft_binary:
+	case ft_ascii:
+	case ft_vascii:
+	case ft_alias:
+		// memory contents plus CRC16
+		return 8 * (1 + OWQ_size(owq) + 2);
+	default:
+		return 8 * (1 + TIMED_SCRATCHPAD_BYTES);
+	}
+}
+
+/* Temperature and voltage conversions, unless a /simultaneous conversion is still valid */
+static GOOD_OR_BAD Timed_conversion(struct one_wire_query *owq)
+{
+	struct parsedname *pn = PN(owq);
+	struct filetype *ft = pn->selected_filetype;
+	const struct internal_prop *ip;
+	UINT delay;
+
+	if (ft->format == ft_temperature && (ft->change == fc_simultaneous_temperature || ft->change == fc_link)) {
+		int resolution = (ft->data.i >= 9 && ft->data.i <= 12) ? ft->data.i : 12;
+		delay = TIMED_TEMPERATURE_CONVERSION >> (12 - resolution);
+		ip = SlaveSpecificTag(S_T);
+	} else if (ft->change == fc_simultaneous_voltage) {
+		delay = TIMED_VOLTAGE_CONVERSION;
+		ip = SlaveSpecificTag(S_V);
+	} else {
+		return gbGOOD;
+	}
+
+	if (GOOD(FS_Test_Simultaneous(ip, delay, pn))) {
+		// already converted, test waited out any remainder
+		return gbGOOD;
+	}
+
+	BUSLOCK(pn);
+	Timed_charge(1, Timed_select_bits() + 8, pn);
+	if (BAD(Timed_inject_error(pn))) {
+		BUSUNLOCK(pn);
+		return gbBAD;
+	}
+	if (pn->selected_connection->master.timed.parasitic) {
+		// strong pull-up -- no other bus traffic during conversion
+		Timed_charge(0, 8, pn);
+		UT_delay(delay);
+		BUSUNLOCK(pn);
+	} else {
+		// powered -- the bus is free while the device converts
+		BUSUNLOCK(pn);
+		UT_delay(delay);
+	}
+	return gbGOOD;
+}
+
+/* ---------------------------------------------- */
+/* Filesystem callback functions                  */
+/* ---------------------------------------------- */
+
+ZERO_OR_ERROR FS_read_timed(struct one_wire_query *owq)
+{
+	struct parsedname *pn = PN(owq);
+	GOOD_OR_BAD transaction;
+
+	if (BAD(Timed_conversion(owq))) {
+		STAT_ADD1_BUS(e_bus_read_errors, pn->selected_connection);
+		return -EINVAL;
+	}
+
+	BUSLOCK(pn);
+	Timed_charge(1, Timed_select_bits() + Timed_data_bits(owq), pn);
+	transaction = Timed_inject_error(pn);
+	BUSUNLOCK(pn);
+
+	if (BAD(transaction)) {
+		STAT_ADD1_BUS(e_bus_read_errors, pn->selected_connection);
+		return -EINVAL;
+	}
+	return FS_read_fake(owq);
+}
+
+ZERO_OR_ERROR FS_write_timed(struct one_wire_query *owq)
+{
+	struct parsedname *pn = PN(owq);
+	struct filetype *ft = pn->selected_filetype;
+	GOOD_OR_BAD transaction;
+
+	if (ft->write == NO_WRITE_FUNCTION) {
+		return -ENOTSUP;
+	}
+
+	BUSLOCK(pn);
+	Timed_charge(1, Timed_select_bits() + Timed_data_bits(owq), pn);
+	transaction = Timed_inject_error(pn);
+	if (GOOD(transaction)) {
+		// EEPROM copy with strong pull-up
+		if (ft->format == ft_binary) {
+			UT_delay(TIMED_EEPROM_PROGRAM * ((OWQ_size(owq) + TIMED_PAGE_BYTES - 1) / TIMED_PAGE_BYTES));
+		} else if (ft->change == fc_stable) {
+			UT_delay(TIMED_EEPROM_PROGRAM);
+		}
+	}
+	BUSUNLOCK(pn);
+
+	if (BAD(transaction)) {
+		STAT_ADD1_BUS(e_bus_write_errors, pn->selected_connection);
+		return -EINVAL;
+	}
+	return 0;
+}
@@ -16,12 +16,26 @@
 
 static int device_compare(const void *a, const void *b);
 static int file_compare(const void *a, const void *b);
-static void Device2Tree(const struct device *d, enum ePN_type type);
+static void Device2Tree(struct device *d, enum ePN_type type);
+static void Device2Index(struct device *d, enum ePN_type type);
+static int family_index(const char *code);
+static UINT filetype_hash(const char *name, size_t length);
 static void External_Process(void);
 
 struct device *DeviceSimultaneous;
 struct device *DeviceThermostat;
 
+/* Real devices by family code byte, for lookup without the tree */
+/* Built along with the tree, so the same device wins for duplicate codes */
+static struct device *FamilyTable[256];
+
+/* Property name hash for a device (open addressing, at most half full) */
+/* Slots point into the device's filetype_array */
+struct filetype_index {
+	UINT mask;					// number of slots - 1
+	struct filetype **slot;
+};
+
 static int device_compare(const void *a, const void *b)
 {
 	return strcmp(((const struct device *) a)->family_code, ((const struct device *) b)->family_code);
@@ -35,8 +49,69 @@ static int file_compare(const void *a, const void *b)
 void *Tree[ePN_max_type];
 
 
+/* Family code as a table index, or -1 if not written like num2string would */
+static int family_index(const char *code)
+{
+	char ID[] = "XX";
+
+	if (strlen(code) != 2 || !isxdigit((unsigned char) code[0]) || !isxdigit((unsigned char) code[1])) {
+		return -1;
+	}
+	num2string(ID, string2num(code));
+	return (strcmp(ID, code) == 0) ? string2num(code) : -1;
+}
+
+/* FNV-1a */
+static UINT filetype_hash(const char *name, size_t length)
+{
+	uint32_t hash = 2166136261u;
+
+	while (length-- > 0) {
+		hash ^= (BYTE) * name++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/* Add to the family table and hash the (sorted) filetypes */
+static void Device2Index(struct device *d, enum ePN_type type)
+{
+	int family = family_index(d->family_code);
+	UINT slots = 4;
+	struct filetype_index *fti;
+	int i;
+
+	if (type == ePN_real && family >= 0 && FamilyTable[family] == NULL) {
+		FamilyTable[family] = d;
+	}
+
+	if (d->filetype_array == NULL || d->ft_index != NULL) {
+		return;
+	}
+	while (slots < 2 * (UINT) d->count_of_filetypes) {
+		slots <<= 1;
+	}
+	fti = owcalloc(1, sizeof(struct filetype_index) + slots * sizeof(struct filetype *));
+	if (fti == NULL) {
+		// FS_filetype_find falls back to bsearch
+		LEVEL_DATA("Could not allocate property index for device %s", d->readable_name);
+		return;
+	}
+	fti->mask = slots - 1;
+	fti->slot = (struct filetype **) (&fti[1]);	// slots are just beyond the structure
+	for (i = 0; i < d->count_of_filetypes; ++i) {
+		struct filetype *ft = &(d->filetype_array[i]);
+		UINT s = filetype_hash(ft->name, strlen(ft->name)) & fti->mask;
+		while (fti->slot[s] != NULL) {
+			s = (s + 1) & fti->mask;
+		}
+		fti->slot[s] = ft;
+	}
+	d->ft_index = fti;
+}
+
 #ifdef __FreeBSD__
-static void Device2Tree(const struct device *d, enum ePN_type type)
+static void Device2Tree(struct device *d, enum ePN_type type)
 {
 	// FreeBSD fix from Robert Nilsson
 	/*  In order for DeviceDestroy to work on FreeBSD we must copy the keys.
@@ -44,6 +119,7 @@ static void Device2Tree(const struct device *d, enum ePN_type type)
 	*/
 	// Note, I'm not using owmalloc since owfree is probably not calledby FreeBSD's tdestroy //
 	struct device *d_copy ;
+	void *result ;
 	if ((d_copy = (struct device *) malloc(sizeof(struct device)))) {
 		memmove(d_copy, d, sizeof(struct device));
 	} else {
@@ -51,21 +127,32 @@ static void Device2Tree(const struct device *d, enum ePN_type type)
 		return ;
 	}
 	// Add in the device into the appropriate red/black tree
-	tsearch(d_copy, &Tree[type], device_compare);
+	result = tsearch(d_copy, &Tree[type], device_compare);
 	// Sort all the file types alphabetically for search and listing
 	if (d_copy->filetype_array != NULL) {
 		qsort(d_copy->filetype_array, (size_t) d_copy->count_of_filetypes, sizeof(struct filetype), file_compare);
 	}
+	// Only an inserted device is indexed -- DeviceDestroy frees the index by walking the tree
+	if (result != NULL && *(struct device **) result == d_copy) {
+		Device2Index(d_copy, type);
+	} else {
+		// already there (same family code)
+		free(d_copy);
+	}
 }
 #else    /* not FreeBSD */
-static void Device2Tree(const struct device *d, enum ePN_type type)
+static void Device2Tree(struct device *d, enum ePN_type type)
 {
 	// Add in the device into the appropriate red/black tree
-	tsearch(d, &Tree[type], device_compare);
+	void *result = tsearch(d, &Tree[type], device_compare);
 	// Sort all the file types alphabetically for search and listing
 	if (d->filetype_array != NULL) {
 		qsort(d->filetype_array, (size_t) d->count_of_filetypes, sizeof(struct filetype), file_compare);
 	}
+	// Only an inserted device is indexed -- DeviceDestroy frees the index by walking the tree
+	if (result != NULL && *(struct device **) result == d) {
+		Device2Index(d, type);
+	}
 }
 #endif							/* __FreeBSD__ */
 
@@ -76,10 +163,34 @@ static void free_node(void *nodep)
 	return;
 }
 
+static void free_index_action(const void *nodep, const VISIT which, const int depth)
+{
+	struct device *d = *(struct device * const *) nodep;
+	(void) depth;
+
+	switch (which) {
+	case leaf:
+	case postorder:
+		SAFEFREE(d->ft_index);
+	case preorder:
+	case endorder:
+		break;
+	}
+}
+
 void DeviceDestroy(void)
 {
 	UINT i;
 
+	// clear property indexes (before the external devices are freed)
+	for (i = 0; i < (sizeof(Tree) / sizeof(void *)); i++) {
+		if (i != ePN_structure && Tree[i] != NULL) {
+			twalk(Tree[i], free_index_action);
+		}
+	}
+	SAFEFREE(UnknownDevice.ft_index);
+	memset(FamilyTable, 0, sizeof(FamilyTable));
+
 	// clear external trees
 	tdestroy( sensor_tree, owfree_func ) ;
 	tdestroy( family_tree, owfree_func ) ;
@@ -100,9 +211,11 @@ void DeviceDestroy(void)
 void DeviceSort(void)
 {
 	memset(Tree, 0, sizeof(void *) * ePN_max_type);
+	memset(FamilyTable, 0, sizeof(FamilyTable));
 
 	/* Sort the filetypes for the unrecognized device */
 	qsort(UnknownDevice.filetype_array, (size_t) UnknownDevice.count_of_filetypes, sizeof(struct filetype), file_compare);
+	Device2Index(&UnknownDevice, ePN_max_type);
 
 	Device2Tree( & d_Example_slave,  ePN_real);
 
@@ -180,6 +293,8 @@ void DeviceSort(void)
 	Device2Tree( & d_stats_thread,         ePN_statistics);
 	Device2Tree( & d_stats_write,          ePN_statistics);
 	Device2Tree( & d_stats_return_code,    ePN_statistics);
+	Device2Tree( & d_stats_slab,           ePN_statistics);
+	Device2Tree( & d_stats_server_pool,    ePN_statistics);
 
 	Device2Tree( & d_set_timeout,          ePN_settings);
 	Device2Tree( & d_set_units,            ePN_settings);
@@ -218,9 +333,18 @@ void DeviceSort(void)
 struct device * FS_devicefindhex(BYTE f, struct parsedname *pn)
 {
 	char ID[] = "XX";
-	const struct device d = { ID, NULL, 0, 0, NULL, NO_GENERIC_READ, NO_GENERIC_WRITE };
+	const struct device d = { ID, NULL, 0, 0, NULL, NO_GENERIC_READ, NO_GENERIC_WRITE, NULL };
 	struct device_opaque *p;
 
+	if (pn->type == ePN_real || pn->type == ePN_structure) {
+		if (FamilyTable[f] != NULL) {
+			return FamilyTable[f];
+		} else if (FamilyTable[f ^ 0x80] != NULL) {
+			return FamilyTable[f ^ 0x80];
+		}
+		return &UnknownDevice;
+	}
+
 	num2string(ID, f);
 	if ((p = tfind(&d, &Tree[pn->type], device_compare))) {
 		return p->key;
@@ -235,8 +359,16 @@ struct device * FS_devicefindhex(BYTE f, struct parsedname *pn)
 
 void FS_devicefind(const char *code, struct parsedname *pn)
 {
-	const struct device d = { code, NULL, 0, 0, NULL, NO_GENERIC_READ, NO_GENERIC_WRITE };
-	struct device_opaque *p = tfind(&d, &Tree[pn->type], device_compare);
+	const struct device d = { code, NULL, 0, 0, NULL, NO_GENERIC_READ, NO_GENERIC_WRITE, NULL };
+	struct device_opaque *p;
+	int family = family_index(code);
+
+	if (family >= 0 && (pn->type == ePN_real || pn->type == ePN_structure)) {
+		pn->selected_device = (FamilyTable[family] != NULL) ? FamilyTable[family] : &UnknownDevice;
+		return;
+	}
+
+	p = tfind(&d, &Tree[pn->type], device_compare);
 	if (p) {
 		pn->selected_device = p->key;
 	} else {
@@ -244,6 +376,29 @@ void FS_devicefind(const char *code, struct parsedname *pn)
 	}
 }
 
+/* Property by name (length characters, need not be null terminated) */
+struct filetype * FS_filetype_find(const char *name, size_t length, const struct device *pdev)
+{
+	const struct filetype_index *fti = pdev->ft_index;
+	UINT s;
+
+	if (fti == NULL) {
+		// not indexed -- search the sorted array
+		char key[length + 1];
+		memcpy(key, name, length);
+		key[length] = '\0';
+		return bsearch(key, pdev->filetype_array, (size_t) pdev->count_of_filetypes, sizeof(struct filetype), filetype_cmp);
+	}
+
+	for (s = filetype_hash(name, length) & fti->mask; fti->slot[s] != NULL; s = (s + 1) & fti->mask) {
+		const char *ft_name = fti->slot[s]->name;
+		if (strncmp(ft_name, name, length) == 0 && ft_name[length] == '\0') {
+			return fti->slot[s];
+		}
+	}
+	return NO_FILETYPE;
+}
+
 /* Need to lock struct global_namefind_struct since twalk requires global data -- can't pass void pointer */
 /* Except all *_detect routines are done sequentially, not concurrently */
 struct {
@@ -318,7 +473,7 @@ static void External_family_action(const void *nodep, const VISIT which, const i
 		twalk( property_tree, External_propertycopy_action);
 
 		// Finally add to tree
-		Device2Tree( & (p->dev), ePN_real);
+		Device2Tree( & (non_const_f->dev), ePN_real);
 		break ;
 	case preorder:
 	case endorder:
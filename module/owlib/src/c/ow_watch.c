@@ -0,0 +1,262 @@
+/*
+    OW -- One-Wire filesystem
+    version 0.4 7/2/2003
+
+    Written 2003 Paul H Alfille
+    GPL license
+    See the header file: ow.h for full attribution
+    ---------------------------------------------------------------------------
+    Implementation:
+    watch -- tell callers when a property value changes
+*/
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+
+/*
+    FS_watch registers interest in a property. A single sampler thread reads
+    each watched path and calls changefunc for every subscriber when the
+    value (or read error) differs from the previous sample.
+
+    A path is sampled as often as a change could be seen through the cache
+    (Cache_Lifespan), at least every WATCH_INTERVAL_MIN seconds. So an
+    /uncached/ path is read every second and a cached volatile value once
+    per volatile timeout. Several subscribers to one path share its reads.
+
+    The thread runs only while something is watched.
+*/
+
+#define WATCH_INTERVAL_MIN  1		// seconds
+
+struct watch_subscriber {
+	struct watch_subscriber *next;
+	struct watch *watch;
+	void (*changefunc) (void *);
+	void *v;
+};
+
+struct watch {
+	struct watch *next;
+	char *path;
+	time_t interval;
+	time_t next_sample;
+	int sampled;				// read_return and data are valid
+	SIZE_OR_ERROR read_return;
+	BYTE *data;
+	struct watch_subscriber *subscribers;
+};
+
+static pthread_mutex_t watch_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t watch_cond = PTHREAD_COND_INITIALIZER;
+
+#define WATCHLOCK     _MUTEX_LOCK(   watch_mutex )
+#define WATCHUNLOCK   _MUTEX_UNLOCK( watch_mutex )
+#define WATCHSIGNAL   my_pthread_cond_signal( &watch_cond )
+
+static struct watch *watch_list = NULL;
+static int sampler_running = 0;
+static int sampler_again = 0;	// new watch added during a pass
+
+static void *Watch_sampler(void *v);
+static void Watch_sample(const char *path, SIZE_OR_ERROR * read_return, BYTE ** data);
+static void Watch_update(struct watch *w, SIZE_OR_ERROR read_return, BYTE * data);
+static void Watch_free(struct watch *w);
+
+/* Call changefunc(v) from the sampler thread whenever path changes value.
+ * Returns NULL if path is not a readable property.
+ * changefunc must be quick and must not call FS_watch or FS_unwatch */
+struct watch_subscriber *FS_watch(const char *path, void (*changefunc) (void *), void *v)
+{
+	struct parsedname s_pn;
+	struct parsedname *pn = &s_pn;
+	struct watch_subscriber *ws;
+	struct watch *w;
+	time_t interval;
+
+	if (FS_ParsedName(path, pn) != 0) {
+		return NULL;
+	}
+	if (pn->selected_filetype == NO_FILETYPE || IsDir(pn) || pn->selected_filetype->read == NO_READ_FUNCTION) {
+		FS_ParsedName_destroy(pn);
+		return NULL;
+	}
+	interval = Cache_Lifespan(pn);
+	FS_ParsedName_destroy(pn);
+	if (interval < WATCH_INTERVAL_MIN) {
+		interval = WATCH_INTERVAL_MIN;
+	}
+
+	ws = owcalloc(1, sizeof(struct watch_subscriber));
+	if (ws == NULL) {
+		return NULL;
+	}
+	ws->changefunc = changefunc;
+	ws->v = v;
+
+	WATCHLOCK;
+	for (w = watch_list; w != NULL; w = w->next) {
+		if (strcmp(w->path, path) == 0) {
+			break;
+		}
+	}
+	if (w == NULL) {
+		w = owcalloc(1, sizeof(struct watch));
+		if (w == NULL || (w->path = owstrdup(path)) == NULL) {
+			WATCHUNLOCK;
+			SAFEFREE(w);
+			owfree(ws);
+			return NULL;
+		}
+		w->interval = interval;
+		w->next = watch_list;
+		watch_list = w;
+		LEVEL_DEBUG("New watch %s every %d seconds", path, (int) interval);
+	}
+	ws->watch = w;
+	ws->next = w->subscribers;
+	w->subscribers = ws;
+	sampler_again = 1;
+
+	if (!sampler_running) {
+		pthread_t thread;
+		if (pthread_create(&thread, DEFAULT_THREAD_ATTR, Watch_sampler, NULL) == 0) {
+			sampler_running = 1;
+		} else {
+			LEVEL_DEFAULT("Cannot start the watch sampler");
+		}
+	}
+	WATCHSIGNAL;
+	WATCHUNLOCK;
+	return ws;
+}
+
+/* No more callbacks once this returns */
+void FS_unwatch(struct watch_subscriber *ws)
+{
+	struct watch_subscriber **link;
+
+	if (ws == NULL) {
+		return;
+	}
+	WATCHLOCK;
+	for (link = &ws->watch->subscribers; *link != NULL; link = &(*link)->next) {
+		if (*link == ws) {
+			*link = ws->next;
+			break;
+		}
+	}
+	// an empty watch is removed by the sampler
+	WATCHUNLOCK;
+	owfree(ws);
+}
+
+/* The one thread reading watched paths */
+static void *Watch_sampler(void *v)
+{
+	(void) v;
+	DETACH_THREAD;
+
+	WATCHLOCK;
+	while (watch_list != NULL) {
+		struct watch **link = &watch_list;
+		time_t next_wake = NOW_TIME + 60;
+		struct timespec until;
+
+		while (*link != NULL) {
+			struct watch *w = *link;
+
+			if (w->subscribers == NULL) {
+				// last subscriber gone
+				LEVEL_DEBUG("End watch %s", w->path);
+				*link = w->next;
+				Watch_free(w);
+				continue;
+			}
+
+			if (w->next_sample <= NOW_TIME) {
+				SIZE_OR_ERROR read_return;
+				BYTE *data;
+
+				// only this thread changes or removes watches, so w stays valid
+				WATCHUNLOCK;
+				Watch_sample(w->path, &read_return, &data);
+				WATCHLOCK;
+				Watch_update(w, read_return, data);
+				w->next_sample = NOW_TIME + w->interval;
+			}
+			if (w->next_sample < next_wake) {
+				next_wake = w->next_sample;
+			}
+			link = &w->next;
+		}
+
+		if (sampler_again) {
+			sampler_again = 0;
+		} else if (watch_list != NULL && next_wake > NOW_TIME) {
+			until.tv_sec = next_wake;
+			until.tv_nsec = 0;
+			// new watches signal; timeout is the normal case
+			pthread_cond_timedwait(&watch_cond, &watch_mutex, &until);
+		}
+	}
+	sampler_running = 0;
+	WATCHUNLOCK;
+	return VOID_RETURN;
+}
+
+/* Read the current value (no lock held) */
+static void Watch_sample(const char *path, SIZE_OR_ERROR * read_return, BYTE ** data)
+{
+	struct one_wire_query *owq = OWQ_create_from_path(path);
+
+	*data = NULL;
+	if (owq == NO_ONE_WIRE_QUERY) {
+		*read_return = -ENOENT;
+		return;
+	}
+	if (BAD(OWQ_allocate_read_buffer(owq))) {
+		*read_return = -ENOMEM;
+	} else {
+		*read_return = FS_read_postparse(owq);
+		if (*read_return > 0) {
+			*data = owmalloc(*read_return);
+			if (*data == NULL) {
+				*read_return = -ENOMEM;
+			} else {
+				memcpy(*data, OWQ_buffer(owq), *read_return);
+			}
+		}
+	}
+	OWQ_destroy(owq);
+}
+
+/* Compare with the last sample and tell the subscribers if it changed */
+static void Watch_update(struct watch *w, SIZE_OR_ERROR read_return, BYTE * data)
+{
+	struct watch_subscriber *ws;
+
+	if (w->sampled && read_return == w->read_return && (read_return <= 0 || memcmp(data, w->data, read_return) == 0)) {
+		SAFEFREE(data);
+		return;
+	}
+	SAFEFREE(w->data);
+	w->read_return = read_return;
+	w->data = data;
+	if (!w->sampled) {
+		// first sample is the starting point
+		w->sampled = 1;
+		return;
+	}
+	LEVEL_DEBUG("Watched %s changed", w->path);
+	for (ws = w->subscribers; ws != NULL; ws = ws->next) {
+		ws->changefunc(ws->v);
+	}
+}
+
+static void Watch_free(struct watch *w)
+{
+	SAFEFREE(w->data);
+	owfree(w->path);
+	owfree(w);
+}
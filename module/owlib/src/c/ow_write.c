@@ -210,6 +210,8 @@ static ZERO_OR_ERROR FS_write_real(int depth, struct one_wire_query *owq)
 		case bus_fake:
 		case bus_tester:
 			return ( ft->write == NO_WRITE_FUNCTION ) ? -ENOTSUP : 0 ;
+		case bus_timed:
+			return FS_write_timed(owq) ;
 		default:
 			// non-virtual devices get handled below
 			break ;
@@ -138,7 +138,10 @@ static ZERO_OR_ERROR OW_script_write( FILE * script_f, struct one_wire_query * o
 {
 	size_t fr_return ;
 
-	int po_return = OWQ_parse_output(owq) ; // load data in buffer
+	int po_return ;
+
+	PN(owq)->control_flags &= ~BINARY_VALUE ; // scripts always get text
+	po_return = OWQ_parse_output(owq) ; // load data in buffer
 	
 	if ( po_return < 0 ) {
 		return -EINVAL ;
@@ -255,6 +255,10 @@ static GOOD_OR_BAD SetupSingleInboundConnection( struct port_in * pin )
 		Mock_detect(pin);	// never fails
 		break;
 
+	case bus_timed:
+		Timed_detect(pin);	// never fails
+		break;
+
 	case bus_w1_monitor:
 		RETURN_BAD_IF_BAD( W1_monitor_detect(pin) ) ;
 		break;
@@ -274,6 +274,12 @@ time_t timegm(struct tm *tm);
 /* memory blob used for bundled transactions */
 #include "ow_memblob.h"
 
+/* per-request memory arena */
+#include "ow_memarena.h"
+
+/* fixed size object pools */
+#include "ow_slab.h"
+
 /* We use our own read-write locks */
 #include "rwlock.h"
 /* Many mutexes separated out for readability */
@@ -351,6 +357,9 @@ struct connection_out;
   holds name, flags, values, and path */
 #include "ow_onewirequery.h"
 
+/* Raw (unformatted) values for the BINARY_VALUE flag */
+#include "ow_binaryvalue.h"
+
 /* Delay for clearing buffer */
 #define    WASTE_TIME    (2)
 
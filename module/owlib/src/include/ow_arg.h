@@ -63,6 +63,7 @@ GOOD_OR_BAD ARG_Xport(const char *arg);
 GOOD_OR_BAD ARG_Fake(const char *arg);
 GOOD_OR_BAD ARG_Tester(const char *arg);
 GOOD_OR_BAD ARG_Mock(const char *arg);
+GOOD_OR_BAD ARG_Timed(const char *arg);
 GOOD_OR_BAD ARG_Link(const char *arg);
 GOOD_OR_BAD ARG_W1_monitor(void);
 GOOD_OR_BAD ARG_MasterHub(const char *arg);
@@ -0,0 +1,52 @@
+/*
+    OW -- One-Wire filesystem
+    version 0.4 7/2/2003
+
+    Written 2003 Paul H Alfille
+    GPL license
+    See the header file: ow.h for full attribution
+    ---------------------------------------------------------------------------
+    Implementation:
+    binaryvalue -- raw property values for owserver clients
+*/
+
+#ifndef OW_BINARYVALUE_H			/* tedious wrapper */
+#define OW_BINARYVALUE_H
+
+/*
+With the BINARY_VALUE control flag a read of a numeric property
+returns the value itself instead of text. All little-endian:
+
+  byte 0      BINARY_VALUE_MAGIC
+  byte 1      type tag (enum binary_value_type)
+  bytes 2-3   number of elements (1, or the array size for .ALL)
+  elements    integer   int32
+              unsigned  uint32 (also .BYTE)
+              float     IEEE 754 double, already in the requested
+                        temperature / pressure scale
+              yesno     uint8 0 or 1
+              date      int64 seconds since the epoch
+
+ascii, binary and structure properties are never formatted and are
+returned unchanged -- owserver clears the flag in the reply for them.
+Binary values are always read whole (offset 0).
+*/
+
+#define BINARY_VALUE_MAGIC   0xB7
+#define BINARY_VALUE_HEADER  4
+
+enum binary_value_type {
+	bv_none = 0,
+	bv_integer = 'i',
+	bv_unsigned = 'u',
+	bv_float = 'f',
+	bv_yesno = 'y',
+	bv_date = 'd',
+};
+
+enum binary_value_type BinaryValueType(const struct parsedname *pn);
+size_t BinaryValueElementSize(enum binary_value_type type);
+size_t BinaryValueLength(const struct parsedname *pn);
+GOOD_OR_BAD BinaryValueDecode(const BYTE * data, size_t length, size_t index, _FLOAT * value);
+
+#endif							/* OW_BINARYVALUE_H */
@@ -65,6 +65,7 @@ GOOD_OR_BAD Cache_Add_SlaveSpecific(const void *data, const size_t datasize, con
 GOOD_OR_BAD Cache_Add_Alias(const ASCII *name, const BYTE * sn) ;
 GOOD_OR_BAD Cache_Add_Simul(const struct internal_prop *ip, const struct parsedname *pn);
 void Cache_Add_Alias_Bus(const ASCII * alias_name, INDEX_OR_ERROR bus);
+GOOD_OR_BAD Cache_Add_ParsedName(uint32_t control_flags, const struct parsedname *pn);
 
 GOOD_OR_BAD OWQ_Cache_Get(struct one_wire_query *owq);
 GOOD_OR_BAD Cache_Get(void *data, size_t * dsize, const struct parsedname *pn);
@@ -75,6 +76,11 @@ ASCII * Cache_Get_Alias(const BYTE * sn) ;
 GOOD_OR_BAD Cache_Get_Simul_Time(const struct internal_prop *ip, time_t * dwell_time, const struct parsedname * pn);
 INDEX_OR_ERROR Cache_Get_Alias_Bus(const ASCII * alias_name) ;
 GOOD_OR_BAD Cache_Get_Alias_SN(const ASCII * alias_name, BYTE * sn );
+GOOD_OR_BAD Cache_Get_ParsedName(uint32_t control_flags, struct parsedname *pn);
+time_t Cache_Remaining(const struct parsedname *pn);
+time_t Cache_Lifespan(const struct parsedname *pn);
+UINT Cache_ParsedName_Generation(void);
+time_t Cache_ParsedName_Lifespan(void);
 
 void OWQ_Cache_Del(struct one_wire_query *owq);
 void OWQ_Cache_Del_ALL(struct one_wire_query *owq);
@@ -89,6 +95,7 @@ void Cache_Del_Mixed_Aggregate(const struct parsedname *pn);
 void Cache_Del_Mixed_Individual(const struct parsedname *pn);
 void Cache_Del_Alias_Bus(const ASCII * alias_name);
 void Cache_Del_Alias(const BYTE * sn);
+void Cache_Del_ParsedName(void);
 
 void Aliaslist( struct memblob * mb  ) ;
 
@@ -143,6 +143,10 @@ See: http://www.iana.org/assignments/port-numbers
  * returned very strange result on c->busmode before... but not anymore */
 int BusIsServer(struct connection_in *in);
 
+/* idle persistent connections to a remote owserver (ow_server_message.c) */
+void Server_pool_seed(struct connection_in *in);
+void Server_pool_clear(struct connection_in *in);
+
 // mode bit flags for level
 #define MODE_NORMAL                    0x00
 #define MODE_STRONG5                   0x01
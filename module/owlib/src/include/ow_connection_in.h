@@ -77,6 +77,7 @@ enum adapter_type {
 	adapter_pbm,
 	adapter_ds1wm,
 	adapter_k1wm,
+	adapter_timed,
 };
 
 enum e_reconnect {
@@ -134,6 +135,7 @@ struct connection_in {
 	pthread_mutex_t bus_mutex;
 	pthread_mutex_t dev_mutex;
 	void *dev_db;				// dev-lock tree
+	struct slab_pool dev_slab;	// dev-locks in the tree
 	enum e_reconnect reconnect_state;
 	struct timeval last_lock;	/* statistics */
 
@@ -180,6 +182,7 @@ extern struct inbound_control {
 	int next_fake ; // count of fake buses
 	int next_tester ; // count tester buses
 	int next_mock ; // count mock buses
+	int next_timed ; // count timed buses
 
 	struct connection_in * w1_monitor ;
 	struct connection_in * external ;
@@ -75,6 +75,15 @@ struct directory {
 	UINT entries;
 };
 
+/* persistent connections to remote owservers (ow_server_message.c) */
+struct server_pool_stats {
+	UINT connections;			// new connections made
+	UINT reused;				// requests on an idle connection
+	UINT stale;					// idle connections found closed or too old
+	UINT overflow;				// closed since the pool was full
+	UINT idle;					// currently idle (all servers)
+};
+
 #define AVERAGE_IN(pA)  ++(pA)->current; ++(pA)->count; (pA)->sum+=(pA)->current; if ((pA)->current>(pA)->max)++(pA)->max;
 #define AVERAGE_OUT(pA) --(pA)->current;
 #define AVERAGE_MARK(pA)  ++(pA)->count; (pA)->sum+=(pA)->current;
@@ -90,6 +99,15 @@ extern struct cache_stats cache_int;
 extern struct cache_stats cache_dir;
 extern struct cache_stats cache_dev;
 extern struct cache_stats cache_pst;
+extern struct cache_stats cache_pn;
+
+extern struct slab_stats slab_cache_64;
+extern struct slab_stats slab_cache_128;
+extern struct slab_stats slab_cache_256;
+extern struct slab_stats slab_cache_512;
+extern struct slab_stats slab_devlock;
+
+extern struct server_pool_stats server_pool;
 
 extern UINT read_calls;
 extern UINT read_cache;
@@ -44,6 +44,7 @@
 /* --------------------------------------------------------- */
 /* Predeclare struct filetype */
 struct filetype;
+struct filetype_index;
 
 /* -------------------------------- */
 /* Devices -- types of 1-wire chips */
@@ -82,6 +83,7 @@ struct device {
 	struct filetype *filetype_array;
 	struct generic_read * g_read ;
 	struct generic_write * g_write ;
+	struct filetype_index * ft_index ; // property name hash, built by DeviceSort
 };
 
 #define DeviceHeader( chip )    extern struct device d_##chip
@@ -91,8 +93,8 @@ struct device {
    filetype arrays aren;t defined at this point */
 #define COUNT_OF_FILETYPES(filetype_array) ((int)(sizeof(filetype_array)/sizeof(struct filetype)))
 
-#define DeviceEntryExtended( code , chip , flags, gread, gwrite )  struct device d_##chip = {#code,#chip,flags,COUNT_OF_FILETYPES(chip),chip,gread,gwrite}
-#define DeviceEntryExtendedSecondary( code , chip , flags, gread, gwrite )  struct device d_##chip##_##code = {#code,#chip,flags,COUNT_OF_FILETYPES(chip),chip,gread,gwrite}
+#define DeviceEntryExtended( code , chip , flags, gread, gwrite )  struct device d_##chip = {#code,#chip,flags,COUNT_OF_FILETYPES(chip),chip,gread,gwrite,NULL}
+#define DeviceEntryExtendedSecondary( code , chip , flags, gread, gwrite )  struct device d_##chip##_##code = {#code,#chip,flags,COUNT_OF_FILETYPES(chip),chip,gread,gwrite,NULL}
 
 #define DeviceEntry( code , chip, gread, gwrite )  DeviceEntryExtended( code, chip, 0, gread, gwrite )
 
@@ -69,6 +69,7 @@ ZERO_OR_ERROR FS_ParsedName(const char *fn, struct parsedname *pn);
 ZERO_OR_ERROR FS_ParsedName_BackFromRemote(const char *fn, struct parsedname *pn);
 void FS_ParsedName_destroy(struct parsedname *pn);
 void FS_ParsedName_Placeholder( struct parsedname * pn ) ;
+ZERO_OR_ERROR FS_ParsedName_Sibling(const char *sibling, const struct parsedname *pn_original, struct parsedname *pn);
 
 size_t FileLength(const struct parsedname *pn);
 size_t FullFileLength(const struct parsedname *pn);
@@ -78,6 +79,7 @@ INDEX_OR_ERROR RemoteAlias(struct parsedname *pn);
 void FS_devicename(char *buffer, const size_t length, const BYTE * sn, const struct parsedname *pn);
 void FS_devicefind(const char *code, struct parsedname *pn);
 struct device * FS_devicefindhex(BYTE f, struct parsedname *pn);
+struct filetype * FS_filetype_find(const char *name, size_t length, const struct device *pdev);
 
 const char *FS_DirName(const struct parsedname *pn);
 
@@ -121,6 +123,8 @@ GOOD_OR_BAD FS_Test_Simultaneous( const struct internal_prop *ip, UINT delay, co
 void LockSetup(void);
 ZERO_OR_ERROR DeviceLockGet(struct parsedname *pn);
 void DeviceLockRelease(struct parsedname *pn);
+void DeviceLockTreeInit(struct connection_in *in);
+void DeviceLockTreeDestroy(struct connection_in *in);
 
 /* 1-wire lowlevel */
 void UT_delay(const UINT len);
@@ -160,6 +164,12 @@ ZERO_OR_ERROR ServerDir(void (*dirfunc) (void *, const struct parsedname *), voi
 ZERO_OR_ERROR FS_dir(void (*dirfunc) (void *, const struct parsedname *), void *v, struct parsedname *pn);
 ZERO_OR_ERROR FS_dir_remote(void (*dirfunc) (void *, const struct parsedname *), void *v, const struct parsedname *pn, uint32_t * flags);
 void FS_dir_entry_aliased(void (*dirfunc) (void *, const struct parsedname *), void *v, const struct parsedname *pn) ;
+ZERO_OR_ERROR FS_snapshot(void (*chunkfunc) (void *, const char *, size_t), void *v, const struct parsedname *pn);
+void JSON_string(struct memblob *mb, const char *text, size_t length);
+void JSON_hex(struct memblob *mb, const BYTE *data, size_t length);
+struct watch_subscriber;
+struct watch_subscriber *FS_watch(const char *path, void (*changefunc) (void *), void *v);
+void FS_unwatch(struct watch_subscriber *ws);
 
 SIZE_OR_ERROR FS_write(const char *path, const char *buf, const size_t size, const off_t offset);
 SIZE_OR_ERROR FS_write_postparse(struct one_wire_query *owq);
@@ -169,8 +179,26 @@ SIZE_OR_ERROR FS_get(const char *path, char **return_buffer, size_t * buffer_len
 
 SIZE_OR_ERROR FS_read(const char *path, char *buf, const size_t size, const off_t offset);
 SIZE_OR_ERROR FS_read_postparse(struct one_wire_query *owq);
+
+/* one of a list for FS_read_many, read straight into buffer */
+struct many_read {
+	const char *path;
+	char *buffer;				// NULL -- FS_read_many owmallocs one for the whole value, the caller frees it
+	size_t size;
+	off_t offset;
+	SIZE_OR_ERROR read_return;	// length read, or -errno
+	int binary;					// set if the value is binary (ft_binary)
+};
+void FS_read_many(struct many_read *reads, int nreads);
+int FS_simultaneous_wanted(const struct parsedname *pn);
+void FS_simultaneous_start(struct connection_in *in, int wanted);
+
 ZERO_OR_ERROR FS_read_fake(struct one_wire_query *owq);
 ZERO_OR_ERROR FS_read_tester(struct one_wire_query *owq);
+ZERO_OR_ERROR FS_read_timed(struct one_wire_query *owq);
+ZERO_OR_ERROR FS_write_timed(struct one_wire_query *owq);
+void Timed_charge(int resets, size_t bits, const struct parsedname *pn);
+GOOD_OR_BAD Timed_inject_error(const struct parsedname *pn);
 ZERO_OR_ERROR FS_r_aggregate_all(struct one_wire_query *owq);
 SIZE_OR_ERROR FS_read_local( struct one_wire_query *owq);
 
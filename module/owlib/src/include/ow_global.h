@@ -99,6 +99,8 @@ struct global {
 	ASCII *fatal_debug_file;
 	int readonly;
 	int max_clients;			// for ftp
+	int http_workers;			// owhttpd threads building pages
+	int ftp_workers;			// owftpd threads running commands
 	size_t cache_size;			// max cache size (or 0 for no max) ;
 	int one_device;				// Single device, use faster ROM comands
 	/* Special parameter to trigger William Robison <ibutton@n952.dyndns.ws> timings */
@@ -117,6 +119,7 @@ struct global {
 	int timeout_network;
 	int timeout_server;
 	int timeout_ftp;
+	int timeout_http;
 	int timeout_ha7;
 	int timeout_w1;
 	int timeout_persistent_low;
@@ -137,6 +140,9 @@ struct global {
 	int locks ; // show mutexes
 	_FLOAT templow ;
 	_FLOAT temphigh ;
+	unsigned long timed_latency ; // simulated adapter round trip (usec)
+	int timed_errors ; // simulated transaction failure (percent)
+	int timed_parasitic ; // simulated devices use strong pull-up
 #if OW_USB
 	libusb_context * luc ;
 #endif /* OW_USB */
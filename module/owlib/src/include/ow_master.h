@@ -25,11 +25,19 @@
 
 /* included in ow_connection.h as the bus-master specific portion of the connection_in structure */
 
+/* idle persistent connections kept for each remote owserver */
+#define SERVER_POOL_SIZE  8
+
 struct master_server {
 	char *type;					// for zeroconf
 	char *domain;				// for zeroconf
 	char *name;					// zeroconf name
 	int no_dirall;				// flag that server doesn't support DIRALL
+
+	// persistent connections not in use, under the bus lock
+	FILE_DESCRIPTOR_OR_ERROR pool[SERVER_POOL_SIZE];
+	time_t pool_time[SERVER_POOL_SIZE];	// when put back
+	int pool_count;
 } ;
 
 struct master_serial {
@@ -42,6 +50,11 @@ struct master_fake {
 	_FLOAT templow;
 	_FLOAT temphigh;
 
+	// For the "timed" adapter only -- bus timing model
+	unsigned long latency_us;   /* adapter round trip (serial, usb, network) */
+	int error_percent;          /* injected transaction failures */
+	int parasitic;              /* conversions need strong pull-up */
+
 	// For adapters that maintain dir-at-once (or dirgulp):
 	struct dirblob main;        /* main directory */
 	struct dirblob alarm;       /* alarm directory */
@@ -214,6 +227,7 @@ union master_union {
 	struct master_fake fake;
 	struct master_fake tester;
 	struct master_fake mock;
+	struct master_fake timed;
 	struct master_enet enet;
 	struct master_enet_monitor enet_monitor ;
 	struct master_ha5 ha5;
@@ -0,0 +1,49 @@
+/*
+    OW -- One-Wire filesystem
+    version 0.4 7/2/2003
+
+    Written 2003 Paul H Alfille
+    GPL license
+    See the header file: ow.h for full attribution
+    ---------------------------------------------------------------------------
+    Implementation:
+    memarena -- per-request bump allocator
+*/
+
+#ifndef OW_MEMARENA_H			/* tedious wrapper */
+#define OW_MEMARENA_H
+
+/*
+A memarena hands out memory for the lifetime of one request
+(one owserver message). Allocations are carved sequentially
+from chunks and all released at once by MemarenaReset.
+
+Allocations too large for a chunk come from the heap.
+Every allocation is tagged, so MemarenaFree is correct from
+any thread and for either origin (arena memory is a no-op).
+
+The arena used by MemarenaMalloc is per-thread, chosen with
+MemarenaSelect. With no arena selected it is plain owmalloc.
+*/
+
+#define MEMARENA_CHUNK_SIZE  (16*1024)
+#define MEMARENA_MAX_ALLOC   ( 4*1024)
+
+struct memarena_chunk ;
+
+struct memarena {
+	struct memarena_chunk * chunk ; // current chunk (head of list)
+	size_t allocated ; // bytes handed out since reset
+};
+
+void MemarenaInit(struct memarena *ma);
+void MemarenaReset(struct memarena *ma);
+void MemarenaClear(struct memarena *ma);
+void MemarenaSelect(struct memarena *ma);
+
+void *MemarenaAlloc(struct memarena *ma, size_t size);
+void *MemarenaMalloc(size_t size);
+char *MemarenaStrdup(const char * s);
+void MemarenaFree(void * ptr);
+
+#endif							/* OW_MEMARENA_H */
@@ -60,19 +60,22 @@ enum e_long_option { e_error_print = 257, e_error_level, e_debug,
 	e_cache_size,
 	e_fuse_opt, e_fuse_open_opt,
 	e_max_clients,
+	e_http_workers,
+	e_ftp_workers,
 	e_safemode,
-	e_ha7, e_fake, e_link, e_ha3, e_ha4b, e_ha5, e_ha7e, e_tester, e_mock, e_etherweather, e_passive, e_i2c, e_xport, 
+	e_ha7, e_fake, e_link, e_ha3, e_ha4b, e_ha5, e_ha7e, e_tester, e_mock, e_timed, e_etherweather, e_passive, e_i2c, e_xport, 
 	e_enet, e_pbm, e_masterhub, e_ds1wm, e_k1wm,
 	e_want_background, e_want_foreground,
 	e_w1_monitor, e_browse,
 	e_pressure_mbar, e_pressure_atm, e_pressure_mmhg, e_pressure_inhg, e_pressure_psi, e_pressure_Pa, e_pressure_6, e_pressure_7,
 	e_announce,
 	e_timeout_volatile, e_timeout_stable, e_timeout_directory, e_timeout_presence,
-	e_timeout_serial, e_timeout_usb, e_timeout_network, e_timeout_server, e_timeout_ftp, e_timeout_ha7, e_timeout_w1,
+	e_timeout_serial, e_timeout_usb, e_timeout_network, e_timeout_server, e_timeout_ftp, e_timeout_http, e_timeout_ha7, e_timeout_w1,
 	e_timeout_persistent_low, e_timeout_persistent_high, e_clients_persistent_low, e_clients_persistent_high,
 	e_fatal_debug_file,
 	e_baud,
 	e_templow, e_temphigh,
+	e_timed_latency, e_timed_errors,
 	e_detail,
 };
 
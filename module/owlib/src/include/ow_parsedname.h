@@ -64,6 +64,10 @@ ds2409_hubs and ds2409_depth interpret the route through
 filetype and extension correspond to property
   (filetype) details
 subdir points to in-device groupings
+path and path_to_server are stored out-of-line in a single
+  allocation owned by the parsedname that was parsed.
+  Shallow copies share it (read only) and must not be
+  destroyed or outlive the original.
 */
 
 #define NO_PARSEDNAME NULL
@@ -126,8 +130,9 @@ enum ePS_state {
 };
 
 struct parsedname {
-	char path[2*PATH_MAX+2];				// full device name
-	char path_to_server[PATH_MAX+2];			// path without first bus
+	char * path;				// full device name
+	char * path_to_server;			// path without first bus (same allocation as path)
+	size_t path_length ;			// strlen(path)
 	char * device_name ;		// for external name
 	struct connection_in *known_bus;	// where this device is located
 	enum ePN_type type;			// real? settings? ...
@@ -158,6 +163,7 @@ struct parsedname {
 #define SAFEMODE                    ( (UINT) 0x00000010 )
 #define UNCACHED                    ( (UINT) 0x00000020 )
 #define TRIM                        ( (UINT) 0x00000040 )
+#define BINARY_VALUE                ( (UINT) 0x00000080 )
 #define OWNET                       ( (UINT) 0x00000100 )
 #define TEMPSCALE_MASK              ( (UINT) 0x00030000 )
 #define TEMPSCALE_BIT      16
@@ -193,6 +199,7 @@ struct parsedname {
 #define     InSafeMode(pn)    ( (((pn)->control_flags) & SAFEMODE ) != 0 )
 
 #define     ShouldTrim(pn)    ( (((pn)->control_flags) & TRIM ) != 0 )
+#define ShouldReturnBinary(pn)    ( (((pn)->control_flags) & BINARY_VALUE ) != 0 )
 
 #define KnownBus(pn)          ((((pn)->state) & ePS_bus) != 0 )
 #define UnsetKnownBus(pn)           do { (pn)->state &= ~ePS_bus; \
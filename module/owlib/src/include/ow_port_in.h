@@ -58,6 +58,7 @@ enum bus_mode {
 	bus_external,
 	bus_ds1wm,
 	bus_k1wm,
+	bus_timed,
 };
 
 enum com_state {
@@ -0,0 +1,56 @@
+/*
+    OW -- One-Wire filesystem
+    version 0.4 7/2/2003
+
+    Written 2003 Paul H Alfille
+    GPL license
+    See the header file: ow.h for full attribution
+    ---------------------------------------------------------------------------
+    Implementation:
+    slab -- fixed size object pools
+*/
+
+#ifndef OW_SLAB_H			/* tedious wrapper */
+#define OW_SLAB_H
+
+/*
+A slab pool hands out objects of one size, carved from blocks
+of many objects. Freed objects go on a free list for reuse.
+SlabClear releases every block at once (e.g. a retired cache tree).
+
+No locking inside -- the owner serializes access to a pool
+(cache lock, per-bus device tree lock).
+Statistics are shared between pools of the same class,
+and updated atomically.
+*/
+
+#define SLAB_BLOCK_SIZE  4096
+
+struct slab_stats {
+	UINT blocks;		// blocks currently allocated
+	UINT in_use;		// objects handed out and not freed
+	UINT max;			// highest in_use
+	UINT allocations;
+	UINT frees;
+};
+
+struct slab_block ;
+
+struct slab_pool {
+	size_t size ;		// object size (aligned)
+	UINT per_block ;	// objects per block
+	UINT in_use ;		// this pool's share of stats->in_use
+	void * free_list ;
+	struct slab_block * blocks ;
+	struct slab_stats * stats ;
+};
+
+void SlabInit(struct slab_pool *sp, size_t size, struct slab_stats *stats);
+void *SlabAlloc(struct slab_pool *sp);
+void SlabFree(struct slab_pool *sp, void *object);
+void SlabClear(struct slab_pool *sp);
+
+/* free function for tdestroy of a tree whose pool is cleared with SlabClear */
+void SlabTreeKeep(void *object);
+
+#endif							/* OW_SLAB_H */
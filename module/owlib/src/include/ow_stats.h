@@ -24,5 +24,7 @@ DeviceHeader(stats_directory);
 DeviceHeader(stats_errors);
 DeviceHeader(stats_thread);
 DeviceHeader(stats_return_code);
+DeviceHeader(stats_slab);
+DeviceHeader(stats_server_pool);
 
 #endif							/* OW_STATS */
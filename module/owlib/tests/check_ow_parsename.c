@@ -0,0 +1,184 @@
+#include "ow_testhelper.h"
+
+// Fake LCD device (ow_lcd.c)
+#define LCD_ADDR "FF.AAAAAA000000"
+static void add_lcd_device() {
+	const BYTE addr[] = {0xFF,0xAA,0xAA,0xAA,0x00,0x00,0x00,0xA9};
+	ck_assert_int_eq(gbGOOD, Cache_Add_Device(0, addr));
+}
+
+static struct parsedname s_pn;
+static struct parsedname *pn = &s_pn;
+
+// Parse a path that should be accepted, leaving it in pn
+static void parse_good(const char *path) {
+	ck_assert_int_eq(0, FS_ParsedName(path, pn));
+}
+
+// Parse a path that should be rejected
+static void parse_bad(const char *path) {
+	ck_assert_int_ne(0, FS_ParsedName(path, pn));
+}
+
+
+// Top level keywords are case-insensitive
+START_TEST(test_FS_ParsedName_keywords)
+{
+	parse_good("/settings");
+	ck_assert_int_eq(ePN_settings, pn->type);
+	FS_ParsedName_destroy(pn);
+
+	parse_good("/STATISTICS");
+	ck_assert_int_eq(ePN_statistics, pn->type);
+	FS_ParsedName_destroy(pn);
+
+	parse_good("/Structure");
+	ck_assert_int_eq(ePN_structure, pn->type);
+	FS_ParsedName_destroy(pn);
+
+	parse_good("/system");
+	ck_assert_int_eq(ePN_system, pn->type);
+	FS_ParsedName_destroy(pn);
+}
+END_TEST
+
+// State prefixes can be combined
+START_TEST(test_FS_ParsedName_state)
+{
+	parse_good("/uncached/text/settings");
+	ck_assert(pn->state & ePS_uncached);
+	ck_assert(pn->state & ePS_text);
+	ck_assert_int_eq(ePN_settings, pn->type);
+	FS_ParsedName_destroy(pn);
+
+	parse_good("/json/unaliased");
+	ck_assert(pn->state & ePS_json);
+	ck_assert(pn->state & ePS_unaliased);
+	FS_ParsedName_destroy(pn);
+
+	parse_good("/alarm");
+	ck_assert(pn->state & ePS_alarm);
+	FS_ParsedName_destroy(pn);
+}
+END_TEST
+
+// Bus entries need a bus, and /interface needs a bus entry
+START_TEST(test_FS_ParsedName_bus)
+{
+	parse_bad("/bus.");
+	parse_bad("/bus.0");
+	parse_bad("/interface");
+}
+END_TEST
+
+// Extensions on an aggregate property
+START_TEST(test_FS_ParsedName_extension)
+{
+	add_lcd_device();
+
+	parse_good("/" LCD_ADDR "/line20.3");
+	ck_assert_int_eq(3, pn->extension);
+	ck_assert_str_eq("line20", pn->selected_filetype->name);
+	FS_ParsedName_destroy(pn);
+
+	parse_good("/" LCD_ADDR "/line20.ALL");
+	ck_assert_int_eq(EXTENSION_ALL, pn->extension);
+	FS_ParsedName_destroy(pn);
+
+	parse_good("/" LCD_ADDR "/line20.all");
+	ck_assert_int_eq(EXTENSION_ALL, pn->extension);
+	FS_ParsedName_destroy(pn);
+
+	parse_bad("/" LCD_ADDR "/line20");
+	parse_bad("/" LCD_ADDR "/line20.");
+	parse_bad("/" LCD_ADDR "/line20.4");
+	parse_bad("/" LCD_ADDR "/line20.A");
+	parse_bad("/" LCD_ADDR "/line20.BYTE");
+}
+END_TEST
+
+// Letter and BYTE extensions, using the structure directory (no device needed)
+START_TEST(test_FS_ParsedName_letter)
+{
+	parse_good("/structure/1D/counter.B");
+	ck_assert_int_eq(1, pn->extension);
+	FS_ParsedName_destroy(pn);
+
+	parse_good("/structure/1D/counter.a");
+	ck_assert_int_eq(0, pn->extension);
+	FS_ParsedName_destroy(pn);
+
+	parse_good("/structure/3A/PIO.BYTE");
+	ck_assert_int_eq(EXTENSION_BYTE, pn->extension);
+	FS_ParsedName_destroy(pn);
+
+	parse_bad("/structure/1D/counter.C");
+	parse_bad("/structure/1D/counter.AB");
+	parse_bad("/structure/1D/counter.0");
+}
+END_TEST
+
+// Properties in a subdirectory
+START_TEST(test_FS_ParsedName_subdir)
+{
+	parse_good("/structure/1D/pages/page.0");
+	ck_assert_int_eq(0, pn->extension);
+	ck_assert_str_eq("pages/page", pn->selected_filetype->name);
+	FS_ParsedName_destroy(pn);
+
+	parse_bad("/structure/1D/pages/page.x");
+	parse_bad("/structure/1D/nonexistent");
+}
+END_TEST
+
+// Siblings are cloned from the original with its extension
+START_TEST(test_FS_ParsedName_Sibling)
+{
+	struct parsedname s_pn_sibling;
+	struct parsedname *pn_sibling = &s_pn_sibling;
+
+	add_lcd_device();
+
+	parse_good("/" LCD_ADDR "/line20.3");
+
+	// aggregate sibling takes the extension
+	ck_assert_int_eq(0, FS_ParsedName_Sibling("line16", pn, pn_sibling));
+	ck_assert_str_eq("/" LCD_ADDR "/line16.3", pn_sibling->path);
+	ck_assert_str_eq("line16", pn_sibling->selected_filetype->name);
+	ck_assert_int_eq(3, pn_sibling->extension);
+	ck_assert_int_eq(pn->dirlength, pn_sibling->dirlength);
+	FS_ParsedName_destroy(pn_sibling);
+
+	// non-aggregate sibling has none
+	ck_assert_int_eq(0, FS_ParsedName_Sibling("version", pn, pn_sibling));
+	ck_assert_str_eq("/" LCD_ADDR "/version", pn_sibling->path);
+	ck_assert_int_eq(0, pn_sibling->extension);
+	FS_ParsedName_destroy(pn_sibling);
+
+	// out of range for the sibling, or unknown
+	ck_assert_int_ne(0, FS_ParsedName_Sibling("line40", pn, pn_sibling));
+	ck_assert_int_ne(0, FS_ParsedName_Sibling("nonexistent", pn, pn_sibling));
+
+	FS_ParsedName_destroy(pn);
+}
+END_TEST
+
+// Create test-suite
+Suite* ow_parsename_suite(void) {
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("Owfs");
+	tc = tcase_create("parsename");
+
+	tcase_add_checked_fixture(tc, owlib_test_setup, owlib_test_teardown);
+	suite_add_tcase (s, tc);
+	tcase_add_test(tc, test_FS_ParsedName_keywords);
+	tcase_add_test(tc, test_FS_ParsedName_state);
+	tcase_add_test(tc, test_FS_ParsedName_bus);
+	tcase_add_test(tc, test_FS_ParsedName_extension);
+	tcase_add_test(tc, test_FS_ParsedName_letter);
+	tcase_add_test(tc, test_FS_ParsedName_subdir);
+	tcase_add_test(tc, test_FS_ParsedName_Sibling);
+	return s;
+}
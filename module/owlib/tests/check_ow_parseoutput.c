@@ -0,0 +1,155 @@
+#include "ow_testhelper.h"
+
+// Fake devices (serial number CRC filled in)
+static void add_device(BYTE family, BYTE * addr) {
+	const BYTE sn[] = {family,0xAA,0xAA,0xAA,0x00,0x00,0x00,0x00};
+	memcpy(addr, sn, SERIAL_NUMBER_SIZE);
+	addr[7] = CRC8compute(addr, 7, 0);
+	ck_assert_int_eq(gbGOOD, Cache_Add_Device(0, addr));
+}
+
+// Setup a query for property on a fake device of family
+static void setup_query(BYTE family, const char * property, int trim) {
+	BYTE addr[SERIAL_NUMBER_SIZE];
+	char path[64];
+
+	add_device(family, addr);
+	snprintf(path, sizeof(path), "/%.2X.%.2X%.2X%.2X%.2X%.2X%.2X/%s",
+		addr[0], addr[1], addr[2], addr[3], addr[4], addr[5], addr[6], property);
+	owq = owmalloc(sizeof(struct one_wire_query));
+	memset(owq, 0, sizeof(struct one_wire_query));
+	ck_assert_int_eq(gbGOOD, OWQ_create(path, owq));
+	if (trim) {
+		PN(owq)->control_flags |= TRIM;
+	} else {
+		PN(owq)->control_flags &= ~TRIM;
+	}
+}
+
+// Format into buf and compare
+static void check_output(const char * expected) {
+	char buf[100];
+	size_t length = strlen(expected);
+
+	OWQ_assign_read_buffer(buf, sizeof(buf), 0, owq);
+	ck_assert_int_eq(length, OWQ_parse_output(owq));
+	ck_assert(!memcmp(expected, buf, length));
+}
+
+// Integer is padded to the property width
+START_TEST(test_FS_output_integer)
+{
+	setup_query(0x27, "interval", 0);
+	OWQ_I(owq) = -123456;
+	check_output("     -123456");
+}
+END_TEST
+
+// Integer trimmed, including the most negative value
+START_TEST(test_FS_output_integer_trim)
+{
+	setup_query(0x27, "interval", 1);
+	OWQ_I(owq) = INT_MIN;
+	check_output("-2147483648");
+	OWQ_I(owq) = 0;
+	check_output("0");
+}
+END_TEST
+
+// Unsigned padded and trimmed
+START_TEST(test_FS_output_unsigned)
+{
+	setup_query(0x1D, "counter.A", 0);
+	OWQ_U(owq) = 4000000000U;
+	check_output("  4000000000");
+	PN(owq)->control_flags |= TRIM;
+	OWQ_U(owq) = 7;
+	check_output("7");
+}
+END_TEST
+
+// Float in fixed notation, same as "%G"
+START_TEST(test_FS_output_float)
+{
+	setup_query(0x26, "VAD", 0);
+	OWQ_F(owq) = 4.875;
+	check_output("       4.875");
+	OWQ_F(owq) = -0.000123456;
+	check_output("-0.000123456");
+	PN(owq)->control_flags |= TRIM;
+	OWQ_F(owq) = 99999.95;
+	check_output("99999.9");
+	OWQ_F(owq) = 999999.5;
+	check_output("1E+06");
+	OWQ_F(owq) = 1.5E-05;
+	check_output("1.5E-05");
+	OWQ_F(owq) = 0;
+	check_output("0");
+}
+END_TEST
+
+// Array elements are formatted and comma separated
+START_TEST(test_FS_output_unsigned_array)
+{
+	setup_query(0x1D, "counter.ALL", 1);
+	OWQ_array_U(owq, 0) = 1000000;
+	OWQ_array_U(owq, 1) = 42;
+	check_output("1000000,42");
+}
+END_TEST
+
+// Binary value: header, then the raw double (no formatting)
+START_TEST(test_FS_output_binary_float)
+{
+	char buf[100];
+	_FLOAT F;
+
+	setup_query(0x26, "VAD", 0);
+	PN(owq)->control_flags |= BINARY_VALUE;
+	OWQ_F(owq) = -4.875;
+	OWQ_assign_read_buffer(buf, sizeof(buf), 0, owq);
+	ck_assert_int_eq(BINARY_VALUE_HEADER + 8, OWQ_parse_output(owq));
+	ck_assert(!memcmp("\xB7" "f" "\x01\x00", buf, BINARY_VALUE_HEADER));
+	ck_assert_int_eq(gbGOOD, BinaryValueDecode((BYTE *) buf, BINARY_VALUE_HEADER + 8, 0, &F));
+	ck_assert(F == -4.875);
+}
+END_TEST
+
+// Binary value of an array, little-endian elements
+START_TEST(test_FS_output_binary_integer_array)
+{
+	char buf[100];
+	_FLOAT F;
+
+	setup_query(0x1D, "counter.ALL", 0);
+	PN(owq)->control_flags |= BINARY_VALUE;
+	OWQ_array_U(owq, 0) = 0x01020304;
+	OWQ_array_U(owq, 1) = 4000000000U;
+	OWQ_assign_read_buffer(buf, sizeof(buf), 0, owq);
+	ck_assert_int_eq(BINARY_VALUE_HEADER + 2 * 4, OWQ_parse_output(owq));
+	ck_assert(!memcmp("\xB7" "u" "\x02\x00" "\x04\x03\x02\x01", buf, BINARY_VALUE_HEADER + 4));
+	ck_assert_int_eq(gbGOOD, BinaryValueDecode((BYTE *) buf, BINARY_VALUE_HEADER + 2 * 4, 1, &F));
+	ck_assert(F == 4000000000.);
+	ck_assert_int_eq(gbBAD, BinaryValueDecode((BYTE *) buf, BINARY_VALUE_HEADER + 2 * 4, 2, &F));
+}
+END_TEST
+
+// Create test-suite
+Suite* ow_parseoutput_suite(void) {
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("Owfs");
+	tc = tcase_create("parseoutput");
+
+	tcase_add_checked_fixture(tc, owlib_test_setup, owlib_test_teardown);
+	suite_add_tcase (s, tc);
+	tcase_add_test(tc, test_FS_output_integer);
+	tcase_add_test(tc, test_FS_output_integer_trim);
+	tcase_add_test(tc, test_FS_output_unsigned);
+	tcase_add_test(tc, test_FS_output_float);
+	tcase_add_test(tc, test_FS_output_unsigned_array);
+	tcase_add_test(tc, test_FS_output_binary_float);
+	tcase_add_test(tc, test_FS_output_binary_integer_array);
+	return s;
+}
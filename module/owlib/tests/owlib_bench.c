@@ -0,0 +1,486 @@
+/*
+    OWFS -- One-Wire filesystem
+    OWHTTPD -- One-Wire Web Server
+    Written 2003 Paul H Alfille
+    email: paul.alfille@gmail.com
+    Released under the GPL
+    See the header file: ow.h for full attribution
+    1wire/iButton system from Dallas Semiconductor
+$ID: $
+*/
+
+/* Microbenchmarks for the owlib core primitives
+ *
+ * Not a test -- build and run with "make bench" in this directory.
+ * Uses a fake adapter so no hardware is needed.
+ *
+ * Output is one JSON object per line:
+ *   {"bench":"parse/property","iterations":200000,"ns_per_op":812.4}
+ * so results can be diffed or plotted between builds.
+ *
+ * Optional argument: iteration multiplier (default 1)
+ * */
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+#include "ow_connection.h"
+
+#define BENCH_ITERATIONS    200000
+#define BENCH_CACHE_ENTRIES   4096
+
+static int multiplier = 1;
+
+/* Serial numbers of the fake devices, by family */
+static BYTE sn_10[SERIAL_NUMBER_SIZE];
+static BYTE sn_1D[SERIAL_NUMBER_SIZE];
+static BYTE sn_26[SERIAL_NUMBER_SIZE];
+static BYTE sn_27[SERIAL_NUMBER_SIZE];
+static BYTE sn_28[SERIAL_NUMBER_SIZE];
+
+/* ---------------------------------------------- */
+/* Timing and reporting                           */
+/* ---------------------------------------------- */
+
+static double Bench_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1E9 + ts.tv_nsec;
+}
+
+static void Bench_report(const char *name, long iterations, double start, double stop)
+{
+	printf("{\"bench\":\"%s\",\"iterations\":%ld,\"ns_per_op\":%.1f}\n", name, iterations, (stop - start) / iterations);
+	fflush(stdout);
+}
+
+static long Bench_iterations(long base)
+{
+	return base * multiplier;
+}
+
+static GOOD_OR_BAD Bench_find_device(BYTE family, BYTE * sn)
+{
+	struct connection_in *in = Inbound_Control.head_port->first;
+	int device;
+
+	for (device = 0; DirblobGet(device, sn, &in->master.fake.main) == 0; ++device) {
+		if (sn[0] == family) {
+			return gbGOOD;
+		}
+	}
+	fprintf(stderr, "No fake device of family %.2X\n", family);
+	return gbBAD;
+}
+
+static void Bench_path(char *path, size_t size, const BYTE * sn, const char *property)
+{
+	snprintf(path, size, "/%.2X.%.2X%.2X%.2X%.2X%.2X%.2X%s", sn[0], sn[1], sn[2], sn[3], sn[4], sn[5], sn[6], property);
+}
+
+/* ---------------------------------------------- */
+/* FS_ParsedName                                  */
+/* ---------------------------------------------- */
+
+static void Bench_parse(const char *name, const char *path)
+{
+	struct parsedname s_pn;
+	long iterations = Bench_iterations(BENCH_ITERATIONS);
+	long i;
+	double start;
+
+	if (FS_ParsedName(path, &s_pn) != 0) {
+		fprintf(stderr, "Cannot parse %s\n", path);
+		return;
+	}
+	FS_ParsedName_destroy(&s_pn);
+
+	start = Bench_now();
+	for (i = 0; i < iterations; ++i) {
+		FS_ParsedName(path, &s_pn);
+		FS_ParsedName_destroy(&s_pn);
+	}
+	Bench_report(name, iterations, start, Bench_now());
+}
+
+static void Bench_parse_all(void)
+{
+	char path[PATH_MAX];
+
+	Bench_parse("parse/root", "/");
+	Bench_parse("parse/settings", "/settings/timeout/volatile");
+	Bench_parse("parse/structure", "/structure/28/temperature");
+
+	Bench_path(path, sizeof(path), sn_28, "");
+	Bench_parse("parse/device", path);
+
+	Bench_path(path, sizeof(path), sn_28, "/temperature");
+	Bench_parse("parse/property", path);
+
+	Bench_path(path, sizeof(path), sn_1D, "/counter.A");
+	Bench_parse("parse/extension", path);
+
+	Bench_path(path, sizeof(path), sn_1D, "/counter.ALL");
+	Bench_parse("parse/aggregate", path);
+
+	snprintf(path, sizeof(path), "/uncached/bus.0/%.2X.%.2X%.2X%.2X%.2X%.2X%.2X/temperature",
+		sn_28[0], sn_28[1], sn_28[2], sn_28[3], sn_28[4], sn_28[5], sn_28[6]);
+	Bench_parse("parse/uncached_bus", path);
+}
+
+/* ---------------------------------------------- */
+/* OWQ_create / OWQ_destroy                       */
+/* ---------------------------------------------- */
+
+static void Bench_owq(const char *name, const char *path)
+{
+	long iterations = Bench_iterations(BENCH_ITERATIONS);
+	long i;
+	double start;
+	OWQ_allocate_struct_and_pointer(owq);
+
+	start = Bench_now();
+	for (i = 0; i < iterations; ++i) {
+		if (BAD(OWQ_create(path, owq))) {
+			fprintf(stderr, "Cannot create %s\n", path);
+			return;
+		}
+		OWQ_destroy(owq);
+	}
+	Bench_report(name, iterations, start, Bench_now());
+}
+
+/* Sibling of an existing query, as the device drivers do */
+static void Bench_owq_sibling(const char *name, const char *path, const char *sibling)
+{
+	long iterations = Bench_iterations(BENCH_ITERATIONS);
+	long i;
+	double start;
+	struct one_wire_query *owq_sibling;
+	OWQ_allocate_struct_and_pointer(owq);
+
+	if (BAD(OWQ_create(path, owq))) {
+		fprintf(stderr, "Cannot create %s\n", path);
+		return;
+	}
+	start = Bench_now();
+	for (i = 0; i < iterations; ++i) {
+		owq_sibling = OWQ_create_sibling(sibling, owq);
+		if (owq_sibling == NO_ONE_WIRE_QUERY) {
+			fprintf(stderr, "Cannot create sibling %s of %s\n", sibling, path);
+			break;
+		}
+		OWQ_destroy(owq_sibling);
+	}
+	Bench_report(name, iterations, start, Bench_now());
+	OWQ_destroy(owq);
+}
+
+/* Query with its read buffer, as owserver does, optionally from an arena */
+static void Bench_owq_buffer(const char *name, const char *path, struct memarena *ma)
+{
+	long iterations = Bench_iterations(BENCH_ITERATIONS);
+	long i;
+	double start;
+	OWQ_allocate_struct_and_pointer(owq);
+
+	MemarenaSelect(ma);
+	start = Bench_now();
+	for (i = 0; i < iterations; ++i) {
+		if (BAD(OWQ_create(path, owq)) || BAD(OWQ_allocate_read_buffer(owq))) {
+			fprintf(stderr, "Cannot create %s\n", path);
+			break;
+		}
+		OWQ_destroy(owq);
+		if (ma != NULL) {
+			MemarenaReset(ma);
+		}
+	}
+	Bench_report(name, iterations, start, Bench_now());
+	MemarenaSelect(NULL);
+}
+
+static void Bench_owq_all(void)
+{
+	struct memarena arena;
+
+	char path[PATH_MAX];
+
+	Bench_path(path, sizeof(path), sn_28, "/temperature");
+	Bench_owq("owq/create_destroy", path);
+
+	Bench_path(path, sizeof(path), sn_1D, "/counter.ALL");
+	Bench_owq("owq/create_destroy_aggregate", path);
+
+	Bench_path(path, sizeof(path), sn_28, "/temperature");
+	Bench_owq_sibling("owq/sibling", path, "temperature9");
+
+	Bench_path(path, sizeof(path), sn_1D, "/counter.A");
+	Bench_owq_sibling("owq/sibling_aggregate", path, "pages/page");
+
+	Bench_path(path, sizeof(path), sn_1D, "/pages/page.ALL");
+	Bench_owq_buffer("owq/read_buffer_heap", path, NULL);
+	MemarenaInit(&arena);
+	Bench_owq_buffer("owq/read_buffer_arena", path, &arena);
+	MemarenaClear(&arena);
+}
+
+/* ---------------------------------------------- */
+/* Cache                                          */
+/* ---------------------------------------------- */
+
+/* Vary the serial number so each entry is a distinct tree node */
+static void Bench_cache_key(struct one_wire_query *owq, long i)
+{
+	struct parsedname *pn = PN(owq);
+	pn->sn[1] = BYTE_MASK(i);
+	pn->sn[2] = BYTE_MASK(i >> 8);
+	pn->sn[3] = BYTE_MASK(i >> 16);
+}
+
+static void Bench_cache_all(void)
+{
+	char path[PATH_MAX];
+	long iterations = Bench_iterations(BENCH_ITERATIONS);
+	long entries = BENCH_CACHE_ENTRIES;
+	long i;
+	double start;
+	OWQ_allocate_struct_and_pointer(owq);
+
+	// a volatile property so the value is stored in the cache tree
+	Bench_path(path, sizeof(path), sn_1D, "/counter.A");
+	if (BAD(OWQ_create(path, owq))) {
+		fprintf(stderr, "Cannot create %s\n", path);
+		return;
+	}
+	OWQ_U(owq) = 12345;
+
+	Cache_Clear();
+	start = Bench_now();
+	for (i = 0; i < iterations; ++i) {
+		Bench_cache_key(owq, i % entries);
+		OWQ_Cache_Add(owq);
+	}
+	Bench_report("cache/add", iterations, start, Bench_now());
+
+	start = Bench_now();
+	for (i = 0; i < iterations; ++i) {
+		Bench_cache_key(owq, i % entries);
+		OWQ_Cache_Get(owq);
+	}
+	Bench_report("cache/get_hit", iterations, start, Bench_now());
+
+	start = Bench_now();
+	for (i = 0; i < iterations; ++i) {
+		Bench_cache_key(owq, entries + (i % entries));
+		OWQ_Cache_Get(owq);
+	}
+	Bench_report("cache/get_miss", iterations, start, Bench_now());
+
+	// Cache_Clear flips the tree twice, releasing every node
+	iterations = Bench_iterations(100);
+	start = Bench_now();
+	for (i = 0; i < iterations; ++i) {
+		long entry;
+		for (entry = 0; entry < entries; ++entry) {
+			Bench_cache_key(owq, entry);
+			OWQ_Cache_Add(owq);
+		}
+	}
+	Bench_report("cache/fill_4096", iterations, start, Bench_now());
+
+	start = Bench_now();
+	for (i = 0; i < iterations; ++i) {
+		long entry;
+		for (entry = 0; entry < entries; ++entry) {
+			Bench_cache_key(owq, entry);
+			OWQ_Cache_Add(owq);
+		}
+		Cache_Clear();
+	}
+	Bench_report("cache/fill_flip_4096", iterations, start, Bench_now());
+
+	OWQ_destroy(owq);
+}
+
+/* ---------------------------------------------- */
+/* Dirblob                                        */
+/* ---------------------------------------------- */
+
+static void Bench_dirblob_all(void)
+{
+	struct dirblob db;
+	BYTE sn[SERIAL_NUMBER_SIZE];
+	long iterations = Bench_iterations(BENCH_ITERATIONS / 100);
+	int devices = 100;
+	long i;
+	int device;
+	double start;
+
+	memcpy(sn, sn_28, SERIAL_NUMBER_SIZE);
+	DirblobInit(&db);
+
+	start = Bench_now();
+	for (i = 0; i < iterations; ++i) {
+		DirblobClear(&db);
+		for (device = 0; device < devices; ++device) {
+			sn[1] = BYTE_MASK(device);
+			DirblobAdd(sn, &db);
+		}
+	}
+	Bench_report("dirblob/add_100", iterations, start, Bench_now());
+
+	start = Bench_now();
+	for (i = 0; i < iterations; ++i) {
+		for (device = 0; device < devices; ++device) {
+			DirblobGet(device, sn, &db);
+		}
+	}
+	Bench_report("dirblob/get_100", iterations, start, Bench_now());
+
+	DirblobClear(&db);
+}
+
+/* ---------------------------------------------- */
+/* CRC                                            */
+/* ---------------------------------------------- */
+
+static void Bench_crc_all(void)
+{
+	BYTE data[32];
+	long iterations = Bench_iterations(BENCH_ITERATIONS * 10);
+	long i;
+	volatile UINT crc = 0;
+	double start;
+
+	for (i = 0; i < (long) sizeof(data); ++i) {
+		data[i] = BYTE_MASK(i * 37 + 11);
+	}
+
+	start = Bench_now();
+	for (i = 0; i < iterations; ++i) {
+		crc += CRC8compute(data, SERIAL_NUMBER_SIZE, 0);
+	}
+	Bench_report("crc/crc8_8bytes", iterations, start, Bench_now());
+
+	start = Bench_now();
+	for (i = 0; i < iterations; ++i) {
+		crc += CRC16compute(data, sizeof(data), 0);
+	}
+	Bench_report("crc/crc16_32bytes", iterations, start, Bench_now());
+}
+
+/* ---------------------------------------------- */
+/* OWQ_parse_output                               */
+/* ---------------------------------------------- */
+
+static void Bench_output(const char *name, const BYTE * sn, const char *property, void (*set_value) (struct one_wire_query *))
+{
+	char path[PATH_MAX];
+	char buffer[PATH_MAX];
+	long iterations = Bench_iterations(BENCH_ITERATIONS);
+	long i;
+	double start;
+	OWQ_allocate_struct_and_pointer(owq);
+
+	Bench_path(path, sizeof(path), sn, property);
+	if (BAD(OWQ_create(path, owq))) {
+		fprintf(stderr, "Cannot create %s\n", path);
+		return;
+	}
+	start = Bench_now();
+	for (i = 0; i < iterations; ++i) {
+		// formatting overwrites the value with the output length
+		set_value(owq);
+		OWQ_assign_read_buffer(buffer, sizeof(buffer), 0, owq);
+		if (OWQ_parse_output(owq) < 0) {
+			fprintf(stderr, "Cannot format %s\n", path);
+			break;
+		}
+	}
+	Bench_report(name, iterations, start, Bench_now());
+
+	OWQ_destroy(owq);
+}
+
+static void Set_integer(struct one_wire_query *owq)
+{
+	OWQ_I(owq) = -123456;
+}
+
+static void Set_unsigned(struct one_wire_query *owq)
+{
+	OWQ_U(owq) = 4000000000U;
+}
+
+static void Set_float(struct one_wire_query *owq)
+{
+	OWQ_F(owq) = 4.875;
+}
+
+static void Set_yesno(struct one_wire_query *owq)
+{
+	OWQ_Y(owq) = 1;
+}
+
+static void Set_date(struct one_wire_query *owq)
+{
+	OWQ_D(owq) = 1300000000;
+}
+
+static void Set_unsigned_array(struct one_wire_query *owq)
+{
+	size_t elements = PN(owq)->selected_filetype->ag->elements;
+	size_t i;
+	for (i = 0; i < elements; ++i) {
+		OWQ_array_U(owq, i) = 1000000 + i;
+	}
+}
+
+static void Bench_output_all(void)
+{
+	Bench_output("output/integer", sn_27, "/interval", Set_integer);
+	Bench_output("output/unsigned", sn_1D, "/counter.A", Set_unsigned);
+	Bench_output("output/float", sn_26, "/VAD", Set_float);
+	Bench_output("output/temperature", sn_10, "/temperature", Set_float);
+	Bench_output("output/yesno", sn_26, "/IAD", Set_yesno);
+	Bench_output("output/date", sn_26, "/date", Set_date);
+	Bench_output("output/unsigned_array", sn_1D, "/counter.ALL", Set_unsigned_array);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1) {
+		multiplier = atoi(argv[1]);
+		if (multiplier < 1) {
+			multiplier = 1;
+		}
+	}
+
+	API_setup(program_type_clibrary);
+	if (BAD(API_init("--fake=10,1D,26,27,28 --error_level=0", restart_if_repeat))) {
+		fprintf(stderr, "Cannot start owlib\n");
+		return EXIT_FAILURE;
+	}
+	Globals.error_print = e_err_print_console;
+
+	if (BAD(Bench_find_device(0x10, sn_10))
+		|| BAD(Bench_find_device(0x1D, sn_1D))
+		|| BAD(Bench_find_device(0x26, sn_26))
+		|| BAD(Bench_find_device(0x27, sn_27))
+		|| BAD(Bench_find_device(0x28, sn_28))) {
+		API_finish();
+		return EXIT_FAILURE;
+	}
+
+	Bench_parse_all();
+	Bench_owq_all();
+	Bench_cache_all();
+	Bench_dirblob_all();
+	Bench_crc_all();
+	Bench_output_all();
+
+	API_finish();
+	return EXIT_SUCCESS;
+}
@@ -8,9 +8,13 @@
  */
 
 _DEFINE_SUITE(ow_parseinput_suite);
+_DEFINE_SUITE(ow_parsename_suite);
+_DEFINE_SUITE(ow_parseoutput_suite);
 
 static void setup_test_suites(SRunner *runner) {
 	_INCLUDE_SUITE(ow_parseinput_suite);
+	_INCLUDE_SUITE(ow_parsename_suite);
+	_INCLUDE_SUITE(ow_parseoutput_suite);
 }
 
 int main(void)
@@ -61,7 +61,8 @@ struct connection_in *NewIn(void)
 		}
 		
 		now->handle = count_inbound_connections++;
-		now->file_descriptor = FILE_DESCRIPTOR_BAD ;
+		now->pool_count = 0 ;
+		now->async = NULL ;
 		my_pthread_mutex_init(&(now->bus_mutex), Mutex.pmattr);
 	}
 
@@ -94,12 +95,11 @@ void FreeIn(struct connection_in *target)
 		target->name = NULL;
 	}
 
-	my_pthread_mutex_destroy(&(target->bus_mutex));
+	// file descriptors
+	ServerPoolClear(target);
+	AsyncFree(target);
 
-	// file descriptor
-	if ( target->file_descriptor > FILE_DESCRIPTOR_BAD ) {
-		close( target->file_descriptor ) ;
-	}
+	my_pthread_mutex_destroy(&(target->bus_mutex));
 
 	// Fix link of prior connection in list
 	if ( target->prior ) {
@@ -15,6 +15,7 @@
 #include "owfs_config.h"
 #include "ow.h"
 #include "ow_server.h"
+#include <poll.h>
 
 struct server_connection_state {
 	FILE_DESCRIPTOR_OR_ERROR file_descriptor ;
@@ -22,8 +23,7 @@ struct server_connection_state {
 	struct connection_in * in ;
 } ;
 
-static uint32_t SetupSemi(int persistent);
-
+static int Pool_healthy(FILE_DESCRIPTOR_OR_ERROR file_descriptor);
 static void Release_Persistent( struct server_connection_state * scs, int granted ) ;
 static void Close_Persistent( struct server_connection_state * scs) ;
 static int To_Server( struct server_connection_state * scs, struct server_msg * sm, struct serverpackage *sp) ;
@@ -44,7 +44,7 @@ int Zero_detect(struct connection_in *in)
 		return -1;
 	if (ClientAddr(in->name, in))
 		return -1;
-	in->file_descriptor = FILE_DESCRIPTOR_BAD;	// No persistent connection yet
+	in->pool_count = 0;	// No persistent connection yet
 	in->busmode = bus_zero;
 	return 0;
 }
@@ -57,7 +57,7 @@ int Server_detect(struct connection_in *in)
 		return -1;
 	if (ClientAddr(in->name, in))
 		return -1;
-	in->file_descriptor = FILE_DESCRIPTOR_BAD;	// No persistent connection yet
+	in->pool_count = 0;	// No persistent connection yet
 	in->busmode = bus_server;
 	return 0;
 }
@@ -236,6 +236,42 @@ static int ServerDIR(void (*dirfunc) (void *, const char *), void *v, struct req
 	return cm.ret;
 }
 
+// Send to an owserver using the SNAPSHOT message
+int ServerSnapshot(void (*jsonfunc) (void *, const char *), void *v, struct request_packet *rp)
+{
+	struct server_msg sm;
+	struct client_msg cm;
+	struct serverpackage sp = { rp->path, NULL, 0, rp->tokenstring, rp->tokens, };
+	int persistent = 1;
+	struct server_connection_state scs ;
+	char *return_json;
+
+	memset(&sm, 0, sizeof(struct server_msg));
+	memset(&cm, 0, sizeof(struct client_msg));
+	sm.type = msg_snapshot;
+	scs.persistence = persistent_yes ;
+	scs.in =rp->owserver ;
+
+	LEVEL_CALL("SERVER SNAPSHOT path=%s\n", SAFESTRING(rp->path));
+
+	// Send to owserver
+	sm.control_flags = SetupSemi(persistent);
+	if ( To_Server( &scs, &sm, &sp) == 1 ) {
+		Release_Persistent( &scs, 0 ) ;
+		return -EIO ;
+	}
+
+	// Receive from owserver -- in a loop for each piece of JSON
+	while ( (return_json = From_ServerAlloc(&scs, &cm))  != NULL ) {
+		return_json[cm.payload - 1] = '\0';	/* Ensure trailing null */
+		jsonfunc(v, return_json);
+		free(return_json);
+	}
+
+	Release_Persistent(&scs, cm.control_flags & PERSISTENT_MASK);
+	return cm.ret;
+}
+
 // Send to an owserver using the DIRALL message
 static int ServerDIRALL(void (*dirfunc) (void *, const char *), void *v, struct request_packet *rp)
 {
@@ -285,7 +321,7 @@ static int ServerDIRALL(void (*dirfunc) (void *, const char *), void *v, struct
 	return cm.ret;
 }
 /* flag the sg for "virtual root" -- the remote bus was specifically requested */
-static uint32_t SetupSemi(int persistent)
+uint32_t SetupSemi(int persistent)
 {
 	uint32_t sg = ow_Global.control_flags;
 
@@ -300,57 +336,35 @@ static uint32_t SetupSemi(int persistent)
 	return sg;
 }
 
-/* Request a persistent connection
-   Three possibilities:
-     1. no persistent connection currently (in->file_descriptor = -1)
-        create one, flag in->file_descriptor as -2, and return file_descriptor
-        or return -1 if a new one can't be created
-     2. persistent available (in->file_descriptor > -1 )
-        use it, flag in->file_descriptor as -2, and return in->file_descriptor
-     3. in use, (in->file_descriptor = -2)
-        return -1
+/* Persistent connections
+   Each handle keeps up to OWNET_POOL_SIZE idle connections (in->pool).
+   A request takes one, or connects anew if none are idle, so requests
+   from several threads each have their own connection at the same time.
+   Afterwards the connection goes back to the pool if the owserver
+   granted persistence and the pool has room, else it is closed.
 */
 
 /* Clean up at end of routine,
-   either leave connection open and persistent flag available,
-   or close
+   either return the connection to the pool or close it
 */
 static void Release_Persistent( struct server_connection_state * scs, int granted )
 {
-	if ( granted == 0 ) {
-		Close_Persistent( scs ) ;
-		return ;
-	}
-	
-	if ( scs->file_descriptor <= FILE_DESCRIPTOR_BAD  ) {
-		Close_Persistent( scs ) ;
-		return ;
-	}
-	
-	if (scs->persistence == persistent_no) {		
-		// non-persistence from the start
+	if ( granted == 0 || scs->persistence == persistent_no || scs->file_descriptor <= FILE_DESCRIPTOR_BAD ) {
 		Close_Persistent( scs ) ;
 		return ;
 	}
 
-	// mark as available
 	BUSLOCKIN(scs->in);
-	scs->in->file_descriptor = scs->file_descriptor;
+	if ( scs->in->pool_count < OWNET_POOL_SIZE ) {
+		scs->in->pool[scs->in->pool_count++] = scs->file_descriptor ;
+		scs->file_descriptor = FILE_DESCRIPTOR_BAD ;
+	}
 	BUSUNLOCKIN(scs->in);
-	scs->persistence = persistent_no ; // we no longer own this connection
-	scs->file_descriptor = FILE_DESCRIPTOR_BAD ;
+	Close_Persistent( scs ) ; // if the pool was full
 }
 
 static void Close_Persistent( struct server_connection_state * scs)
 {
-	// First set up the file descriptor based on persistent state
-	if (scs->persistence == persistent_yes) {
-		// no persistence wanted
-		BUSLOCKIN(scs->in);
-			scs->in->file_descriptor = FILE_DESCRIPTOR_BAD ;
-		BUSUNLOCKIN(scs->in);
-	}
-	
 	scs->persistence = persistent_no ;
 	if ( scs->file_descriptor > FILE_DESCRIPTOR_BAD ) {
 		close(scs->file_descriptor) ;
@@ -358,88 +372,54 @@ static void Close_Persistent( struct server_connection_state * scs)
 	}
 }
 
+/* Close the idle connections (handle closed) */
+void ServerPoolClear(struct connection_in *in)
+{
+	BUSLOCKIN(in);
+	while ( in->pool_count > 0 ) {
+		close( in->pool[--in->pool_count] ) ;
+	}
+	BUSUNLOCKIN(in);
+}
+
+/* An idle connection has nothing to read. Readable means the owserver
+   closed it (its timeout) or it is out of step -- either way unusable.
+   This contributed check fixed a timeout problem (Jacob Joseph)
+   http://permalink.gmane.org/gmane.comp.file-systems.owfs.devel/7306
+ */
+static int Pool_healthy(FILE_DESCRIPTOR_OR_ERROR file_descriptor)
+{
+	struct pollfd pfd = { file_descriptor, POLLIN, 0, } ;
+
+	return poll( &pfd, 1, 0 ) == 0 ;
+}
+
 /* return 0 good, 1 bad */
 static int To_Server( struct server_connection_state * scs, struct server_msg * sm, struct serverpackage *sp)
 {
 	struct connection_in * in = scs->in ; // for convenience
-	BYTE test_read[1] ;
-	int old_flags ;
-	ssize_t rcv_value ;
-	int saved_errno ;
-	
+	int pooled = 0 ;
+
 	// initialize the variables
 	scs->file_descriptor = FILE_DESCRIPTOR_BAD ;
 
-	// First set up the file descriptor based on persistent state
-	if (scs->persistence == persistent_no) {		
-		// no persistence wanted
-		scs->file_descriptor = ClientConnect(in);
-	} else {
-		// Persistence desired
+	// First an idle persistent connection, if any
+	if (scs->persistence == persistent_yes) {
 		BUSLOCKIN(in);
-		switch ( in->file_descriptor ) {
-			case FILE_DESCRIPTOR_PERSISTENT_IN_USE:
-				// Currently in use, so make new non-persistent connection
-				scs->file_descriptor = ClientConnect(in);
-				scs->persistence = persistent_no ;
-				break ;
-			case FILE_DESCRIPTOR_BAD:
-				// no conection currently, so make a new one
-				scs->file_descriptor = ClientConnect(in);
-				if ( scs->file_descriptor > FILE_DESCRIPTOR_BAD ) {
-					in->file_descriptor = FILE_DESCRIPTOR_PERSISTENT_IN_USE ;
-				}	
-				break ;
-			default:
-				// persistent connection idle and waiting for use
-				// connection_in is locked so this is safe
-				scs->file_descriptor = in->file_descriptor;
-				in->file_descriptor = FILE_DESCRIPTOR_PERSISTENT_IN_USE;
-			break ;
+		while ( in->pool_count > 0 && pooled == 0 ) {
+			FILE_DESCRIPTOR_OR_ERROR file_descriptor = in->pool[--in->pool_count] ;
+			if ( Pool_healthy( file_descriptor ) ) {
+				scs->file_descriptor = file_descriptor ;
+				pooled = 1 ;
+			} else {
+				LEVEL_DEBUG("Server connection was closed.  Reconnecting.");
+				close( file_descriptor ) ;
+			}
 		}
 		BUSUNLOCKIN(in);
 	}
-	
-	// Check if the server closed the connection
-	// This is contributed by Jacob Joseph to fix a timeout problem.
-	// http://permalink.gmane.org/gmane.comp.file-systems.owfs.devel/7306
-	//rcv_value = recv(scs->file_descriptor, test_read, 1, MSG_DONTWAIT | MSG_PEEK) ;
-	old_flags = fcntl( scs->file_descriptor, F_GETFL, 0 ) ; // save socket flags
-	if ( old_flags == -1 ) {
-		rcv_value = -2 ;
-	} else if ( scs->file_descriptor < 0 ) {
-		rcv_value = 0 ; // bad file descriptor -- need to reset
-	} else if ( fcntl( scs->file_descriptor, F_SETFL, old_flags | O_NONBLOCK ) == -1 ) { // set non-blocking
-		rcv_value = -2 ;
-	} else {
-		rcv_value = recv(scs->file_descriptor, test_read, 1, MSG_PEEK) ; // test read the socket to see if closed
-		saved_errno = errno ;
-		if ( fcntl( scs->file_descriptor, F_SETFL, old_flags ) == -1 ) { // restore  socket flags
-			rcv_value = -2 ;
-		}
-	}
-
-	switch ( rcv_value ) {
-		case -1:
-			if ( saved_errno==EAGAIN || saved_errno==EWOULDBLOCK ) {
-				// No data to be read -- so connection healthy
-				break ;
-			}
-			// real error, fall through to close connection case
-			__attribute__ ((fallthrough));
-		case -2:
-			// fnctl error, fall through again
-		case 0:
-			LEVEL_DEBUG("Server connection was closed.  Reconnecting.");
-			Close_Persistent( scs);
-			scs->file_descriptor = ClientConnect(in);
-			if ( scs->file_descriptor > FILE_DESCRIPTOR_BAD ) {
-				in->file_descriptor = FILE_DESCRIPTOR_PERSISTENT_IN_USE ;
-			}
-			break ;
-		default:
-			// data to be read, so a good connection
-			break ;
+	if ( pooled == 0 ) {
+		scs->file_descriptor = ClientConnect(in);
 	}
 
 	// Now test
@@ -454,15 +434,15 @@ static int To_Server( struct server_connection_state * scs, struct server_msg *
 		return 0;
 	}
 
-	// This is where it gets a bit tricky. For non-persistent conections we're done'
-	if ( scs->persistence == persistent_no ) {
-		// not persistent, so no reconnection needed
+	// A new connection failed, so we're done
+	if ( pooled == 0 ) {
 		Close_Persistent( scs ) ;
 		return 1 ;
 	}
-	
+
 	// perhaps the persistent connection is stale?
 	// Make a new one
+	close( scs->file_descriptor ) ;
 	scs->file_descriptor = ClientConnect(in) ;
 
 	// Now retest
@@ -471,8 +451,6 @@ static int To_Server( struct server_connection_state * scs, struct server_msg *
 		Close_Persistent( scs ) ;
 		return 1 ;
 	}
-	
-	// Leave in->file_descriptor = FILE_DESCRIPTOR_PERSISTENT_IN_USE
 
 	// Second attempt at the write, now with new connection
 	if (WriteToServer(scs->file_descriptor, sm, sp) >= 0) {
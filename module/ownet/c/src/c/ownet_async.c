@@ -0,0 +1,511 @@
+/*
+    OWFS -- One-Wire filesystem
+    OWHTTPD -- One-Wire Web Server
+    Written 2003 Paul H Alfille
+    email: paul.alfille@gmail.com
+    Released under the GPL
+    See the header file: ow.h for full attribution
+    1wire/iButton system from Dallas Semiconductor
+*/
+
+/* Non-blocking reads and writes, pipelined on one connection per handle */
+
+/* Requests are queued in order on a persistent, non-blocking connection
+   and sent without waiting for earlier replies. The owserver answers them
+   in order, so each reply belongs to the oldest outstanding request.
+   The caller polls the socket (OWNET_async_fd) and calls
+   OWNET_async_process, which sends and receives what it can without
+   blocking and calls donefunc for every request that finished.
+
+   If the owserver refuses persistence it closes the connection after each
+   reply. The unanswered requests are then sent again on a new connection,
+   one at a time until a reply grants persistence again. A connection that
+   is lost unexpectedly is made again once, also one request at a time;
+   a read is sent again, a write already sent fails (-EIO) rather than
+   risk writing twice.
+*/
+
+#include "ownetapi.h"
+#include "ow_server.h"
+#include <poll.h>
+
+struct ownet_async_request {
+	struct ownet_async_request *next;
+	char *message;				// header, path and data, in network order
+	size_t length;
+	char *buffer;				// for the reply (reads)
+	size_t size;
+	int is_write;
+	int resent;
+	int result;
+	void (*donefunc) (void *, int);
+	void *v;
+};
+
+struct ownet_async {
+	FILE_DESCRIPTOR_OR_ERROR file_descriptor;
+	int lockstep;				// one request at a time (persistence in doubt)
+	int outstanding;
+
+	// oldest first, unsent points into the list
+	struct ownet_async_request *head;
+	struct ownet_async_request *tail;
+	struct ownet_async_request *unsent;
+	size_t sent;				// part of unsent->message already sent
+
+	// reply to head in progress
+	struct client_msg cm;
+	size_t header_read;
+	size_t payload_read;
+};
+
+#define ASYNC_DISCARD_SIZE  256
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL  0
+#endif							/* MSG_NOSIGNAL */
+
+static int Async_queue(OWNET_HANDLE h, int type, const char *onewire_path, char *buffer, const char *data, size_t size, off_t offset, void (*donefunc) (void *, int), void *v);
+static int Async_connect(struct ownet_async *as, struct connection_in *in);
+static void Async_restart(struct ownet_async *as, int unexpected, struct ownet_async_request **done);
+static int Async_send(struct ownet_async *as);
+static int Async_receive(struct ownet_async *as, struct ownet_async_request **done);
+static void Async_finish(struct ownet_async *as, int result, struct ownet_async_request **done);
+static void Async_done(struct ownet_async_request *done);
+
+int OWNET_async_lread(OWNET_HANDLE h, const char *onewire_path, char *return_string, size_t size, off_t offset, void (*donefunc) (void *v, int result), void *v)
+{
+	if (return_string == NULL) {
+		return -EINVAL;
+	}
+	return Async_queue(h, msg_read, onewire_path, return_string, NULL, size, offset, donefunc, v);
+}
+
+int OWNET_async_lwrite(OWNET_HANDLE h, const char *onewire_path, const char *value_string, size_t size, off_t offset, void (*donefunc) (void *v, int result), void *v)
+{
+	if (value_string == NULL && size > 0) {
+		return -EINVAL;
+	}
+	return Async_queue(h, msg_write, onewire_path, NULL, value_string, size, offset, donefunc, v);
+}
+
+int OWNET_async_fd(OWNET_HANDLE h, short *events)
+{
+	struct connection_in *in;
+	int return_value;
+
+	CONNIN_RLOCK;
+	in = find_connection_in(h);
+	if (in == NULL) {
+		CONNIN_RUNLOCK;
+		return -EBADF;
+	}
+	BUSLOCKIN(in);
+	if (in->async == NULL || in->async->file_descriptor <= FILE_DESCRIPTOR_BAD) {
+		return_value = -ENOTCONN;
+		if (events != NULL) {
+			*events = 0;
+		}
+	} else {
+		struct ownet_async *as = in->async;
+		return_value = as->file_descriptor;
+		if (events != NULL) {
+			// readable also when an idle connection is closed
+			*events = POLLIN;
+			if (as->unsent != NULL && (as->lockstep == 0 || as->unsent == as->head)) {
+				*events |= POLLOUT;
+			}
+		}
+	}
+	BUSUNLOCKIN(in);
+	CONNIN_RUNLOCK;
+	return return_value;
+}
+
+int OWNET_async_process(OWNET_HANDLE h)
+{
+	struct connection_in *in;
+	struct ownet_async *as;
+	struct ownet_async_request *done = NULL;
+	int reconnects = 0;
+	int return_value;
+
+	CONNIN_RLOCK;
+	in = find_connection_in(h);
+	if (in == NULL) {
+		CONNIN_RUNLOCK;
+		return -EBADF;
+	}
+	BUSLOCKIN(in);
+	as = in->async;
+	if (as == NULL) {
+		BUSUNLOCKIN(in);
+		CONNIN_RUNLOCK;
+		return 0;
+	}
+
+	while (1) {
+		if (as->file_descriptor <= FILE_DESCRIPTOR_BAD) {
+			if (as->head == NULL) {
+				break;
+			}
+			if (Async_connect(as, in) != 0) {
+				// no owserver -- fail everything
+				while (as->head != NULL) {
+					Async_finish(as, -ECONNREFUSED, &done);
+				}
+				break;
+			}
+		}
+		if (Async_send(as) != 0 || Async_receive(as, &done) != 0) {
+			// connection closed
+			Async_restart(as, 1, &done);
+			if (++reconnects > 2) {
+				while (as->head != NULL) {
+					Async_finish(as, -EIO, &done);
+				}
+			}
+			continue;
+		}
+		if (as->file_descriptor <= FILE_DESCRIPTOR_BAD) {
+			// persistence refused, send the rest again
+			continue;
+		}
+		break;
+	}
+	return_value = as->outstanding;
+
+	BUSUNLOCKIN(in);
+	CONNIN_RUNLOCK;
+
+	// callbacks without locks, they may queue more
+	Async_done(done);
+	return return_value;
+}
+
+/* Outstanding requests are dropped without calling donefunc (handle closed) */
+void AsyncFree(struct connection_in *in)
+{
+	struct ownet_async *as = in->async;
+
+	if (as == NULL) {
+		return;
+	}
+	if (as->file_descriptor > FILE_DESCRIPTOR_BAD) {
+		close(as->file_descriptor);
+	}
+	while (as->head != NULL) {
+		struct ownet_async_request *ar = as->head;
+		as->head = ar->next;
+		free(ar->message);
+		free(ar);
+	}
+	free(as);
+	in->async = NULL;
+}
+
+/* Encode the request and add it to the pipeline */
+static int Async_queue(OWNET_HANDLE h, int type, const char *onewire_path, char *buffer, const char *data, size_t size, off_t offset, void (*donefunc) (void *, int), void *v)
+{
+	struct connection_in *in;
+	struct ownet_async_request *ar;
+	struct server_msg net_sm;
+	const char *path = (onewire_path == NULL) ? "/" : onewire_path;
+	size_t pathlength = strlen(path) + 1;
+	size_t datalength = (type == msg_write) ? size : 0;
+	int return_value = 0;
+
+	if (donefunc == NULL) {
+		return -EINVAL;
+	}
+
+	ar = calloc(1, sizeof(struct ownet_async_request));
+	if (ar == NULL) {
+		return -ENOMEM;
+	}
+	ar->length = sizeof(struct server_msg) + pathlength + datalength;
+	ar->message = malloc(ar->length);
+	if (ar->message == NULL) {
+		free(ar);
+		return -ENOMEM;
+	}
+	ar->buffer = buffer;
+	ar->size = size;
+	ar->is_write = (type == msg_write);
+	ar->donefunc = donefunc;
+	ar->v = v;
+
+	net_sm.version = htonl(MakeServerprotocol(OWSERVER_PROTOCOL_VERSION));
+	net_sm.payload = htonl(pathlength + datalength);
+	net_sm.size = htonl(size);
+	net_sm.type = htonl(type);
+	net_sm.control_flags = htonl(SetupSemi(1));
+	net_sm.offset = htonl(offset);
+	memcpy(ar->message, &net_sm, sizeof(struct server_msg));
+	memcpy(ar->message + sizeof(struct server_msg), path, pathlength);
+	if (datalength > 0) {
+		memcpy(ar->message + sizeof(struct server_msg) + pathlength, data, datalength);
+	}
+	LEVEL_CALL("SERVER ASYNC %s path=%s\n", ar->is_write ? "WRITE" : "READ", path);
+
+	CONNIN_RLOCK;
+	in = find_connection_in(h);
+	if (in == NULL) {
+		CONNIN_RUNLOCK;
+		free(ar->message);
+		free(ar);
+		return -EBADF;
+	}
+	BUSLOCKIN(in);
+	if (in->async == NULL) {
+		in->async = calloc(1, sizeof(struct ownet_async));
+		if (in->async != NULL) {
+			in->async->file_descriptor = FILE_DESCRIPTOR_BAD;
+		}
+	}
+	if (in->async == NULL) {
+		return_value = -ENOMEM;
+	} else if (in->async->file_descriptor <= FILE_DESCRIPTOR_BAD && Async_connect(in->async, in) != 0) {
+		return_value = -ECONNREFUSED;
+	} else {
+		struct ownet_async *as = in->async;
+		if (as->tail == NULL) {
+			as->head = ar;
+		} else {
+			as->tail->next = ar;
+		}
+		as->tail = ar;
+		if (as->unsent == NULL) {
+			as->unsent = ar;
+			as->sent = 0;
+		}
+		++as->outstanding;
+	}
+	BUSUNLOCKIN(in);
+	CONNIN_RUNLOCK;
+
+	if (return_value < 0) {
+		free(ar->message);
+		free(ar);
+	}
+	return return_value;
+}
+
+/* New connection, non-blocking after the connect */
+static int Async_connect(struct ownet_async *as, struct connection_in *in)
+{
+	int flags;
+
+	as->file_descriptor = ClientConnect(in);
+	if (as->file_descriptor <= FILE_DESCRIPTOR_BAD) {
+		as->file_descriptor = FILE_DESCRIPTOR_BAD;
+		return 1;
+	}
+	flags = fcntl(as->file_descriptor, F_GETFL, 0);
+	if (flags < 0 || fcntl(as->file_descriptor, F_SETFL, flags | O_NONBLOCK) < 0) {
+		close(as->file_descriptor);
+		as->file_descriptor = FILE_DESCRIPTOR_BAD;
+		return 1;
+	}
+	return 0;
+}
+
+/* Connection closed: everything not answered is sent again on a new one */
+static void Async_restart(struct ownet_async *as, int unexpected, struct ownet_async_request **done)
+{
+	if (as->file_descriptor > FILE_DESCRIPTOR_BAD) {
+		close(as->file_descriptor);
+		as->file_descriptor = FILE_DESCRIPTOR_BAD;
+	}
+	as->header_read = 0;
+	as->payload_read = 0;
+
+	if (unexpected) {
+		struct ownet_async_request **link = &as->head;
+		int before_unsent = 1;
+
+		// until a reply shows the owserver keeps connections
+		as->lockstep = 1;
+
+		as->tail = NULL;
+		while (*link != NULL) {
+			struct ownet_async_request *ar = *link;
+			int sent = before_unsent;
+
+			if (ar == as->unsent) {
+				before_unsent = 0;
+				sent = (as->sent > 0);
+			}
+			if (sent && (ar->resent || ar->is_write)) {
+				// a write may have been done already
+				*link = ar->next;
+				ar->result = -EIO;
+				--as->outstanding;
+				ar->next = *done;
+				*done = ar;
+			} else {
+				if (sent) {
+					ar->resent = 1;
+				}
+				as->tail = ar;
+				link = &ar->next;
+			}
+		}
+	}
+	as->unsent = as->head;
+	as->sent = 0;
+}
+
+/* Send what the socket will take, return 0 ok, 1 connection closed */
+static int Async_send(struct ownet_async *as)
+{
+	while (as->unsent != NULL && (as->lockstep == 0 || as->unsent == as->head)) {
+		ssize_t written = send(as->file_descriptor, as->unsent->message + as->sent, as->unsent->length - as->sent, MSG_NOSIGNAL);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				return 0;
+			}
+			LEVEL_CONNECT("Async write error %s\n", strerror(errno));
+			return 1;
+		}
+		as->sent += written;
+		if (as->sent == as->unsent->length) {
+			as->unsent = as->unsent->next;
+			as->sent = 0;
+		}
+	}
+	return 0;
+}
+
+/* Read the replies that have arrived, return 0 ok, 1 connection closed */
+static int Async_receive(struct ownet_async *as, struct ownet_async_request **done)
+{
+	while (as->file_descriptor > FILE_DESCRIPTOR_BAD) {
+		struct ownet_async_request *ar = as->head;
+		char discard[ASYNC_DISCARD_SIZE];
+		char *target;
+		size_t want;
+		ssize_t got;
+
+		if (as->header_read < sizeof(struct client_msg)) {
+			target = ((char *) &as->cm) + as->header_read;
+			want = sizeof(struct client_msg) - as->header_read;
+		} else if (as->payload_read < ar->size) {
+			target = ar->buffer + as->payload_read;
+			want = as->cm.payload - as->payload_read;
+			if (want > ar->size - as->payload_read) {
+				want = ar->size - as->payload_read;
+			}
+		} else {
+			// bigger than the buffer
+			target = discard;
+			want = as->cm.payload - as->payload_read;
+			if (want > ASYNC_DISCARD_SIZE) {
+				want = ASYNC_DISCARD_SIZE;
+			}
+		}
+
+		got = read(as->file_descriptor, target, want);
+		if (got < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				return 0;
+			}
+			LEVEL_CONNECT("Async read error %s\n", strerror(errno));
+			return 1;
+		}
+		if (got == 0) {
+			if (ar == NULL || (as->unsent == ar && as->sent == 0)) {
+				// idle connection timed out, nothing lost
+				close(as->file_descriptor);
+				as->file_descriptor = FILE_DESCRIPTOR_BAD;
+				return 0;
+			}
+			return 1;
+		}
+		if (ar == NULL) {
+			LEVEL_DEBUG("Unexpected data from owserver\n");
+			return 1;
+		}
+
+		if (as->header_read < sizeof(struct client_msg)) {
+			as->header_read += got;
+			if (as->header_read < sizeof(struct client_msg)) {
+				continue;
+			}
+			as->cm.payload = ntohl(as->cm.payload);
+			as->cm.size = ntohl(as->cm.size);
+			as->cm.ret = ntohl(as->cm.ret);
+			as->cm.control_flags = ntohl(as->cm.control_flags);
+			as->cm.offset = ntohl(as->cm.offset);
+			if (as->cm.payload < 0) {
+				// delay message, the real header follows
+				as->header_read = 0;
+				continue;
+			}
+		} else {
+			as->payload_read += got;
+		}
+
+		if (as->payload_read == (size_t) as->cm.payload) {
+			// reply complete
+			int persistent = as->cm.control_flags & PERSISTENT_MASK;
+			Async_finish(as, as->cm.ret, done);
+			if (persistent == 0) {
+				LEVEL_DEBUG("Persistence refused, one request at a time\n");
+				as->lockstep = 1;
+				Async_restart(as, 0, done);
+			} else {
+				as->lockstep = 0;
+			}
+		}
+	}
+	return 0;
+}
+
+/* Oldest request answered */
+static void Async_finish(struct ownet_async *as, int result, struct ownet_async_request **done)
+{
+	struct ownet_async_request *ar = as->head;
+
+	as->head = ar->next;
+	if (as->head == NULL) {
+		as->tail = NULL;
+	}
+	if (as->unsent == ar) {
+		as->unsent = ar->next;
+		as->sent = 0;
+	}
+	--as->outstanding;
+	as->header_read = 0;
+	as->payload_read = 0;
+
+	ar->result = result;
+	ar->next = *done;
+	*done = ar;
+}
+
+/* Call donefunc in the order the requests were made */
+static void Async_done(struct ownet_async_request *done)
+{
+	struct ownet_async_request *in_order = NULL;
+
+	while (done != NULL) {
+		struct ownet_async_request *ar = done;
+		done = ar->next;
+		ar->next = in_order;
+		in_order = ar;
+	}
+	while (in_order != NULL) {
+		struct ownet_async_request *ar = in_order;
+		in_order = ar->next;
+		ar->donefunc(ar->v, ar->result);
+		free(ar->message);
+		free(ar);
+	}
+}
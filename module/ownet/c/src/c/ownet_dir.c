@@ -74,3 +74,24 @@ int OWNET_dirprocess(OWNET_HANDLE h,
 	CONNIN_RUNLOCK;
 	return return_value;
 }
+
+int OWNET_snapshot(OWNET_HANDLE h, const char *onewire_path, void (*jsonfunc) (void *passed_on_value, const char *json_text), void *passed_on_value)
+{
+	struct request_packet s_request_packet;
+	struct request_packet *rp = &s_request_packet;
+	int return_value;
+	memset(rp, 0, sizeof(struct request_packet));
+
+	CONNIN_RLOCK;
+	rp->owserver = find_connection_in(h);
+	if (rp->owserver == NULL) {
+		CONNIN_RUNLOCK;
+		return -EBADF;
+	}
+
+	rp->path = (onewire_path == NULL) ? "/" : onewire_path;
+	return_value = ServerSnapshot(jsonfunc, passed_on_value, rp);
+
+	CONNIN_RUNLOCK;
+	return return_value;
+}
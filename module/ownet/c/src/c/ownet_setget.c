@@ -102,3 +102,14 @@ int OWNET_get_trim( void )
 {
 	return (ow_Global.control_flags & TRIM) != 0 ;
 }
+
+void OWNET_set_binary( int binary_state )
+{
+	ow_Global.control_flags &= ~BINARY_VALUE ; // clear binary
+	ow_Global.control_flags |= binary_state ? BINARY_VALUE : 0 ;
+}
+
+int OWNET_get_binary( void )
+{
+	return (ow_Global.control_flags & BINARY_VALUE) != 0 ;
+}
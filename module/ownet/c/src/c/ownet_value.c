@@ -0,0 +1,142 @@
+/*
+    OWFS -- One-Wire filesystem
+    OWHTTPD -- One-Wire Web Server
+    Written 2003 Paul H Alfille
+    email: paul.alfille@gmail.com
+    Released under the GPL
+    See the header file: ow.h for full attribution
+    1wire/iButton system from Dallas Semiconductor
+*/
+
+/* Decode read results -- binary values (OWNET_set_binary) or text */
+/* owservers without binary support always send text */
+
+#include "ownetapi.h"
+#include "ow_server.h"
+
+static int binary_element_size(BYTE type)
+{
+	switch (type) {
+	case 'i':					// integer
+	case 'u':					// unsigned
+		return 4;
+	case 'f':					// float
+	case 'd':					// date
+		return 8;
+	case 'y':					// yesno
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/* Number of binary values, or <0 if not a binary value */
+static int binary_elements(const BYTE * data, int length)
+{
+	int elements;
+	int size;
+
+	if (length < BINARY_VALUE_HEADER || data[0] != BINARY_VALUE_MAGIC) {
+		return -1;
+	}
+	size = binary_element_size(data[1]);
+	elements = data[2] | (data[3] << 8);
+	if (size == 0 || length != BINARY_VALUE_HEADER + elements * size) {
+		return -1;
+	}
+	return elements;
+}
+
+static uint64_t binary_get(const BYTE * data, int size)
+{
+	uint64_t u = 0;
+
+	while (size-- > 0) {
+		u = (u << 8) | data[size];
+	}
+	return u;
+}
+
+int OWNET_value_count(const char *value_string, int length)
+{
+	int elements;
+	int count = 1;
+	int i;
+
+	if (value_string == NULL || length <= 0) {
+		return -EINVAL;
+	}
+	elements = binary_elements((const BYTE *) value_string, length);
+	if (elements >= 0) {
+		return elements;
+	}
+	// text: comma separated
+	for (i = 0; i < length; ++i) {
+		if (value_string[i] == ',') {
+			++count;
+		}
+	}
+	return count;
+}
+
+int OWNET_value_double(const char *value_string, int length, int index, double *value)
+{
+	const BYTE *data = (const BYTE *) value_string;
+	int elements;
+	int start = 0;
+	int end;
+	char element[64];
+	char *parse_end;
+
+	if (value_string == NULL || value == NULL || length <= 0 || index < 0) {
+		return -EINVAL;
+	}
+
+	elements = binary_elements(data, length);
+	if (elements >= 0) {
+		int size = binary_element_size(data[1]);
+		uint64_t u;
+
+		if (index >= elements) {
+			return -EINVAL;
+		}
+		u = binary_get(&data[BINARY_VALUE_HEADER + index * size], size);
+		switch (data[1]) {
+		case 'i':
+			*value = (int32_t) (uint32_t) u;
+			break;
+		case 'd':
+			*value = (int64_t) u;
+			break;
+		case 'f':
+			memcpy(value, &u, sizeof(double));
+			break;
+		default:
+			*value = u;
+			break;
+		}
+		return 0;
+	}
+
+	// text: find element number index
+	for (; index > 0 && start < length; ++start) {
+		if (value_string[start] == ',') {
+			--index;
+		}
+	}
+	if (index > 0) {
+		return -EINVAL;
+	}
+	for (end = start; end < length && value_string[end] != ','; ++end) {
+	}
+	if (end - start >= (int) sizeof(element)) {
+		return -EINVAL;
+	}
+	memcpy(element, &value_string[start], end - start);
+	element[end - start] = '\0';
+	*value = strtod(element, &parse_end);
+	if (parse_end == element) {
+		return -EINVAL;
+	}
+	return 0;
+}
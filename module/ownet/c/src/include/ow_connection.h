@@ -72,6 +72,10 @@ See: http://www.iana.org/assignments/port-numbers
 
 
 struct connection_in;
+struct ownet_async;
+
+/* idle persistent connections kept for each owserver */
+#define OWNET_POOL_SIZE  8
 
 /* -------------------------------------------- */
 
@@ -99,7 +103,14 @@ struct connection_in {
 	struct connection_in *prior;
 	int handle;
 	char *name;
-	FILE_DESCRIPTOR_OR_ERROR file_descriptor;
+
+	/* persistent connections not in use, under bus_mutex */
+	FILE_DESCRIPTOR_OR_ERROR pool[OWNET_POOL_SIZE];
+	int pool_count;
+
+	/* non-blocking requests (ownet_async.c), under bus_mutex */
+	struct ownet_async *async;
+
 	pthread_mutex_t bus_mutex;
 
 	enum bus_mode busmode;
@@ -132,5 +143,7 @@ void OW_Browse(void);
 */
 int Server_detect(struct connection_in *in);
 int Zero_detect(struct connection_in *in);
+void ServerPoolClear(struct connection_in *in);
+void AsyncFree(struct connection_in *in);
 
 #endif							/* OW_CONNECTION_H */
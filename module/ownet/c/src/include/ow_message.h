@@ -39,6 +39,7 @@ enum msg_classification {
 	msg_get,
 	msg_dirallslash,
 	msg_getslash,
+	msg_snapshot,				// all devices and values as JSON, streamed
 };
 /* message to owserver */
 struct server_msg {
@@ -54,6 +54,11 @@ extern struct ow_global {
 #define DEVFORMAT_MASK ( (UINT) 0xFF000000 )
 #define DEVFORMAT_BIT  24
 #define TRIM                        ( (UINT) 0x00000040 )
+#define BINARY_VALUE                ( (UINT) 0x00000080 )
+
+/* Layout of a binary value -- see owlib ow_binaryvalue.h */
+#define BINARY_VALUE_MAGIC   0xB7
+#define BINARY_VALUE_HEADER  4
 #define IsPersistent         ( ow_Global.control_flags & PERSISTENT_MASK )
 #define SetPersistent(b)      UT_Setbit(ow_Global.control_flags,PERSISTENT_BIT,(b))
 #define TemperatureScale     ( (enum temp_type) ((ow_Global.control_flags & TEMPSCALE_MASK) >> TEMPSCALE_BIT) )
@@ -61,9 +66,11 @@ extern struct ow_global {
 #define DeviceFormat         ( (enum deviceformat) ((ow_Global.control_flags & DEVFORMAT_MASK) >> DEVFORMAT_BIT) )
 #define set_semiglobal(s, mask, bit, val) do { *(s) = (*(s) & ~(mask)) | ((val)<<bit); } while(0)
 
+uint32_t SetupSemi(int persistent);
 int ServerPresence(struct request_packet *rp);
 int ServerRead(struct request_packet *rp);
 int ServerWrite(struct request_packet *rp);
 int ServerDir(void (*dirfunc) (void *, const char *), void *v, struct request_packet *rp);
+int ServerSnapshot(void (*jsonfunc) (void *, const char *), void *v, struct request_packet *rp);
 
 #endif							/* OW_SERVER_H */
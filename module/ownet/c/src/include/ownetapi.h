@@ -71,6 +71,21 @@ extern "C" {
 	int OWNET_dirprocess(OWNET_HANDLE h, const char *onewire_path, void (*dirfunc) (void *passed_on_value, const char *directory_element),
 						 void *passed_on_value);
 
+/* int OWNET_snapshot( OWNET_HANDLE h, const char * onewire_path, 
+        void (*jsonfunc) (void * passed_on_value, const char* json_text), 
+        void * passed_on_value )
+   Read every device and readable property below onewire_path (root or a bus)
+   as a single JSON object, { "device":{ "property":"value", ... }, ... }
+   Call function jsonfunc on each piece of the text as the owserver sends it
+   (the opening brace, one device at a time, the closing brace).
+   The pieces concatenated are the whole object.
+
+   returns 0 on success,
+   or <0 for error
+*/
+	int OWNET_snapshot(OWNET_HANDLE h, const char *onewire_path, void (*jsonfunc) (void *passed_on_value, const char *json_text),
+						 void *passed_on_value);
+
 
 /* int OWNET_present( OWNET_HANDLE h, const char * onewire_path)
    Check if a one-wire device is present
@@ -122,6 +137,54 @@ extern "C" {
 */
 	int OWNET_lwrite(OWNET_HANDLE h, const char *onewire_path, const char *value_string, size_t size, off_t offset);
 
+/* int OWNET_async_lread( OWNET_HANDLE h, const char * onewire_path,
+        char * return_string, size_t size, off_t offset,
+        void (*donefunc)(void * v, int result), void * v )
+   Queue a read without waiting for the result.
+   Requests on a handle are sent on one connection without waiting for
+   earlier replies, and answered in order.
+   return_string must stay valid until donefunc is called.
+   donefunc(v, result) is called from OWNET_async_process,
+   result as for OWNET_lread.
+
+   return 0 on success (queued)
+   return <0 on error (donefunc will not be called)
+*/
+	int OWNET_async_lread(OWNET_HANDLE h, const char *onewire_path, char *return_string, size_t size, off_t offset, void (*donefunc) (void *v, int result), void *v);
+
+/* int OWNET_async_lwrite( OWNET_HANDLE h, const char * onewire_path,
+        const char * value_string, size_t size, off_t offset,
+        void (*donefunc)(void * v, int result), void * v )
+   Queue a write without waiting for the result.
+   value_string is copied.
+   donefunc(v, result) is called from OWNET_async_process,
+   result as for OWNET_lwrite.
+
+   return 0 on success (queued)
+   return <0 on error (donefunc will not be called)
+*/
+	int OWNET_async_lwrite(OWNET_HANDLE h, const char *onewire_path, const char *value_string, size_t size, off_t offset, void (*donefunc) (void *v, int result), void *v);
+
+/* int OWNET_async_fd( OWNET_HANDLE h, short * events )
+   The socket for the queued requests, to add to a poll or epoll loop.
+   events is set to the poll events to wait for (POLLIN, POLLOUT).
+   Ask again after each OWNET_async_process, the socket can change.
+
+   returns socket file descriptor,
+   returns <0 if not connected or on error
+*/
+	int OWNET_async_fd(OWNET_HANDLE h, short *events);
+
+/* int OWNET_async_process( OWNET_HANDLE h )
+   Send and receive what is ready, and call donefunc for finished requests.
+   Only blocks to connect to the owserver again.
+   Closing the handle drops queued requests without calling donefunc.
+
+   returns number of requests still outstanding,
+   returns <0 on error
+*/
+	int OWNET_async_process(OWNET_HANDLE h);
+
 /* void OWNET_close( OWNET_HANDLE h)
    close a particular owserver connection
 */
@@ -170,6 +233,36 @@ extern "C" {
 	void OWNET_set_trim( int trim_state ) ;
 	int OWNET_get_trim( void ) ;
 
+/* get and set binary state
+ * Numeric values are returned by OWNET_read and OWNET_lread
+ * as raw little-endian values instead of text
+ * (no formatting on the server, no parsing here).
+ * Decode them with OWNET_value_count and OWNET_value_double.
+ * ascii and binary properties are unaffected.
+   Note that binary state applies to all HANDLES
+*/
+	void OWNET_set_binary( int binary_state ) ;
+	int OWNET_get_binary( void ) ;
+
+/* int OWNET_value_count( const char * value_string, int length )
+   Number of values in the result of a read (array size for .ALL)
+   Works for both binary and text results
+
+   returns number of values,
+   returns <0 on error
+*/
+	int OWNET_value_count(const char *value_string, int length);
+
+/* int OWNET_value_double( const char * value_string, int length,
+        int index, double * value )
+   Value number index of the result of a read, as a double
+   Works for both binary and text results
+
+   return 0 on success
+   return <0 on error
+*/
+	int OWNET_value_double(const char *value_string, int length, int index, double *value);
+
 
 #ifdef __cplusplus
 }
@@ -57,6 +57,9 @@ void *DataHandler(void *v)
 	}
 #endif
 
+	// Allocations for this request come from the handler's arena
+	MemarenaSelect(&hd->arena);
+
 	memset(&cm, 0, sizeof(struct client_msg));
 	cm.version = MakeServerprotocol(OWSERVER_PROTOCOL_VERSION);
 	cm.control_flags = hd->sm.control_flags;			// default flag return -- includes persistence state
@@ -91,6 +94,7 @@ void *DataHandler(void *v)
 	case msg_dirallslash:			// good message
 	case msg_get:				// good message
 	case msg_getslash:			// good message
+	case msg_snapshot:			// good message
 		if (hd->sm.payload == 0) {	/* Bad query -- no data after header */
 			LEVEL_DEBUG("No payload -- ignore.") ;
 			cm.ret = -EBADMSG;
@@ -131,7 +135,7 @@ void *DataHandler(void *v)
 				LEVEL_CALL("Presence message for %s", SAFESTRING(pn->path));
 				// Basically, if we were able to ParsedName it's here!
 				cm.size = 0;
-				retbuffer = owmalloc( SERIAL_NUMBER_SIZE ) ;
+				retbuffer = MemarenaMalloc( SERIAL_NUMBER_SIZE ) ;
 				if ( retbuffer ) {
 					memcpy( retbuffer, pn->sn, SERIAL_NUMBER_SIZE ) ;
 					cm.payload = SERIAL_NUMBER_SIZE ;
@@ -185,6 +189,10 @@ void *DataHandler(void *v)
 					retbuffer = ReadHandler(hd, &cm, owq);
 				}
 				break;
+			case msg_snapshot:
+				LEVEL_CALL("Snapshot message (all devices and values)");
+				SnapshotHandler(hd, &cm, pn);
+				break;
 			default:			// never reached
 				LEVEL_CALL("Error: unknown message %d", (int) hd->sm.type);
 				break;
@@ -220,9 +228,8 @@ void *DataHandler(void *v)
 	}
 	TOCLIENTUNLOCK(hd);
 
-	if (retbuffer) {
-		owfree(retbuffer);
-	}
+	MemarenaFree(retbuffer);
+	MemarenaSelect(NULL);
 	LEVEL_DEBUG("Finished with client request");
 	return VOID_RETURN;
 }
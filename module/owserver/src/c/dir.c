@@ -55,7 +55,7 @@ static void DirHandlerCallback(void *v, const struct parsedname *pn_entry)
 
 	LEVEL_DEBUG("owserver Calling dir=%s", SAFESTRING(path));
 
-	dhs->cm->size = strlen(path);
+	dhs->cm->size = pn_entry->path_length;
 	dhs->cm->payload = dhs->cm->size + 1;
 	dhs->cm->ret = 0;
 
@@ -73,7 +73,7 @@ void DirHandler(struct handlerdata *hd, struct client_msg *cm, const struct pars
 	LEVEL_CALL("DirHandler: pn->path=%s", pn->path);
 
 	// Settings for all directory elements
-	cm->payload = strlen(pn->path) + 1 + OW_FULLNAME_MAX + 2;
+	cm->payload = pn->path_length + 1 + OW_FULLNAME_MAX + 2;
 
 	LEVEL_DEBUG("OWSERVER SpecifiedBus=%d path=%s", SpecifiedBus(pn), SAFESTRING(pn->path));
 
@@ -48,7 +48,7 @@
 void DirallHandlerCallback(void *v, const struct parsedname *pn_entry)
 {
 	struct charblob *cb = v;
-	CharblobAdd(pn_entry->path, strlen(pn_entry->path), cb);
+	CharblobAdd(pn_entry->path, pn_entry->path_length, cb);
 }
 
 void *DirallHandler(struct handlerdata *hd, struct client_msg *cm, const struct parsedname *pn)
@@ -75,7 +75,7 @@ void *DirallHandler(struct handlerdata *hd, struct client_msg *cm, const struct
 		cm->size = cm->payload = 0;
 	} else if (CharblobData(&cb) == NO_CHARBLOB) {	// empty
 		cm->size = cm->payload = 0;
-	} else if ((ret = owstrdup(CharblobData(&cb))) != NULL) {	// try to copy
+	} else if ((ret = MemarenaStrdup(CharblobData(&cb))) != NULL) {	// try to copy
 		cm->payload = CharblobLength(&cb) + 1;
 		cm->size = CharblobLength(&cb);
 	} else {					// couldn't copy
@@ -83,7 +83,7 @@ int FromClient(struct handlerdata *hd)
 	}
 
 	/* Can allocate space? */
-	if ((msg = owmalloc(trueload+2)) == NULL) {	/* create a buffer */
+	if ((msg = MemarenaAlloc(&hd->arena, trueload+2)) == NULL) {	/* create a buffer */
 		// Adds an extra byte for the path null
 		hd->sm.type = msg_error;
 		return -ENOMEM;
@@ -148,6 +148,6 @@ int FromClient(struct handlerdata *hd)
 	return 0;
 	
 BADDATA:
-	owfree(msg);
+	MemarenaFree(msg);
 	return -EINVAL;
 }
@@ -55,6 +55,7 @@ void Handler(FILE_DESCRIPTOR_OR_ERROR file_descriptor)
 
 	hd.file_descriptor = file_descriptor;
 	_MUTEX_INIT(hd.to_client);
+	MemarenaInit(&hd.arena);
 
 	timersub(&tv_high, &tv_low, &tv_high);	// just the delta
 
@@ -133,6 +134,7 @@ void Handler(FILE_DESCRIPTOR_OR_ERROR file_descriptor)
 
 	LEVEL_DEBUG("OWSERVER handler done");
 	_MUTEX_DESTROY(hd.to_client);
+	MemarenaClear(&hd.arena);
 	// restore the persistent count
 	if (persistent) {
 
@@ -164,13 +166,16 @@ static void SingleHandler(struct handlerdata *hd)
 #if ( __GNUC__ > 4 ) || (__GNUC__ == 4 && __GNUC_MINOR__ > 4 )
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wcast-qual"
-	// allocated in From_Client with owmalloc, but cast to const
-		owfree( (void *) hd->sp.path);
+	// allocated in From_Client from the arena, but cast to const
+		MemarenaFree( (void *) hd->sp.path);
 #pragma GCC diagnostic pop
 #else
-	// allocated in From_Client with owmalloc, but cast to const
-		owfree( (void *) hd->sp.path);
+	// allocated in From_Client from the arena, but cast to const
+		MemarenaFree( (void *) hd->sp.path);
 #endif
 		hd->sp.path = NULL;
 	}
+
+	// everything this request drew from the arena is released at once
+	MemarenaReset(&hd->arena);
 }
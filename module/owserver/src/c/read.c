@@ -73,6 +73,10 @@ void *ReadHandler(struct handlerdata *hd, struct client_msg *cm, struct one_wire
 		if ( OWQ_size(owq) > (size_t) hd->sm.size ) {
 			OWQ_size(owq) = hd->sm.size ;
 		}
+		if ( ShouldReturnBinary(pn) && BinaryValueType(pn) == bv_none ) {
+			// ascii, binary and structure are sent as is -- tell the client
+			cm->control_flags &= ~BINARY_VALUE ;
+		}
 		OWQ_offset(owq) = hd->sm.offset ;
 
 		LEVEL_DEBUG("ReadHandler: call FS_read_postparse on %s", pn->path);
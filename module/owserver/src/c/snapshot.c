@@ -0,0 +1,86 @@
+/*
+    OW_HTML -- OWFS used for the web
+    OW -- One-Wire filesystem
+
+    Written 2004 Paul H Alfille
+
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* owserver -- responds to requests over a network socket, and processes them on the 1-wire bus/
+         Basic idea: control the 1-wire bus and answer queries over a network socket
+         Clients can be owperl, owfs, owhttpd, etc...
+         Clients can be local or remote
+                 Eventually will also allow bounce servers.
+
+         syntax:
+                 owserver
+                 -u (usb)
+                 -d /dev/ttyS1 (serial)
+                 -p tcp port
+                 e.g. 3001 or 10.183.180.101:3001 or /tmp/1wire
+*/
+
+#include "owserver.h"
+
+/* Snapshot, called from Handler with the following caveats: */
+/* path is path, already parsed, and null terminated */
+/* sm has been read, cm has been zeroed */
+/* pn is configured */
+/* Snapshot, will return: */
+/* one message per JSON chunk (opening brace, each device, closing brace) */
+/* cm fully constructed for error message or null marker (end of snapshot) */
+/* cm.ret is also set to an error or 0 */
+struct snapshothandlerstruct {
+	struct handlerdata *hd;
+	struct client_msg *cm;
+};
+
+static void SnapshotHandlerCallback(void *v, const char *text, size_t length)
+{
+	struct snapshothandlerstruct *shs = (struct snapshothandlerstruct *) v;
+
+	shs->cm->size = length;
+	shs->cm->payload = length + 1;
+	shs->cm->ret = 0;
+
+	TOCLIENTLOCK(shs->hd);
+	ToClient(shs->hd->file_descriptor, shs->cm, text);	// send this piece of the snapshot
+	shs->hd->toclient = toclient_postmessage ;
+	TOCLIENTUNLOCK(shs->hd);
+}
+
+void SnapshotHandler(struct handlerdata *hd, struct client_msg *cm, const struct parsedname *pn)
+{
+	struct snapshothandlerstruct shs = { hd, cm, };
+
+	LEVEL_CALL("SnapshotHandler: pn->path=%s", pn->path);
+
+	if (hd->sm.payload >= PATH_MAX) {
+		cm->ret = -EMSGSIZE;
+	} else {
+		// Now read the tree, the callback above sends each piece as it is ready
+		// A whole-tree walk allocates and frees a read buffer per property;
+		// take those from the heap so OWQ_destroy really releases them
+		// instead of piling up in the request arena until the reply is done
+		MemarenaSelect(NULL);
+		cm->ret = FS_snapshot(SnapshotHandlerCallback, &shs, pn);
+		MemarenaSelect(&hd->arena);
+	}
+
+	/* Now null entry to show end of snapshot */
+	cm->payload = cm->size = 0;
+}
@@ -41,6 +41,7 @@ struct handlerdata {
 	struct timeval tv;
 	struct server_msg sm;
 	struct serverpackage sp;
+	struct memarena arena; // per-request allocations, reset after each message
 };
 
 /* read from client, free return pointer if not Null */
@@ -64,6 +65,9 @@ void *DirallHandler(struct handlerdata *hd, struct client_msg *cm, const struct
 /* Newer directory-at-once with directory '/' */
 void *DirallslashHandler(struct handlerdata *hd, struct client_msg *cm, const struct parsedname *pn);
 
+/* Every device and value as JSON, streamed */
+void SnapshotHandler(struct handlerdata *hd, struct client_msg *cm, const struct parsedname *pn);
+
 /* Handle the actual request -- pings handled higher up */
 void *DataHandler(void *v);
 
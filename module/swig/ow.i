@@ -12,6 +12,7 @@ API_setup(program_type_swig) ;
 #include "config.h"
 #include "owfs_config.h"
 #include "ow.h"
+#include <math.h>
 
 // define this to add debug-output from newer swig-versions.
 //#define SWIGRUNTIME_DEBUG 1
@@ -65,6 +66,37 @@ char * get( const char * path )
 	return return_buffer ;
 }
 
+/*
+  Numeric value of a property (element index of an .ALL property, else 0)
+  Read as a raw value -- never formatted as text and parsed back.
+  Returns NAN on error
+ */
+double get_value( const char * path, int index )
+{
+	double value = NAN ;
+
+	if ( index >= 0 && API_access_start() == 0 ) {
+		OWQ_allocate_struct_and_pointer(owq);
+
+		if ( GOOD( OWQ_create(path, owq) ) ) {
+			PN(owq)->control_flags |= BINARY_VALUE ;
+			if ( GOOD( OWQ_allocate_read_buffer(owq) ) ) {
+				SIZE_OR_ERROR length ;
+				_FLOAT F ;
+
+				OWQ_offset(owq) = 0 ;
+				length = FS_read_postparse(owq) ;
+				if ( length > 0 && GOOD( BinaryValueDecode( (BYTE *) OWQ_buffer(owq), length, index, &F ) ) ) {
+					value = F ;
+				}
+			}
+			OWQ_destroy(owq) ;
+		}
+		API_access_end() ;
+	}
+	return value ;
+}
+
 void finish( void ) {
 	API_finish() ;
 }
@@ -97,6 +129,7 @@ int opt(const char option_char, const char *arg) {
 extern char *version( );
 extern int init( const char * dev ) ;
 extern char * get( const char * path ) ;
+extern double get_value( const char * path, int index ) ;
 extern int put( const char * path, const char * value ) ;
 extern void finish( void ) ;
 extern void set_error_print(int);